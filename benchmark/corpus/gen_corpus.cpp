@@ -0,0 +1,445 @@
+// Synthetic stress-PDF generator. Writes reproducible worst-case documents with
+// MuPDF's document writer so the benchmark targets do not depend on PDFs that
+// cannot be checked into the repo. Every document is a pure function of the
+// parameters and the seed.
+#include <CLI11.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+extern "C" {
+#include <mupdf/fitz.h>
+}
+
+namespace {
+constexpr fz_rect LETTER = {0, 0, 612, 792};
+constexpr fz_rect POSTER = {0, 0, 14'400, 14'400};  ///< 200in square, the PDF page size limit
+
+constexpr std::array<const char*, 14> BASE14_FONTS = {
+    "Times-Roman",
+    "Times-Bold",
+    "Times-Italic",
+    "Times-BoldItalic",
+    "Helvetica",
+    "Helvetica-Bold",
+    "Helvetica-Oblique",
+    "Helvetica-BoldOblique",
+    "Courier",
+    "Courier-Bold",
+    "Courier-Oblique",
+    "Courier-BoldOblique",
+    "Symbol",
+    "ZapfDingbats",
+};
+
+constexpr std::array<std::string_view, 8> KINDS = {
+    "many_pages",
+    "huge_paths",
+    "large_jpeg",
+    "bilevel_scan",
+    "many_fonts",
+    "transparency",
+    "poster",
+    "broken_xref",
+};
+
+struct CorpusParams {
+  int pages = 5'000;            ///< Pages in many_pages and broken_xref
+  int path_segments = 100'000;  ///< Curve segments per path in huge_paths
+  int image_width = 6'000;      ///< Pixels, large_jpeg and bilevel_scan
+  int image_height = 4'000;
+  int image_pages = 8;  ///< Pages in the image, path, font and transparency documents
+  std::uint32_t seed = 1;
+  std::vector<std::filesystem::path> font_files;  ///< Extra fonts embedded by many_fonts
+};
+
+/**
+ * @brief State shared by the page painters of one document.
+ *
+ * Painters run inside fz_try, so they only use MuPDF objects and trivially
+ * destructible locals; MuPDF errors unwind with longjmp.
+ */
+struct PageContext {
+  fz_context* ctx;
+  fz_device* dev;
+  fz_rect mediabox;
+  int page_num;
+  const CorpusParams* params;
+  std::mt19937* rng;
+  fz_image* image;  ///< Shared image for the image documents, else nullptr
+  const std::vector<fz_font*>* fonts;  ///< Base 14 faces first, then any loaded font files
+};
+
+using PagePainter = void (*)(PageContext&);
+
+float uniform(std::mt19937& rng, float lo, float hi) {
+  return std::uniform_real_distribution<float>(lo, hi)(rng);
+}
+
+void fill_rect(PageContext& page, fz_rect rect, const float* rgb, float alpha) {
+  fz_path* path = fz_new_path(page.ctx);
+  fz_try(page.ctx) {
+    fz_rectto(page.ctx, path, rect.x0, rect.y0, rect.x1, rect.y1);
+    fz_fill_path(page.ctx, page.dev, path, 0, fz_identity, fz_device_rgb(page.ctx), rgb, alpha,
+                 fz_default_color_params);
+  }
+  fz_always(page.ctx) { fz_drop_path(page.ctx, path); }
+  fz_catch(page.ctx) { fz_rethrow(page.ctx); }
+}
+
+void show_text(PageContext& page, fz_font* font, float size, float x, float y, const char* s) {
+  static constexpr float black[3] = {0, 0, 0};
+  fz_text* text = fz_new_text(page.ctx);
+  fz_try(page.ctx) {
+    fz_show_string(page.ctx, text, font, fz_make_matrix(size, 0, 0, -size, x, y), s, 0, 0,
+                   FZ_BIDI_LTR, FZ_LANG_UNSET);
+    fz_fill_text(page.ctx, page.dev, text, fz_identity, fz_device_rgb(page.ctx), black, 1.0F,
+                 fz_default_color_params);
+  }
+  fz_always(page.ctx) { fz_drop_text(page.ctx, text); }
+  fz_catch(page.ctx) { fz_rethrow(page.ctx); }
+}
+
+void paint_page_number(PageContext& page) {
+  char label[32];
+  std::snprintf(label, sizeof(label), "Page %d", page.page_num + 1);
+  show_text(page, (*page.fonts)[4], 24, 72, 72, label);
+}
+
+/// A page number and a few coloured blocks: cheap pages in large numbers.
+void paint_simple(PageContext& page) {
+  paint_page_number(page);
+  for (int i = 0; i < 4; i++) {
+    const float rgb[3] = {uniform(*page.rng, 0, 1), uniform(*page.rng, 0, 1), 0.5F};
+    const float x = uniform(*page.rng, 72, 400);
+    const float y = uniform(*page.rng, 120, 600);
+    fill_rect(page, {x, y, x + 120, y + 80}, rgb, 1.0F);
+  }
+}
+
+/// One filled and stroked random-walk path with params.path_segments curves.
+void paint_huge_path(PageContext& page) {
+  static constexpr float fill[3] = {0.2F, 0.4F, 0.8F};
+  static constexpr float stroke_rgb[3] = {0, 0, 0};
+  fz_context* ctx = page.ctx;
+  fz_path* path = fz_new_path(ctx);
+  fz_stroke_state* stroke = nullptr;
+  fz_var(stroke);
+  fz_try(ctx) {
+    const fz_rect box = page.mediabox;
+    float x = (box.x0 + box.x1) / 2;
+    float y = (box.y0 + box.y1) / 2;
+    fz_moveto(ctx, path, x, y);
+    for (int i = 0; i < page.params->path_segments; i++) {
+      const float step = 8.0F;
+      const float nx = std::clamp(x + uniform(*page.rng, -step, step), box.x0, box.x1);
+      const float ny = std::clamp(y + uniform(*page.rng, -step, step), box.y0, box.y1);
+      fz_curveto(ctx, path, x + uniform(*page.rng, -step, step), y, nx,
+                 ny + uniform(*page.rng, -step, step), nx, ny);
+      x = nx;
+      y = ny;
+    }
+    fz_closepath(ctx, path);
+    fz_fill_path(ctx, page.dev, path, 1, fz_identity, fz_device_rgb(ctx), fill, 1.0F,
+                 fz_default_color_params);
+    stroke = fz_new_stroke_state(ctx);
+    stroke->linewidth = 0.25F;
+    fz_stroke_path(ctx, page.dev, path, stroke, fz_identity, fz_device_rgb(ctx), stroke_rgb, 1.0F,
+                   fz_default_color_params);
+  }
+  fz_always(ctx) {
+    fz_drop_stroke_state(ctx, stroke);
+    fz_drop_path(ctx, path);
+  }
+  fz_catch(ctx) { fz_rethrow(ctx); }
+}
+
+/// The shared image scaled to fill the page.
+void paint_full_page_image(PageContext& page) {
+  const fz_rect box = page.mediabox;
+  const fz_matrix ctm = fz_concat(fz_scale(box.x1 - box.x0, box.y1 - box.y0),
+                                  fz_translate(box.x0, box.y0));
+  fz_fill_image(page.ctx, page.dev, page.image, ctm, 1.0F, fz_default_color_params);
+  paint_page_number(page);
+}
+
+/// Lines of text cycling through every loaded font at varying sizes.
+void paint_fonts(PageContext& page) {
+  static constexpr const char* sample = "The quick brown fox jumps over the lazy dog 0123456789";
+  float y = 60;
+  for (int line = 0; y < page.mediabox.y1 - 40; line++) {
+    const auto font_index = static_cast<std::size_t>(line + page.page_num) % page.fonts->size();
+    const float size = 6.0F + static_cast<float>(line % 7) * 2.0F;
+    show_text(page, (*page.fonts)[font_index], size, 36, y, sample);
+    y += size * 1.3F;
+  }
+}
+
+/// Nested isolated and knockout groups with every separable blend mode.
+void paint_transparency(PageContext& page) {
+  constexpr int blend_modes = FZ_BLEND_EXCLUSION + 1;
+  fz_context* ctx = page.ctx;
+  const fz_rect box = page.mediabox;
+  for (int outer = 0; outer < 6; outer++) {
+    const float inset = static_cast<float>(outer) * 30.0F;
+    const fz_rect area = {box.x0 + inset, box.y0 + inset, box.x1 - inset, box.y1 - inset};
+    fz_begin_group(ctx, page.dev, area, fz_device_rgb(ctx), outer % 2, outer % 3 == 0,
+                   (outer + page.page_num) % blend_modes, 0.85F);
+    for (int i = 0; i < 24; i++) {
+      const float rgb[3] = {uniform(*page.rng, 0, 1), uniform(*page.rng, 0, 1),
+                            uniform(*page.rng, 0, 1)};
+      const float x = uniform(*page.rng, area.x0, area.x1 - 100);
+      const float y = uniform(*page.rng, area.y0, area.y1 - 100);
+      fz_begin_group(ctx, page.dev, {x, y, x + 150, y + 150}, nullptr, 0, 0,
+                     i % blend_modes, uniform(*page.rng, 0.2F, 0.9F));
+      fill_rect(page, {x, y, x + 150, y + 150}, rgb, uniform(*page.rng, 0.3F, 1.0F));
+      fz_end_group(ctx, page.dev);
+    }
+    fz_end_group(ctx, page.dev);
+  }
+}
+
+/// A poster-sized page: a dense grid of blocks and labels.
+void paint_poster(PageContext& page) {
+  constexpr float cell = 200.0F;
+  char label[32];
+  for (float y = 0; y < page.mediabox.y1; y += cell) {
+    for (float x = 0; x < page.mediabox.x1; x += cell) {
+      const float rgb[3] = {x / page.mediabox.x1, y / page.mediabox.y1, 0.6F};
+      fill_rect(page, {x + 10, y + 10, x + cell - 10, y + cell - 10}, rgb, 1.0F);
+      std::snprintf(label, sizeof(label), "%d,%d", static_cast<int>(x), static_cast<int>(y));
+      show_text(page, (*page.fonts)[8], 18, x + 20, y + 40, label);
+    }
+  }
+}
+
+/**
+ * @brief Seeded smooth gradient with noise, big enough not to compress away.
+ * @param bilevel Threshold to pure black and white, like a scanned text page.
+ */
+fz_pixmap* make_pixmap(fz_context* ctx, const CorpusParams& params, bool bilevel,
+                       std::mt19937& rng) {
+  fz_colorspace* cs = bilevel ? fz_device_gray(ctx) : fz_device_rgb(ctx);
+  fz_pixmap* pix = fz_new_pixmap(ctx, cs, params.image_width, params.image_height, nullptr, 0);
+  std::uniform_int_distribution<int> noise(-24, 24);
+  for (int y = 0; y < pix->h; y++) {
+    unsigned char* row = pix->samples + (static_cast<std::ptrdiff_t>(y) * pix->stride);
+    for (int x = 0; x < pix->w; x++) {
+      for (int c = 0; c < pix->n; c++) {
+        const int base = ((x * (c + 1)) / 16 + (y * (3 - c)) / 24) % 256;
+        int value = std::clamp(base + noise(rng), 0, 255);
+        if (bilevel) {
+          // glyph-like strokes: short dark runs on most rows, margins left blank
+          value = (y % 24 < 16 && (x / 6 + y / 24) % 5 != 0 && noise(rng) > -12) ? 0 : 255;
+        }
+        row[(x * pix->n) + c] = static_cast<unsigned char>(value);
+      }
+    }
+  }
+  return pix;
+}
+
+/**
+ * @brief Writes n_pages pages of mediabox size, each painted by painter.
+ * @return An error message on failure.
+ */
+std::string write_document(fz_context* ctx, const std::filesystem::path& path, int n_pages,
+                           fz_rect mediabox, PagePainter painter, PageContext& page) {
+  const std::string path_string = path.string();
+  fz_document_writer* writer = nullptr;
+  fz_var(writer);
+  fz_try(ctx) {
+    writer = fz_new_pdf_writer(ctx, path_string.c_str(), "compress");
+    for (int i = 0; i < n_pages; i++) {
+      page.dev = fz_begin_page(ctx, writer, mediabox);
+      page.mediabox = mediabox;
+      page.page_num = i;
+      painter(page);
+      fz_end_page(ctx, writer);
+    }
+    fz_close_document_writer(ctx, writer);
+  }
+  fz_always(ctx) { fz_drop_document_writer(ctx, writer); }
+  fz_catch(ctx) { return fz_caught_message(ctx); }
+  return {};
+}
+
+/**
+ * @brief Points startxref at the file header so readers have to repair the xref.
+ * @return An error message on failure.
+ */
+std::string break_xref(const std::filesystem::path& path) {
+  std::string data;
+  {
+    std::ifstream in(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  const std::size_t startxref = data.rfind("startxref");
+  if (startxref == std::string::npos) {
+    return "no startxref";
+  }
+  std::size_t pos = data.find_first_of("0123456789", startxref);
+  while (pos < data.size() && data[pos] >= '0' && data[pos] <= '9') {
+    data[pos++] = '0';
+  }
+  // also damage the xref keyword so the table cannot be found by scanning back
+  const std::size_t xref = data.rfind("xref", startxref - 1);
+  if (xref != std::string::npos) {
+    data[xref] = 'X';
+  }
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!(out << data)) {
+    return "could not rewrite file";
+  }
+  return {};
+}
+
+std::string generate(fz_context* ctx, std::string_view kind, const CorpusParams& params,
+                     const std::filesystem::path& path) {
+  std::mt19937 rng(params.seed);
+  std::vector<fz_font*> fonts(BASE14_FONTS.size(), nullptr);
+  std::vector<std::string> font_paths;
+  if (kind == "many_fonts") {
+    for (const auto& file : params.font_files) {
+      font_paths.push_back(file.string());
+    }
+    fonts.resize(fonts.size() + font_paths.size(), nullptr);
+  }
+  PageContext page{.ctx = ctx,
+                   .dev = nullptr,
+                   .mediabox = LETTER,
+                   .page_num = 0,
+                   .params = &params,
+                   .rng = &rng,
+                   .image = nullptr,
+                   .fonts = &fonts};
+  fz_pixmap* pix = nullptr;
+  fz_buffer* jpeg = nullptr;
+  fz_var(pix);
+  fz_var(jpeg);
+  fz_try(ctx) {
+    for (std::size_t i = 0; i < BASE14_FONTS.size(); i++) {
+      fonts[i] = fz_new_base14_font(ctx, BASE14_FONTS[i]);
+    }
+    for (std::size_t i = 0; i < font_paths.size(); i++) {
+      fonts[BASE14_FONTS.size() + i] =
+          fz_new_font_from_file(ctx, nullptr, font_paths[i].c_str(), 0, 0);
+    }
+    if (kind == "large_jpeg") {
+      pix = make_pixmap(ctx, params, false, rng);
+      jpeg = fz_new_buffer_from_pixmap_as_jpeg(ctx, pix, fz_default_color_params, 90, 0);
+      page.image = fz_new_image_from_buffer(ctx, jpeg);
+    } else if (kind == "bilevel_scan") {
+      pix = make_pixmap(ctx, params, true, rng);
+      page.image = fz_new_image_from_pixmap(ctx, pix, nullptr);
+    }
+  }
+  fz_catch(ctx) {
+    for (fz_font* font : fonts) {
+      fz_drop_font(ctx, font);
+    }
+    fz_drop_buffer(ctx, jpeg);
+    fz_drop_pixmap(ctx, pix);
+    return fz_caught_message(ctx);
+  }
+
+  std::string error;
+  if (kind == "many_pages") {
+    error = write_document(ctx, path, params.pages, LETTER, paint_simple, page);
+  } else if (kind == "huge_paths") {
+    error = write_document(ctx, path, params.image_pages, LETTER, paint_huge_path, page);
+  } else if (kind == "large_jpeg" || kind == "bilevel_scan") {
+    error = write_document(ctx, path, params.image_pages, LETTER, paint_full_page_image, page);
+  } else if (kind == "many_fonts") {
+    error = write_document(ctx, path, params.image_pages, LETTER, paint_fonts, page);
+  } else if (kind == "transparency") {
+    error = write_document(ctx, path, params.image_pages, LETTER, paint_transparency, page);
+  } else if (kind == "poster") {
+    error = write_document(ctx, path, 2, POSTER, paint_poster, page);
+  } else if (kind == "broken_xref") {
+    error = write_document(ctx, path, params.pages, LETTER, paint_simple, page);
+    if (error.empty()) {
+      error = break_xref(path);
+    }
+  }
+
+  fz_drop_image(ctx, page.image);
+  fz_drop_buffer(ctx, jpeg);
+  fz_drop_pixmap(ctx, pix);
+  for (fz_font* font : fonts) {
+    fz_drop_font(ctx, font);
+  }
+  return error;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  CLI::App app("pdvu_gen_corpus: write synthetic stress PDFs");
+
+  std::filesystem::path out_dir = "corpus";
+  app.add_option("-o,--out-dir", out_dir, "Directory for the generated documents");
+
+  std::vector<std::string> kinds(KINDS.begin(), KINDS.end());
+  app.add_option("-k,--kinds", kinds, "Documents to generate")
+      ->delimiter(',')
+      ->check(CLI::IsMember(std::vector<std::string>(KINDS.begin(), KINDS.end())));
+
+  CorpusParams params;
+  app.add_option("--pages", params.pages, "Pages in many_pages and broken_xref");
+  app.add_option("--path-segments", params.path_segments, "Curve segments per path in huge_paths");
+  app.add_option("--image-width", params.image_width, "Embedded image width in pixels");
+  app.add_option("--image-height", params.image_height, "Embedded image height in pixels");
+  app.add_option("--image-pages", params.image_pages, "Pages in the heavy-content documents");
+  app.add_option("--seed", params.seed, "Seed for all random content");
+
+  std::filesystem::path font_dir;
+  app.add_option("--font-dir", font_dir, "Embed every .ttf/.otf in this directory in many_fonts")
+      ->check(CLI::ExistingDirectory);
+
+  CLI11_PARSE(app, argc, argv);
+
+  if (!font_dir.empty()) {
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(font_dir)) {
+      const auto extension = entry.path().extension();
+      if (entry.is_regular_file() && (extension == ".ttf" || extension == ".otf")) {
+        params.font_files.push_back(entry.path());
+      }
+    }
+    std::ranges::sort(params.font_files);  // directory order is not reproducible
+  }
+
+  std::error_code error_code;
+  std::filesystem::create_directories(out_dir, error_code);
+  if (error_code) {
+    std::println(stderr, "Error: could not create {}: {}", out_dir.string(), error_code.message());
+    return 1;
+  }
+
+  fz_context* ctx = fz_new_context(nullptr, nullptr, FZ_STORE_DEFAULT);
+  if (ctx == nullptr) {
+    std::println(stderr, "Error: could not create MuPDF context");
+    return 1;
+  }
+  int status = 0;
+  for (const auto& kind : kinds) {
+    const auto path = out_dir / std::format("{}.pdf", kind);
+    std::println(stderr, "writing {}", path.string());
+    const std::string error = generate(ctx, kind, params, path);
+    if (!error.empty()) {
+      std::println(stderr, "Error: {}: {}", kind, error);
+      status = 1;
+    }
+  }
+  fz_drop_context(ctx);
+  return status;
+}
@@ -0,0 +1,131 @@
+#include "graphics_protocol.h"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace {
+constexpr char ESC = '\x1b';
+
+constexpr std::array<std::int8_t, 256> make_base64_table() {
+  std::array<std::int8_t, 256> table{};
+  table.fill(-1);
+  constexpr std::string_view alphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  for (std::size_t i = 0; i < alphabet.size(); i++) {
+    table[static_cast<unsigned char>(alphabet[i])] = static_cast<std::int8_t>(i);
+  }
+  return table;
+}
+
+constexpr std::array<std::int8_t, 256> g_base64 = make_base64_table();
+}  // namespace
+
+namespace e2e {
+std::string_view GraphicsCommand::get(char key, std::string_view fallback) const {
+  const auto it = control.find(key);
+  return it == control.end() ? fallback : std::string_view(it->second);
+}
+
+std::int64_t GraphicsCommand::get_int(char key, std::int64_t fallback) const {
+  const std::string_view value = get(key);
+  std::int64_t out = 0;
+  const auto [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), out);
+  if (value.empty() || error != std::errc{} || ptr != value.data() + value.size()) {
+    return fallback;
+  }
+  return out;
+}
+
+void GraphicsParser::feed(std::string_view bytes, std::vector<GraphicsCommand>& out) {
+  for (const char c : bytes) {
+    switch (m_state) {
+      case State::Text:
+        if (c == ESC) {
+          m_state = State::Escape;
+        } else {
+          m_text_bytes++;
+        }
+        break;
+      case State::Escape:
+        if (c == '_') {
+          m_state = State::Apc;
+          m_apc.clear();
+        } else {
+          m_text_bytes += 2;  // some other escape sequence, treated as text
+          m_state = c == ESC ? State::Escape : State::Text;
+        }
+        break;
+      case State::Apc:
+        if (c == ESC) {
+          m_state = State::ApcEscape;
+        } else {
+          m_apc.push_back(c);
+        }
+        break;
+      case State::ApcEscape:
+        if (c == '\\') {
+          if (auto command = parse_command(m_apc)) {
+            out.push_back(std::move(*command));
+          }
+          m_state = State::Text;
+        } else {
+          m_apc.push_back(ESC);
+          m_apc.push_back(c);
+          m_state = State::Apc;
+        }
+        break;
+    }
+  }
+}
+
+std::optional<GraphicsCommand> parse_command(std::string_view apc_body) {
+  if (!apc_body.starts_with('G')) {
+    return std::nullopt;
+  }
+  apc_body.remove_prefix(1);
+  GraphicsCommand command;
+  const std::size_t separator = apc_body.find(';');
+  std::string_view control = apc_body.substr(0, separator);
+  if (separator != std::string_view::npos) {
+    command.payload = std::string(apc_body.substr(separator + 1));
+  }
+  while (!control.empty()) {
+    const std::size_t comma = control.find(',');
+    const std::string_view pair = control.substr(0, comma);
+    if (pair.size() >= 2 && pair[1] == '=') {
+      command.control[pair[0]] = std::string(pair.substr(2));
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    control.remove_prefix(comma + 1);
+  }
+  return command;
+}
+
+std::string base64_decode(std::string_view input) {
+  std::string out;
+  out.reserve((input.size() / 4) * 3);
+  std::uint32_t value = 0;
+  int bits = -8;
+  for (const char c : input) {
+    const std::int8_t sextet = g_base64[static_cast<unsigned char>(c)];
+    if (sextet < 0) {
+      break;  // padding or garbage ends the data
+    }
+    value = (value << 6) | static_cast<std::uint32_t>(sextet);
+    bits += 6;
+    if (bits >= 0) {
+      out.push_back(static_cast<char>((value >> bits) & 0xFF));
+      bits -= 8;
+    }
+  }
+  return out;
+}
+}  // namespace e2e
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace e2e {
+/**
+ * @brief One Kitty graphics protocol command: <code>ESC _ G control ; payload ESC \</code>.
+ */
+struct GraphicsCommand {
+  std::unordered_map<char, std::string> control;  ///< Single-letter keys, e.g. 'a' -> "t"
+  std::string payload;                            ///< Still base64 encoded
+
+  /// Value of key, or fallback when absent.
+  [[nodiscard]] std::string_view get(char key, std::string_view fallback = "") const;
+
+  /// Integer value of key, or fallback when absent or malformed.
+  [[nodiscard]] std::int64_t get_int(char key, std::int64_t fallback = 0) const;
+};
+
+/**
+ * @brief Extracts graphics commands from a terminal output stream.
+ *
+ * Bytes may arrive split at any point; partial commands are kept until the
+ * terminator arrives. Everything outside graphics APC sequences is counted
+ * and otherwise ignored.
+ */
+class GraphicsParser {
+ public:
+  /// Appends decoded commands to out.
+  void feed(std::string_view bytes, std::vector<GraphicsCommand>& out);
+
+  /// Bytes seen outside graphics commands (text, cursor movement, colours).
+  [[nodiscard]] std::size_t text_bytes() const { return m_text_bytes; }
+
+ private:
+  enum class State {
+    Text,
+    Escape,        ///< Saw ESC
+    Apc,           ///< Inside ESC _ ... collecting
+    ApcEscape,     ///< Saw ESC inside the APC, expecting '\'
+  };
+
+  State m_state = State::Text;
+  std::string m_apc;
+  std::size_t m_text_bytes = 0;
+};
+
+/// Parses the body of an APC sequence (without ESC _ and ESC \). Non-graphics APCs yield nullopt.
+std::optional<GraphicsCommand> parse_command(std::string_view apc_body);
+
+/// Standard base64 decoding; stops at the first padding or invalid character.
+std::string base64_decode(std::string_view input);
+}  // namespace e2e
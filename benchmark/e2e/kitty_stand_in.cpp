@@ -0,0 +1,97 @@
+#include "kitty_stand_in.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace e2e {
+std::optional<std::string> read_payload(char medium, const std::string& path, std::size_t size) {
+  int fd = -1;
+  if (medium == 'f') {
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  } else if (medium == 's') {
+    fd = shm_open(path.c_str(), O_RDONLY, 0);
+  }
+  if (fd == -1 || size == 0) {
+    if (fd != -1) {
+      close(fd);
+    }
+    return std::nullopt;
+  }
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return std::nullopt;
+  }
+  // copy out like the terminal does before uploading, so page faults are paid here
+  std::string pixels(static_cast<const char*>(mapped), size);
+  munmap(mapped, size);
+  return pixels;
+}
+
+void KittyStandIn::apply(const GraphicsCommand& command, Clock::time_point now) {
+  const std::string_view action = command.get('a', "t");
+  const auto id = static_cast<std::uint32_t>(command.get_int('i'));
+  if (action == "t" || action == "T") {
+    transmit(command, now);
+    if (action == "T") {
+      place(id, now);
+    }
+  } else if (action == "p") {
+    place(id, now);
+  } else if (action == "d") {
+    if (command.get('d') == "i" || command.get('d') == "I") {
+      m_images.erase(id);
+    }
+  }
+}
+
+void KittyStandIn::mark(Clock::time_point now) {
+  m_mark = now;
+  m_observation = {};
+}
+
+void KittyStandIn::transmit(const GraphicsCommand& command, Clock::time_point now) {
+  const auto id = static_cast<std::uint32_t>(command.get_int('i'));
+  const std::int64_t width = command.get_int('s');
+  const std::int64_t height = command.get_int('v');
+  const std::int64_t channels = command.get_int('f', 32) / 8;
+  const char medium = command.get('t', "d").front();
+
+  std::optional<std::string> pixels;
+  if (medium == 'd') {
+    pixels = base64_decode(command.payload);
+  } else if (width > 0 && height > 0) {
+    const auto size = static_cast<std::size_t>(width * height * channels);
+    pixels = read_payload(medium, base64_decode(command.payload), size);
+  }
+  const auto loaded_at = Clock::now();
+  if (!pixels) {
+    m_load_errors++;
+    m_images.erase(id);
+    return;
+  }
+  m_observation.bytes_loaded += pixels->size();
+  m_observation.load_time += loaded_at - now;
+  m_images[id] = {.pixels = std::move(*pixels), .loaded_at = loaded_at};
+}
+
+void KittyStandIn::place(std::uint32_t id, Clock::time_point now) {
+  const auto it = m_images.find(id);
+  if (it == m_images.end()) {
+    return;
+  }
+  const auto displayable = std::max(now, it->second.loaded_at);
+  if (!m_observation.first_placement) {
+    m_observation.first_placement = displayable;
+  }
+  if (!m_observation.first_new_frame && it->second.loaded_at >= m_mark) {
+    m_observation.first_new_frame = displayable;
+  }
+}
+}  // namespace e2e
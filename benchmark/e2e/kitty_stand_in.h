@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "graphics_protocol.h"
+
+namespace e2e {
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Minimal terminal side of the Kitty graphics protocol.
+ *
+ * Implements what pdvu emits: transmissions from a file (t=f) or POSIX shared
+ * memory (t=s), direct RGBA transmit-and-place (a=T), placements (a=p) and
+ * deletions (a=d). A transmission is loaded into memory the way Kitty would
+ * before it can be shown; a placement is displayable once its image has been
+ * loaded. Placements of images that failed to load are counted, not shown.
+ */
+class KittyStandIn {
+ public:
+  /// Timestamps of what was displayed since the last mark().
+  struct Observation {
+    std::optional<Clock::time_point> first_placement;  ///< Any displayable placement
+    std::optional<Clock::time_point> first_new_frame;  ///< Placement of an image loaded after mark
+    std::size_t bytes_loaded = 0;
+    Clock::duration load_time{};  ///< Time spent copying payloads in
+  };
+
+  void apply(const GraphicsCommand& command, Clock::time_point now);
+
+  /// Starts a new observation window, e.g. right before injecting a key.
+  void mark(Clock::time_point now);
+
+  [[nodiscard]] const Observation& observation() const { return m_observation; }
+  [[nodiscard]] std::size_t images() const { return m_images.size(); }
+  [[nodiscard]] std::uint64_t load_errors() const { return m_load_errors; }
+
+ private:
+  struct Image {
+    std::string pixels;
+    Clock::time_point loaded_at;
+  };
+
+  void transmit(const GraphicsCommand& command, Clock::time_point now);
+  void place(std::uint32_t id, Clock::time_point now);
+
+  std::unordered_map<std::uint32_t, Image> m_images;
+  Clock::time_point m_mark{};
+  Observation m_observation;
+  std::uint64_t m_load_errors = 0;
+};
+
+/**
+ * @brief Reads a t=f or t=s payload of exactly size bytes.
+ * @return The pixels, or std::nullopt if the medium cannot be read.
+ */
+std::optional<std::string> read_payload(char medium, const std::string& path, std::size_t size);
+}  // namespace e2e
@@ -0,0 +1,227 @@
+// End-to-end latency harness. Runs pdvu on a pseudo terminal, plays the part of
+// a Kitty terminal for the graphics protocol and measures the time from an
+// injected keypress until the resulting frame could be displayed, including
+// transmission through temp files or shared memory.
+#include <CLI11.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pty_session.h"
+#include "render/parser.h"
+#include "utils/metrics.h"
+#include "viewer/pageview.h"
+
+namespace {
+using e2e::Clock;
+
+constexpr std::string_view KEY_RIGHT = "\x1b[C";
+constexpr std::string_view KEY_LEFT = "\x1b[D";
+constexpr std::string_view KEY_ZOOM_IN = "=";
+constexpr std::string_view KEY_ZOOM_OUT = "-";
+
+struct Options {
+  std::filesystem::path pdvu = PDVU_BINARY_PATH;
+  std::filesystem::path pdf;
+  std::vector<std::string> scenarios = {"flip", "zoom"};
+  int max_pages = 20;
+  int repeat = 1;
+  e2e::WindowSize window;
+  bool use_shm = false;
+  int threads = 1;
+  std::chrono::milliseconds key_timeout{5'000};
+  std::chrono::milliseconds settle{100};
+};
+
+struct ScenarioResult {
+  std::string name;
+  metrics::HistogramSummary first_placement;  ///< Key to first displayable placement
+  metrics::HistogramSummary frame;            ///< Key to first newly transmitted frame
+  std::uint64_t keys = 0;
+  std::uint64_t timeouts = 0;
+  std::size_t bytes_loaded = 0;
+  double load_ms = 0;  ///< Stand-in time spent reading payloads
+};
+
+/// Keys for a sweep through the document and back.
+std::vector<std::string_view> flip_keys(int n_pages) {
+  std::vector<std::string_view> keys(static_cast<std::size_t>(std::max(n_pages - 1, 0)),
+                                     KEY_RIGHT);
+  keys.insert(keys.end(), keys.size(), KEY_LEFT);
+  return keys;
+}
+
+/// Keys zooming from the default level up to the largest, down to the smallest and back.
+std::vector<std::string_view> zoom_keys() {
+  const auto up = static_cast<std::size_t>(
+      static_cast<int>(PageView::m_zoom_levels.size()) - 1 - PageView::m_default_zoom_index);
+  const auto down = static_cast<std::size_t>(PageView::m_default_zoom_index);
+  std::vector<std::string_view> keys(up, KEY_ZOOM_IN);
+  keys.insert(keys.end(), up + down, KEY_ZOOM_OUT);
+  keys.insert(keys.end(), down, KEY_ZOOM_IN);
+  return keys;
+}
+
+ScenarioResult run_scenario(e2e::PtySession& session, const std::string& name,
+                            const std::vector<std::string_view>& keys, const Options& options) {
+  ScenarioResult result{.name = name, .first_placement = {}, .frame = {}};
+  metrics::LatencyHistogram first_placement;
+  metrics::LatencyHistogram frame;
+  for (int r = 0; r < options.repeat; r++) {
+    for (const auto key : keys) {
+      const auto pressed = Clock::now();
+      session.press(key);
+      const bool drawn = session.wait_for_frame(pressed + options.key_timeout);
+      const auto& observed = session.terminal().observation();
+      result.keys++;
+      if (observed.first_placement) {
+        first_placement.record(*observed.first_placement - pressed);
+      }
+      if (drawn) {
+        frame.record(*observed.first_new_frame - pressed);
+      } else {
+        result.timeouts++;
+      }
+      // let trailing redraws finish so they are not attributed to the next key
+      session.settle(options.settle, Clock::now() + options.key_timeout);
+      result.bytes_loaded += observed.bytes_loaded;
+      result.load_ms += std::chrono::duration<double, std::milli>(observed.load_time).count();
+    }
+  }
+  result.first_placement = first_placement.summary();
+  result.frame = frame.summary();
+  return result;
+}
+
+std::string summary_json(const metrics::HistogramSummary& s) {
+  return std::format(
+      R"({{"count": {}, "p50_ms": {:.3f}, "p95_ms": {:.3f}, "p99_ms": {:.3f}, "max_ms": {:.3f}}})",
+      s.count,
+      s.p50_us / 1000.0,
+      s.p95_us / 1000.0,
+      s.p99_us / 1000.0,
+      s.max_us / 1000.0);
+}
+
+std::string to_json(const Options& options, std::optional<Clock::duration> startup,
+                    const std::vector<ScenarioResult>& results, std::uint64_t load_errors) {
+  const double startup_ms =
+      startup ? std::chrono::duration<double, std::milli>(*startup).count() : -1.0;
+  std::string json = std::format(
+      "{{\n  \"transmission\": \"{}\",\n  \"threads\": {},\n  \"window\": {{\"columns\": {}, "
+      "\"rows\": {}, \"pixel_width\": {}, \"pixel_height\": {}}},\n  \"startup_ms\": {:.3f},\n"
+      "  \"load_errors\": {},\n  \"scenarios\": [",
+      options.use_shm ? "shm" : "tempfile",
+      options.threads,
+      options.window.columns,
+      options.window.rows,
+      options.window.pixel_width,
+      options.window.pixel_height,
+      startup_ms,
+      load_errors);
+  std::string_view separator;
+  for (const auto& result : results) {
+    json += std::format(
+        "{}\n    {{\"scenario\": \"{}\", \"keys\": {}, \"timeouts\": {}, \"bytes_loaded\": {}, "
+        "\"load_ms\": {:.3f},\n     \"first_placement\": {},\n     \"frame\": {}}}",
+        separator,
+        result.name,
+        result.keys,
+        result.timeouts,
+        result.bytes_loaded,
+        result.load_ms,
+        summary_json(result.first_placement),
+        summary_json(result.frame));
+    separator = ",";
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  CLI::App app("pdvu_e2e: end-to-end latency through a stand-in Kitty terminal");
+  Options options;
+  app.add_option("pdf", options.pdf, "PDF to open")->required()->check(CLI::ExistingFile);
+  app.add_option("--pdvu", options.pdvu, "pdvu binary to run")->check(CLI::ExistingFile);
+  app.add_option("-s,--scenarios", options.scenarios, "Scenarios to run: flip, zoom")
+      ->delimiter(',')
+      ->check(CLI::IsMember({"flip", "zoom"}));
+  app.add_option("--max-pages", options.max_pages, "Pages visited by the flip scenario");
+  app.add_option("--repeat", options.repeat, "Times to repeat each scenario");
+  app.add_option("--columns", options.window.columns, "Terminal columns");
+  app.add_option("--rows", options.window.rows, "Terminal rows");
+  app.add_option("--pixel-width", options.window.pixel_width, "Terminal width in pixels");
+  app.add_option("--pixel-height", options.window.pixel_height, "Terminal height in pixels");
+  app.add_flag("--shm", options.use_shm, "Run pdvu with shared memory transmission");
+  app.add_option("-j,--threads", options.threads, "Worker threads passed to pdvu");
+  int key_timeout_ms = static_cast<int>(options.key_timeout.count());
+  app.add_option("--timeout-ms", key_timeout_ms, "Give up on a key after this long");
+  int settle_ms = static_cast<int>(options.settle.count());
+  app.add_option("--settle-ms", settle_ms, "Quiet period required between keys");
+  std::filesystem::path out_path;
+  app.add_option("-o,--out", out_path, "Write JSON results here instead of stdout");
+  CLI11_PARSE(app, argc, argv);
+  options.key_timeout = std::chrono::milliseconds(key_timeout_ms);
+  options.settle = std::chrono::milliseconds(settle_ms);
+
+  pdf::MuPDFParser parser(false);
+  if (!parser.load_document(options.pdf)) {
+    std::println(stderr, "Error: failed to load {}", options.pdf.string());
+    return 1;
+  }
+  const int n_pages = std::min(parser.num_pages(), options.max_pages);
+
+  std::vector<std::string> args = {options.pdf.string(), "-j", std::to_string(options.threads)};
+  if (options.use_shm) {
+    args.emplace_back("--shm");
+  }
+  e2e::PtySession session(options.pdvu, std::move(args), options.window);
+  if (!session.started()) {
+    std::println(stderr, "Error: could not start {}", options.pdvu.string());
+    return 1;
+  }
+
+  std::optional<Clock::duration> startup;
+  if (session.wait_for_frame(session.spawned_at() + options.key_timeout)) {
+    startup = *session.terminal().observation().first_new_frame - session.spawned_at();
+  } else {
+    std::println(stderr, "Error: pdvu did not display a frame, is the binary built with Kitty "
+                         "output and the document readable?");
+    return 1;
+  }
+  session.settle(options.settle, Clock::now() + options.key_timeout);
+
+  std::vector<ScenarioResult> results;
+  for (const auto& name : options.scenarios) {
+    std::println(stderr, "running {}", name);
+    const auto keys = name == "flip" ? flip_keys(n_pages) : zoom_keys();
+    results.push_back(run_scenario(session, name, keys, options));
+  }
+  const std::uint64_t load_errors = session.terminal().load_errors();
+  const int exit_code = session.stop();
+  if (exit_code != 0) {
+    std::println(stderr, "Warning: pdvu exited with status {}", exit_code);
+  }
+
+  const std::string json = to_json(options, startup, results, load_errors);
+  if (out_path.empty()) {
+    std::print("{}", json);
+    return 0;
+  }
+  std::ofstream out(out_path, std::ios::trunc);
+  if (!(out << json)) {
+    std::println(stderr, "Error: could not write {}", out_path.string());
+    return 1;
+  }
+  return 0;
+}
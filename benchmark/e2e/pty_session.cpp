@@ -0,0 +1,143 @@
+#include "pty_session.h"
+
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <print>
+
+namespace {
+using namespace std::chrono_literals;
+
+winsize to_winsize(const e2e::WindowSize& size) {
+  return {.ws_row = size.rows,
+          .ws_col = size.columns,
+          .ws_xpixel = size.pixel_width,
+          .ws_ypixel = size.pixel_height};
+}
+
+int exit_code(int status) { return WIFEXITED(status) ? WEXITSTATUS(status) : -1; }
+}  // namespace
+
+namespace e2e {
+PtySession::PtySession(const std::filesystem::path& binary, std::vector<std::string> args,
+                       const WindowSize& size) {
+  winsize ws = to_winsize(size);
+  m_spawned_at = Clock::now();
+  m_pid = forkpty(&m_master, nullptr, nullptr, &ws);
+  if (m_pid == 0) {
+    setenv("TERM", "xterm-kitty", 1);
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(binary.c_str()));
+    for (auto& arg : args) {
+      argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+}
+
+PtySession::~PtySession() {
+  if (m_pid > 0) {
+    stop();
+  }
+  if (m_master != -1) {
+    close(m_master);
+  }
+}
+
+void PtySession::press(std::string_view key) {
+  m_terminal.mark(Clock::now());
+  if (write(m_master, key.data(), key.size()) != static_cast<ssize_t>(key.size())) {
+    std::println(stderr, "Warning: short write to pty");
+  }
+}
+
+void PtySession::resize(const WindowSize& size) {
+  const winsize ws = to_winsize(size);
+  m_terminal.mark(Clock::now());
+  ioctl(m_master, TIOCSWINSZ, &ws);
+}
+
+bool PtySession::wait_for_frame(Clock::time_point deadline) {
+  while (!m_terminal.observation().first_new_frame) {
+    const auto now = Clock::now();
+    if (now >= deadline || !pump(deadline - now)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PtySession::settle(std::chrono::milliseconds quiet, Clock::time_point deadline) {
+  auto last_output = Clock::now();
+  while (Clock::now() - last_output < quiet && Clock::now() < deadline) {
+    if (pump(quiet)) {
+      last_output = Clock::now();
+    }
+  }
+}
+
+bool PtySession::alive() {
+  if (m_pid <= 0) {
+    return false;
+  }
+  int status = 0;
+  if (waitpid(m_pid, &status, WNOHANG) == m_pid) {
+    m_exit_status = exit_code(status);
+    m_pid = -1;
+    return false;
+  }
+  return true;
+}
+
+int PtySession::stop() {
+  if (!alive()) {
+    return m_exit_status;
+  }
+  press("q");
+  int status = 0;
+  const auto deadline = Clock::now() + 2s;
+  while (Clock::now() < deadline) {
+    pump(10ms);  // keep draining so pdvu never blocks on a full pty
+    if (waitpid(m_pid, &status, WNOHANG) == m_pid) {
+      m_pid = -1;
+      m_exit_status = exit_code(status);
+      return m_exit_status;
+    }
+  }
+  kill(m_pid, SIGKILL);
+  waitpid(m_pid, &status, 0);
+  m_pid = -1;
+  m_exit_status = -1;
+  return m_exit_status;
+}
+
+bool PtySession::pump(Clock::duration timeout) {
+  pollfd pfd{.fd = m_master, .events = POLLIN, .revents = 0};
+  const auto ms = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+  if (poll(&pfd, 1, static_cast<int>(std::max<std::int64_t>(ms, 0))) <= 0) {
+    return false;
+  }
+  const ssize_t n = read(m_master, m_buffer.data(), m_buffer.size());
+  if (n <= 0) {
+    return false;  // EIO once pdvu has exited
+  }
+  const auto now = Clock::now();
+  m_output_bytes += static_cast<std::size_t>(n);
+  m_commands.clear();
+  m_parser.feed({m_buffer.data(), static_cast<std::size_t>(n)}, m_commands);
+  for (const auto& command : m_commands) {
+    m_terminal.apply(command, now);
+  }
+  return true;
+}
+}  // namespace e2e
@@ -0,0 +1,82 @@
+#pragma once
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "graphics_protocol.h"
+#include "kitty_stand_in.h"
+
+namespace e2e {
+/**
+ * @brief Terminal geometry reported to pdvu through the pty.
+ */
+struct WindowSize {
+  unsigned short columns = 160;
+  unsigned short rows = 50;
+  unsigned short pixel_width = 1600;
+  unsigned short pixel_height = 1000;
+};
+
+/**
+ * @brief pdvu running on the slave side of a pty, with the stand-in terminal on the master.
+ */
+class PtySession {
+ public:
+  PtySession(const std::filesystem::path& binary, std::vector<std::string> args,
+             const WindowSize& size);
+
+  PtySession(const PtySession&) = delete;
+  PtySession& operator=(const PtySession&) = delete;
+
+  ~PtySession();
+
+  [[nodiscard]] bool started() const { return m_pid > 0; }
+  [[nodiscard]] pid_t pid() const { return m_pid; }
+  [[nodiscard]] Clock::time_point spawned_at() const { return m_spawned_at; }
+  [[nodiscard]] const KittyStandIn& terminal() const { return m_terminal; }
+  [[nodiscard]] std::size_t output_bytes() const { return m_output_bytes; }
+
+  /// Starts a new observation window and writes key to pdvu's input.
+  void press(std::string_view key);
+
+  /// Changes the window size, the kernel delivers SIGWINCH to pdvu.
+  void resize(const WindowSize& size);
+
+  /**
+   * @brief Processes output until a new frame is displayable or the deadline passes.
+   * @return true if a new frame became displayable.
+   */
+  bool wait_for_frame(Clock::time_point deadline);
+
+  /// Processes output until pdvu has been quiet for the settle period.
+  void settle(std::chrono::milliseconds quiet, Clock::time_point deadline);
+
+  /// True while the child has not exited. Reaps it once it has.
+  bool alive();
+
+  /**
+   * @brief Asks pdvu to quit and reaps it, killing it if it does not exit.
+   * @return The exit status, or -1 if it was killed or crashed.
+   */
+  int stop();
+
+ private:
+  /// Waits up to timeout for output and applies it. Returns false on timeout or EOF.
+  bool pump(Clock::duration timeout);
+
+  pid_t m_pid = -1;
+  int m_master = -1;
+  int m_exit_status = -1;
+  Clock::time_point m_spawned_at;
+  std::vector<char> m_buffer = std::vector<char>(1 << 16);
+  GraphicsParser m_parser;
+  std::vector<GraphicsCommand> m_commands;
+  KittyStandIn m_terminal;
+  std::size_t m_output_bytes = 0;
+};
+}  // namespace e2e
@@ -0,0 +1,19 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+
+#include "terminal/kitty_internal.h"
+
+void BM_Base64Encode(benchmark::State& state) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  std::string input(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    input[i] = static_cast<char>(i * 31);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kitty::detail::base64_encode(input));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64Encode)->Arg(64)->Arg(1 << 10)->Arg(64 << 10)->Arg(1 << 20);
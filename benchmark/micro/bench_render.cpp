@@ -0,0 +1,199 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "render/bounds.h"
+#include "render/page_specs.h"
+#include "render/parser.h"
+#include "render/parallelism.h"
+#include "render/pdf_constants.h"
+#include "render/threadpool.h"
+
+namespace {
+constexpr std::string_view g_fixtures_dir = PDVU_BENCH_FIXTURES_DIR;
+
+auto pdf_file_path(std::string_view filename) {
+  return std::filesystem::path(g_fixtures_dir) / "pdf" / filename;
+}
+
+pdf::PageSpecs make_page_specs(int width, int height) {
+  return pdf::PageSpecs{
+      .base_x0 = 0.0F,
+      .base_y0 = 0.0F,
+      .base_x1 = static_cast<float>(width),
+      .base_y1 = static_cast<float>(height),
+      .x0 = 0,
+      .y0 = 0,
+      .x1 = width,
+      .y1 = height,
+      .width = width,
+      .height = height,
+      .size = static_cast<std::size_t>(width * height * pdf::g_pad),
+      .acc_width = static_cast<float>(width),
+      .acc_height = static_cast<float>(height),
+      .rotation = 0,
+  };
+}
+}  // namespace
+
+// strip count per page render
+void BM_SplitBounds(benchmark::State& state) {
+  const auto specs = make_page_specs(1700, 2200);
+  const auto n = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pdf::split_bounds(specs, n));
+  }
+}
+BENCHMARK(BM_SplitBounds)->RangeMultiplier(2)->Range(1, 16);
+
+void BM_PageSpecsScale(benchmark::State& state) {
+  const auto specs = make_page_specs(612, 792);
+  float zoom = 1.0F;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(specs.scale(zoom));
+    zoom = zoom < 3.0F ? zoom + 0.01F : 0.5F;
+  }
+}
+BENCHMARK(BM_PageSpecsScale);
+
+void BM_PageSpecsRotate(benchmark::State& state) {
+  const auto specs = make_page_specs(612, 792);
+  int quarter_turns = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(specs.rotate_quarter_clockwise(quarter_turns));
+    quarter_turns = (quarter_turns + 1) % 4;
+  }
+}
+BENCHMARK(BM_PageSpecsRotate);
+
+// submit a no-op and wait for it, i.e. queue, wake-up and future overhead
+void BM_ThreadPoolSubmitRoundTrip(benchmark::State& state) {
+  ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    pool.submit([] { return 1; }).get();
+  }
+}
+BENCHMARK(BM_ThreadPoolSubmitRoundTrip)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// one batch of range(1) tasks, the pattern used to render a page in strips
+void BM_ThreadPoolSubmitBatch(benchmark::State& state) {
+  ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  const auto batch = static_cast<std::size_t>(state.range(1));
+  std::vector<std::future<void>> futures;
+  futures.reserve(batch);
+  for (auto _ : state) {
+    futures.clear();
+    for (std::size_t i = 0; i < batch; i++) {
+      futures.push_back(pool.submit([] {}));
+    }
+    for (auto& f : futures) {
+      f.get();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_ThreadPoolSubmitBatch)->ArgsProduct({{1, 4}, {4, 16}})->UseRealTime();
+
+// the same batch through parallel_for: one lock, one wake-up, caller runs an index
+void BM_ThreadPoolParallelFor(benchmark::State& state) {
+  ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  const auto batch = static_cast<std::size_t>(state.range(1));
+  for (auto _ : state) {
+    pool.parallel_for(batch, [](std::size_t i) { benchmark::DoNotOptimize(i); });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_ThreadPoolParallelFor)->ArgsProduct({{1, 4}, {4, 16}})->UseRealTime();
+
+// full-page raster of a fixture page at range(1) percent zoom, display list prebuilt
+void BM_WriteSection(benchmark::State& state, std::string_view fixture) {
+  pdf::MuPDFParser parser(false);
+  if (!parser.load_document(pdf_file_path(fixture))) {
+    state.SkipWithError("failed to load fixture");
+    return;
+  }
+  const auto base = parser.page_specs(0);
+  auto dlist = parser.get_display_list(0);
+  if (!base || !dlist) {
+    state.SkipWithError("failed to prepare page 0");
+    return;
+  }
+  const float zoom = static_cast<float>(state.range(0)) / 100.0F;
+  const auto ps = base->scale(zoom);
+  std::vector<unsigned char> buffer(ps.size);
+  const pdf::Rect clip{
+      .x0 = static_cast<float>(ps.x0),
+      .y0 = static_cast<float>(ps.y0),
+      .x1 = static_cast<float>(ps.x1),
+      .y1 = static_cast<float>(ps.y1),
+  };
+  for (auto _ : state) {
+    parser.write_section(ps.width, ps.height, zoom, ps, *dlist, buffer.data(), clip);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(ps.size));
+}
+BENCHMARK_CAPTURE(BM_WriteSection, single_page, "single_page.pdf")->Arg(100)->Arg(400);
+BENCHMARK_CAPTURE(BM_WriteSection, multi_page, "multi_page.pdf")->Arg(100)->Arg(400);
+BENCHMARK_CAPTURE(BM_WriteSection, rotated_page, "rotated_page.pdf")->Arg(100)->Arg(400);
+
+// one page split into range(1) strips on a pool, the speedup curve strip tuning works from;
+// the "picked" counter is what StripTuner chooses for the page after measuring it
+void BM_StripSpeedup(benchmark::State& state, std::string_view fixture) {
+  pdf::MuPDFParser parser(false);
+  if (!parser.load_document(pdf_file_path(fixture))) {
+    state.SkipWithError("failed to load fixture");
+    return;
+  }
+  const auto base = parser.page_specs(0);
+  auto dlist = parser.get_display_list(0);
+  if (!base || !dlist) {
+    state.SkipWithError("failed to prepare page 0");
+    return;
+  }
+  const float zoom = static_cast<float>(state.range(0)) / 100.0F;
+  const auto ps = base->scale(zoom);
+  const auto bounds = pdf::split_bounds(ps, static_cast<int>(state.range(1)));
+  std::vector<std::unique_ptr<pdf::Parser>> workers;
+  for (std::size_t i = 0; i < bounds.size(); i++) {
+    workers.push_back(parser.duplicate());
+  }
+  ThreadPool pool(bounds.size());
+  std::vector<unsigned char> buffer(ps.size);
+  const std::size_t pixels =
+      static_cast<std::size_t>(ps.width) * static_cast<std::size_t>(ps.height);
+  parallelism::StripTuner tuner(parallelism::available_cpus());
+  for (auto _ : state) {
+    std::atomic<std::int64_t> work_ns = 0;
+    pool.parallel_for(bounds.size(), [&](std::size_t i) {
+      const auto start = std::chrono::steady_clock::now();
+      workers[i]->write_section(bounds[i].width,
+                                bounds[i].height,
+                                zoom,
+                                ps,
+                                *dlist,
+                                buffer.data() + bounds[i].offset,
+                                bounds[i].rect);
+      work_ns.fetch_add((std::chrono::steady_clock::now() - start).count());
+    });
+    tuner.record(0, pixels, std::chrono::nanoseconds(work_ns.load()));
+    benchmark::ClobberMemory();
+  }
+  state.counters["picked"] = tuner.choose(0, pixels, parallelism::available_cpus());
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(ps.size));
+}
+BENCHMARK_CAPTURE(BM_StripSpeedup, single_page, "single_page.pdf")
+    ->ArgsProduct({{100, 400}, {1, 2, 4, 8}})
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_StripSpeedup, multi_page, "multi_page.pdf")
+    ->ArgsProduct({{100, 400}, {1, 2, 4, 8}})
+    ->UseRealTime();
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+
+#include "utils/lru_cache.h"
+#include "utils/shm.h"
+#include "utils/tempfile.h"
+
+namespace {
+using Cache = LRUCache<int, std::string>;
+
+/// Fills the cache with keys 0 to size - 1, leaving size - 1 most recently used.
+void fill(Cache& cache, int size) {
+  for (int i = 0; i < size; i++) {
+    cache.put(i, std::string(32, 'x'));
+  }
+}
+}  // namespace
+
+// hit on the most recently used entry, no reordering needed
+void BM_LRUCacheGetFront(benchmark::State& state) {
+  const auto size = static_cast<int>(state.range(0));
+  Cache cache(static_cast<std::size_t>(size));
+  fill(cache, size);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.get(size - 1));
+  }
+}
+BENCHMARK(BM_LRUCacheGetFront)->Arg(4)->Arg(10)->Arg(32)->Arg(128);
+
+// hit on the least recently used entry, the worst case linear scan and rotate
+void BM_LRUCacheGetBack(benchmark::State& state) {
+  const auto size = static_cast<int>(state.range(0));
+  Cache cache(static_cast<std::size_t>(size));
+  fill(cache, size);
+  int key = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.get(key));
+    key = (key + 1) % size;  // the key just after is now the oldest
+  }
+}
+BENCHMARK(BM_LRUCacheGetBack)->Arg(4)->Arg(10)->Arg(32)->Arg(128);
+
+void BM_LRUCacheMiss(benchmark::State& state) {
+  const auto size = static_cast<int>(state.range(0));
+  Cache cache(static_cast<std::size_t>(size));
+  fill(cache, size);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.get(-1));
+  }
+}
+BENCHMARK(BM_LRUCacheMiss)->Arg(4)->Arg(10)->Arg(32)->Arg(128);
+
+// insert a new key into a full cache, evicting the oldest entry
+void BM_LRUCachePutEvict(benchmark::State& state) {
+  const auto size = static_cast<int>(state.range(0));
+  Cache cache(static_cast<std::size_t>(size));
+  fill(cache, size);
+  int key = size;
+  for (auto _ : state) {
+    cache.put(key++, std::string(32, 'y'));
+  }
+}
+BENCHMARK(BM_LRUCachePutEvict)->Arg(4)->Arg(10)->Arg(32)->Arg(128);
+
+// create, size and map a frame buffer, then unmap and unlink on destruction
+void BM_SharedMemoryLifecycle(benchmark::State& state) {
+  if (!Shm::is_shm_supported()) {
+    state.SkipWithError("POSIX shared memory not supported");
+    return;
+  }
+  const auto size = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    SharedMemory shm(size);
+    benchmark::DoNotOptimize(shm);
+  }
+}
+BENCHMARK(BM_SharedMemoryLifecycle)->Arg(1 << 20)->Arg(8 << 20)->Arg(32 << 20);
+
+void BM_TempfileLifecycle(benchmark::State& state) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    Tempfile file(size);
+    benchmark::DoNotOptimize(file);
+  }
+}
+BENCHMARK(BM_TempfileLifecycle)->Arg(1 << 20)->Arg(8 << 20)->Arg(32 << 20);
@@ -0,0 +1,345 @@
+// Headless render benchmark. Drives RenderEngine directly with scripted
+// workloads and reports latency, throughput and memory as JSON, so it can run
+// on a machine without a terminal or display.
+#include <CLI11.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "render/parallelism.h"
+#include "render/parser.h"
+#include "render/render_engine.h"
+#include "utils/metrics.h"
+#include "utils/ram_usage.h"
+#include "workloads.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct RunConfig {
+  int n_threads;
+  bool use_cache;
+  WorkerContexts contexts;
+  StripPolicy strips;
+  std::string transmission;
+  std::chrono::milliseconds frame_timeout;
+};
+
+struct RunResult {
+  std::string workload;
+  RunConfig config;
+  metrics::HistogramSummary latency;
+  std::uint64_t frames = 0;      ///< Awaited frames that completed successfully
+  std::uint64_t superseded = 0;  ///< Results for requests replaced before completion
+  std::uint64_t errors = 0;
+  double wall_seconds = 0;
+  std::size_t peak_rss_bytes = 0;  ///< Largest RSS sampled after each frame
+  std::uint64_t lock_acquisitions = 0;  ///< MuPDF lock acquisitions during the run
+  std::uint64_t lock_contended = 0;
+  double lock_wait_ms = 0;
+  double mean_strips = 0;      ///< Strips per rendered page, showing what auto tuning picked
+  double first_frame_ms = -1;  ///< Engine construction to the first frame, -1 if none
+};
+
+/// Sums the statistics of every shared MuPDF lock.
+pdf::LockStats total_lock_stats() {
+  pdf::LockStats total{.name = "total"};
+  for (const auto& lock : pdf::mupdf_lock_stats()) {
+    total.acquisitions += lock.acquisitions;
+    total.contended += lock.contended;
+    total.wait += lock.wait;
+  }
+  return total;
+}
+
+float fit_zoom(const pdf::PageSpecs& specs, const bench::Viewport& viewport) {
+  const float h_scale = static_cast<float>(viewport.width) / specs.acc_width;
+  const float v_scale = static_cast<float>(viewport.height) / specs.acc_height;
+  return std::min(h_scale, v_scale);
+}
+
+/**
+ * @brief Polls the engine until the result for req_id arrives.
+ * @return The matching result, or std::nullopt on timeout.
+ */
+std::optional<RenderResult> wait_for(RenderEngine& engine, std::size_t req_id,
+                                     std::chrono::milliseconds timeout, RunResult& run) {
+  constexpr auto poll_interval = std::chrono::microseconds(20);
+  const auto deadline = Clock::now() + timeout;
+  while (Clock::now() < deadline) {
+    if (auto result = engine.get_result()) {
+      if (result->req_id == req_id) {
+        return result;
+      }
+      run.superseded++;
+      continue;
+    }
+    std::this_thread::sleep_for(poll_interval);
+  }
+  return std::nullopt;
+}
+
+RunResult run_workload(const pdf::Parser& parser, const bench::Workload& workload,
+                       const RunConfig& config) {
+  RunResult run{.workload = workload.name, .config = config, .latency = {}};
+  metrics::LatencyHistogram latency;
+  const pdf::LockStats locks_before = total_lock_stats();
+  auto& strips = metrics::registry().counter("render.parallelism.strips");
+  auto& strip_requests = metrics::registry().counter("render.parallelism.requests");
+  const std::uint64_t strips_before = strips.value();
+  const std::uint64_t strip_requests_before = strip_requests.value();
+  const auto construction_start = Clock::now();
+  RenderEngine engine(parser, config.n_threads, config.use_cache, config.contexts, config.strips);
+
+  std::optional<Clock::time_point> burst_start;
+  const auto start = Clock::now();
+  for (const auto& step : workload.steps) {
+    const auto specs = parser.page_specs(step.page_num);
+    if (!specs) {
+      run.errors++;
+      continue;
+    }
+    const float zoom = fit_zoom(*specs, step.viewport) * step.zoom;
+    const auto request_time = Clock::now();
+    if (!burst_start) {
+      burst_start = request_time;
+    }
+    const std::size_t req_id =
+        engine.request_page(step.page_num, zoom, specs->scale(zoom), config.transmission);
+    if (!step.await) {
+      continue;
+    }
+
+    const auto result = wait_for(engine, req_id, config.frame_timeout, run);
+    if (!result || !result->error_message.empty()) {
+      run.errors++;
+    } else {
+      const auto now = Clock::now();
+      latency.record(now - *burst_start);
+      if (run.frames == 0) {
+        run.first_frame_ms =
+            std::chrono::duration<double, std::milli>(now - construction_start).count();
+      }
+      run.frames++;
+    }
+    burst_start.reset();
+    run.peak_rss_bytes = std::max(run.peak_rss_bytes, ram_usage::getCurrentRSS());
+  }
+  run.wall_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  run.latency = latency.summary();
+  const pdf::LockStats locks_after = total_lock_stats();
+  run.lock_acquisitions = locks_after.acquisitions - locks_before.acquisitions;
+  run.lock_contended = locks_after.contended - locks_before.contended;
+  run.lock_wait_ms =
+      std::chrono::duration<double, std::milli>(locks_after.wait - locks_before.wait).count();
+  if (const auto rendered = strip_requests.value() - strip_requests_before; rendered > 0) {
+    run.mean_strips =
+        static_cast<double>(strips.value() - strips_before) / static_cast<double>(rendered);
+  }
+  return run;
+}
+
+std::string json_escape(std::string_view s) {
+  std::string out;
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  return out;
+}
+
+std::string to_json(const std::string& document, int n_pages, const bench::Viewport& viewport,
+                    std::string_view allocator, std::string_view input,
+                    const std::vector<RunResult>& runs) {
+  std::string json = std::format(
+      "{{\n  \"document\": \"{}\",\n  \"pages\": {},\n  \"allocator\": \"{}\",\n  "
+      "\"input\": \"{}\",\n  "
+      "\"viewport\": {{\"width\": {}, \"height\": {}}},\n  \"runs\": [",
+      json_escape(document),
+      n_pages,
+      allocator,
+      input,
+      viewport.width,
+      viewport.height);
+  std::string_view separator;
+  for (const auto& run : runs) {
+    const double pages_per_second =
+        run.wall_seconds > 0 ? static_cast<double>(run.frames) / run.wall_seconds : 0.0;
+    json += std::format(
+        "{}\n    {{\"workload\": \"{}\", \"threads\": {}, \"cache\": {}, \"contexts\": \"{}\", "
+        "\"strips\": \"{}\", \"mean_strips\": {:.2f}, \"transmission\": \"{}\", "
+        "\"first_frame_ms\": {:.3f}, \"frames\": {}, "
+        "\"superseded\": {}, \"errors\": {}, "
+        "\"wall_s\": {:.3f}, \"pages_per_s\": {:.2f}, \"p50_ms\": {:.3f}, \"p95_ms\": {:.3f}, "
+        "\"p99_ms\": {:.3f}, \"max_ms\": {:.3f}, \"peak_rss_bytes\": {}, "
+        "\"lock_acquisitions\": {}, \"lock_contended\": {}, \"lock_wait_ms\": {:.3f}}}",
+        separator,
+        run.workload,
+        run.config.n_threads,
+        run.config.use_cache,
+        run.config.contexts == WorkerContexts::Independent ? "independent" : "cloned",
+        run.config.strips == StripPolicy::Auto ? "auto" : "fixed",
+        run.mean_strips,
+        run.config.transmission,
+        run.first_frame_ms,
+        run.frames,
+        run.superseded,
+        run.errors,
+        run.wall_seconds,
+        pages_per_second,
+        run.latency.p50_us / 1000.0,
+        run.latency.p95_us / 1000.0,
+        run.latency.p99_us / 1000.0,
+        run.latency.max_us / 1000.0,
+        run.peak_rss_bytes,
+        run.lock_acquisitions,
+        run.lock_contended,
+        run.lock_wait_ms);
+    separator = ",";
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  CLI::App app("pdvu_bench: headless render benchmark");
+
+  std::filesystem::path pdf_path;
+  app.add_option("pdf", pdf_path, "PDF to render")->required()->check(CLI::ExistingFile);
+
+  std::vector<int> thread_counts = {1};
+  app.add_option("-j,--threads", thread_counts, "Worker thread counts to compare, e.g. 1,2,4")
+      ->delimiter(',');
+
+  std::vector<std::string> cache_modes = {"on", "off"};
+  app.add_option("--cache", cache_modes, "Cache configurations to compare: on, off")
+      ->delimiter(',')
+      ->check(CLI::IsMember({"on", "off"}));
+
+  std::vector<std::string> context_modes = {"cloned"};
+  app.add_option("--contexts",
+                 context_modes,
+                 "Worker MuPDF contexts to compare: cloned (shared locks), independent")
+      ->delimiter(',')
+      ->check(CLI::IsMember({"cloned", "independent"}));
+
+  std::vector<std::string> strip_modes = {"auto"};
+  app.add_option("--strips",
+                 strip_modes,
+                 "Strip policies to compare: auto (per page cost), fixed (one per thread)")
+      ->delimiter(',')
+      ->check(CLI::IsMember({"auto", "fixed"}));
+
+  std::string allocator = "arena";
+  app.add_option("--allocator", allocator, "MuPDF allocator: arena (size classes), system")
+      ->check(CLI::IsMember({"arena", "system"}));
+
+  std::string input = "file";
+  app.add_option("--input", input, "Document input: file (opened per parser), mmap (shared)")
+      ->check(CLI::IsMember({"file", "mmap"}));
+
+  std::vector<std::string> workload_names(std::begin(bench::WORKLOAD_NAMES),
+                                          std::end(bench::WORKLOAD_NAMES));
+  app.add_option("-w,--workloads", workload_names, "Workloads to run")->delimiter(',');
+
+  bench::WorkloadParams params{.n_pages = 0};
+  app.add_option("--width", params.viewport.width, "Viewport width in pixels");
+  app.add_option("--height", params.viewport.height, "Viewport height in pixels");
+  app.add_option("--max-pages", params.max_pages, "Pages visited by sequential_flip");
+  app.add_option("--jumps", params.n_jumps, "Requests issued by random_jump");
+  app.add_option("--seed", params.seed, "Seed for random_jump");
+
+  bool use_shm = false;
+  app.add_flag("--shm", use_shm, "Write frames to POSIX shared memory instead of temp files");
+
+  bool enable_icc = false;
+  app.add_flag("--ICC", enable_icc, "Enable ICC colour management");
+
+  int timeout_ms = 30'000;
+  app.add_option("--timeout-ms", timeout_ms, "Give up on a frame after this long");
+
+  std::filesystem::path out_path;
+  app.add_option("-o,--out", out_path, "Write JSON results here instead of stdout");
+
+  CLI11_PARSE(app, argc, argv);
+
+  pdf::set_mupdf_allocator(allocator == "system" ? pdf::MuPDFAllocator::System
+                                                 : pdf::MuPDFAllocator::SizeClassArena);
+  pdf::MuPDFParser parser(
+      enable_icc, input == "mmap" ? pdf::DocumentInput::MemoryMap : pdf::DocumentInput::File);
+  if (!parser.load_document(pdf_path)) {
+    std::println(stderr, "Error: failed to load {}", pdf_path.string());
+    return 1;
+  }
+  params.n_pages = parser.num_pages();
+
+  std::vector<bench::Workload> workloads;
+  for (const auto& name : workload_names) {
+    auto workload = bench::make_workload(name, params);
+    if (!workload) {
+      std::println(stderr, "Error: unknown workload '{}'", name);
+      return 1;
+    }
+    workloads.push_back(std::move(*workload));
+  }
+
+  const int max_threads = parallelism::available_cpus();
+  std::vector<RunConfig> configs;
+  for (const int requested_threads : thread_counts) {
+    for (const auto& cache_mode : cache_modes) {
+      for (const auto& context_mode : context_modes) {
+        for (const auto& strip_mode : strip_modes) {
+          configs.push_back({
+              .n_threads = std::clamp(requested_threads, 1, max_threads),
+              .use_cache = cache_mode == "on",
+              .contexts = context_mode == "independent" ? WorkerContexts::Independent
+                                                        : WorkerContexts::Cloned,
+              .strips = strip_mode == "fixed" ? StripPolicy::Fixed : StripPolicy::Auto,
+              .transmission = use_shm ? "shm" : "tempfile",
+              .frame_timeout = std::chrono::milliseconds(timeout_ms),
+          });
+        }
+      }
+    }
+  }
+
+  std::vector<RunResult> runs;
+  for (const auto& config : configs) {
+    for (const auto& workload : workloads) {
+      std::println(stderr,
+                   "running {} (threads={}, cache={}, contexts={}, strips={})",
+                   workload.name,
+                   config.n_threads,
+                   config.use_cache ? "on" : "off",
+                   config.contexts == WorkerContexts::Independent ? "independent" : "cloned",
+                   config.strips == StripPolicy::Auto ? "auto" : "fixed");
+      runs.push_back(run_workload(parser, workload, config));
+    }
+  }
+
+  const std::string json = to_json(
+      parser.get_document_name(), params.n_pages, params.viewport, allocator, input, runs);
+  if (out_path.empty()) {
+    std::print("{}", json);
+    return 0;
+  }
+  std::ofstream out(out_path, std::ios::trunc);
+  if (!(out << json)) {
+    std::println(stderr, "Error: could not write {}", out_path.string());
+    return 1;
+  }
+  return 0;
+}
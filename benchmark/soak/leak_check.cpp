@@ -0,0 +1,68 @@
+#include "leak_check.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <span>
+
+namespace {
+constexpr std::size_t WINDOWS = 4;
+constexpr std::size_t MIN_JUDGED_SAMPLES = 4 * WINDOWS;
+
+double slope(std::span<const double> values) {
+  const auto n = static_cast<double>(values.size());
+  double sum_x = 0;
+  double sum_y = 0;
+  double sum_xy = 0;
+  double sum_xx = 0;
+  for (std::size_t i = 0; i < values.size(); i++) {
+    const auto x = static_cast<double>(i);
+    sum_x += x;
+    sum_y += values[i];
+    sum_xy += x * values[i];
+    sum_xx += x * x;
+  }
+  const double denominator = (n * sum_xx) - (sum_x * sum_x);
+  return denominator == 0 ? 0 : ((n * sum_xy) - (sum_x * sum_y)) / denominator;
+}
+}  // namespace
+
+namespace soak {
+GrowthReport check_growth(std::span<const double> values, double interval_s,
+                          const GrowthTolerance& tolerance) {
+  GrowthReport report;
+  const std::span<const double> judged = values.subspan(values.size() / 4);
+  if (judged.size() < MIN_JUDGED_SAMPLES) {
+    report.reason = std::format("too few samples ({})", values.size());
+    return report;
+  }
+  report.slope_per_hour = slope(judged) * (3600.0 / interval_s);
+
+  const std::size_t window = judged.size() / WINDOWS;
+  double previous_peak = 0;
+  bool never_falls = true;
+  for (std::size_t w = 0; w < WINDOWS; w++) {
+    // the last window takes the remainder
+    const std::size_t count = w + 1 == WINDOWS ? judged.size() - (w * window) : window;
+    const double peak = std::ranges::max(judged.subspan(w * window, count));
+    if (w == 0) {
+      report.plateau = peak;
+    } else if (peak < previous_peak) {
+      never_falls = false;
+    }
+    previous_peak = peak;
+  }
+  report.final_peak = previous_peak;
+
+  const double allowed =
+      report.plateau + tolerance.absolute + (tolerance.relative * report.plateau);
+  report.unbounded = never_falls && report.final_peak > allowed;
+  report.reason = report.unbounded
+                      ? std::format("peak rose from {:.0f} to {:.0f}, allowed {:.0f}",
+                                    report.plateau,
+                                    report.final_peak,
+                                    allowed)
+                      : "bounded";
+  return report;
+}
+}  // namespace soak
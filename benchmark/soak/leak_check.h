@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+
+namespace soak {
+/**
+ * @brief How much a series may grow before it counts as unbounded.
+ */
+struct GrowthTolerance {
+  double absolute = 0;  ///< Allowed growth in the series' own unit
+  double relative = 0;  ///< Allowed growth as a fraction of the early plateau
+};
+
+/**
+ * @brief Verdict for one sampled series.
+ */
+struct GrowthReport {
+  bool unbounded = false;
+  double plateau = 0;         ///< Peak of the first window after warm-up
+  double final_peak = 0;      ///< Peak of the last window
+  double slope_per_hour = 0;  ///< Least squares trend after warm-up
+  std::string reason;         ///< Why the series was flagged or not judged
+};
+
+/**
+ * @brief Decides whether a resource grows without bound.
+ *
+ * Caches make memory saw-tooth, so individual samples are not compared.
+ * After discarding the first quarter as warm-up, the rest is split into four
+ * windows and the peak of each is taken. The series is flagged when the peaks
+ * never fall and the last exceeds the first by more than the tolerance; a
+ * bounded cache reaches its peak early and then stays there.
+ *
+ * @param values Samples in time order.
+ * @param interval_s Seconds between samples, used for the reported slope.
+ */
+GrowthReport check_growth(std::span<const double> values, double interval_s,
+                          const GrowthTolerance& tolerance);
+}  // namespace soak
@@ -0,0 +1,363 @@
+// Soak harness. Drives RenderEngine in-process and the pdvu viewer on a pty
+// through long runs of randomized navigation, zoom, rotation and resizes while
+// sampling memory, file descriptors and transmission buffers. Exits non-zero if
+// any sampled resource keeps growing.
+#include <CLI11.hpp>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "leak_check.h"
+#include "process_stats.h"
+#include "pty_session.h"
+#include "render/parser.h"
+#include "render/render_engine.h"
+#include "viewer/pageview.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr double MIB = 1024.0 * 1024.0;
+
+struct Options {
+  std::filesystem::path pdf;
+  std::filesystem::path pdvu = PDVU_BINARY_PATH;
+  std::string mode = "both";
+  std::uint64_t ops = 1'000'000;
+  std::chrono::seconds duration{0};  ///< Per mode, 0 runs until ops are done
+  std::chrono::milliseconds sample_interval{1'000};
+  std::uint32_t seed = 1;
+  int threads = 2;
+  bool use_shm = false;
+  std::chrono::milliseconds frame_timeout{50};  ///< Viewer: wait per key before the next
+};
+
+/**
+ * @brief One column of sampled values and how much it may grow.
+ */
+struct Series {
+  std::string name;
+  soak::GrowthTolerance tolerance;
+  std::vector<double> values;
+};
+
+/**
+ * @brief Periodic sampler shared by both modes.
+ */
+class Sampler {
+ public:
+  Sampler(std::chrono::milliseconds interval, bool with_mupdf) : m_interval(interval) {
+    m_series.push_back({.name = "pss_mib", .tolerance = {16, 0.10}, .values = {}});
+    m_series.push_back({.name = "open_fds", .tolerance = {4, 0}, .values = {}});
+    m_series.push_back({.name = "shm_entries", .tolerance = {2, 0}, .values = {}});
+    m_series.push_back({.name = "tempfile_mappings", .tolerance = {2, 0}, .values = {}});
+    if (with_mupdf) {
+      m_series.push_back({.name = "mupdf_heap_mib", .tolerance = {16, 0.10}, .values = {}});
+    }
+  }
+
+  /// Takes a sample if the interval has elapsed, or unconditionally with force.
+  void maybe_sample(pid_t pid, std::uint64_t ops, bool force = false) {
+    const auto now = Clock::now();
+    if (now < m_next && !force) {
+      return;
+    }
+    m_next = now + m_interval;
+    const soak::ProcessSample sample = soak::sample_process(pid);
+    const std::array<double, 5> row = {
+        static_cast<double>(sample.pss_bytes) / MIB,
+        static_cast<double>(sample.open_fds),
+        static_cast<double>(sample.shm_entries),
+        static_cast<double>(sample.tempfile_mappings),
+        static_cast<double>(pdf::mupdf_allocated_bytes()) / MIB,
+    };
+    for (std::size_t i = 0; i < m_series.size(); i++) {
+      m_series[i].values.push_back(row[i]);
+    }
+    m_ops.push_back(ops);
+  }
+
+  [[nodiscard]] const std::vector<Series>& series() const { return m_series; }
+  [[nodiscard]] const std::vector<std::uint64_t>& ops() const { return m_ops; }
+  [[nodiscard]] double interval_s() const {
+    return std::chrono::duration<double>(m_interval).count();
+  }
+
+ private:
+  std::chrono::milliseconds m_interval;
+  Clock::time_point m_next{};
+  std::vector<Series> m_series;
+  std::vector<std::uint64_t> m_ops;  ///< Operations completed at each sample
+};
+
+struct ModeResult {
+  std::string mode;
+  std::uint64_t ops = 0;
+  std::uint64_t errors = 0;
+  double wall_seconds = 0;
+  std::vector<Series> series;
+  std::vector<std::uint64_t> sample_ops;
+  double interval_s = 1;
+};
+
+bool out_of_time(const Options& options, Clock::time_point start) {
+  return options.duration.count() > 0 && Clock::now() - start >= options.duration;
+}
+
+/**
+ * @brief Random walk over viewer state: page, zoom level, rotation and viewport.
+ */
+struct NavigationState {
+  int page = 0;
+  int zoom_index = PageView::m_default_zoom_index;
+  int rotation = 0;
+  int width = 1600;
+  int height = 1000;
+};
+
+ModeResult soak_engine(const pdf::Parser& parser, const Options& options) {
+  ModeResult result;
+  result.mode = "engine";
+  Sampler sampler(options.sample_interval, true);
+  std::mt19937 rng(options.seed);
+  std::uniform_int_distribution<int> op_dist(0, 99);
+  const int n_pages = parser.num_pages();
+  const int n_levels = static_cast<int>(PageView::m_zoom_levels.size());
+  NavigationState state;
+
+  auto engine = std::make_unique<RenderEngine>(parser, options.threads, true);
+  const auto start = Clock::now();
+  while (result.ops < options.ops && !out_of_time(options, start)) {
+    const int op = op_dist(rng);
+    if (op < 40) {
+      state.page = std::uniform_int_distribution<int>(0, n_pages - 1)(rng);
+    } else if (op < 65) {
+      state.zoom_index = std::clamp(state.zoom_index + (op % 2 == 0 ? 1 : -1), 0, n_levels - 1);
+    } else if (op < 75) {
+      state.rotation = (state.rotation + 90) % 360;
+    } else if (op < 95) {
+      state.width = std::uniform_int_distribution<int>(400, 3000)(rng);
+      state.height = std::uniform_int_distribution<int>(300, 2000)(rng);
+    } else {
+      // engine restarts exercise worker, cache and transmission teardown
+      engine.reset();
+      engine = std::make_unique<RenderEngine>(parser, options.threads, op % 2 == 0);
+    }
+
+    const auto specs = parser.page_specs(state.page);
+    if (!specs) {
+      result.errors++;
+      continue;
+    }
+    const auto rotated = specs->rotate_quarter_clockwise(state.rotation / 90);
+    const float fit = std::min(static_cast<float>(state.width) / rotated.acc_width,
+                               static_cast<float>(state.height) / rotated.acc_height);
+    const float zoom = fit * PageView::m_zoom_levels[static_cast<std::size_t>(state.zoom_index)];
+    const bool use_shm = options.use_shm && op % 3 != 0;
+    const std::size_t req_id =
+        engine->request_page(state.page, zoom, rotated.scale(zoom), use_shm ? "shm" : "tempfile");
+
+    // mostly await like a user waiting for the page, sometimes supersede like key repeat
+    const bool await = op % 4 != 0;
+    const auto deadline = Clock::now() + std::chrono::seconds(30);
+    while (await && Clock::now() < deadline) {
+      if (const auto frame = engine->get_result()) {
+        if (!frame->error_message.empty()) {
+          result.errors++;
+        }
+        if (frame->req_id == req_id) {
+          break;
+        }
+        continue;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    result.ops++;
+    sampler.maybe_sample(getpid(), result.ops);
+  }
+  engine.reset();
+  sampler.maybe_sample(getpid(), result.ops, true);
+  result.wall_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.series = sampler.series();
+  result.sample_ops = sampler.ops();
+  result.interval_s = sampler.interval_s();
+  return result;
+}
+
+ModeResult soak_viewer(const Options& options) {
+  static constexpr std::array<std::string_view, 11> keys = {
+      "\x1b[C", "\x1b[D", "=", "-", "r", "w", "a", "s", "d", "z", "\x1b[C"};
+  ModeResult result;
+  result.mode = "viewer";
+  Sampler sampler(options.sample_interval, false);
+  std::mt19937 rng(options.seed);
+  std::uniform_int_distribution<std::size_t> key_dist(0, keys.size() * 10 - 1);
+
+  std::vector<std::string> args = {options.pdf.string(), "-j", std::to_string(options.threads)};
+  if (options.use_shm) {
+    args.emplace_back("--shm");
+  }
+  e2e::PtySession session(options.pdvu, std::move(args), {});
+  if (!session.started() || !session.wait_for_frame(Clock::now() + std::chrono::seconds(10))) {
+    std::println(stderr, "Error: pdvu did not display its first frame");
+    result.errors++;
+    return result;
+  }
+
+  const auto start = Clock::now();
+  while (result.ops < options.ops && !out_of_time(options, start)) {
+    if (!session.alive()) {
+      std::println(stderr, "Error: pdvu exited during the soak");
+      result.errors++;
+      break;
+    }
+    const std::size_t pick = key_dist(rng);
+    if (pick < keys.size()) {
+      // roughly one op in eleven is a resize, bursts of them like a dragged window
+      session.resize({
+          .columns = static_cast<unsigned short>(80 + (pick * 13)),
+          .rows = static_cast<unsigned short>(30 + (pick * 3)),
+          .pixel_width = static_cast<unsigned short>(800 + (pick * 130)),
+          .pixel_height = static_cast<unsigned short>(600 + (pick * 60)),
+      });
+    } else {
+      session.press(keys[pick % keys.size()]);
+    }
+    session.wait_for_frame(Clock::now() + options.frame_timeout);
+    result.ops++;
+    sampler.maybe_sample(session.pid(), result.ops);
+  }
+  if (session.stop() != 0) {
+    result.errors++;
+  }
+  result.wall_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.series = sampler.series();
+  result.sample_ops = sampler.ops();
+  result.interval_s = sampler.interval_s();
+  return result;
+}
+
+/// Writes every sample as CSV: mode, ops, then one column per series.
+bool write_samples(const std::filesystem::path& path, const std::vector<ModeResult>& results) {
+  std::ofstream out(path, std::ios::trunc);
+  for (const auto& result : results) {
+    out << "mode,ops";
+    for (const auto& series : result.series) {
+      out << ',' << series.name;
+    }
+    out << '\n';
+    for (std::size_t i = 0; i < result.sample_ops.size(); i++) {
+      out << result.mode << ',' << result.sample_ops[i];
+      for (const auto& series : result.series) {
+        out << std::format(",{:.3f}", series.values[i]);
+      }
+      out << '\n';
+    }
+  }
+  return static_cast<bool>(out);
+}
+
+/// Prints the verdicts as JSON and returns true if nothing grew without bound.
+bool report(const std::vector<ModeResult>& results) {
+  bool bounded = true;
+  std::string json = "{\n  \"modes\": [";
+  std::string_view mode_separator;
+  for (const auto& result : results) {
+    json += std::format(
+        "{}\n    {{\"mode\": \"{}\", \"ops\": {}, \"errors\": {}, \"wall_s\": {:.1f}, "
+        "\"samples\": {}, \"series\": [",
+        mode_separator,
+        result.mode,
+        result.ops,
+        result.errors,
+        result.wall_seconds,
+        result.sample_ops.size());
+    std::string_view separator;
+    for (const auto& series : result.series) {
+      const auto growth = soak::check_growth(series.values, result.interval_s, series.tolerance);
+      bounded = bounded && !growth.unbounded;
+      json += std::format(
+          "{}\n      {{\"name\": \"{}\", \"unbounded\": {}, \"plateau\": {:.2f}, "
+          "\"final_peak\": {:.2f}, \"slope_per_hour\": {:.2f}, \"reason\": \"{}\"}}",
+          separator,
+          series.name,
+          growth.unbounded,
+          growth.plateau,
+          growth.final_peak,
+          growth.slope_per_hour,
+          growth.reason);
+      separator = ",";
+    }
+    json += "\n    ]}";
+    mode_separator = ",";
+  }
+  json += "\n  ]\n}\n";
+  std::print("{}", json);
+  return bounded;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  CLI::App app("pdvu_soak: long-running leak and growth check");
+  Options options;
+  app.add_option("pdf", options.pdf, "PDF to open")->required()->check(CLI::ExistingFile);
+  app.add_option("--pdvu", options.pdvu, "pdvu binary for the viewer mode")
+      ->check(CLI::ExistingFile);
+  app.add_option("--mode", options.mode, "What to soak: engine, viewer or both")
+      ->check(CLI::IsMember({"engine", "viewer", "both"}));
+  app.add_option("--ops", options.ops, "Randomized operations per mode");
+  int duration_s = 0;
+  app.add_option("--duration", duration_s, "Seconds per mode before stopping, 0 for no limit");
+  int sample_ms = static_cast<int>(options.sample_interval.count());
+  app.add_option("--sample-ms", sample_ms, "Milliseconds between samples");
+  app.add_option("--seed", options.seed, "Seed for the operation sequence");
+  app.add_option("-j,--threads", options.threads, "Render worker threads");
+  app.add_flag("--shm", options.use_shm, "Use shared memory transmission (mixed with temp files)");
+  std::filesystem::path samples_path;
+  app.add_option("--samples-out", samples_path, "Write every sample as CSV");
+  CLI11_PARSE(app, argc, argv);
+  options.duration = std::chrono::seconds(duration_s);
+  options.sample_interval = std::chrono::milliseconds(std::max(sample_ms, 1));
+
+  std::vector<ModeResult> results;
+  if (options.mode != "viewer") {
+    pdf::MuPDFParser parser(false);
+    if (!parser.load_document(options.pdf)) {
+      std::println(stderr, "Error: failed to load {}", options.pdf.string());
+      return 1;
+    }
+    if (parser.num_pages() <= 0) {
+      std::println(stderr, "Error: {} has no pages to soak", options.pdf.string());
+      return 1;
+    }
+    std::println(stderr, "soaking RenderEngine");
+    results.push_back(soak_engine(parser, options));
+  }
+  if (options.mode != "engine") {
+    std::println(stderr, "soaking pdvu on a pty");
+    results.push_back(soak_viewer(options));
+  }
+
+  if (!samples_path.empty() && !write_samples(samples_path, results)) {
+    std::println(stderr, "Error: could not write {}", samples_path.string());
+  }
+  const bool bounded = report(results);
+  const bool clean = std::ranges::all_of(results, [](const auto& r) { return r.errors == 0; });
+  if (!bounded) {
+    std::println(stderr, "FAIL: a sampled resource grows without bound");
+  }
+  return bounded && clean ? 0 : 1;
+}
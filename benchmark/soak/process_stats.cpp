@@ -0,0 +1,45 @@
+#include "process_stats.h"
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "utils/memory_accounting.h"
+
+namespace {
+std::size_t count_entries(const std::filesystem::path& dir, std::string_view prefix) {
+  std::error_code error;
+  std::size_t count = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(dir, error)) {
+    if (entry.path().filename().string().starts_with(prefix)) {
+      count++;
+    }
+  }
+  return count;
+}
+}  // namespace
+
+namespace soak {
+ProcessSample sample_process(pid_t pid) {
+  ProcessSample sample;
+  const std::filesystem::path proc = std::format("/proc/{}", pid);
+  if (const auto memory = memory_accounting::read_smaps_rollup(proc / "smaps_rollup")) {
+    sample.pss_bytes = memory->pss;
+  }
+  {
+    std::string line;
+    std::ifstream maps(proc / "maps");
+    while (std::getline(maps, line)) {
+      if (line.find(" /tmp/pdvu_") != std::string::npos) {
+        sample.tempfile_mappings++;
+      }
+    }
+  }
+  sample.open_fds = count_entries(proc / "fd", "");
+  sample.shm_entries = count_entries("/dev/shm", std::format("pdvu_{}_", pid));
+  return sample;
+}
+}  // namespace soak
@@ -0,0 +1,20 @@
+#pragma once
+#include <sys/types.h>
+
+#include <cstddef>
+
+namespace soak {
+/**
+ * @brief Resource usage of one process, read from /proc and /dev/shm.
+ *
+ * Fields that cannot be read (e.g. after the process exited) are left at 0.
+ */
+struct ProcessSample {
+  std::size_t pss_bytes = 0;          ///< Proportional set size from smaps_rollup
+  std::size_t open_fds = 0;           ///< Entries in /proc/<pid>/fd
+  std::size_t shm_entries = 0;        ///< /dev/shm/pdvu_<pid>_* objects that still exist
+  std::size_t tempfile_mappings = 0;  ///< Mappings of /tmp/pdvu_* files
+};
+
+ProcessSample sample_process(pid_t pid);
+}  // namespace soak
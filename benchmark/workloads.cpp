@@ -0,0 +1,82 @@
+#include "workloads.h"
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <string_view>
+
+#include "viewer/pageview.h"
+
+namespace bench {
+Workload sequential_flip(const WorkloadParams& params) {
+  Workload workload{.name = "sequential_flip", .steps = {}};
+  const int n = std::min(params.n_pages, params.max_pages);
+  for (int page = 0; page < n; page++) {
+    workload.steps.push_back(
+        {.page_num = page, .zoom = 1.0F, .viewport = params.viewport, .await = true});
+  }
+  return workload;
+}
+
+Workload random_jump(const WorkloadParams& params) {
+  Workload workload{.name = "random_jump", .steps = {}};
+  std::mt19937 rng(params.seed);
+  std::uniform_int_distribution<int> page_dist(0, std::max(params.n_pages - 1, 0));
+  for (int i = 0; i < params.n_jumps; i++) {
+    workload.steps.push_back(
+        {.page_num = page_dist(rng), .zoom = 1.0F, .viewport = params.viewport, .await = true});
+  }
+  return workload;
+}
+
+Workload zoom_ladder(const WorkloadParams& params) {
+  constexpr int ladder_pages = 3;
+  Workload workload{.name = "zoom_ladder", .steps = {}};
+  const auto& levels = PageView::m_zoom_levels;
+  for (int page = 0; page < std::min(params.n_pages, ladder_pages); page++) {
+    auto add = [&](float zoom) {
+      workload.steps.push_back(
+          {.page_num = page, .zoom = zoom, .viewport = params.viewport, .await = true});
+    };
+    std::ranges::for_each(levels, add);
+    std::ranges::for_each(levels | std::views::reverse | std::views::drop(1), add);
+  }
+  return workload;
+}
+
+Workload resize_storm(const WorkloadParams& params) {
+  Workload workload{.name = "resize_storm", .steps = {}};
+  const int events = std::max(params.storm_events, 1);
+  for (int storm = 0; storm < params.n_storms; storm++) {
+    const int page = params.n_pages > 0 ? storm % params.n_pages : 0;
+    for (int e = 0; e < events; e++) {
+      // shrink towards half size, the direction alternates between bursts
+      const int step = storm % 2 == 0 ? e : events - 1 - e;
+      const Viewport viewport{
+          .width = params.viewport.width - (params.viewport.width * step / (2 * events)),
+          .height = params.viewport.height - (params.viewport.height * step / (2 * events)),
+      };
+      workload.steps.push_back(
+          {.page_num = page, .zoom = 1.0F, .viewport = viewport, .await = e == events - 1});
+    }
+  }
+  return workload;
+}
+
+std::optional<Workload> make_workload(std::string_view name, const WorkloadParams& params) {
+  if (name == "sequential_flip") {
+    return sequential_flip(params);
+  }
+  if (name == "random_jump") {
+    return random_jump(params);
+  }
+  if (name == "zoom_ladder") {
+    return zoom_ladder(params);
+  }
+  if (name == "resize_storm") {
+    return resize_storm(params);
+  }
+  return std::nullopt;
+}
+}  // namespace bench
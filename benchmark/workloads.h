@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+/**
+ * @brief Pixel area available for the page, i.e. the terminal window minus the status bars.
+ */
+struct Viewport {
+  int width;
+  int height;
+};
+
+/**
+ * @brief One render request issued by a scripted workload.
+ */
+struct RenderStep {
+  int page_num;       ///< Zero-based page to render
+  float zoom;         ///< User zoom multiplier applied on top of fit-to-viewport
+  Viewport viewport;  ///< Area the page is fitted into
+  bool await;         ///< Wait for this frame before issuing the next step
+};
+
+/**
+ * @brief Named sequence of render requests replayed against a RenderEngine.
+ *
+ * Steps that are not awaited are issued back to back and superseded by the
+ * next awaited step, the same way the viewer coalesces a burst of input.
+ * Latency for an awaited step is measured from the first request of its burst.
+ */
+struct Workload {
+  std::string name;
+  std::vector<RenderStep> steps;
+};
+
+/// Parameters shared by every workload generator.
+struct WorkloadParams {
+  int n_pages;            ///< Pages in the document
+  int max_pages = 100;    ///< Upper bound on pages visited by sequential workloads
+  int n_jumps = 100;      ///< Requests issued by random_jump
+  int n_storms = 20;      ///< Bursts issued by resize_storm
+  int storm_events = 15;  ///< Requests per resize burst
+  std::uint32_t seed = 1;
+  Viewport viewport{.width = 1600, .height = 1000};
+};
+
+/// Names accepted by make_workload(), in the order they are run by default.
+inline constexpr std::string_view WORKLOAD_NAMES[] = {
+    "sequential_flip",
+    "random_jump",
+    "zoom_ladder",
+    "resize_storm",
+};
+
+/// Pages 0 to max_pages - 1 in order, one awaited frame each.
+Workload sequential_flip(const WorkloadParams& params);
+
+/// n_jumps awaited frames on uniformly random pages, reproducible from seed.
+Workload random_jump(const WorkloadParams& params);
+
+/// Steps through every PageView zoom level up and back down on the first few pages.
+Workload zoom_ladder(const WorkloadParams& params);
+
+/**
+ * @brief Simulates dragging the terminal edge: each burst issues storm_events
+ * requests with a shrinking viewport and only the last one is awaited.
+ */
+Workload resize_storm(const WorkloadParams& params);
+
+/// Builds a workload by name, or std::nullopt if the name is unknown.
+std::optional<Workload> make_workload(std::string_view name, const WorkloadParams& params);
+}  // namespace bench
@@ -1,13 +1,23 @@
 #include <CLI11.hpp>
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <format>
 #include <print>
+#include <string_view>
 #include <system_error>
-#include <thread>
 
 #include "plog/Log.h"
+#include "render/parallelism.h"
+#include "render/progressive_source.h"
+#include "render/search_index.h"
+#include "terminal/terminal.h"
+#include "utils/chrome_trace.h"
 #include "utils/logging.h"
+#include "utils/metrics.h"
+#include "utils/perf_counters.h"
 #include "utils/profiling.h"
+#include "viewer/trace.h"
 #include "viewer/viewer.h"
 
 int main(int argc, char** argv) {
@@ -29,15 +39,73 @@ int main(int argc, char** argv) {
                "Disable PDVU caching of rendered pages and display lists. "
                "(MuPDF cache unaffected)");
 
+  bool independent_contexts = false;
+  app.add_flag("--independent-contexts",
+               independent_contexts,
+               "Give each worker thread its own MuPDF context and cache instead of sharing locks");
+
+  bool use_mmap = false;
+  app.add_flag("--mmap",
+               use_mmap,
+               "Map the PDF into memory once and let every worker read it from there. "
+               "Truncating or rewriting the file while pdvu has it open crashes with SIGBUS");
+
   bool enable_logging = false;
   app.add_flag("--log", enable_logging, "Enable logging. Logs are written to /tmp/pdvu.log file");
 
-  int n_threads = 1;
-  app.add_option("-j,--jobs,--threads", n_threads, "Number of worker threads to use. Default 1.");
-  n_threads = n_threads <= 0 ? 1 : n_threads;
+  int n_threads = 0;
+  app.add_option("-j,--jobs,--threads",
+                 n_threads,
+                 "Maximum worker threads. Default 0 uses every CPU the process may run on");
+
+  bool fixed_strips = false;
+  app.add_flag("--fixed-strips",
+               fixed_strips,
+               "Split every page into one strip per thread instead of choosing per page");
+
+  bool use_search_index = false;
+  app.add_flag("--index",
+               use_search_index,
+               "Keep a search index of the document under $XDG_CACHE_HOME or ~/.cache, built "
+               "in the background and reused whenever the same file is opened again");
+
+  std::filesystem::path metrics_path;
+  app.add_option("--metrics-out",
+                 metrics_path,
+                 "Write render, cache and input latency metrics as JSON to this file on exit");
+
+  std::filesystem::path trace_out_path;
+  app.add_option("--trace-out",
+                 trace_out_path,
+                 "Record profiling zones and write them as Chrome/Perfetto trace JSON on exit");
+
+  bool enable_perf_counters = false;
+  app.add_flag("--perf-counters",
+               enable_perf_counters,
+               "Count cycles, instructions, cache and branch misses per render stage (Linux)");
+
+  std::filesystem::path record_trace_path;
+  auto* record_opt = app.add_option(
+      "--record-trace", record_trace_path, "Record input, resizes and renders to a trace file");
+
+  std::filesystem::path replay_trace_path;
+  app.add_option("--replay-trace", replay_trace_path, "Replay a recorded trace instead of input")
+      ->check(CLI::ExistingFile)
+      ->excludes(record_opt);
+
+  std::string replay_speed = "original";
+  app.add_option("--replay-speed",
+                 replay_speed,
+                 "original: replay with recorded timing. fast: next step once the last settles")
+      ->check(CLI::IsMember({"original", "fast"}));
+
+  std::filesystem::path replay_report_path;
+  app.add_option(
+      "--replay-report", replay_report_path, "Write per-step replay latencies as JSON lines");
 
   std::filesystem::path pdf_path;
-  app.add_option("pdf", pdf_path, "Path to PDF file")->check(CLI::ExistingFile);
+  app.add_option("pdf", pdf_path, "Path to PDF file or FIFO, or - to read the PDF from stdin")
+      ->check(CLI::ExistingFile | CLI::IsMember({"-"}));
 
   CLI11_PARSE(app, argc, argv);
   if (show_license) {
@@ -70,7 +138,10 @@ int main(int argc, char** argv) {
     return 0;
   }
 
-  if (pdf_path.extension() != ".pdf") {
+  // pipes are loaded progressively, so linearized PDFs show before they have fully arrived
+  const bool from_stdin = pdf_path == "-";
+  const bool streamed = from_stdin || std::filesystem::is_fifo(pdf_path);
+  if (!streamed && pdf_path.extension() != ".pdf") {
     std::println(stderr, "Error: Pdf file must be provided");
     return 1;
   }
@@ -81,37 +152,163 @@ int main(int argc, char** argv) {
     std::println(stderr, "Failed to initialise logging: {}", result.error());
     return 1;
   }
+  if (enable_perf_counters) {
+    if (const auto result = perf_counters::enable(); !result) {
+      std::println(stderr, "Warning: hardware counters unavailable: {}", result.error());
+      PLOG_WARNING << "Hardware counters unavailable: " << result.error();
+    }
+  }
+  if (!trace_out_path.empty()) {
+    chrome_trace::start();
+    chrome_trace::set_thread_name("main");
+  }
 
   // 1) Set up parser and load in document
   std::unique_ptr<pdf::Parser> parser = nullptr;
   {
     ZoneScopedN("Parser setup");
-    parser = std::make_unique<pdf::MuPDFParser>(enable_ICC);
-    if (!parser->load_document(pdf_path)) {
+    parser = std::make_unique<pdf::MuPDFParser>(
+        enable_ICC, use_mmap ? pdf::DocumentInput::MemoryMap : pdf::DocumentInput::File);
+    if (streamed) {
+      auto source = pdf::ProgressiveSource::open(pdf_path);
+      if (!source) {
+        std::println(stderr, "Error: {}", source.error());
+        return 1;
+      }
+      // the source reads its own copy of stdin, keys come from the terminal
+      if (from_stdin && !terminal::reattach_stdin()) {
+        std::println(stderr, "Error: reading the PDF from stdin needs a controlling terminal");
+        return 1;
+      }
+      if (!parser->load_progressive(std::move(*source))) {
+        throw std::runtime_error("failed to load document");
+      }
+    } else if (!parser->load_document(pdf_path)) {
       throw std::runtime_error("failed to load document");
     }
   }
 
   // 2) setup render engine
-  int max_cores = static_cast<int>(std::thread::hardware_concurrency());  // may return 0
-  max_cores = std::max(max_cores, 1);
-  n_threads = std::clamp(n_threads, 1, max_cores);
+  // respects CPU affinity and the cgroup quota when running in a container
+  const int max_cores = parallelism::available_cpus();
+  n_threads = n_threads <= 0 ? max_cores : std::clamp(n_threads, 1, max_cores);
   std::unique_ptr<RenderEngine> render_engine = nullptr;
   {
     ZoneScopedN("Render engine setup");
-    render_engine = std::make_unique<RenderEngine>(*parser, n_threads, enable_cache);
+    render_engine = std::make_unique<RenderEngine>(
+        *parser,
+        n_threads,
+        enable_cache,
+        independent_contexts ? WorkerContexts::Independent : WorkerContexts::Cloned,
+        fixed_strips ? StripPolicy::Fixed : StripPolicy::Auto);
   }
 
-  // 3) set up viewer and run
+  // 3) optional session recording or replay
+  std::unique_ptr<trace::Recorder> recorder = nullptr;
+  if (!record_trace_path.empty()) {
+    auto created = trace::Recorder::create(record_trace_path,
+                                           {.version = 1, .document = parser->get_document_name()});
+    if (!created) {
+      std::println(stderr, "Failed to record trace: {}", created.error());
+      return 1;
+    }
+    recorder = std::make_unique<trace::Recorder>(std::move(*created));
+  }
+  std::unique_ptr<trace::Replayer> replayer = nullptr;
+  if (!replay_trace_path.empty()) {
+    auto loaded = trace::load(replay_trace_path);
+    if (!loaded) {
+      std::println(stderr, "Failed to load trace: {}", loaded.error());
+      return 1;
+    }
+    if (loaded->header.document != parser->get_document_name()) {
+      std::println(stderr,
+                   "Warning: trace was recorded on {}, replaying on {}",
+                   loaded->header.document,
+                   parser->get_document_name());
+    }
+    const auto pacing = replay_speed == "fast" ? trace::Replayer::Pacing::AsFastAsPossible
+                                               : trace::Replayer::Pacing::OriginalTiming;
+    replayer = std::make_unique<trace::Replayer>(std::move(*loaded), pacing);
+  }
+
+  // 4) set up viewer and run
+  std::vector<trace::ReplayLatency> replay_latencies;
   try {
     Viewer viewer(std::move(parser), std::move(render_engine), use_shm);
+    if (recorder) {
+      viewer.record_trace(std::move(recorder));
+    }
+    if (replayer) {
+      viewer.replay_trace(std::move(replayer));
+    }
+    if (use_search_index && !streamed) {
+      if (const auto directory = pdf::SearchIndex::default_directory()) {
+        viewer.build_search_index(pdf_path, *directory);
+      } else {
+        PLOG_WARNING << "No cache directory for the search index, HOME is not set";
+      }
+    }
     PLOG_INFO << "Start up complete, starting loop";
     viewer.run();  // start main loop
     PLOG_INFO << "Shutdown session";
+    if (viewer.replayer() != nullptr) {
+      replay_latencies = viewer.replayer()->latencies();
+    }
   } catch (const std::system_error& e) {
     std::println(stderr, "Terminal error: {}", e.what());
     PLOG_ERROR << "Terminal error: " << e.what();
     return 1;
   }
+
+  if (!replay_trace_path.empty()) {
+    metrics::LatencyHistogram latency;
+    std::size_t timed_out = 0;
+    for (const auto& step : replay_latencies) {
+      latency.record(step.latency);
+      timed_out += step.timed_out ? 1 : 0;
+    }
+    const auto s = latency.summary();
+    std::println("replayed {} steps ({} timed out): p50 {:.2f}ms p95 {:.2f}ms p99 {:.2f}ms "
+                 "max {:.2f}ms",
+                 s.count,
+                 timed_out,
+                 s.p50_us / 1000.0,
+                 s.p95_us / 1000.0,
+                 s.p99_us / 1000.0,
+                 s.max_us / 1000.0);
+    if (!replay_report_path.empty()) {
+      if (const auto result = trace::write_report(replay_latencies, replay_report_path); !result) {
+        std::println(stderr, "Failed to write replay report: {}", result.error());
+        return 1;
+      }
+    }
+  }
+
+  if (!trace_out_path.empty()) {
+    chrome_trace::stop();
+    if (const auto result = chrome_trace::write_json(trace_out_path); !result) {
+      std::println(stderr, "Failed to write trace: {}", result.error());
+      return 1;
+    }
+  }
+
+  if (!metrics_path.empty()) {
+    // memory.* gauges were last published by the viewer as the session ended
+    auto& registry = metrics::registry();
+    for (const auto& lock : pdf::mupdf_lock_stats()) {
+      auto gauge = [&](std::string_view stat) -> metrics::Gauge& {
+        return registry.gauge(std::format("mupdf.lock.{}.{}", lock.name, stat));
+      };
+      gauge("acquisitions").set(static_cast<std::int64_t>(lock.acquisitions));
+      gauge("contended").set(static_cast<std::int64_t>(lock.contended));
+      gauge("wait_us").set(
+          std::chrono::duration_cast<std::chrono::microseconds>(lock.wait).count());
+    }
+    if (const auto result = metrics::write_json(registry, metrics_path); !result) {
+      std::println(stderr, "Failed to write metrics: {}", result.error());
+      return 1;
+    }
+  }
   return 0;
 }
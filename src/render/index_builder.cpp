@@ -0,0 +1,470 @@
+#include "index_builder.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <pthread/qos.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "plog/Log.h"
+#include "utils/logging.h"
+#include "utils/metrics.h"
+#include "utils/profiling.h"
+
+namespace {
+constexpr std::array<char, 8> LOG_MAGIC = {'P', 'D', 'V', 'U', 'L', 'O', 'G', '\0'};
+/// Bumped together with the index format, or whenever extraction changes
+constexpr std::uint32_t LOG_VERSION = 1;
+
+constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+constexpr std::uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+/**
+ * @brief Index build metrics, looked up once from the process-wide registry.
+ */
+struct IndexMetrics {
+  /// Builder started to the index being usable, loaded or built
+  metrics::LatencyHistogram& ready = metrics::registry().histogram("search.index.ready");
+  /// Pages extracted into the log this session
+  metrics::Counter& pages = metrics::registry().counter("search.index.pages");
+};
+
+IndexMetrics& index_metrics() {
+  static IndexMetrics instance;
+  return instance;
+}
+
+struct LogHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t num_pages;
+  std::uint64_t doc_size;
+  std::uint64_t doc_hash;
+};
+
+/// Followed by the page's text, then its TextLines, then its edges
+struct RecordHeader {
+  std::uint32_t page_num;
+  std::uint32_t text_size;
+  std::uint32_t n_lines;
+  std::uint32_t n_edges;
+  std::uint64_t checksum;  ///< FNV-1a of the fields above and the payload
+};
+
+void hash_bytes(std::uint64_t& hash, std::span<const char> bytes) {
+  for (const char b : bytes) {
+    hash = (hash ^ static_cast<unsigned char>(b)) * FNV_PRIME;
+  }
+}
+
+template <typename T>
+std::span<const char> bytes_of(std::span<const T> values) {
+  return {reinterpret_cast<const char*>(values.data()), values.size_bytes()};
+}
+
+/// Copies count Ts stored at offset in bytes, which may be unaligned.
+template <typename T>
+std::vector<T> read_array(std::string_view bytes, std::size_t offset, std::size_t count) {
+  std::vector<T> values(count);
+  if (count > 0) {
+    std::memcpy(values.data(), bytes.data() + offset, count * sizeof(T));
+  }
+  return values;
+}
+
+std::uint64_t record_checksum(const RecordHeader& header, const pdf::PageTextView& page) {
+  std::uint64_t hash = FNV_OFFSET_BASIS;
+  hash_bytes(hash, {reinterpret_cast<const char*>(&header), offsetof(RecordHeader, checksum)});
+  hash_bytes(hash, page.text());
+  hash_bytes(hash, bytes_of(page.lines()));
+  hash_bytes(hash, bytes_of(page.edges()));
+  return hash;
+}
+
+/**
+ * @brief Append-only log of extracted pages, the resumable half of an index build.
+ *
+ * Records are appended whole and flushed one at a time. A session killed
+ * mid-write leaves a torn last record, which fails its checksum and is cut
+ * off when the log is next opened.
+ */
+class IndexLog {
+ public:
+  /**
+   * @brief Opens the log at path for appending, reading back the pages it holds into pages.
+   *
+   * A log for another document or format is started over.
+   */
+  static std::expected<IndexLog, std::string> open(
+      const std::filesystem::path& path, const pdf::DocumentKey& key,
+      std::vector<std::optional<pdf::PageText>>& pages);
+
+  std::expected<void, std::string> append(int page_num, const pdf::PageText& page);
+
+ private:
+  IndexLog(std::ofstream out, std::filesystem::path path)
+      : m_out(std::move(out)), m_path(std::move(path)) {}
+
+  /// Bytes of valid header and records at the start of contents, 0 if the header is not ours.
+  static std::size_t read_records(std::string_view contents, const pdf::DocumentKey& key,
+                                  std::vector<std::optional<pdf::PageText>>& pages);
+
+  std::ofstream m_out;
+  std::filesystem::path m_path;
+};
+
+std::expected<IndexLog, std::string> IndexLog::open(
+    const std::filesystem::path& path, const pdf::DocumentKey& key,
+    std::vector<std::optional<pdf::PageText>>& pages) {
+  std::string contents;
+  if (std::ifstream in(path, std::ios::binary); in) {
+    contents.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  const std::size_t valid = read_records(contents, key, pages);
+
+  std::error_code error;
+  if (valid == 0) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    LogHeader header{};
+    std::ranges::copy(LOG_MAGIC, header.magic);
+    header.version = LOG_VERSION;
+    header.num_pages = static_cast<std::uint32_t>(pages.size());
+    header.doc_size = key.size;
+    header.doc_hash = key.hash;
+    if (!out.write(reinterpret_cast<const char*>(&header), sizeof(header)).flush()) {
+      return std::unexpected(std::format("Cannot write {}", path.string()));
+    }
+    return IndexLog(std::move(out), path);
+  }
+  if (valid < contents.size()) {
+    PLOG_WARNING << std::format(
+        "Dropping {} torn bytes from {}", contents.size() - valid, path.string());
+    std::filesystem::resize_file(path, valid, error);
+    if (error) {
+      return std::unexpected(std::format("Cannot truncate {}: {}", path.string(), error.message()));
+    }
+  }
+  std::ofstream out(path, std::ios::binary | std::ios::app);
+  if (!out) {
+    return std::unexpected(std::format("Cannot append to {}", path.string()));
+  }
+  return IndexLog(std::move(out), path);
+}
+
+std::size_t IndexLog::read_records(std::string_view contents, const pdf::DocumentKey& key,
+                                   std::vector<std::optional<pdf::PageText>>& pages) {
+  LogHeader header{};
+  if (contents.size() < sizeof(header)) {
+    return 0;
+  }
+  std::memcpy(&header, contents.data(), sizeof(header));
+  if (!std::ranges::equal(header.magic, LOG_MAGIC) || header.version != LOG_VERSION ||
+      header.num_pages != pages.size() || header.doc_size != key.size ||
+      header.doc_hash != key.hash) {
+    return 0;
+  }
+
+  std::size_t offset = sizeof(header);
+  while (contents.size() - offset >= sizeof(RecordHeader)) {
+    RecordHeader record{};
+    std::memcpy(&record, contents.data() + offset, sizeof(record));
+    const std::size_t payload = std::size_t{record.text_size} +
+                                std::size_t{record.n_lines} * sizeof(pdf::TextLine) +
+                                std::size_t{record.n_edges} * sizeof(float);
+    const std::size_t start = offset + sizeof(record);
+    if (record.page_num >= pages.size() || payload > contents.size() - start) {
+      break;
+    }
+    const std::size_t lines_start = start + record.text_size;
+    const std::size_t edges_start = lines_start + record.n_lines * sizeof(pdf::TextLine);
+    pdf::PageText page(std::string(contents.substr(start, record.text_size)),
+                       read_array<pdf::TextLine>(contents, lines_start, record.n_lines),
+                       read_array<float>(contents, edges_start, record.n_edges));
+    if (record_checksum(record, page.view()) != record.checksum) {
+      break;
+    }
+    pages[record.page_num] = std::move(page);
+    offset = start + payload;
+  }
+  return offset;
+}
+
+std::expected<void, std::string> IndexLog::append(int page_num, const pdf::PageText& page) {
+  const auto view = page.view();
+  RecordHeader record{
+      .page_num = static_cast<std::uint32_t>(page_num),
+      .text_size = static_cast<std::uint32_t>(view.text().size()),
+      .n_lines = static_cast<std::uint32_t>(view.lines().size()),
+      .n_edges = static_cast<std::uint32_t>(view.edges().size()),
+      .checksum = 0,
+  };
+  record.checksum = record_checksum(record, view);
+  const auto lines = bytes_of(view.lines());
+  const auto edges = bytes_of(view.edges());
+  m_out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  m_out.write(view.text().data(), static_cast<std::streamsize>(view.text().size()));
+  m_out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+  m_out.write(edges.data(), static_cast<std::streamsize>(edges.size()));
+  if (!m_out.flush()) {
+    return std::unexpected(std::format("Cannot append to {}", m_path.string()));
+  }
+  return {};
+}
+
+/**
+ * @brief Exclusive flock on an index log, so one process at a time builds a document's index.
+ *
+ * Released when destroyed, or when the process exits however it exits.
+ */
+class LogLock {
+ public:
+  /**
+   * @brief Locks the log at path, creating it if missing.
+   * @return The lock, std::nullopt if another process holds it, or an error message.
+   */
+  static std::expected<std::optional<LogLock>, std::string> try_acquire(
+      const std::filesystem::path& path);
+
+  ~LogLock() {
+    if (m_fd != -1) {
+      ::close(m_fd);
+    }
+  }
+
+  LogLock(const LogLock&) = delete;
+  LogLock& operator=(const LogLock&) = delete;
+  LogLock(LogLock&& other) noexcept : m_fd(std::exchange(other.m_fd, -1)) {}
+  LogLock& operator=(LogLock&&) = delete;
+
+ private:
+  explicit LogLock(int fd) : m_fd(fd) {}
+
+  int m_fd;
+};
+
+std::expected<std::optional<LogLock>, std::string> LogLock::try_acquire(
+    const std::filesystem::path& path) {
+  while (true) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+      return std::unexpected(std::format("Cannot open {}: {}", path.string(), strerror(errno)));
+    }
+    LogLock lock(fd);
+    if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+      if (errno == EWOULDBLOCK) {
+        return std::nullopt;
+      }
+      return std::unexpected(std::format("Cannot lock {}: {}", path.string(), strerror(errno)));
+    }
+    // the holder before us may have finished and removed the log we opened
+    struct stat held{};
+    struct stat current{};
+    if (fstat(fd, &held) == 0 && stat(path.c_str(), &current) == 0 &&
+        held.st_dev == current.st_dev && held.st_ino == current.st_ino) {
+      return lock;
+    }
+  }
+}
+
+/// Opens the index at path, checking it has num_pages pages.
+std::expected<pdf::SearchIndex, std::string> open_index(const std::filesystem::path& path,
+                                                        const pdf::DocumentKey& key,
+                                                        int num_pages) {
+  auto index = pdf::SearchIndex::open(path, key);
+  if (index && index->num_pages() != num_pages) {
+    return std::unexpected(std::format("{} has the wrong page count", path.string()));
+  }
+  return index;
+}
+
+/// Moves the calling thread to the lowest CPU priority the platform offers.
+void lower_thread_priority() {
+#if defined(__linux__)
+  const sched_param param{.sched_priority = 0};
+  if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+    setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), 19);  // niceness is per thread here
+  }
+#elif defined(__APPLE__)
+  pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#endif
+}
+}  // namespace
+
+namespace pdf {
+IndexBuilder::IndexBuilder(const Parser& prototype, std::filesystem::path document,
+                           std::filesystem::path directory)
+    : m_num_pages(prototype.num_pages()),
+      // an independent context shares no locks with the renderers, so an idle thread
+      // preempted while holding one cannot stall them
+      m_open(prototype.duplicate_deferred(true)),
+      m_document(std::move(document)),
+      m_directory(std::move(directory)) {
+  m_thread = std::thread(&IndexBuilder::run, this);
+}
+
+IndexBuilder::~IndexBuilder() {
+  m_stop.store(true, std::memory_order_relaxed);
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+std::shared_ptr<const SearchIndex> IndexBuilder::index() const {
+  std::scoped_lock lock(m_mutex);
+  return m_index;
+}
+
+void IndexBuilder::wait() const {
+  std::unique_lock lock(m_mutex);
+  m_finished_cv.wait(lock, [&] { return m_finished; });
+}
+
+void IndexBuilder::run() {
+  chrome_trace::set_thread_name("search index");
+  lower_thread_priority();
+  const auto start = std::chrono::steady_clock::now();
+  auto built = build();
+  if (!built) {
+    PLOG_WARNING << "Search index unavailable: " << built.error();
+  } else if (*built) {
+    index_metrics().ready.record(std::chrono::steady_clock::now() - start);
+    PLOG_INFO << std::format("Search index of {} ready, {} bytes mapped",
+                             m_document.filename().string(),
+                             (*built)->bytes());
+  }
+  {
+    std::scoped_lock lock(m_mutex);
+    m_index = built.value_or(nullptr);
+    m_finished = true;
+  }
+  m_finished_cv.notify_all();
+}
+
+std::expected<std::shared_ptr<const SearchIndex>, std::string> IndexBuilder::build() {
+  ZoneScopedN("build search index");
+  const auto key = DocumentKey::of(m_document);
+  if (!key) {
+    return std::unexpected(key.error());
+  }
+  std::error_code error;
+  std::filesystem::create_directories(m_directory, error);
+  if (error) {
+    return std::unexpected(
+        std::format("Cannot create {}: {}", m_directory.string(), error.message()));
+  }
+
+  const std::string stem = key->file_stem();
+  const auto index_path = m_directory / (stem + ".idx");
+  if (auto index = open_index(index_path, *key, m_num_pages)) {
+    m_pages_indexed.store(m_num_pages, std::memory_order_relaxed);
+    return std::make_shared<const SearchIndex>(std::move(*index));
+  }
+
+  const auto log_path = m_directory / (stem + ".log");
+  auto lock = LogLock::try_acquire(log_path);
+  if (!lock) {
+    return std::unexpected(lock.error());
+  }
+  if (!*lock) {
+    PLOG_INFO << std::format("Another pdvu is indexing {}, searching without an index",
+                             m_document.filename().string());
+    return nullptr;
+  }
+  // the last holder of the lock may have finished the index since it was looked for
+  if (std::filesystem::exists(index_path, error)) {
+    auto index = open_index(index_path, *key, m_num_pages);
+    if (index) {
+      m_pages_indexed.store(m_num_pages, std::memory_order_relaxed);
+      return std::make_shared<const SearchIndex>(std::move(*index));
+    }
+    PLOG_WARNING << index.error() << ", rebuilding it";
+    std::filesystem::remove(index_path, error);
+  }
+
+  std::vector<std::optional<PageText>> pages(static_cast<std::size_t>(m_num_pages));
+  auto log = IndexLog::open(log_path, *key, pages);
+  if (!log) {
+    return std::unexpected(log.error());
+  }
+  const auto resumed =
+      std::ranges::count_if(pages, [](const auto& page) { return page.has_value(); });
+  m_pages_indexed.store(static_cast<int>(resumed), std::memory_order_relaxed);
+  if (resumed > 0) {
+    PLOG_INFO << std::format("Resuming search index of {} at {}/{} pages",
+                             m_document.filename().string(),
+                             resumed,
+                             m_num_pages);
+  }
+
+  std::unique_ptr<Parser> parser;
+  int failed = 0;
+  for (std::size_t i = 0; i < pages.size(); i++) {
+    if (pages[i]) {
+      continue;
+    }
+    if (m_stop.load(std::memory_order_relaxed)) {
+      return nullptr;  // the log keeps what is done for the next session
+    }
+    if (!parser) {
+      try {
+        parser = m_open();
+      } catch (const std::exception& e) {
+        return std::unexpected(std::format("Cannot open the document: {}", e.what()));
+      }
+    }
+    auto text = parser->page_text(static_cast<int>(i));
+    if (!text) {
+      failed++;  // left out of the log, so the next session tries it again
+      continue;
+    }
+    pages[i] = std::move(*text);
+    if (auto appended = log->append(static_cast<int>(i), *pages[i]); !appended) {
+      return std::unexpected(appended.error());
+    }
+    m_pages_indexed.fetch_add(1, std::memory_order_relaxed);
+    index_metrics().pages.add();
+  }
+  parser.reset();
+  if (failed > 0) {
+    return std::unexpected(
+        std::format("{} pages could not be extracted, the index is finished next session", failed));
+  }
+
+  std::vector<PageText> complete;
+  complete.reserve(pages.size());
+  for (auto& page : pages) {
+    complete.push_back(std::move(*page));
+  }
+  if (auto written = SearchIndex::write(index_path, *key, complete); !written) {
+    return std::unexpected(written.error());
+  }
+  std::filesystem::remove(log_path, error);
+  auto index = SearchIndex::open(index_path, *key);
+  if (!index) {
+    return std::unexpected(index.error());
+  }
+  return std::make_shared<const SearchIndex>(std::move(*index));
+}
+}  // namespace pdf
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "parser.h"
+#include "search_index.h"
+
+namespace pdf {
+/**
+ * @brief Builds the SearchIndex of a document in the background, or loads the one built before.
+ *
+ * Runs on one thread at idle priority, so it only uses CPU time nothing
+ * else wants. Each page is appended to a log in the index directory as soon
+ * as it is extracted. A session that quits half way leaves the log behind,
+ * and the next session opening the same document extracts only the pages it
+ * lacks. Pages that fail to extract are left out of the log, so the next session
+ * tries them again. Once every page is in, the log is turned into the index
+ * file and removed.
+ *
+ * The builder holds a flock on the log while it works. Another process
+ * opening the same document finds it held and searches without an index
+ * rather than appending to the same log.
+ */
+class IndexBuilder {
+ public:
+  /**
+   * @brief Starts building, or loading, the index of document.
+   *
+   * Must be called on the thread owning prototype.
+   *
+   * @param prototype Parser with document loaded. Extraction uses its own independent context.
+   * @param document File the document was loaded from, hashed to find its index.
+   * @param directory Where index files are kept, created if missing.
+   */
+  IndexBuilder(const Parser& prototype, std::filesystem::path document,
+               std::filesystem::path directory);
+
+  /// Stops between pages, keeping the log for the next session, and joins the thread.
+  ~IndexBuilder();
+
+  IndexBuilder(const IndexBuilder&) = delete;
+  IndexBuilder& operator=(const IndexBuilder&) = delete;
+  IndexBuilder(IndexBuilder&&) = delete;
+  IndexBuilder& operator=(IndexBuilder&&) = delete;
+
+  /// The index once built or loaded, nullptr before then or if building failed.
+  [[nodiscard]] std::shared_ptr<const SearchIndex> index() const;
+
+  /// Pages in the index or its log so far.
+  [[nodiscard]] int pages_indexed() const {
+    return m_pages_indexed.load(std::memory_order_relaxed);
+  }
+
+  /// Blocks until the index is ready, building failed, or the builder was stopped.
+  void wait() const;
+
+ private:
+  void run();
+  std::expected<std::shared_ptr<const SearchIndex>, std::string> build();
+
+  int m_num_pages;
+  Parser::DeferredParser m_open;
+  std::filesystem::path m_document;
+  std::filesystem::path m_directory;
+  std::atomic<bool> m_stop = false;
+  std::atomic<int> m_pages_indexed = 0;
+
+  mutable std::mutex m_mutex;
+  mutable std::condition_variable m_finished_cv;
+  std::shared_ptr<const SearchIndex> m_index;
+  bool m_finished = false;
+  std::thread m_thread;
+};
+}  // namespace pdf
@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Move-only `void()` callable that stores small callables inline.
+ *
+ * Unlike `std::function`, the target does not have to be copyable, and a
+ * target of up to INLINE_SIZE bytes that is nothrow movable lives inside the
+ * task itself, so queuing it allocates nothing. Larger targets are moved to
+ * the heap.
+ */
+class InplaceTask {
+ public:
+  static constexpr std::size_t INLINE_SIZE = 48;
+
+  InplaceTask() = default;
+
+  template <typename F>
+    requires(!std::same_as<std::decay_t<F>, InplaceTask> && std::invocable<std::decay_t<F>&>)
+  InplaceTask(F&& callable) {  // NOLINT(google-explicit-constructor): converts like std::function
+    using T = std::decay_t<F>;
+    if constexpr (fits_inline<T>) {
+      ::new (static_cast<void*>(m_storage.data())) T(std::forward<F>(callable));
+      m_ops = &inline_ops<T>;
+    } else {
+      ::new (static_cast<void*>(m_storage.data())) T*(new T(std::forward<F>(callable)));
+      m_ops = &heap_ops<T>;
+    }
+  }
+
+  InplaceTask(InplaceTask&& other) noexcept { take(other); }
+
+  InplaceTask& operator=(InplaceTask&& other) noexcept {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+
+  InplaceTask(const InplaceTask&) = delete;
+  InplaceTask& operator=(const InplaceTask&) = delete;
+
+  ~InplaceTask() { reset(); }
+
+  /// @return Whether the task holds a callable.
+  explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+  /// Invokes the callable. The task must not be empty.
+  void operator()() { m_ops->invoke(m_storage.data()); }
+
+ private:
+  /// Type-erased operations on the stored callable.
+  struct Ops {
+    void (*invoke)(void* storage);
+    void (*move)(void* dst, void* src) noexcept;  ///< Move constructs dst and destroys src
+    void (*destroy)(void* storage) noexcept;
+  };
+
+  template <typename T>
+  static constexpr bool fits_inline = sizeof(T) <= INLINE_SIZE &&
+                                      alignof(T) <= alignof(std::max_align_t) &&
+                                      std::is_nothrow_move_constructible_v<T>;
+
+  template <typename T>
+  static constexpr Ops inline_ops{
+      [](void* storage) { (*std::launder(static_cast<T*>(storage)))(); },
+      [](void* dst, void* src) noexcept {
+        T* source = std::launder(static_cast<T*>(src));
+        ::new (dst) T(std::move(*source));
+        source->~T();
+      },
+      [](void* storage) noexcept { std::launder(static_cast<T*>(storage))->~T(); },
+  };
+
+  template <typename T>
+  static constexpr Ops heap_ops{
+      [](void* storage) { (**std::launder(static_cast<T**>(storage)))(); },
+      [](void* dst, void* src) noexcept { ::new (dst) T*(*std::launder(static_cast<T**>(src))); },
+      [](void* storage) noexcept { delete *std::launder(static_cast<T**>(storage)); },
+  };
+
+  void take(InplaceTask& other) noexcept {
+    if (other.m_ops != nullptr) {
+      other.m_ops->move(m_storage.data(), other.m_storage.data());
+      m_ops = std::exchange(other.m_ops, nullptr);
+    }
+  }
+
+  void reset() noexcept {
+    if (m_ops != nullptr) {
+      std::exchange(m_ops, nullptr)->destroy(m_storage.data());
+    }
+  }
+
+  alignas(std::max_align_t) std::array<std::byte, INLINE_SIZE> m_storage;
+  const Ops* m_ops = nullptr;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <stdexcept>
 #include <utility>
@@ -52,9 +53,12 @@ class MuPDFContext final {
    *
    * @param ctx Non-null unique owner whose context is transferred into this
    * wrapper.
+   * @param allocator_state Opaque state the context's allocation callbacks
+   * use, released only after the context is dropped.
    * @throws std::invalid_argument If ctx is empty.
    */
-  explicit MuPDFContext(UniqueHandle ctx) : m_ctx(std::move(ctx)) {
+  explicit MuPDFContext(UniqueHandle ctx, std::shared_ptr<void> allocator_state = nullptr)
+      : m_allocator_state(std::move(allocator_state)), m_ctx(std::move(ctx)) {
     if (m_ctx == nullptr) {
       throw std::invalid_argument("Null MuPDF context");
     }
@@ -78,7 +82,13 @@ class MuPDFContext final {
    */
   [[nodiscard]] fz_context* borrow() const noexcept { return m_ctx.get(); }
 
+  /// Allocation state to share with contexts cloned from this one.
+  [[nodiscard]] const std::shared_ptr<void>& allocator_state() const noexcept {
+    return m_allocator_state;
+  }
+
  private:
+  std::shared_ptr<void> m_allocator_state;  ///< Declared first so it outlives m_ctx
   UniqueHandle m_ctx;
 };
 
@@ -94,10 +104,12 @@ class MuPDFDisplayList final {
   /**
    * @param ctx A shared_ptr to a MuPDFContext containing a valid fz_context.
    * @param dlist A non null fz_display_list*.
+   * @param estimated_bytes MuPDF memory retained while building the list, 0 if unknown.
    * @throws std::invalid_argument if nullptr passed in for either parameter.
    */
-  explicit MuPDFDisplayList(std::shared_ptr<MuPDFContext> ctx, fz_display_list* dlist)
-      : m_context(std::move(ctx)), m_dlist(dlist) {
+  explicit MuPDFDisplayList(std::shared_ptr<MuPDFContext> ctx, fz_display_list* dlist,
+                            std::size_t estimated_bytes = 0)
+      : m_context(std::move(ctx)), m_dlist(dlist), m_estimated_bytes(estimated_bytes) {
     if (m_context == nullptr) {
       throw std::invalid_argument("Null MuPDF context wrapper");
     }
@@ -122,8 +134,15 @@ class MuPDFDisplayList final {
    */
   [[nodiscard]] fz_display_list* borrow() const noexcept { return m_dlist; }
 
+  /**
+   * Approximate heap size of the list. Measured as the net MuPDF allocations of
+   * the building thread, so it also includes store entries first loaded for it.
+   */
+  [[nodiscard]] std::size_t estimated_bytes() const noexcept { return m_estimated_bytes; }
+
  private:
   std::shared_ptr<MuPDFContext> m_context;
   fz_display_list* m_dlist;
+  std::size_t m_estimated_bytes;
 };
 }  // namespace pdf
\ No newline at end of file
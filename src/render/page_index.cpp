@@ -0,0 +1,106 @@
+#include "page_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <utility>
+
+#include "plog/Log.h"
+#include "utils/logging.h"
+#include "utils/metrics.h"
+#include "utils/profiling.h"
+
+namespace {
+/**
+ * @brief Page index metrics, looked up once from the process-wide registry.
+ */
+struct IndexMetrics {
+  metrics::LatencyHistogram& build = metrics::registry().histogram("page_index.build");
+  metrics::Counter& fallbacks = metrics::registry().counter("page_index.fallbacks");
+};
+
+IndexMetrics& index_metrics() {
+  static IndexMetrics instance;
+  return instance;
+}
+}  // namespace
+
+namespace pdf {
+PageIndex::PageIndex(const Parser& prototype) {
+  const auto n = static_cast<std::size_t>(std::max(prototype.num_pages(), 0));
+  m_x0.resize(n);
+  m_y0.resize(n);
+  m_x1.resize(n);
+  m_y1.resize(n);
+  m_rotation.resize(n);
+  m_state = std::vector<std::atomic<State>>(n);
+  try {
+    // only the context is cloned here; the document is reopened on the index thread
+    m_open = prototype.duplicate_deferred(false);
+  } catch (const std::exception& e) {
+    PLOG_WARNING << "Page index disabled, pages are measured on demand: " << e.what();
+    m_complete.store(true, std::memory_order_release);
+    return;
+  }
+  m_thread = std::thread(&PageIndex::build, this);
+}
+
+PageIndex::~PageIndex() {
+  m_stop.store(true, std::memory_order_relaxed);
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void PageIndex::build() {
+  chrome_trace::set_thread_name("page index");
+  ZoneScopedN("page index build");
+  const auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<Parser> parser;
+  try {
+    parser = std::exchange(m_open, nullptr)();
+  } catch (const std::exception& e) {
+    PLOG_WARNING << "Page index disabled, pages are measured on demand: " << e.what();
+    m_complete.store(true, std::memory_order_release);
+    m_complete.notify_all();
+    return;
+  }
+  for (std::size_t i = 0; i < m_state.size() && !m_stop.load(std::memory_order_relaxed); i++) {
+    const auto specs = parser->page_specs(static_cast<int>(i));
+    if (specs) {
+      m_x0[i] = specs->base_x0;
+      m_y0[i] = specs->base_y0;
+      m_x1[i] = specs->base_x1;
+      m_y1[i] = specs->base_y1;
+      m_rotation[i] = static_cast<std::int16_t>(specs->rotation);
+    }
+    m_state[i].store(specs ? Ready : Failed, std::memory_order_release);
+  }
+  index_metrics().build.record(std::chrono::steady_clock::now() - start);
+  parser.reset();  // drop the document and context early, the index is all we need
+  m_complete.store(true, std::memory_order_release);
+  m_complete.notify_all();
+}
+
+std::optional<PageSpecs> PageIndex::get(int page_num) const {
+  if (page_num < 0 || page_num >= num_pages()) {
+    return std::nullopt;
+  }
+  const auto i = static_cast<std::size_t>(page_num);
+  if (m_state[i].load(std::memory_order_acquire) != Ready) {
+    return std::nullopt;
+  }
+  return PageSpecs::from_base_bounds(
+      {.x0 = m_x0[i], .y0 = m_y0[i], .x1 = m_x1[i], .y1 = m_y1[i]}, m_rotation[i]);
+}
+
+std::optional<PageSpecs> PageIndex::get_or_load(int page_num, const Parser& fallback) const {
+  if (auto specs = get(page_num)) {
+    return specs;
+  }
+  index_metrics().fallbacks.add();
+  return fallback.page_specs(page_num);
+}
+
+void PageIndex::wait() const { m_complete.wait(false, std::memory_order_acquire); }
+}  // namespace pdf
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "page_specs.h"
+#include "parser.h"
+
+namespace pdf {
+/**
+ * @brief Bounds of every page of a document, built on a background thread.
+ *
+ * Finding the size of a page means loading it, which on heavy pages costs
+ * as much as parsing its content. The index loads every page once, in order,
+ * on its own parser and keeps the base zoom bounds and rotation in parallel
+ * arrays, about 20 bytes per page, so layout code such as the viewer or
+ * go-to-page gets a page's geometry in O(1) without touching MuPDF.
+ *
+ * Each page is published with a release store of its state, so lookups are
+ * lock free and may run on any thread while the index is being built. Pages
+ * not indexed yet are loaded on demand through the caller's parser.
+ */
+class PageIndex {
+ public:
+  /**
+   * @brief Starts indexing the document loaded in prototype.
+   *
+   * Must be called on the thread owning prototype. Only the MuPDF context is
+   * cloned here; the document is reopened on the background thread. If
+   * either fails the index stays empty and every lookup falls back to
+   * loading the page.
+   */
+  explicit PageIndex(const Parser& prototype);
+
+  /// Stops indexing and joins the background thread.
+  ~PageIndex();
+
+  PageIndex(const PageIndex&) = delete;
+  PageIndex& operator=(const PageIndex&) = delete;
+  PageIndex(PageIndex&&) = delete;
+  PageIndex& operator=(PageIndex&&) = delete;
+
+  /// @return Specs of an indexed page, or std::nullopt if it is not indexed (yet).
+  [[nodiscard]] std::optional<PageSpecs> get(int page_num) const;
+
+  /**
+   * @brief Specs of a page, from the index or loaded with fallback.
+   * @return std::nullopt if the page is out of range or cannot be loaded.
+   */
+  [[nodiscard]] std::optional<PageSpecs> get_or_load(int page_num, const Parser& fallback) const;
+
+  /// Number of pages in the document.
+  [[nodiscard]] int num_pages() const { return static_cast<int>(m_state.size()); }
+
+  /// Whether the background thread has visited every page.
+  [[nodiscard]] bool complete() const { return m_complete.load(std::memory_order_acquire); }
+
+  /// Blocks until complete(). Used by tests and benchmarks.
+  void wait() const;
+
+ private:
+  enum State : std::uint8_t {
+    Pending,
+    Ready,
+    Failed,  ///< Could not be loaded; lookups retry through the fallback parser
+  };
+
+  void build();
+
+  Parser::DeferredParser m_open;  ///< Opens the index parser, called once on the background thread
+  // structure of arrays, written once per page before its state turns Ready
+  std::vector<float> m_x0;
+  std::vector<float> m_y0;
+  std::vector<float> m_x1;
+  std::vector<float> m_y1;
+  std::vector<std::int16_t> m_rotation;
+  std::vector<std::atomic<State>> m_state;
+  std::atomic<bool> m_stop = false;
+  std::atomic<bool> m_complete = false;
+  std::thread m_thread;
+};
+}  // namespace pdf
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
 #include <compare>
 #include <cstddef>
@@ -10,6 +11,13 @@ extern "C" {
 }
 
 namespace pdf {
+/**
+ * @brief defines a rectangle with (x0, y0) at the top left and (x1, y1) at the bottom right.
+ */
+struct Rect {
+  float x0, y0, x1, y1;
+};
+
 /**
  * @brief Contains dimensions and bounding box specifications for a PDF page.
  *
@@ -26,6 +34,36 @@ struct PageSpecs {
 
   auto operator<=>(const PageSpecs&) const = default;
 
+  /**
+   * @brief Builds the specs of a page from its bounds at the base zoom.
+   *
+   * @param bounds Page bounds, already transformed by the base zoom.
+   * @param rotation Rotation of the page in degrees.
+   * @return Specs with integer bounds rounded out from bounds.
+   */
+  [[nodiscard]] static PageSpecs from_base_bounds(const Rect& bounds, int rotation = 0) {
+    const fz_irect bbox =
+        fz_round_rect({.x0 = bounds.x0, .y0 = bounds.y0, .x1 = bounds.x1, .y1 = bounds.y1});
+    const int w = bbox.x1 - bbox.x0;
+    const int h = bbox.y1 - bbox.y0;
+    return PageSpecs{
+        .base_x0 = bounds.x0,
+        .base_y0 = bounds.y0,
+        .base_x1 = bounds.x1,
+        .base_y1 = bounds.y1,
+        .x0 = bbox.x0,
+        .y0 = bbox.y0,
+        .x1 = bbox.x1,
+        .y1 = bbox.y1,
+        .width = w,
+        .height = h,
+        .size = static_cast<size_t>(w) * g_pad * static_cast<size_t>(h),
+        .acc_width = bounds.x1 - bounds.x0,
+        .acc_height = bounds.y1 - bounds.y0,
+        .rotation = rotation,
+    };
+  }
+
   /**
    * @brief Scales the page specifications manually without reloading the page bounds.
    *
@@ -64,6 +102,17 @@ struct PageSpecs {
     };
   }
 
+  /**
+   * @brief Scale at which the page just fits a max_width x max_height pixel area.
+   *
+   * Applies to the current acc_width and acc_height, so rotate before fitting.
+   */
+  [[nodiscard]] float fit_zoom(int max_width, int max_height) const {
+    const float h_scale = static_cast<float>(max_width) / acc_width;
+    const float v_scale = static_cast<float>(max_height) / acc_height;
+    return std::min(h_scale, v_scale);
+  }
+
   /**
    * @brief Rotates the page dimensions in 90-degree clockwise increments.
    *
@@ -105,13 +154,6 @@ struct PageSpecs {
   }
 };
 
-/**
- * @brief defines a rectangle with (x0, y0) at the top left and (x1, y1) at the bottom right.
- */
-struct Rect {
-  float x0, y0, x1, y1;
-};
-
 /**
  * @brief Represents a horizontal slice of a page for parallel processing.
  */
@@ -0,0 +1,159 @@
+#include "page_text.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+char fold_ascii(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+/// Whether text byte t matches query byte q, see PageText::find().
+bool matches(char t, char q) {
+  if (q == ' ') {
+    return t == ' ' || t == '\n';
+  }
+  return fold_ascii(t) == fold_ascii(q);
+}
+
+void append_utf8(std::string& out, char32_t c) {
+  if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+    c = 0xFFFD;  // replacement character
+  }
+  if (c < 0x80) {
+    out.push_back(static_cast<char>(c));
+  } else if (c < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+    out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+  } else if (c < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+  }
+}
+
+/// Number of code points starting in text[from, to).
+std::uint32_t count_code_points(std::string_view text, std::uint32_t from, std::uint32_t to) {
+  std::uint32_t count = 0;
+  for (std::uint32_t i = from; i < to; i++) {
+    count += (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80 ? 1U : 0U;
+  }
+  return count;
+}
+}  // namespace
+
+namespace pdf {
+void PageText::begin_line(float y0, float y1) {
+  end_line();
+  m_lines.push_back({
+      .y0 = y0,
+      .y1 = y1,
+      .begin = static_cast<std::uint32_t>(m_text.size()),
+      .first_edge = static_cast<std::uint32_t>(m_edges.size()),
+  });
+  m_line_end = 0.0F;
+  m_in_line = true;
+}
+
+void PageText::add_char(char32_t c, float x0, float x1) {
+  if (!m_in_line) {
+    return;
+  }
+  // control characters would break the one '\n' per line layout
+  append_utf8(m_text, c < 0x20 ? U' ' : c);
+  m_edges.push_back(x0);
+  m_line_end = x1;
+}
+
+void PageText::end_line() {
+  if (!m_in_line) {
+    return;
+  }
+  m_in_line = false;
+  if (m_text.size() == m_lines.back().begin) {
+    m_lines.pop_back();
+    return;
+  }
+  m_edges.push_back(m_line_end);
+  m_text.push_back('\n');
+}
+
+void PageText::shrink_to_fit() {
+  end_line();
+  m_text.shrink_to_fit();
+  m_lines.shrink_to_fit();
+  m_edges.shrink_to_fit();
+}
+
+std::vector<std::uint32_t> PageTextView::find(std::string_view query) const {
+  std::vector<std::uint32_t> offsets;
+  if (query.empty()) {
+    return offsets;
+  }
+  auto it = m_text.begin();
+  while ((it = std::search(it, m_text.end(), query.begin(), query.end(), matches)) !=
+         m_text.end()) {
+    offsets.push_back(static_cast<std::uint32_t>(it - m_text.begin()));
+    it += static_cast<std::ptrdiff_t>(query.size());
+  }
+  return offsets;
+}
+
+std::vector<Rect> PageTextView::rects(std::uint32_t offset, std::uint32_t length) const {
+  std::vector<Rect> boxes;
+  const std::uint32_t end = offset + length;
+  auto line = std::upper_bound(
+      m_lines.begin(), m_lines.end(), offset, [](std::uint32_t value, const TextLine& l) {
+        return value < l.begin;
+      });
+  if (line == m_lines.begin()) {
+    return boxes;
+  }
+  for (--line; line != m_lines.end() && line->begin < end; ++line) {
+    // every line ends with '\n', which has no box
+    const auto newline = static_cast<std::uint32_t>(
+        (line + 1 != m_lines.end() ? (line + 1)->begin : m_text.size()) - 1);
+    const std::uint32_t from = std::max(offset, line->begin);
+    const std::uint32_t to = std::min(end, newline);
+    const std::size_t left_edge = line->first_edge + count_code_points(m_text, line->begin, from);
+    const std::size_t right_edge = line->first_edge + count_code_points(m_text, line->begin, to);
+    if (from >= to || right_edge >= m_edges.size()) {  // views of index files are untrusted
+      continue;
+    }
+    const float left = m_edges[left_edge];
+    const float right = m_edges[right_edge];
+    boxes.push_back({
+        .x0 = std::min(left, right),  // right to left text runs backwards
+        .y0 = line->y0,
+        .x1 = std::max(left, right),
+        .y1 = line->y1,
+    });
+  }
+  return boxes;
+}
+
+std::size_t PageText::bytes() const {
+  return m_text.capacity() + m_lines.capacity() * sizeof(TextLine) +
+         m_edges.capacity() * sizeof(float);
+}
+
+std::string PageText::normalize_query(std::string_view query) {
+  std::string normalized;
+  bool space = false;
+  for (const char c : query) {
+    if (std::isspace(static_cast<unsigned char>(c)) != 0) {
+      space = !normalized.empty();
+      continue;
+    }
+    if (space) {
+      normalized.push_back(' ');
+      space = false;
+    }
+    normalized.push_back(c);
+  }
+  return normalized;
+}
+}  // namespace pdf
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "page_specs.h"
+
+namespace pdf {
+/**
+ * @brief One line of a page's text. Stored as is in search index files.
+ */
+struct TextLine {
+  float y0, y1;
+  std::uint32_t begin;       ///< Offset of the line's first byte in the page's text
+  std::uint32_t first_edge;  ///< Index of the line's first character edge in the page's edges
+};
+static_assert(std::is_trivially_copyable_v<TextLine> && sizeof(TextLine) == 16);
+
+/**
+ * @brief Read-only view of one page's text and character positions.
+ *
+ * Points either into a PageText or into a memory-mapped SearchIndex, so
+ * both are searched the same way. See PageText for the layout.
+ */
+class PageTextView {
+ public:
+  PageTextView() = default;
+  PageTextView(std::string_view text, std::span<const TextLine> lines,
+               std::span<const float> edges)
+      : m_text(text), m_lines(lines), m_edges(edges) {}
+
+  [[nodiscard]] std::string_view text() const { return m_text; }
+  [[nodiscard]] std::span<const TextLine> lines() const { return m_lines; }
+  [[nodiscard]] std::span<const float> edges() const { return m_edges; }
+
+  /// See PageText::find().
+  [[nodiscard]] std::vector<std::uint32_t> find(std::string_view query) const;
+
+  /// See PageText::rects().
+  [[nodiscard]] std::vector<Rect> rects(std::uint32_t offset, std::uint32_t length) const;
+
+ private:
+  std::string_view m_text;
+  std::span<const TextLine> m_lines;
+  std::span<const float> m_edges;
+};
+
+/**
+ * @brief Text of one page with the position of every character, kept compact for searching.
+ *
+ * MuPDF's structured text stores a quad, font and colour per character,
+ * well over 100 bytes each. Here the text is one UTF-8 string and a
+ * character costs its bytes plus the float of its left edge; the vertical
+ * extent is shared by its line. Lines end with '\n' in text, so a match's
+ * boxes are found from its byte offsets alone.
+ *
+ * Coordinates are unrotated page bounds at the base zoom, like the base_*
+ * fields of PageSpecs.
+ */
+class PageText {
+ public:
+  PageText() = default;
+
+  /// Adopts a complete page, as read back from a search index log.
+  PageText(std::string text, std::vector<TextLine> lines, std::vector<float> edges)
+      : m_text(std::move(text)), m_lines(std::move(lines)), m_edges(std::move(edges)) {}
+
+  /**
+   * @brief Starts a new line of text.
+   * @param y0 Top of the line.
+   * @param y1 Bottom of the line.
+   */
+  void begin_line(float y0, float y1);
+
+  /**
+   * @brief Appends a character to the current line.
+   * @param c Unicode code point.
+   * @param x0 Left edge of the character.
+   * @param x1 Right edge, which ends the line's last box.
+   */
+  void add_char(char32_t c, float x0, float x1);
+
+  /// Ends the current line. Lines without characters are dropped.
+  void end_line();
+
+  /// Releases spare capacity once the page is complete.
+  void shrink_to_fit();
+
+  /// The page's text in reading order, UTF-8, each line followed by '\n'.
+  [[nodiscard]] const std::string& text() const { return m_text; }
+
+  [[nodiscard]] PageTextView view() const { return {m_text, m_lines, m_edges}; }
+
+  /**
+   * @brief Byte offsets of every match of query in text().
+   *
+   * Matching ignores ASCII case, and a space in query also matches a line
+   * break so phrases wrapping onto the next line are found. Matches do not
+   * overlap, and each is query.size() bytes long.
+   *
+   * @param query Search text, normalized with normalize_query().
+   */
+  [[nodiscard]] std::vector<std::uint32_t> find(std::string_view query) const {
+    return view().find(query);
+  }
+
+  /**
+   * @brief Boxes covering text()[offset, offset + length), one per line it spans.
+   */
+  [[nodiscard]] std::vector<Rect> rects(std::uint32_t offset, std::uint32_t length) const {
+    return view().rects(offset, length);
+  }
+
+  /// Heap bytes held, for memory accounting.
+  [[nodiscard]] std::size_t bytes() const;
+
+  /**
+   * @brief Trims a query and collapses its whitespace runs to single spaces.
+   * @return The normalized query, empty if it held nothing but whitespace.
+   */
+  [[nodiscard]] static std::string normalize_query(std::string_view query);
+
+ private:
+  std::string m_text;
+  std::vector<TextLine> m_lines;
+  /// Per line, the left edge of every character, then the right edge of the last
+  std::vector<float> m_edges;
+  float m_line_end = 0.0F;  ///< Right edge of the line being built
+  bool m_in_line = false;
+};
+}  // namespace pdf
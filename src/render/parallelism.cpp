@@ -0,0 +1,242 @@
+#include "parallelism.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+std::optional<std::string> read_file(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in) {
+    return std::nullopt;
+  }
+  return std::string{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+/// Parses the leading integer of text after skipping spaces, advancing text past it.
+template <typename T>
+std::optional<T> next_number(std::string_view& text) {
+  const std::size_t start = text.find_first_not_of(" \t");
+  if (start == std::string_view::npos) {
+    return std::nullopt;
+  }
+  T value{};
+  const auto [end, error] = std::from_chars(text.data() + start, text.data() + text.size(), value);
+  if (error != std::errc{}) {
+    return std::nullopt;
+  }
+  text.remove_prefix(static_cast<std::size_t>(end - text.data()));
+  return value;
+}
+
+/// Path of this process's cgroup v2 relative to the hierarchy root, from /proc/self/cgroup.
+std::filesystem::path own_cgroup() {
+  const auto text = read_file("/proc/self/cgroup");
+  if (!text) {
+    return {};
+  }
+  std::string_view rest = *text;
+  while (!rest.empty()) {
+    const std::size_t newline = rest.find('\n');
+    const std::string_view line = rest.substr(0, newline);
+    rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+    if (line.starts_with("0::")) {
+      return std::filesystem::path(line.substr(3)).relative_path();
+    }
+  }
+  return {};
+}
+
+/// Quota of a cgroup v1 cpu controller directory, in CPUs.
+std::optional<double> cfs_quota(const std::filesystem::path& dir) {
+  const auto quota_text = read_file(dir / "cpu.cfs_quota_us");
+  const auto period_text = read_file(dir / "cpu.cfs_period_us");
+  if (!quota_text || !period_text) {
+    return std::nullopt;
+  }
+  std::string_view quota_view = *quota_text;
+  std::string_view period_view = *period_text;
+  const auto quota = next_number<std::int64_t>(quota_view);
+  const auto period = next_number<std::int64_t>(period_view);
+  if (!quota || !period || *quota <= 0 || *period <= 0) {
+    return std::nullopt;  // -1 means no quota
+  }
+  return static_cast<double>(*quota) / static_cast<double>(*period);
+}
+
+/// CPU time used by this process so far.
+std::chrono::nanoseconds own_cpu_time() {
+#ifdef __linux__
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return {};
+  }
+  auto to_ns = [](const timeval& t) {
+    return std::chrono::seconds(t.tv_sec) + std::chrono::microseconds(t.tv_usec);
+  };
+  return to_ns(usage.ru_utime) + to_ns(usage.ru_stime);
+#else
+  return {};
+#endif
+}
+}  // namespace
+
+namespace parallelism {
+std::optional<double> parse_cpu_max(std::string_view text) {
+  if (text.starts_with("max")) {
+    return std::nullopt;
+  }
+  const auto quota = next_number<std::int64_t>(text);
+  const auto period = next_number<std::int64_t>(text);
+  if (!quota || !period || *quota <= 0 || *period <= 0) {
+    return std::nullopt;
+  }
+  return static_cast<double>(*quota) / static_cast<double>(*period);
+}
+
+std::optional<double> cpu_quota(const std::filesystem::path& cgroup_root) {
+  std::optional<double> quota;
+  auto take = [&quota](std::optional<double> q) {
+    if (q && (!quota || *q < *quota)) {
+      quota = q;
+    }
+  };
+  // a quota on any ancestor limits this cgroup too
+  const std::filesystem::path own = own_cgroup();
+  auto dir = own.empty() ? cgroup_root : cgroup_root / own;
+  while (true) {
+    if (const auto text = read_file(dir / "cpu.max")) {
+      take(parse_cpu_max(*text));
+    }
+    if (dir == cgroup_root || !dir.has_relative_path() || dir.parent_path() == dir) {
+      break;
+    }
+    dir = dir.parent_path();
+  }
+  if (!quota) {
+    take(cfs_quota(cgroup_root / "cpu"));
+    take(cfs_quota(cgroup_root / "cpu,cpuacct"));
+  }
+  return quota;
+}
+
+int available_cpus() {
+  int cpus = static_cast<int>(std::thread::hardware_concurrency());
+#ifdef __linux__
+  // taskset and cpuset containers narrow the CPUs we may run on
+  cpu_set_t affinity;
+  CPU_ZERO(&affinity);
+  if (sched_getaffinity(0, sizeof(affinity), &affinity) == 0) {
+    cpus = CPU_COUNT(&affinity);
+  }
+#endif
+  if (const auto quota = cpu_quota()) {
+    cpus = std::min(cpus, static_cast<int>(std::ceil(*quota)));
+  }
+  return std::max(cpus, 1);
+}
+
+std::optional<CpuTimes> parse_proc_stat(std::string_view text) {
+  if (!text.starts_with("cpu ")) {
+    return std::nullopt;
+  }
+  text.remove_prefix(4);
+  // user nice system idle iowait irq softirq steal; guest time is already in user
+  std::array<std::uint64_t, 8> fields{};
+  for (auto& field : fields) {
+    const auto value = next_number<std::uint64_t>(text);
+    if (!value) {
+      return std::nullopt;
+    }
+    field = *value;
+  }
+  const auto [user, nice, system, idle, iowait, irq, softirq, steal] = fields;
+  const std::uint64_t busy = user + nice + system + irq + softirq + steal;
+  return CpuTimes{.busy = busy, .total = busy + idle + iowait};
+}
+
+LoadMonitor::LoadMonitor(std::chrono::milliseconds interval)
+    : m_interval(interval), m_cpu_limit(available_cpus()), m_headroom(m_cpu_limit) {}
+
+int LoadMonitor::headroom() {
+#ifdef __linux__
+  const auto now = std::chrono::steady_clock::now();
+  if (m_system && now - m_sampled_at < m_interval) {
+    return m_headroom;
+  }
+  const auto text = read_file("/proc/stat");
+  const auto system = text ? parse_proc_stat(*text) : std::nullopt;
+  const auto own_cpu = own_cpu_time();
+  if (m_system && system && system->busy >= m_system->busy) {
+    const double wall = std::chrono::duration<double>(now - m_sampled_at).count();
+    const auto ticks_per_second = static_cast<double>(sysconf(_SC_CLK_TCK));
+    const double busy_cpus =
+        static_cast<double>(system->busy - m_system->busy) / ticks_per_second / wall;
+    const double own_cpus = std::chrono::duration<double>(own_cpu - m_own_cpu).count() / wall;
+    const double others = std::max(0.0, busy_cpus - own_cpus);
+    const auto online = static_cast<double>(std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L));
+    const int idle = static_cast<int>(std::lround(online - others));
+    m_headroom = std::clamp(idle, 1, m_cpu_limit);
+  }
+  m_system = system;
+  m_own_cpu = own_cpu;
+  m_sampled_at = now;
+  return m_headroom;
+#else
+  return m_headroom;
+#endif
+}
+
+StripTuner::StripTuner(int max_strips, std::chrono::microseconds min_strip_work)
+    : m_max_strips(std::max(max_strips, 1)), m_min_strip_work(min_strip_work) {}
+
+int StripTuner::choose(int page_num, std::size_t pixels, int cpu_budget) const {
+  const int limit = std::clamp(cpu_budget, 1, m_max_strips);
+  const auto work = predict(page_num, pixels);
+  if (!work) {
+    return limit;
+  }
+  const std::int64_t strips =
+      *work / std::chrono::duration_cast<std::chrono::nanoseconds>(m_min_strip_work);
+  return static_cast<int>(std::clamp<std::int64_t>(strips, 1, limit));
+}
+
+void StripTuner::record(int page_num, std::size_t pixels, std::chrono::nanoseconds work) {
+  if (pixels == 0) {
+    return;
+  }
+  const double ns_per_pixel = static_cast<double>(work.count()) / static_cast<double>(pixels);
+  // halfway towards the latest sample per page, a fifth for the average over pages
+  auto [it, inserted] = m_page_ns_per_pixel.try_emplace(page_num, ns_per_pixel);
+  if (!inserted) {
+    it->second += (ns_per_pixel - it->second) / 2.0;
+  }
+  if (m_average_ns_per_pixel) {
+    *m_average_ns_per_pixel += (ns_per_pixel - *m_average_ns_per_pixel) / 5.0;
+  } else {
+    m_average_ns_per_pixel = ns_per_pixel;
+  }
+}
+
+std::optional<std::chrono::nanoseconds> StripTuner::predict(int page_num,
+                                                            std::size_t pixels) const {
+  const auto it = m_page_ns_per_pixel.find(page_num);
+  const std::optional<double> ns_per_pixel =
+      it != m_page_ns_per_pixel.end() ? std::optional(it->second) : m_average_ns_per_pixel;
+  if (!ns_per_pixel) {
+    return std::nullopt;
+  }
+  return std::chrono::nanoseconds(std::llround(*ns_per_pixel * static_cast<double>(pixels)));
+}
+}  // namespace parallelism
@@ -0,0 +1,120 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief Chooses how many strips to render a page in.
+ *
+ * Splitting a page costs a fan-out and makes every strip walk the whole
+ * display list, which a small text page cannot pay back. The number of
+ * strips follows the predicted raster work of the request, capped by the CPUs
+ * the process may use (its cgroup quota) and by how busy other processes keep
+ * the machine.
+ */
+namespace parallelism {
+/**
+ * @brief Parses a cgroup v2 cpu.max file, e.g. "200000 100000".
+ * @return The quota in CPUs, or std::nullopt for "max" (no quota) or malformed text.
+ */
+[[nodiscard]] std::optional<double> parse_cpu_max(std::string_view text);
+
+/**
+ * @brief Smallest CPU quota of the cgroup this process runs in and its ancestors.
+ *
+ * Reads cgroup v2 cpu.max files under cgroup_root, falling back to the cgroup
+ * v1 cpu.cfs_quota_us and cpu.cfs_period_us pair.
+ *
+ * @return The quota in CPUs, or std::nullopt when there is none or it cannot be read.
+ */
+[[nodiscard]] std::optional<double> cpu_quota(
+    const std::filesystem::path& cgroup_root = "/sys/fs/cgroup");
+
+/// CPUs this process may use: hardware threads, limited by the cgroup quota. At least 1.
+[[nodiscard]] int available_cpus();
+
+/// Aggregate CPU time from /proc/stat, in clock ticks.
+struct CpuTimes {
+  std::uint64_t busy = 0;   ///< Everything but idle and iowait
+  std::uint64_t total = 0;
+};
+
+/**
+ * @brief Parses the aggregate "cpu" line of /proc/stat.
+ * @return The times, or std::nullopt if the line is missing or malformed.
+ */
+[[nodiscard]] std::optional<CpuTimes> parse_proc_stat(std::string_view text);
+
+/**
+ * @brief Tracks how many CPUs other processes keep busy.
+ *
+ * Samples /proc/stat and this process's own CPU time, at most once per
+ * interval, and attributes the difference to other processes. Off Linux the
+ * machine is assumed to be otherwise idle.
+ */
+class LoadMonitor {
+ public:
+  explicit LoadMonitor(std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+
+  /**
+   * @brief CPUs this process can expect to get right now, at least 1.
+   *
+   * The smaller of available_cpus(), read once at construction, and the
+   * machine's CPUs not busy with other processes.
+   */
+  [[nodiscard]] int headroom();
+
+ private:
+  std::chrono::milliseconds m_interval;
+  int m_cpu_limit;  ///< available_cpus() at construction
+  std::chrono::steady_clock::time_point m_sampled_at;
+  std::optional<CpuTimes> m_system;     ///< /proc/stat at the last sample
+  std::chrono::nanoseconds m_own_cpu{};  ///< This process's CPU time at the last sample
+  int m_headroom;
+};
+
+/**
+ * @brief Predicts raster work per page and turns it into a strip count.
+ *
+ * Work is measured as the summed time of a request's strips, so it does not
+ * depend on how many strips were used. Each page remembers its work per
+ * pixel, which captures content complexity while letting zoom changes scale
+ * the prediction; pages not rendered yet use a running average over all pages.
+ */
+class StripTuner {
+ public:
+  /**
+   * @param max_strips Upper bound on strips, e.g. the number of worker parsers.
+   * @param min_strip_work Work below which another strip costs more than it saves.
+   */
+  explicit StripTuner(int max_strips,
+                      std::chrono::microseconds min_strip_work = std::chrono::microseconds(1000));
+
+  /**
+   * @brief Number of strips for rendering pixels pixels of page_num.
+   *
+   * Before anything has been measured the page is assumed to be expensive.
+   *
+   * @param cpu_budget CPUs available for the request, see LoadMonitor::headroom().
+   * @return A count in [1, min(max_strips, cpu_budget)].
+   */
+  [[nodiscard]] int choose(int page_num, std::size_t pixels, int cpu_budget) const;
+
+  /// Records the summed strip time of a finished request.
+  void record(int page_num, std::size_t pixels, std::chrono::nanoseconds work);
+
+  /// Predicted work for a request, or std::nullopt before any measurement.
+  [[nodiscard]] std::optional<std::chrono::nanoseconds> predict(int page_num,
+                                                                std::size_t pixels) const;
+
+ private:
+  int m_max_strips;
+  std::chrono::microseconds m_min_strip_work;
+  std::unordered_map<int, double> m_page_ns_per_pixel;
+  std::optional<double> m_average_ns_per_pixel;  ///< Exponential moving average over pages
+};
+}  // namespace parallelism
@@ -1,29 +1,137 @@
 #include "parser.h"
 
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#include <unistd.h>
+
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
 #include <format>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "page_specs.h"
 #include "pdf_constants.h"
 #include "plog/Log.h"
+#include "utils/adaptive_mutex.h"
 #include "utils/logging.h"
+#include "utils/metrics.h"
 #include "utils/profiling.h"
+#include "utils/size_class_arena.h"
+
+extern "C" {
+#include <mupdf/pdf.h>
+}
 
 namespace {
+/**
+ * @brief Repair metrics, looked up once from the process-wide registry.
+ */
+struct RepairMetrics {
+  metrics::LatencyHistogram& save = metrics::registry().histogram("mupdf.repaired_copy_save");
+};
+
+RepairMetrics& repair_metrics() {
+  static RepairMetrics instance;
+  return instance;
+}
+
+// -----------------------------------------------------------------------------
+// Streams over progressively loaded documents
+// -----------------------------------------------------------------------------
+
+/// Longest open_progressive() waits for more of the document before trying again anyway.
+constexpr auto PROGRESSIVE_RETRY = std::chrono::milliseconds(100);
+
+/**
+ * @brief State of an fz_stream reading a ProgressiveSource, owned by the stream.
+ */
+struct SourceStream {
+  std::shared_ptr<pdf::ProgressiveSource> source;
+};
+
+/**
+ * @brief fz_stream next callback, exposing the received bytes at the stream position.
+ *
+ * Throws FZ_ERROR_TRYLATER when they have not arrived yet, which MuPDF passes
+ * on to whoever needed them. fz_throw unwinds with longjmp, so nothing alive
+ * here may need a destructor.
+ */
+int next_source(fz_context* ctx, fz_stream* stm, size_t /*max*/) {
+  const pdf::ProgressiveSource& source = *static_cast<SourceStream*>(stm->state)->source;
+  const bool complete = source.complete();  // before view(), so no bytes arrive in between
+  const auto bytes = source.view(static_cast<std::size_t>(stm->pos));
+  if (bytes.empty()) {
+    if (complete) {
+      return EOF;
+    }
+    fz_throw(ctx, FZ_ERROR_TRYLATER, "waiting for more of the document");
+  }
+  // MuPDF never writes through rp, fz_open_memory casts const away the same way
+  stm->rp = const_cast<unsigned char*>(bytes.data());
+  stm->wp = stm->rp + bytes.size();
+  stm->pos += static_cast<std::int64_t>(bytes.size());
+  return *stm->rp++;
+}
+
+/**
+ * @brief fz_stream seek callback. fz_seek turns SEEK_CUR into SEEK_SET before calling it.
+ *
+ * Seeking to the end needs the document length, which is known once the
+ * stream is complete or from the linearization dictionary, so opening any
+ * other PDF waits for the whole file.
+ */
+void seek_source(fz_context* ctx, fz_stream* stm, std::int64_t offset, int whence) {
+  if (whence == SEEK_END) {
+    const auto size = static_cast<SourceStream*>(stm->state)->source->expected_size();
+    if (!size) {
+      fz_throw(ctx, FZ_ERROR_TRYLATER, "document length not known yet");
+    }
+    offset += static_cast<std::int64_t>(*size);
+  }
+  stm->pos = std::max<std::int64_t>(offset, 0);
+  stm->rp = nullptr;  // next read starts at pos
+  stm->wp = nullptr;
+}
+
+void drop_source(fz_context* /*ctx*/, void* state) { delete static_cast<SourceStream*>(state); }
 
 /**
  * @brief Internal facilities for creating and adopting MuPDF contexts.
  */
 namespace mupdf_context_factory {
+using pdf::MuPDFAllocator;
 
 // -----------------------------------------------------------------------------
 // MuPDF locking configuration
 // -----------------------------------------------------------------------------
 
+/**
+ * @brief One MuPDF lock and its contention statistics.
+ *
+ * Statistics are only written while the lock is held, so plain loads and
+ * stores suffice; they are atomics so metrics can read them at any time.
+ * Each lock has its own cache line so allocator traffic does not slow down
+ * glyph cache users.
+ */
+struct alignas(64) InstrumentedLock {
+  AdaptiveMutex mutex;
+  std::atomic<std::uint64_t> acquisitions{0};
+  std::atomic<std::uint64_t> contended{0};  ///< Acquisitions that had to wait
+  std::atomic<std::uint64_t> wait_ns{0};    ///< Total time spent waiting
+};
+
 /**
  * @brief Wrapper struct for MuPDF's required threading mutexes.
  *
@@ -32,7 +140,7 @@ namespace mupdf_context_factory {
  * MuPDF requires an array of FZ_LOCK_MAX mutexes
  */
 struct MutexLocks {
-  std::array<std::mutex, FZ_LOCK_MAX> mutexes;
+  std::array<InstrumentedLock, FZ_LOCK_MAX> locks;
 };
 
 /**
@@ -43,14 +151,33 @@ struct MutexLocks {
  */
 MutexLocks global_mu_locks;
 
+/// Adds n to a counter only ever written by the holder of its lock.
+void add_held(std::atomic<std::uint64_t>& counter, std::uint64_t n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
 /**
  * @brief MuPDF callback invoked when the library needs to acquire a lock.
  *
+ * Uncontended acquisitions are not timed, so the clock is only read when the
+ * caller would have to wait anyway.
+ *
  * @param user Opaque pointer to the user-provided lock state (our MutexLocks instance).
  * @param lock The internal ID of the mutex to lock (0 to FZ_LOCK_MAX - 1).
  */
 void lock_callback(void* user, int lock) {
-  static_cast<MutexLocks*>(user)->mutexes[static_cast<size_t>(lock)].lock();
+  auto& l = static_cast<MutexLocks*>(user)->locks[static_cast<size_t>(lock)];
+  if (l.mutex.try_lock()) {
+    add_held(l.acquisitions, 1);
+    return;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  l.mutex.lock();
+  const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  add_held(l.acquisitions, 1);
+  add_held(l.contended, 1);
+  add_held(l.wait_ns, static_cast<std::uint64_t>(waited.count()));
 }
 
 /**
@@ -60,7 +187,7 @@ void lock_callback(void* user, int lock) {
  * @param lock The internal ID of the mutex to unlock.
  */
 void unlock_callback(void* user, int lock) {
-  static_cast<MutexLocks*>(user)->mutexes[static_cast<size_t>(lock)].unlock();
+  static_cast<MutexLocks*>(user)->locks[static_cast<size_t>(lock)].mutex.unlock();
 }
 
 /**
@@ -77,6 +204,150 @@ fz_locks_context make_locks_context() {
   return locks_ctx;
 }
 
+// -----------------------------------------------------------------------------
+// MuPDF allocation accounting
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Live bytes allocated through the counting allocator by every context.
+ *
+ * Block sizes include size class or C allocator rounding, so the count
+ * matches what the blocks actually occupy.
+ */
+std::atomic<std::size_t> mupdf_live_bytes{0};
+
+/**
+ * @brief Net bytes allocated minus freed by MuPDF on this thread.
+ *
+ * Only differences are meaningful: blocks freed on another thread than the
+ * one that allocated them shift the balance between threads.
+ */
+thread_local std::int64_t thread_net_bytes = 0;
+
+/// Allocator used by root contexts created from now on.
+std::atomic<MuPDFAllocator> default_allocator{MuPDFAllocator::SizeClassArena};
+
+/**
+ * @brief Allocation state of one root context and its clones, passed to MuPDF as `user`.
+ *
+ * MuPDF copies the fz_alloc_context into the context and its clones, so this
+ * object must outlive all of them; every MuPDFContext of the family holds it.
+ * The allocator is fixed at creation since blocks must be freed by the
+ * allocator that returned them.
+ */
+struct ContextAllocator {
+  std::string name;  ///< "shared_<id>" or "independent_<id>"
+  bool independent;
+  MuPDFAllocator kind;
+  fz_alloc_context alloc{};
+  std::atomic<std::size_t> live_bytes{0};
+  std::atomic<std::size_t> peak_bytes{0};
+};
+
+/// Every live context family, for reporting. Expired entries are pruned on registration.
+std::mutex allocators_mutex;
+std::vector<std::weak_ptr<ContextAllocator>> allocators;
+
+/// Usable size of a block returned by the C allocator.
+std::size_t system_block_size(void* ptr) {
+#if defined(__APPLE__)
+  return malloc_size(ptr);
+#elif defined(_WIN32)
+  return _msize(ptr);
+#else
+  return malloc_usable_size(ptr);
+#endif
+}
+
+std::size_t block_size(const ContextAllocator& owner, void* ptr) {
+  return owner.kind == MuPDFAllocator::SizeClassArena ? size_class_arena::usable_size(ptr)
+                                                      : system_block_size(ptr);
+}
+
+void add_bytes(ContextAllocator& owner, std::size_t bytes) {
+  mupdf_live_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  thread_net_bytes += static_cast<std::int64_t>(bytes);
+  const std::size_t live = owner.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  std::size_t peak = owner.peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !owner.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+void sub_bytes(ContextAllocator& owner, std::size_t bytes) {
+  mupdf_live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  thread_net_bytes -= static_cast<std::int64_t>(bytes);
+  owner.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief MuPDF allocation callbacks, forwarding to the context's allocator.
+ *
+ * The size class arena serves the small blocks that dominate MuPDF's traffic
+ * from per-thread caches. Cloned contexts still call these under
+ * FZ_LOCK_ALLOC, but for fewer cycles than a malloc that takes its own arena
+ * lock; independent contexts call them without any lock.
+ */
+void* counting_malloc(void* user, size_t size) {
+  auto& owner = *static_cast<ContextAllocator*>(user);
+  void* ptr = owner.kind == MuPDFAllocator::SizeClassArena ? size_class_arena::allocate(size)
+                                                           : std::malloc(size);
+  if (ptr != nullptr) {
+    add_bytes(owner, block_size(owner, ptr));
+  }
+  return ptr;
+}
+
+void counting_free(void* user, void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto& owner = *static_cast<ContextAllocator*>(user);
+  sub_bytes(owner, block_size(owner, ptr));
+  if (owner.kind == MuPDFAllocator::SizeClassArena) {
+    size_class_arena::deallocate(ptr);
+  } else {
+    std::free(ptr);
+  }
+}
+
+void* counting_realloc(void* user, void* old, size_t size) {
+  if (size == 0) {
+    counting_free(user, old);
+    return nullptr;
+  }
+  auto& owner = *static_cast<ContextAllocator*>(user);
+  const std::size_t old_size = old != nullptr ? block_size(owner, old) : 0;
+  void* ptr = owner.kind == MuPDFAllocator::SizeClassArena
+                  ? size_class_arena::reallocate(old, size)
+                  : std::realloc(old, size);
+  if (ptr == nullptr) {
+    return nullptr;  // old block is untouched on failure
+  }
+  sub_bytes(owner, old_size);
+  add_bytes(owner, block_size(owner, ptr));
+  return ptr;
+}
+
+/**
+ * @brief Allocation state for a new root context, inherited by its clones.
+ */
+std::shared_ptr<ContextAllocator> make_context_allocator(bool independent) {
+  static std::atomic<int> next_id{1};
+  auto owner = std::make_shared<ContextAllocator>();
+  owner->name = std::format("{}_{}",
+                            independent ? "independent" : "shared",
+                            next_id.fetch_add(1, std::memory_order_relaxed));
+  owner->independent = independent;
+  owner->kind = default_allocator.load(std::memory_order_relaxed);
+  owner->alloc = {owner.get(), counting_malloc, counting_realloc, counting_free};
+
+  std::scoped_lock lock(allocators_mutex);
+  std::erase_if(allocators, [](const auto& weak) { return weak.expired(); });
+  allocators.push_back(owner);
+  return owner;
+}
+
 // -----------------------------------------------------------------------------
 // Context ownership and publication
 // -----------------------------------------------------------------------------
@@ -106,22 +377,26 @@ using SharedContext = std::shared_ptr<pdf::MuPDFContext>;
  * constructed wrapper releases the context.
  *
  * @param owner Non-null exclusive owner to transfer.
+ * @param allocator Allocation state the context's callbacks use, kept alive with it.
  * @return A non-null shared owner of the initialized context.
  * @throws std::invalid_argument If `owner` is empty.
  * @throws std::bad_alloc If the wrapper or shared ownership control block
  * cannot be allocated.
  */
-SharedContext publish_context(ContextOwner owner) {
-  return std::make_shared<pdf::MuPDFContext>(std::move(owner));
+SharedContext publish_context(ContextOwner owner, std::shared_ptr<void> allocator) {
+  return std::make_shared<pdf::MuPDFContext>(std::move(owner), std::move(allocator));
 }
 
 /**
- * @brief Creates and initializes a MuPDF context with shared locking.
+ * @brief Creates and initializes a root MuPDF context.
  *
  * Acquires a new raw context, immediately places it under exclusive ownership,
  * and registers MuPDF's document handlers. Shared ownership is published only
  * after initialization completes successfully.
  *
+ * @param locks Locks shared with clones of the context, or nullptr for a
+ * context that is never cloned and never used by two threads at once.
+ * @param independent Whether the context is reported as independent or shared.
  * @return A non-null shared owner of the initialized context.
  * @throws std::runtime_error If MuPDF cannot allocate the context or register
  * its document handlers.
@@ -130,10 +405,10 @@ SharedContext publish_context(ContextOwner owner) {
  *
  * @note The acquired context is released automatically on every failure path.
  */
-SharedContext create_locked_context() {
+SharedContext create_context(const fz_locks_context* locks, bool independent) {
+  auto allocator = make_context_allocator(independent);
   // FZ_STORE_DEFAULT = default resource cache size
-  static fz_locks_context locks_context = make_locks_context();
-  ContextOwner owner{fz_new_context(nullptr, &locks_context, FZ_STORE_DEFAULT)};
+  ContextOwner owner{fz_new_context(&allocator->alloc, locks, FZ_STORE_DEFAULT)};
 
   if (owner == nullptr) {
     throw std::runtime_error("Failed to allocate MuPDF context");
@@ -145,9 +420,18 @@ SharedContext create_locked_context() {
     // The deleter will cleanup resources for us.
     throw std::runtime_error("Failed to register MuPDF document handlers");
   }
-  return publish_context(std::move(owner));
+  return publish_context(std::move(owner), std::move(allocator));
 }
 
+/// Root context whose clones share global_mu_locks.
+SharedContext create_locked_context() {
+  static const fz_locks_context locks_context = make_locks_context();
+  return create_context(&locks_context, false);
+}
+
+/// Root context with its own store and no locks, for use by one thread at a time.
+SharedContext create_independent_context() { return create_context(nullptr, true); }
+
 /**
  * @brief Adopts a raw cloned context and publishes shared ownership.
  *
@@ -156,6 +440,7 @@ SharedContext create_locked_context() {
  * regardless of whether the function succeeds.
  *
  * @param raw_context Context returned by `fz_clone_context()`.
+ * @param source The context that was cloned, whose allocation state the clone shares.
  * @return A non-null shared owner of the cloned context.
  * @throws std::runtime_error If `raw_context` is null.
  * @throws std::bad_alloc If the C++ wrapper or shared ownership control block
@@ -163,23 +448,94 @@ SharedContext create_locked_context() {
  *
  * @note A non-null context is released automatically if publication fails.
  */
-SharedContext adopt_context(fz_context* raw_context) {
+SharedContext adopt_context(fz_context* raw_context, const pdf::MuPDFContext& source) {
   ContextOwner owner{raw_context};
 
   if (owner == nullptr) {
     throw std::runtime_error("Failed to clone MuPDF context");
   }
 
-  return publish_context(std::move(owner));
+  return publish_context(std::move(owner), source.allocator_state());
 }
 }  // namespace mupdf_context_factory
 }  // namespace
 
+/**
+ * @brief Repaired copy of a document on disk, deleted with the last parser using it.
+ */
+struct pdf::RepairedCopy {
+  std::filesystem::path path;
+  std::shared_ptr<const MappedFile> mapped;  ///< Set with DocumentInput::MemoryMap
+
+  explicit RepairedCopy(std::filesystem::path path) : path(std::move(path)) {}
+  ~RepairedCopy() {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+  }
+  RepairedCopy(const RepairedCopy&) = delete;
+  RepairedCopy& operator=(const RepairedCopy&) = delete;
+  RepairedCopy(RepairedCopy&&) = delete;
+  RepairedCopy& operator=(RepairedCopy&&) = delete;
+};
+
 using namespace pdf;
 
-MuPDFParser::MuPDFParser(bool use_ICC) try
+std::size_t pdf::mupdf_allocated_bytes() {
+  return mupdf_context_factory::mupdf_live_bytes.load(std::memory_order_relaxed);
+}
+
+void pdf::set_mupdf_allocator(MuPDFAllocator allocator) {
+  mupdf_context_factory::default_allocator.store(allocator, std::memory_order_relaxed);
+}
+
+std::vector<ContextMemory> pdf::mupdf_context_memory() {
+  std::vector<ContextMemory> contexts;
+  std::scoped_lock lock(mupdf_context_factory::allocators_mutex);
+  for (const auto& weak : mupdf_context_factory::allocators) {
+    if (const auto owner = weak.lock()) {
+      contexts.push_back({
+          .name = owner->name,
+          .independent = owner->independent,
+          .live_bytes = owner->live_bytes.load(std::memory_order_relaxed),
+          .peak_bytes = owner->peak_bytes.load(std::memory_order_relaxed),
+      });
+    }
+  }
+  return contexts;
+}
+
+std::vector<LockStats> pdf::mupdf_lock_stats() {
+  std::vector<LockStats> stats;
+  for (std::size_t i = 0; i < mupdf_context_factory::global_mu_locks.locks.size(); i++) {
+    const auto& lock = mupdf_context_factory::global_mu_locks.locks[i];
+    std::string name;
+    switch (i) {
+      case FZ_LOCK_ALLOC:
+        name = "alloc";
+        break;
+      case FZ_LOCK_FREETYPE:
+        name = "freetype";
+        break;
+      case FZ_LOCK_GLYPHCACHE:
+        name = "glyphcache";
+        break;
+      default:
+        name = std::format("lock{}", i);
+    }
+    stats.push_back({
+        .name = std::move(name),
+        .acquisitions = lock.acquisitions.load(std::memory_order_relaxed),
+        .contended = lock.contended.load(std::memory_order_relaxed),
+        .wait = std::chrono::nanoseconds(lock.wait_ns.load(std::memory_order_relaxed)),
+    });
+  }
+  return stats;
+}
+
+MuPDFParser::MuPDFParser(bool use_ICC, DocumentInput input) try
     : m_context(mupdf_context_factory::create_locked_context()),
       m_doc(nullptr),
+      m_input(input),
       m_use_icc_profile(use_ICC) {
   fz_context* ctx = m_context->borrow();
 
@@ -223,6 +579,9 @@ void MuPDFParser::clear_doc() {
 
   m_doc_name.clear();
   m_document_path.clear();
+  m_repaired_copy.reset();
+  m_mapped.reset();
+  m_progressive.reset();
 }
 
 MuPDFParser::~MuPDFParser() { MuPDFParser::clear_doc(); }
@@ -246,20 +605,98 @@ bool MuPDFParser::load_document(const std::filesystem::path& filepath) {
     return false;
   }
 
-  resolved_path = resolved_path.lexically_normal();
+  return open_document(resolved_path.lexically_normal(), nullptr);
+}
+
+bool MuPDFParser::open_document(const std::filesystem::path& resolved_path,
+                                std::shared_ptr<const MappedFile> mapped) {
   const std::string resolved_path_string = resolved_path.string();
+  if (m_input == DocumentInput::MemoryMap && mapped == nullptr) {
+    if (auto mapping = MappedFile::open(resolved_path)) {
+      mapped = std::make_shared<const MappedFile>(std::move(*mapping));
+    } else {
+      PLOG_WARNING << mapping.error() << ", reading the file instead";
+    }
+  }
 
   fz_context* ctx = m_context->borrow();
-  fz_try(ctx) { m_doc = fz_open_document(ctx, resolved_path_string.c_str()); }
+  fz_stream* stream = nullptr;
+  fz_var(stream);
+  fz_try(ctx) {
+    if (mapped != nullptr) {
+      // the stream borrows the mapping, which m_mapped keeps alive as long as the document
+      stream = fz_open_memory(ctx, mapped->data(), mapped->size());
+      m_doc = fz_open_document_with_stream(ctx, resolved_path_string.c_str(), stream);
+    } else {
+      m_doc = fz_open_document(ctx, resolved_path_string.c_str());
+    }
+  }
+  fz_always(ctx) { fz_drop_stream(ctx, stream); }
   fz_catch(ctx) {
     PLOG_ERROR << std::format("Could not open file: {}", resolved_path_string);
     return false;
   }
+  m_mapped = std::move(mapped);
   m_document_path = resolved_path;  // save path for duplicating
   m_doc_name = m_document_path.filename().string();
   return true;
 }
 
+bool MuPDFParser::load_progressive(std::shared_ptr<ProgressiveSource> source) {
+  ensure_valid_context();
+  clear_doc();
+  if (source == nullptr) {
+    PLOG_ERROR << "Cannot load a document from a null source";
+    return false;
+  }
+  return open_progressive(std::move(source));
+}
+
+bool MuPDFParser::open_progressive(std::shared_ptr<ProgressiveSource> source) {
+  fz_context* ctx = m_context->borrow();
+  while (true) {
+    const bool complete = source->complete();
+    const std::size_t seen = source->received();
+    // owned by the stream from here on, fz_new_stream drops it if it fails
+    auto* state = new SourceStream{source};
+    fz_stream* stream = nullptr;
+    int error = FZ_ERROR_NONE;
+    fz_var(stream);
+    fz_try(ctx) {
+      stream = fz_new_stream(ctx, state, next_source, drop_source);
+      stream->seek = seek_source;
+      stream->progressive = complete ? 0 : 1;
+      m_doc = fz_open_document_with_stream(ctx, "application/pdf", stream);
+    }
+    fz_always(ctx) { fz_drop_stream(ctx, stream); }
+    fz_catch(ctx) { error = fz_caught(ctx); }
+    if (error == FZ_ERROR_NONE) {
+      break;
+    }
+    if (error != FZ_ERROR_TRYLATER || complete) {
+      PLOG_ERROR << std::format("Could not open {}: {}", source->name(), fz_caught_message(ctx));
+      return false;
+    }
+    source->wait_for_more(seen, PROGRESSIVE_RETRY);
+  }
+  m_doc_name = source->name();
+  m_progressive = std::move(source);
+  return true;
+}
+
+LoadProgress MuPDFParser::load_progress() const {
+  if (m_progressive == nullptr) {
+    return {};
+  }
+  // completion first: once complete, received is final
+  const bool complete = m_progressive->complete();
+  return {
+      .received = m_progressive->received(),
+      .expected = m_progressive->expected_size(),
+      .complete = complete,
+  };
+}
+
 const std::string& MuPDFParser::get_document_name() const { return m_doc_name; }
 
 int MuPDFParser::num_pages() const {
@@ -303,33 +740,57 @@ std::optional<PageSpecs> MuPDFParser::page_specs(int page_num) const {
 
   // raw page bounds with scaling applied
   raw_bounds = fz_transform_rect(raw_bounds, ctm);
+  return PageSpecs::from_base_bounds(
+      {.x0 = raw_bounds.x0, .y0 = raw_bounds.y0, .x1 = raw_bounds.x1, .y1 = raw_bounds.y1});
+}
 
-  // round to int
-  const fz_irect bbox = fz_round_rect(raw_bounds);
-
-  // dimensions
-  const int w = bbox.x1 - bbox.x0;
-  const int h = bbox.y1 - bbox.y0;
-  const size_t size = static_cast<size_t>(w) * g_pad * static_cast<size_t>(h);
-  const float acc_height = raw_bounds.y1 - raw_bounds.y0;
-  const float acc_width = raw_bounds.x1 - raw_bounds.x0;
-
-  return PageSpecs{
-      .base_x0 = raw_bounds.x0,
-      .base_y0 = raw_bounds.y0,
-      .base_x1 = raw_bounds.x1,
-      .base_y1 = raw_bounds.y1,
-      .x0 = bbox.x0,
-      .y0 = bbox.y0,
-      .x1 = bbox.x1,
-      .y1 = bbox.y1,
-      .width = w,
-      .height = h,
-      .size = size,
-      .acc_width = acc_width,
-      .acc_height = acc_height,
-      .rotation = 0,
-  };
+std::optional<PageText> MuPDFParser::page_text(int page_num) const {
+  ZoneScoped;
+  ensure_valid_context();
+  if (m_doc == nullptr) {
+    return std::nullopt;
+  }
+  fz_context* ctx = m_context->borrow();
+  fz_page* page = nullptr;
+  fz_stext_page* stext = nullptr;
+  fz_var(page);
+  fz_var(stext);
+  fz_try(ctx) {
+    page = fz_load_page(ctx, m_doc, page_num);
+    stext = fz_new_stext_page_from_page(ctx, page, nullptr);
+  }
+  fz_always(ctx) { fz_drop_page(ctx, page); }
+  fz_catch(ctx) {
+    PLOG_ERROR << std::format("Failed to extract text. PageNum: {}", page_num);
+    return std::nullopt;
+  }
+
+  // same scale as page_specs(), so text and page bounds share coordinates
+  const float zoom = g_base_zoom;
+  PageText text;
+  try {
+    for (const fz_stext_block* block = stext->first_block; block != nullptr; block = block->next) {
+      if (block->type != FZ_STEXT_BLOCK_TEXT) {
+        continue;
+      }
+      for (const fz_stext_line* line = block->u.t.first_line; line != nullptr; line = line->next) {
+        text.begin_line(line->bbox.y0 * zoom, line->bbox.y1 * zoom);
+        for (const fz_stext_char* ch = line->first_char; ch != nullptr; ch = ch->next) {
+          const fz_quad& q = ch->quad;
+          text.add_char(static_cast<char32_t>(ch->c),
+                        std::min(q.ul.x, q.ll.x) * zoom,
+                        std::max(q.ur.x, q.lr.x) * zoom);
+        }
+        text.end_line();
+      }
+    }
+  } catch (...) {
+    fz_drop_stext_page(ctx, stext);
+    throw;
+  }
+  fz_drop_stext_page(ctx, stext);
+  text.shrink_to_fit();
+  return text;
 }
 
 std::optional<DisplayListHandle> MuPDFParser::get_display_list(int page_num) {
@@ -346,6 +807,7 @@ std::optional<DisplayListHandle> MuPDFParser::get_display_list(int page_num) {
     PLOG_ERROR << "MuPDFParser failed to load page";
     return std::nullopt;
   }
+  const std::int64_t net_before = mupdf_context_factory::thread_net_bytes;
   fz_try(ctx) {
     raw_display_list = fz_new_display_list_from_page(ctx, page);
     fz_drop_page(ctx, page);
@@ -358,7 +820,9 @@ std::optional<DisplayListHandle> MuPDFParser::get_display_list(int page_num) {
     return std::nullopt;
   }
   try {
-    return std::make_shared<MuPDFDisplayList>(m_context, raw_display_list);
+    const std::int64_t retained = mupdf_context_factory::thread_net_bytes - net_before;
+    return std::make_shared<MuPDFDisplayList>(
+        m_context, raw_display_list, static_cast<std::size_t>(std::max<std::int64_t>(retained, 0)));
   } catch (const std::invalid_argument& e) {
     // In case internal invariants fail and null pointers passed to constructor.
     fz_drop_display_list(ctx, raw_display_list);
@@ -448,27 +912,115 @@ void MuPDFParser::write_section(int w, int h, float zoom, const PageSpecs& ps,
   fz_catch(ctx) { PLOG_ERROR << "Failed to draw page"; }
 }
 
-std::unique_ptr<Parser> MuPDFParser::duplicate() const {
-  ensure_valid_context();
+std::unique_ptr<Parser> MuPDFParser::duplicate() const { return duplicate_deferred(false)(); }
+
+std::unique_ptr<Parser> MuPDFParser::duplicate_independent() const {
+  return duplicate_deferred(true)();
+}
 
-  auto cloned_ctx = mupdf_context_factory::adopt_context(fz_clone_context(m_context->borrow()));
+Parser::DeferredParser MuPDFParser::duplicate_deferred(bool independent) const {
+  ensure_valid_context();
+  auto ctx = independent ? mupdf_context_factory::create_independent_context()
+                         : mupdf_context_factory::adopt_context(
+                               fz_clone_context(m_context->borrow()), *m_context);
+  return [use_icc = m_use_icc_profile,
+          input = m_input,
+          path = m_document_path,
+          mapped = m_mapped,
+          repaired = repaired_copy(),
+          progressive = m_progressive,
+          ctx = std::move(ctx)]() mutable {
+    return reopen_with(use_icc,
+                       input,
+                       path,
+                       std::move(mapped),
+                       std::move(repaired),
+                       std::move(progressive),
+                       std::move(ctx));
+  };
+}
 
-  auto new_parser =
-      std::unique_ptr<MuPDFParser>(new MuPDFParser(this->m_use_icc_profile, std::move(cloned_ctx)));
+std::unique_ptr<Parser> MuPDFParser::reopen_with(bool use_icc, DocumentInput input,
+                                                 const std::filesystem::path& path,
+                                                 std::shared_ptr<const MappedFile> mapped,
+                                                 std::shared_ptr<RepairedCopy> repaired,
+                                                 std::shared_ptr<ProgressiveSource> progressive,
+                                                 std::shared_ptr<MuPDFContext> ctx) {
+  auto new_parser = std::unique_ptr<MuPDFParser>(new MuPDFParser(use_icc, std::move(ctx)));
+  new_parser->m_input = input;
 
-  if (!m_document_path.empty()) {
-    if (!new_parser->load_document(this->m_document_path)) {
+  if (progressive) {
+    // the bytes the original opened with are in already, so this does not wait
+    if (!new_parser->open_progressive(std::move(progressive))) {
       throw std::runtime_error("Failed to load document for cloned parser");
     }
+  } else if (!path.empty()) {
+    const bool opened = repaired ? new_parser->open_document(repaired->path, repaired->mapped)
+                                 : new_parser->open_document(path, std::move(mapped));
+    if (!opened) {
+      throw std::runtime_error("Failed to load document for cloned parser");
+    }
+    if (repaired) {  // present the original document, not the copy
+      new_parser->m_document_path = path;
+      new_parser->m_doc_name = path.filename().string();
+      new_parser->m_repaired_copy = std::move(repaired);
+    }
   }
   return new_parser;
 }
 
+std::shared_ptr<RepairedCopy> MuPDFParser::repaired_copy() const {
+  // streamed documents are not saved, duplicates repair the buffered bytes again
+  if (m_repaired_copy != nullptr || m_doc == nullptr || m_progressive != nullptr) {
+    return m_repaired_copy;
+  }
+  fz_context* ctx = m_context->borrow();
+  pdf_document* pdf = pdf_specifics(ctx, m_doc);  // null for other formats
+  if (pdf == nullptr || pdf_was_repaired(ctx, pdf) == 0) {
+    return nullptr;
+  }
+
+  std::string path = (std::filesystem::temp_directory_path() / "pdvu-repaired-XXXXXX.pdf").string();
+  const int fd = mkstemps(path.data(), 4);
+  if (fd == -1) {
+    PLOG_WARNING << "Could not create a file for the repaired document, duplicates repair again";
+    return nullptr;
+  }
+  close(fd);
+  auto copy = std::make_shared<RepairedCopy>(path);
+
+  const auto start = std::chrono::steady_clock::now();
+  bool saved = true;
+  fz_try(ctx) {
+    pdf_write_options options = pdf_default_write_options;
+    pdf_save_document(ctx, pdf, path.c_str(), &options);
+  }
+  fz_catch(ctx) { saved = false; }
+  if (!saved) {
+    PLOG_WARNING << "Could not save the repaired document, duplicates repair again: "
+                 << fz_caught_message(ctx);
+    return nullptr;
+  }
+  repair_metrics().save.record(std::chrono::steady_clock::now() - start);
+  if (m_input == DocumentInput::MemoryMap) {
+    if (auto mapping = MappedFile::open(path)) {
+      copy->mapped = std::make_shared<const MappedFile>(std::move(*mapping));
+    }
+  }
+  PLOG_INFO << "Document was repaired, duplicates open the repaired copy " << path;
+  m_repaired_copy = std::move(copy);
+  return m_repaired_copy;
+}
+
 MuPDFParser::MuPDFParser(MuPDFParser&& other) noexcept
     : m_context(std::move(other.m_context)),
       m_doc(std::exchange(other.m_doc, nullptr)),
       m_doc_name(std::move(other.m_doc_name)),
       m_document_path(std::move(other.m_document_path)),
+      m_repaired_copy(std::move(other.m_repaired_copy)),
+      m_input(other.m_input),
+      m_mapped(std::move(other.m_mapped)),
+      m_progressive(std::move(other.m_progressive)),
       m_use_icc_profile(std::exchange(other.m_use_icc_profile, false)) {
   other.m_doc_name.clear();
   other.m_document_path.clear();
@@ -486,6 +1038,10 @@ MuPDFParser& MuPDFParser::operator=(MuPDFParser&& other) noexcept {
   other.m_doc_name.clear();
   m_document_path = std::move(other.m_document_path);
   other.m_document_path.clear();
+  m_repaired_copy = std::move(other.m_repaired_copy);
+  m_input = other.m_input;
+  m_mapped = std::move(other.m_mapped);
+  m_progressive = std::move(other.m_progressive);
   m_use_icc_profile = std::exchange(other.m_use_icc_profile, false);
 
   return *this;
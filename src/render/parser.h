@@ -1,12 +1,20 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "mupdf_resources.h"
 #include "page_specs.h"
+#include "page_text.h"
+#include "progressive_source.h"
+#include "utils/mapped_file.h"
 
 namespace pdf {
 
@@ -28,6 +36,15 @@ namespace pdf {
  */
 using DisplayListHandle = std::shared_ptr<MuPDFDisplayList>;
 
+/**
+ * @brief How much of a document read from a stream has arrived.
+ */
+struct LoadProgress {
+  std::size_t received = 0;             ///< Bytes received so far
+  std::optional<std::size_t> expected;  ///< Length of the whole document, if known yet
+  bool complete = true;                 ///< False while pages may still be missing
+};
+
 /**
  * @brief Abstract interface defining the core operations of a PDF parser.
  */
@@ -53,6 +70,26 @@ struct Parser {
    */
   virtual bool load_document(const std::filesystem::path& filepath) = 0;
 
+  /**
+   * @brief Loads a PDF document while it is still arriving.
+   *
+   * Blocks until enough of the document is in to open it: the first page of a
+   * linearized PDF, the whole file otherwise. Pages whose data has not arrived
+   * yet fail to load until it does, see load_progress().
+   *
+   * @param source The document's bytes, shared with duplicates of this parser.
+   * @return True if loaded successfully, false otherwise.
+   */
+  virtual bool load_progressive(std::shared_ptr<ProgressiveSource> source) = 0;
+
+  /**
+   * @brief Progress of a document loaded with load_progressive().
+   *
+   * Only reads counters of the source, so it is cheap and may be called from
+   * any thread. Documents loaded from a file are always complete.
+   */
+  [[nodiscard]] virtual LoadProgress load_progress() const = 0;
+
   /** @return The filename of the currently loaded document. */
   [[nodiscard]] virtual const std::string& get_document_name() const = 0;
 
@@ -66,6 +103,13 @@ struct Parser {
   /** @return The total number of pages in the loaded document. */
   [[nodiscard]] virtual int num_pages() const = 0;
 
+  /**
+   * @brief Extracts the text of a page with the position of every character.
+   * @param page_num The 0-indexed page number.
+   * @return The text, or std::nullopt if the page cannot be loaded.
+   */
+  [[nodiscard]] virtual std::optional<PageText> page_text(int page_num) const = 0;
+
   /**
    * @brief Parses a page into a reusable MuPDF display list.
    *
@@ -107,6 +151,9 @@ struct Parser {
   /**
    * @brief Clones the MuPDF context and reopens the currently loaded document.
    *
+   * If MuPDF had to repair the document, duplicates open a repaired copy so the
+   * repair is not repeated.
+   *
    * @return A unique pointer to the duplicated parser.
    * @throws std::runtime_error If the parser is moved-from, context cloning
    * fails, or the document cannot be reopened.
@@ -114,6 +161,43 @@ struct Parser {
    * allocated.
    */
   [[nodiscard]] virtual std::unique_ptr<Parser> duplicate() const = 0;
+
+  /**
+   * @brief Reopens the current document with a new root context and store.
+   *
+   * The result shares no locks or cache with this parser, so it never waits
+   * on other threads, but it parses and caches resources again and cannot use
+   * display lists created by any other parser.
+   *
+   * @return A unique pointer to the new parser.
+   * @throws std::runtime_error If the parser is moved-from, context creation
+   * fails, or the document cannot be reopened.
+   */
+  [[nodiscard]] virtual std::unique_ptr<Parser> duplicate_independent() const = 0;
+
+  /// Reopens the document for duplicate_deferred(). Call once, from any thread.
+  using DeferredParser = std::function<std::unique_ptr<Parser>()>;
+
+  /**
+   * @brief Splits duplicate() or duplicate_independent() into a cheap and a slow half.
+   *
+   * The MuPDF context is set up now, on the thread owning this parser. Reopening the
+   * document, which parses its cross-reference table again, is left to the returned
+   * function so several parsers can open the document in parallel. The function does
+   * not refer to this parser and may outlive it.
+   *
+   * @param independent Whether the new parser gets its own root context and store.
+   * @throws std::runtime_error If the parser is moved-from or context creation fails.
+   */
+  [[nodiscard]] virtual DeferredParser duplicate_deferred(bool independent) const = 0;
+};
+
+struct RepairedCopy;
+
+/// How MuPDFParser reads the document file.
+enum class DocumentInput {
+  File,       ///< MuPDF opens the file itself, a descriptor and stdio buffer per parser
+  MemoryMap,  ///< Mapped once and shared read-only by the parser and all its duplicates
 };
 
 /**
@@ -127,11 +211,12 @@ class MuPDFParser : public Parser {
    * @brief Constructs a parser with a fresh, lock-enabled MuPDF context.
    *
    * @param use_icc Whether to enable ICC color management.
+   * @param input How documents are read. Files that cannot be mapped are opened normally.
    * @throws std::runtime_error If context allocation or document-handler
    * registration fails.
    * @throws std::bad_alloc If C++ ownership state cannot be allocated.
    */
-  explicit MuPDFParser(bool use_icc);
+  explicit MuPDFParser(bool use_icc, DocumentInput input = DocumentInput::File);
   ~MuPDFParser() override;
 
   // Parser instances are non-copyable.
@@ -144,23 +229,62 @@ class MuPDFParser : public Parser {
 
   void clear_doc() override;
   bool load_document(const std::filesystem::path& filepath) override;
+  bool load_progressive(std::shared_ptr<ProgressiveSource> source) override;
+  [[nodiscard]] LoadProgress load_progress() const override;
   [[nodiscard]] const std::string& get_document_name() const override;
   [[nodiscard]] std::optional<PageSpecs> page_specs(int page_num) const override;
   [[nodiscard]] int num_pages() const override;
+  [[nodiscard]] std::optional<PageText> page_text(int page_num) const override;
   [[nodiscard]] std::optional<DisplayListHandle> get_display_list(int page_num) override;
   void write_section(int w, int h, float zoom, const PageSpecs& ps, DisplayListHandle dlist,
                      unsigned char* buffer, Rect clip) override;
   [[nodiscard]] std::unique_ptr<Parser> duplicate() const override;
+  [[nodiscard]] std::unique_ptr<Parser> duplicate_independent() const override;
+  [[nodiscard]] DeferredParser duplicate_deferred(bool independent) const override;
 
  private:
   /**
    * @brief Constructs the parser, with a cloned MuPDF context.
    * @param use_ICC Whether to enable ICC color management.
-   * @param cloned_ctx Shared ownership of a cloned MuPDF context.
+   * @param cloned_ctx Shared ownership of a cloned or independent MuPDF context.
    * @throws std::invalid_argument if a null cloned_ctx is given.
    */
   explicit MuPDFParser(bool use_ICC, std::shared_ptr<MuPDFContext> cloned_ctx);
 
+  /**
+   * @brief Creates a parser on ctx and loads the document at path into it.
+   * @throws std::runtime_error if the document cannot be reopened.
+   */
+  [[nodiscard]] static std::unique_ptr<Parser> reopen_with(
+      bool use_icc, DocumentInput input, const std::filesystem::path& path,
+      std::shared_ptr<const MappedFile> mapped, std::shared_ptr<RepairedCopy> repaired,
+      std::shared_ptr<ProgressiveSource> progressive, std::shared_ptr<MuPDFContext> ctx);
+
+  /**
+   * @brief Opens the document at resolved_path, from mapped if given.
+   * @return false if MuPDF cannot open it.
+   */
+  bool open_document(const std::filesystem::path& resolved_path,
+                     std::shared_ptr<const MappedFile> mapped);
+
+  /**
+   * @brief Opens the document in source, retrying each time more of it arrives.
+   * @return false if MuPDF cannot open it even though enough has arrived.
+   */
+  bool open_progressive(std::shared_ptr<ProgressiveSource> source);
+
+  /**
+   * @brief Copy of the loaded document for duplicates to open, if MuPDF repaired it.
+   *
+   * Repairing rebuilds the xref by scanning the whole file, which every reopen
+   * would do again. The first call on a repaired document saves it once, in
+   * full since MuPDF refuses incremental saves of repaired files, and later
+   * calls and duplicates share that copy.
+   *
+   * @return The copy, or nullptr if the document was not repaired or saving failed.
+   */
+  std::shared_ptr<RepairedCopy> repaired_copy() const;
+
   /**
    * @brief checks if context is still valid (not nullptr)
    * @throws std::runtime_error if context is invalid (e.g. calling parser methods after
@@ -179,6 +303,61 @@ class MuPDFParser : public Parser {
    * Empty when no document is loaded.
    */
   std::filesystem::path m_document_path;
+  /// Repaired copy of the document that duplicates open instead, shared between them
+  mutable std::shared_ptr<RepairedCopy> m_repaired_copy;
+  DocumentInput m_input = DocumentInput::File;
+  /// Mapping m_doc reads from with DocumentInput::MemoryMap, shared with duplicates
+  std::shared_ptr<const MappedFile> m_mapped;
+  /// Stream m_doc reads from when loaded with load_progressive(), shared with duplicates
+  std::shared_ptr<ProgressiveSource> m_progressive;
   bool m_use_icc_profile;  ///< Flag indicating if ICC colour profiles are active
 };
+
+/**
+ * @brief Bytes currently allocated by MuPDF across every context.
+ *
+ * Counted by the allocator installed on the root context, so it covers the
+ * resource store, display lists and documents shared by all clones.
+ */
+[[nodiscard]] std::size_t mupdf_allocated_bytes();
+
+/// Allocator behind MuPDF's allocation callbacks.
+enum class MuPDFAllocator {
+  SizeClassArena,  ///< Per-thread size class caches, see utils/size_class_arena.h
+  System,          ///< The C allocator
+};
+
+/**
+ * @brief Selects the allocator of root contexts created from now on.
+ *
+ * Clones keep the allocator of the context they were cloned from. The default
+ * is MuPDFAllocator::SizeClassArena; System exists for comparison.
+ */
+void set_mupdf_allocator(MuPDFAllocator allocator);
+
+/**
+ * @brief Memory allocated through one root context and its clones.
+ */
+struct ContextMemory {
+  std::string name;  ///< e.g. "shared_1", or "independent_3" for a worker's own context
+  bool independent = false;
+  std::size_t live_bytes = 0;
+  std::size_t peak_bytes = 0;  ///< Largest live_bytes since the context was created
+};
+
+/// Every context family still alive, in creation order.
+[[nodiscard]] std::vector<ContextMemory> mupdf_context_memory();
+
+/**
+ * @brief Contention statistics of one lock shared by cloned MuPDF contexts.
+ */
+struct LockStats {
+  std::string name;  ///< MuPDF lock, e.g. "alloc" or "glyphcache"
+  std::uint64_t acquisitions = 0;
+  std::uint64_t contended = 0;       ///< Acquisitions that found the lock held
+  std::chrono::nanoseconds wait{0};  ///< Total time spent waiting for the lock
+};
+
+/// Statistics of every lock since process start, in MuPDF lock id order.
+[[nodiscard]] std::vector<LockStats> mupdf_lock_stats();
 }  // namespace pdf
@@ -0,0 +1,199 @@
+#include "progressive_source.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <utility>
+
+#include "plog/Log.h"
+#include "utils/logging.h"
+#include "utils/metrics.h"
+#include "utils/profiling.h"
+
+namespace {
+/// Size of each buffer chunk. Parsers see at most one chunk per read.
+constexpr std::size_t CHUNK_SIZE = std::size_t{1} << 20;
+/// The linearization dictionary must start within the first 1024 bytes of a PDF.
+constexpr std::size_t LINEARIZATION_SCAN_BYTES = 1024;
+/// How often the reader checks whether it should stop while the writer is idle.
+constexpr int POLL_TIMEOUT_MS = 100;
+
+/**
+ * @brief Progressive loading metrics, looked up once from the process-wide registry.
+ */
+struct SourceMetrics {
+  /// Source opened to the last byte received
+  metrics::LatencyHistogram& load = metrics::registry().histogram("progressive.load");
+  metrics::Counter& bytes = metrics::registry().counter("progressive.bytes");
+};
+
+SourceMetrics& source_metrics() {
+  static SourceMetrics instance;
+  return instance;
+}
+
+bool is_pdf_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\0';
+}
+}  // namespace
+
+namespace pdf {
+std::expected<std::shared_ptr<ProgressiveSource>, std::string> ProgressiveSource::open(
+    const std::filesystem::path& path) {
+  if (path == "-") {
+    const int fd = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0);
+    if (fd == -1) {
+      return std::unexpected(std::format("Cannot read stdin: {}", strerror(errno)));
+    }
+    return std::make_shared<ProgressiveSource>(fd, "stdin");
+  }
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return std::unexpected(std::format("Cannot open {}: {}", path.string(), strerror(errno)));
+  }
+  return std::make_shared<ProgressiveSource>(fd, path.filename().string());
+}
+
+ProgressiveSource::ProgressiveSource(int fd, std::string name) : m_fd(fd), m_name(std::move(name)) {
+  m_thread = std::thread(&ProgressiveSource::read_loop, this);
+}
+
+ProgressiveSource::~ProgressiveSource() {
+  m_stop.store(true, std::memory_order_relaxed);
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  close(m_fd);
+}
+
+void ProgressiveSource::read_loop() {
+  chrome_trace::set_thread_name("document reader");
+  const auto start = std::chrono::steady_clock::now();
+  bool scanning = true;  // still looking for the linearization dictionary
+  while (!m_stop.load(std::memory_order_relaxed)) {
+    pollfd pfd{.fd = m_fd, .events = POLLIN, .revents = 0};
+    const int ready = poll(&pfd, 1, POLL_TIMEOUT_MS);
+    if (ready == 0 || (ready == -1 && errno == EINTR)) {
+      continue;
+    }
+    if (ready == -1) {
+      PLOG_ERROR << std::format("Reading {} failed: {}", m_name, strerror(errno));
+      break;
+    }
+
+    // only this thread appends, so received and the last chunk cannot change under us
+    const std::size_t received = m_received.load(std::memory_order_relaxed);
+    const std::size_t in_chunk = received % CHUNK_SIZE;
+    unsigned char* chunk = nullptr;
+    {
+      std::scoped_lock lock(m_mutex);
+      if (received / CHUNK_SIZE == m_chunks.size()) {
+        m_chunks.push_back(std::make_unique_for_overwrite<unsigned char[]>(CHUNK_SIZE));
+      }
+      chunk = m_chunks.back().get();
+    }
+    const ssize_t n = read(m_fd, chunk + in_chunk, CHUNK_SIZE - in_chunk);
+    if (n == -1 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    }
+    if (n == -1) {
+      PLOG_ERROR << std::format("Reading {} failed: {}", m_name, strerror(errno));
+      break;
+    }
+    if (n == 0) {
+      break;  // writer closed its end
+    }
+    const std::size_t total = received + static_cast<std::size_t>(n);
+    if (scanning) {  // before publishing, so readers seeing the bytes also see the length
+      const std::size_t head = std::min(total, LINEARIZATION_SCAN_BYTES);
+      const auto length = parse_linearized_length(
+          {reinterpret_cast<const char*>(m_chunks.front().get()), head});
+      if (length) {
+        m_linearized_length.store(*length, std::memory_order_release);
+      }
+      scanning = !length && head < LINEARIZATION_SCAN_BYTES;
+    }
+    {
+      std::scoped_lock lock(m_mutex);
+      m_received.store(total, std::memory_order_release);
+    }
+    m_arrived.notify_all();
+    source_metrics().bytes.add(static_cast<std::uint64_t>(n));
+  }
+
+  {
+    std::scoped_lock lock(m_mutex);
+    m_complete.store(true, std::memory_order_release);
+  }
+  m_arrived.notify_all();
+  source_metrics().load.record(std::chrono::steady_clock::now() - start);
+  const std::size_t declared = m_linearized_length.load(std::memory_order_relaxed);
+  if (declared != 0 && declared != received()) {
+    PLOG_WARNING << std::format(
+        "{} declared {} bytes but {} arrived, later pages may fail", m_name, declared, received());
+  }
+  PLOG_INFO << std::format("Received all {} bytes of {}", received(), m_name);
+}
+
+std::optional<std::size_t> ProgressiveSource::expected_size() const {
+  if (complete()) {
+    return received();
+  }
+  const std::size_t declared = m_linearized_length.load(std::memory_order_acquire);
+  return declared != 0 ? std::optional(declared) : std::nullopt;
+}
+
+std::span<const unsigned char> ProgressiveSource::view(std::size_t offset) const {
+  const std::size_t available = received();
+  if (offset >= available) {
+    return {};
+  }
+  const std::size_t index = offset / CHUNK_SIZE;
+  const unsigned char* chunk = nullptr;
+  {
+    std::scoped_lock lock(m_mutex);  // the chunk vector may be growing
+    chunk = m_chunks[index].get();
+  }
+  const std::size_t chunk_end = std::min(available, (index + 1) * CHUNK_SIZE);
+  return {chunk + offset % CHUNK_SIZE, chunk_end - offset};
+}
+
+bool ProgressiveSource::wait_for_more(std::size_t seen, std::chrono::milliseconds timeout) const {
+  std::unique_lock lock(m_mutex);
+  return m_arrived.wait_for(lock, timeout, [&] { return received() > seen || complete(); });
+}
+
+std::optional<std::size_t> ProgressiveSource::parse_linearized_length(std::string_view head) {
+  const auto key = head.find("/Linearized");
+  const auto begin = head.rfind("<<", key);
+  const auto end = head.find(">>", key);
+  if (key == std::string_view::npos || begin == std::string_view::npos ||
+      end == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const auto dict = head.substr(begin, end - begin);
+  for (auto pos = dict.find("/L"); pos != std::string_view::npos; pos = dict.find("/L", pos + 2)) {
+    auto value = dict.substr(pos + 2);
+    if (!value.empty() && std::isalpha(static_cast<unsigned char>(value.front())) != 0) {
+      continue;  // another key starting with L, such as /Linearized itself
+    }
+    while (!value.empty() && is_pdf_whitespace(value.front())) {
+      value.remove_prefix(1);
+    }
+    std::size_t length = 0;
+    const auto [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), length);
+    if (error != std::errc{} || length == 0) {
+      return std::nullopt;
+    }
+    return length;
+  }
+  return std::nullopt;
+}
+}  // namespace pdf
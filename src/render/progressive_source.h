@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace pdf {
+/**
+ * @brief A document arriving over a pipe, buffered in memory as it is read.
+ *
+ * A background thread reads stdin or a FIFO until end of file and appends the
+ * bytes to fixed-size chunks, so everything received stays at the same
+ * address and parsers may read it while more arrives. MuPDF reads through a
+ * stream over the source, which asks it to try again later when it needs
+ * bytes that have not arrived yet. Linearized PDFs declare their length in the
+ * first object, which lets MuPDF open them and load the first page before the
+ * rest of the file is in.
+ */
+class ProgressiveSource {
+ public:
+  /**
+   * @brief Starts reading path, or stdin if path is "-".
+   *
+   * Opening a FIFO blocks until a writer opens it. stdin is duplicated, so the
+   * caller may point STDIN_FILENO elsewhere afterwards.
+   *
+   * @return The source, or an error message if path cannot be opened.
+   */
+  [[nodiscard]] static std::expected<std::shared_ptr<ProgressiveSource>, std::string> open(
+      const std::filesystem::path& path);
+
+  /**
+   * @brief Starts reading an already open descriptor, taking ownership of it.
+   * @param name Document name, e.g. "stdin" or the FIFO's filename.
+   */
+  ProgressiveSource(int fd, std::string name);
+
+  /// Stops reading and closes the descriptor.
+  ~ProgressiveSource();
+
+  ProgressiveSource(const ProgressiveSource&) = delete;
+  ProgressiveSource& operator=(const ProgressiveSource&) = delete;
+  ProgressiveSource(ProgressiveSource&&) = delete;
+  ProgressiveSource& operator=(ProgressiveSource&&) = delete;
+
+  /// Name the document is shown under.
+  [[nodiscard]] const std::string& name() const { return m_name; }
+
+  /// Bytes received so far.
+  [[nodiscard]] std::size_t received() const { return m_received.load(std::memory_order_acquire); }
+
+  /// Whether the writer closed its end or reading failed; no more bytes will arrive.
+  [[nodiscard]] bool complete() const { return m_complete.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Length of the whole document, if known.
+   * @return The received size once complete, before that the length declared by a
+   * linearized PDF, otherwise std::nullopt.
+   */
+  [[nodiscard]] std::optional<std::size_t> expected_size() const;
+
+  /**
+   * @brief Received bytes from offset up to the end of their chunk.
+   *
+   * The bytes never move or change, so the span stays valid for the lifetime
+   * of the source. Call again at the end of the span for the next chunk.
+   *
+   * @return Empty if nothing at or after offset has arrived yet.
+   */
+  [[nodiscard]] std::span<const unsigned char> view(std::size_t offset) const;
+
+  /**
+   * @brief Blocks until more than seen bytes arrived, the source completed, or timeout.
+   * @return true unless the timeout expired first.
+   */
+  bool wait_for_more(std::size_t seen, std::chrono::milliseconds timeout) const;
+
+  /**
+   * @brief Length declared by the linearization dictionary at the start of a PDF.
+   *
+   * @param head The first bytes of the document.
+   * @return The /L value, or std::nullopt if head does not hold a complete
+   * linearization dictionary.
+   */
+  [[nodiscard]] static std::optional<std::size_t> parse_linearized_length(std::string_view head);
+
+ private:
+  void read_loop();
+
+  int m_fd;
+  std::string m_name;
+  mutable std::mutex m_mutex;  ///< Guards m_chunks and pairs with m_arrived
+  mutable std::condition_variable m_arrived;
+  std::vector<std::unique_ptr<unsigned char[]>> m_chunks;
+  std::atomic<std::size_t> m_received = 0;
+  std::atomic<bool> m_complete = false;
+  /// /L of a linearized PDF, 0 if unknown. Only looked for in the first bytes.
+  std::atomic<std::size_t> m_linearized_length = 0;
+  std::atomic<bool> m_stop = false;
+  std::thread m_thread;
+};
+}  // namespace pdf
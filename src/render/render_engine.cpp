@@ -1,22 +1,106 @@
 #include "render_engine.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <format>
+#include <tuple>
 
 #include "bounds.h"
 #include "plog/Log.h"
 #include "utils/logging.h"
+#include "utils/metrics.h"
+#include "utils/perf_counters.h"
 #include "utils/profiling.h"
 
-RenderEngine::RenderEngine(const pdf::Parser& prototype_parser, int n_threads, bool use_cache)
-    : n_threads_(n_threads), use_cache(use_cache) {
+namespace {
+/**
+ * @brief Render engine metrics, looked up once from the process-wide registry.
+ */
+struct EngineMetrics {
+  metrics::LatencyHistogram& geometry = metrics::registry().histogram("render.geometry");
+  metrics::LatencyHistogram& display_list_build =
+      metrics::registry().histogram("render.display_list_build");
+  metrics::LatencyHistogram& raster = metrics::registry().histogram("render.raster");
+  metrics::LatencyHistogram& total = metrics::registry().histogram("render.total");
+  metrics::Counter& frames = metrics::registry().counter("render.frames");
+  metrics::Counter& errors = metrics::registry().counter("render.errors");
+  // requests for pages of a streamed document whose data had not arrived yet
+  metrics::Counter& placeholders = metrics::registry().counter("render.placeholders");
+  metrics::Counter& page_hits = metrics::registry().counter("cache.page.hits");
+  metrics::Counter& page_misses = metrics::registry().counter("cache.page.misses");
+  metrics::Counter& dlist_hits = metrics::registry().counter("cache.display_list.hits");
+  metrics::Counter& dlist_misses = metrics::registry().counter("cache.display_list.misses");
+  // strips per rendered page, averaged through the requests counter
+  metrics::Counter& strips = metrics::registry().counter("render.parallelism.strips");
+  metrics::Counter& strip_requests = metrics::registry().counter("render.parallelism.requests");
+  metrics::Gauge& cpu_headroom = metrics::registry().gauge("render.parallelism.cpu_headroom");
+  // engine construction to the first frame, and to every worker parser having tried to open
+  metrics::LatencyHistogram& first_frame = metrics::registry().histogram("startup.first_frame");
+  metrics::LatencyHistogram& workers_ready =
+      metrics::registry().histogram("startup.workers_ready");
+  perf_counters::StageCounters perf_display_list{"display_list"};
+  perf_counters::StageCounters perf_raster{"raster"};
+};
+
+EngineMetrics& engine_metrics() {
+  static EngineMetrics instance;
+  return instance;
+}
+}  // namespace
+
+std::pair<float, pdf::PageSpecs> resolve_geometry(const pdf::PageSpecs& base,
+                                                  const PageIntent& intent) {
+  const auto rotated = base.rotate_quarter_clockwise(intent.rotation_degrees / 90);
+  const float zoom = rotated.fit_zoom(intent.viewport_width, intent.viewport_height) * intent.zoom;
+  return {zoom, rotated.scale(zoom)};
+}
+
+RenderEngine::RenderEngine(const pdf::Parser& prototype_parser, int n_threads, bool use_cache,
+                           WorkerContexts worker_contexts, StripPolicy strip_policy)
+    : created_at(std::chrono::steady_clock::now()),
+      worker_contexts(worker_contexts),
+      n_threads_(n_threads),
+      strip_policy(strip_policy),
+      strip_tuner(n_threads),
+      use_cache(use_cache) {
   // parser created first because during shutdown, any context from parser must
   // be cleared after threadpool shutdown
   parser = prototype_parser.duplicate();
-  for (auto i = 0; i < n_threads; i++) {
-    worker_parsers.emplace_back(prototype_parser.duplicate());
-  }
+  page_index = std::make_unique<pdf::PageIndex>(prototype_parser);
+  const auto n_workers = static_cast<std::size_t>(std::max(n_threads, 0));
+  worker_parsers.resize(n_workers);
+  worker_ready = std::vector<std::atomic<bool>>(n_workers);
+  worker_dlists.resize(n_workers, {-1, nullptr});
+  ready_workers.reserve(n_workers);
 
-  thread_pool = std::make_unique<ThreadPool>(static_cast<std::size_t>(n_threads));
+  thread_pool = std::make_unique<ThreadPool>(n_workers);
+  // Contexts are cloned here, on the thread owning the prototype. Reopening the
+  // document parses its xref again, so workers do that in parallel on the pool
+  // and strips only go to workers that are done.
+  for (std::size_t i = 0; i < n_workers; i++) {
+    auto open = prototype_parser.duplicate_deferred(worker_contexts ==
+                                                    WorkerContexts::Independent);
+    (void)thread_pool->submit([this, i, open = std::move(open)]() mutable {
+      ZoneScopedN("open worker parser");
+      try {
+        worker_parsers[i] = open();
+        worker_ready[i].store(true, std::memory_order_release);
+      } catch (const std::exception& e) {
+        PLOG_ERROR << "Worker parser " << i << " failed to open the document: " << e.what();
+        workers_failed.fetch_add(1, std::memory_order_relaxed);
+      }
+      // failed opens count as finished, so the last attempt always records
+      if (workers_opened.fetch_add(1, std::memory_order_acq_rel) + 1 == worker_parsers.size()) {
+        engine_metrics().workers_ready.record(std::chrono::steady_clock::now() - created_at);
+        if (const auto failed = workers_failed.load(std::memory_order_relaxed); failed > 0) {
+          PLOG_WARNING << failed << " of " << worker_parsers.size()
+                       << " worker parsers failed to open; startup.workers_ready covers the rest";
+        }
+      }
+    });
+  }
   worker = std::thread(&RenderEngine::coordinator_loop, this);
 }
 
@@ -44,6 +128,39 @@ std::size_t RenderEngine::request_page(int page_num, float zoom, pdf::PageSpecs
   return id;
 }
 
+std::size_t RenderEngine::request_page(const PageIntent& intent, const std::string& transmission) {
+  std::size_t id;
+  {
+    std::scoped_lock lock(state_mutex);
+    id = ++current_req_id;
+    pending_request = RenderRequest{
+        .page_num = intent.page_num,
+        .zoom = intent.zoom,
+        .scaled_page_specs = {},
+        .req_id = id,
+        .transmission = transmission,
+        .intent = intent,
+    };
+  }
+  cv_worker.notify_one();
+  return id;
+}
+
+std::optional<pdf::PageSpecs> RenderEngine::indexed_page_specs(int page_num) const {
+  return page_index->get(page_num);
+}
+
+EngineMemory RenderEngine::memory_breakdown() {
+  return {
+      .page_cache = page_cache.total_weight(
+          [](const PageCacheData& data) { return data.rendered_page_specs.size; }),
+      .display_list_cache = dlist_cache.total_weight(
+          [](const pdf::DisplayListHandle& dlist) { return dlist->estimated_bytes(); }),
+      .pending_transmission = pending_bytes.load(std::memory_order_relaxed),
+      .current_transmission = current_bytes.load(std::memory_order_relaxed),
+  };
+}
+
 std::optional<RenderResult> RenderEngine::get_result() {  // get the most recently created image
   // want to leave latest_result as a std::nullopt after move
   // std::swap does this for us automatically
@@ -57,7 +174,7 @@ void RenderEngine::coordinator_loop() {
   /* Main job is to wake on new request, then break down and enqueue tasks to the
    * threadpool to execute
    */
-
+  chrome_trace::set_thread_name("render coordinator");
   while (running) {
     RenderRequest req;
     // wait for work
@@ -70,51 +187,119 @@ void RenderEngine::coordinator_loop() {
       req = std::move(pending_request.value());
       pending_request.reset();
     }
+    const chrome_trace::RequestScope trace_scope(req.req_id, req.page_num);
+    // read before loading the page: failing while the document was still arriving
+    // may only mean the page's data is not in yet
+    const bool loading = !parser->load_progress().complete;
+    if (req.intent && !resolve_intent(req)) {
+      RenderResult result{};
+      result.req_id = req.req_id;
+      result.page_num = req.page_num;
+      mark_failed(result, std::format("Failed to load page {}", req.page_num + 1), loading);
+      std::scoped_lock lock(state_mutex);
+      latest_result = std::move(result);
+      continue;
+    }
     dispatch_page_write(req);
   }
 }
 
+bool RenderEngine::resolve_intent(RenderRequest& req) {
+  ZoneScoped;
+  const auto start = std::chrono::steady_clock::now();
+  const auto base = page_index->get_or_load(req.page_num, *parser);
+  engine_metrics().geometry.record(std::chrono::steady_clock::now() - start);
+  if (!base) {
+    return false;
+  }
+  std::tie(req.zoom, req.scaled_page_specs) = resolve_geometry(*base, *req.intent);
+  return true;
+}
+
+void RenderEngine::mark_failed(RenderResult& result, std::string message, bool loading) {
+  if (loading) {
+    result.pending = true;
+    engine_metrics().placeholders.add();
+  } else {
+    engine_metrics().errors.add();
+  }
+  result.error_message = std::move(message);
+}
+
 void RenderEngine::dispatch_page_write(const RenderRequest& req) {
   ZoneScopedN("dispatch_page_write");
   using namespace std::chrono;
   auto start = steady_clock::now();
+  const bool loading = !parser->load_progress().complete;
   RenderResult result{};
   result.req_id = req.req_id;
   result.page_num = req.page_num;
   result.transmission = req.transmission;
   result.rendered_page_specs = req.scaled_page_specs;
+  result.zoom = req.zoom;
   std::shared_ptr<SharedMemory> new_shm = nullptr;
   std::shared_ptr<Tempfile> new_temp = nullptr;
 
-  auto update_frame = [&](int render_time_ms) {
-    result.render_time_ms = render_time_ms;
+  auto update_frame = [&](steady_clock::duration render_time) {
+    result.render_time = duration_cast<microseconds>(render_time);
+    if (result.error_message.empty()) {
+      if (!first_frame_done) {
+        first_frame_done = true;
+        engine_metrics().first_frame.record(steady_clock::now() - created_at);
+      }
+      engine_metrics().frames.add();
+      engine_metrics().total.record(render_time);
+    }
     std::scoped_lock lock(state_mutex);
+    if (new_shm || new_temp) {
+      current_bytes.store(result.rendered_page_specs.size, std::memory_order_relaxed);
+    }
     if (new_shm) {
       current_shm = std::move(new_shm);
     }
     if (new_temp) {
       current_tempfile = std::move(new_temp);
     }
+    pending_bytes.store(0, std::memory_order_relaxed);
     latest_result = std::move(result);
   };
 
   // check cache for page data first
   auto cached = use_cache ? try_page_cache(req, new_shm, new_temp) : std::nullopt;
+  if (use_cache) {
+    (cached.has_value() ? engine_metrics().page_hits : engine_metrics().page_misses).add();
+  }
   if (cached.has_value()) {
     const auto& data = cached.value();
     result.rendered_page_specs = data.rendered_page_specs;
     result.path_to_data = data.transmission == "shm" ? new_shm->name() : new_temp->path();
     result.transmission = data.transmission;
-    int duration_ms =
-        static_cast<int>(duration_cast<milliseconds>(steady_clock::now() - start).count());
-    update_frame(duration_ms);
+    update_frame(steady_clock::now() - start);
     return;
   }
   // prepare data then enqueue to threadpool
   try {
-    auto dlist = fetch_display_list(req.page_num);
+    // strips go to worker parsers that have opened the document. Until the first
+    // one has, the coordinator's own parser renders the whole page.
+    ready_workers.clear();
+    for (std::size_t i = 0; i < worker_ready.size(); i++) {
+      if (worker_ready[i].load(std::memory_order_acquire)) {
+        ready_workers.push_back(i);
+      }
+    }
+    const bool on_coordinator = ready_workers.empty();
+    // independent workers cannot use a display list from the shared context,
+    // each builds its own inside its task
+    const bool shared_dlist = worker_contexts == WorkerContexts::Cloned || on_coordinator;
+    auto dlist = [&]() -> std::optional<pdf::DisplayListHandle> {
+      if (!shared_dlist) {
+        return nullptr;
+      }
+      const perf_counters::Scope perf(engine_metrics().perf_display_list);
+      return fetch_display_list(req.page_num);
+    }();
     if (!dlist.has_value()) {
-      result.error_message = "Failed to generate display list";
+      mark_failed(result, "Failed to generate display list", loading);
       {
         std::scoped_lock lock(state_mutex);
         latest_result = std::move(result);
@@ -122,12 +307,24 @@ void RenderEngine::dispatch_page_write(const RenderRequest& req) {
       return;
     }
     pdf::PageSpecs ps = req.scaled_page_specs;
-    auto bounds = pdf::split_bounds(ps, n_threads_);
-    std::vector<std::future<void>> futures;
+    const std::size_t pixels = static_cast<std::size_t>(std::max(ps.width, 0)) *
+                               static_cast<std::size_t>(std::max(ps.height, 0));
+    int n_strips = n_threads_;
+    if (strip_policy == StripPolicy::Auto) {
+      const int headroom = load_monitor.headroom();
+      engine_metrics().cpu_headroom.set(headroom);
+      n_strips = strip_tuner.choose(req.page_num, pixels, headroom);
+    }
+    n_strips = std::min(n_strips, std::max(static_cast<int>(ready_workers.size()), 1));
+    auto bounds = pdf::split_bounds(ps, n_strips);
+    engine_metrics().strips.add(bounds.size());
+    engine_metrics().strip_requests.add();
+    std::atomic<std::int64_t> strip_work_ns = 0;  // summed over strips, whatever their count
     auto start_parse = steady_clock::now();
     void* buffer = nullptr;
 
     // set up pointers and buffers
+    pending_bytes.store(ps.size, std::memory_order_relaxed);
     if (req.transmission == "shm") {
       new_shm = std::make_unique<SharedMemory>(ps.size);
       buffer = new_shm->data();
@@ -138,56 +335,61 @@ void RenderEngine::dispatch_page_write(const RenderRequest& req) {
       result.path_to_data = new_temp->path();
     }
 
-    // enqueue jobs
+    // render strips in parallel, this thread taking one of them
     // since the engine design is that we only ever render one page at once
-    // we can use batch-index borrowing where each h_bound uses a parser
+    // we can use batch-index borrowing where each h_bound uses the ready parser
     // at a specific index.
-    // This is also because we maintain that n_bounds <= n_parsers
-    for (std::size_t idx = 0; idx < bounds.size(); idx++) {
-      auto h_bound = bounds[idx];
-      auto fut = thread_pool->submit([h_bound, req, dlist, buffer, idx, this]() {
-        worker_parsers[idx]->write_section(h_bound.width,
-                                           h_bound.height,
-                                           req.zoom,
-                                           req.scaled_page_specs,
-                                           dlist.value(),
-                                           static_cast<unsigned char*>(buffer) + h_bound.offset,
-                                           h_bound.rect);
-      });
-      futures.push_back(std::move(fut));
-    }
+    // This is also because we maintain that n_bounds <= n_ready_parsers
+    // parallel_for returns only once every strip is done, even if one throws,
+    // so the buffer stays open while other threads are still writing to it.
+    thread_pool->parallel_for(bounds.size(), [&](std::size_t idx) {
+      const chrome_trace::RequestScope trace_scope(req.req_id, req.page_num);
+      const perf_counters::Scope perf(engine_metrics().perf_raster, false);
+      const auto& h_bound = bounds[idx];
+      pdf::Parser& strip_parser = on_coordinator ? *parser : *worker_parsers[ready_workers[idx]];
+      auto strip_dlist =
+          dlist.value() ? dlist.value() : worker_display_list(ready_workers[idx], req.page_num);
+      const auto strip_start = steady_clock::now();
+      strip_parser.write_section(h_bound.width,
+                                 h_bound.height,
+                                 req.zoom,
+                                 req.scaled_page_specs,
+                                 std::move(strip_dlist),
+                                 static_cast<unsigned char*>(buffer) + h_bound.offset,
+                                 h_bound.rect);
+      strip_work_ns.fetch_add((steady_clock::now() - strip_start).count(),
+                              std::memory_order_relaxed);
+    });
+    strip_tuner.record(req.page_num, pixels, nanoseconds(strip_work_ns.load()));
 
-    // wait for future, then update result
-    // if an exception occurs, capture it and let all other futures drain
-    // this ensures we don't close the buffer while other threads
-    // are still writing to it.
-    std::exception_ptr first_error;
-    for (auto& fut : futures) {
-      try {
-        fut.get();
-      } catch (...) {
-        if (!first_error) {
-          first_error = std::current_exception();
-        }
-      }
+    if (perf_counters::enabled()) {
+      engine_metrics().perf_raster.add_request();
     }
-
-    if (first_error) {
-      std::rethrow_exception(first_error);
-    }
-
     result.transmission = req.transmission;
     auto end = steady_clock::now();
+    engine_metrics().raster.record(end - start_parse);
     auto write_duration = duration_cast<milliseconds>(end - start_parse);
-    auto full_duration = duration_cast<milliseconds>(end - start);
     if (use_cache && write_duration > page_cache_time_limit) {
       cache_page(req, result, new_shm, new_temp);
     }
-    update_frame(static_cast<int>(full_duration.count()));
+    update_frame(end - start);
   } catch (const std::exception& e) {
-    result.error_message = e.what();
-    update_frame(0);
+    mark_failed(result, e.what(), loading);
+    update_frame(steady_clock::duration::zero());
+  }
+}
+
+pdf::DisplayListHandle RenderEngine::worker_display_list(std::size_t idx, int page_num) {
+  auto& [cached_page, cached_dlist] = worker_dlists[idx];
+  if (cached_dlist == nullptr || cached_page != page_num) {
+    auto dlist = worker_parsers[idx]->get_display_list(page_num);
+    if (!dlist.has_value()) {
+      throw std::runtime_error("Failed to generate display list");
+    }
+    cached_page = page_num;
+    cached_dlist = std::move(dlist.value());
   }
+  return cached_dlist;
 }
 
 std::optional<pdf::DisplayListHandle> RenderEngine::fetch_display_list(int page_num) {
@@ -195,12 +397,15 @@ std::optional<pdf::DisplayListHandle> RenderEngine::fetch_display_list(int page_
   if (use_cache) {
     auto cache_check = dlist_cache.get(page_num);
     if (cache_check.has_value()) {  // exists, use cache
+      engine_metrics().dlist_hits.add();
       return cache_check;
     }
+    engine_metrics().dlist_misses.add();
   }
   const auto start = std::chrono::steady_clock::now();
   auto dlist = parser->get_display_list(page_num);
   const auto end = std::chrono::steady_clock::now();
+  engine_metrics().display_list_build.record(end - start);
 
   if (dlist.has_value()) {
     const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
@@ -1,11 +1,15 @@
 #pragma once
 #include <atomic>
+#include <chrono>
 #include <cmath>
 #include <condition_variable>
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <utility>
 
+#include "page_index.h"
+#include "parallelism.h"
 #include "parser.h"
 #include "threadpool.h"
 #include "utils/lru_cache.h"
@@ -31,37 +35,123 @@ struct PageCacheData {
   pdf::PageSpecs rendered_page_specs{};
 };
 
+/**
+ * @brief What the viewer wants on screen, before any page geometry is known.
+ *
+ * The engine loads the page bounds on its own thread, rotates them and fits
+ * them to the viewport, so submitting an intent never touches MuPDF.
+ */
+struct PageIntent {
+  int page_num;
+  float zoom;            ///< User zoom on top of fit to viewport, 1.0 fits the page exactly
+  int rotation_degrees;  ///< Clockwise rotation on top of the page's own, a multiple of 90
+  int viewport_width;    ///< Pixels available for the page
+  int viewport_height;
+};
+
+/**
+ * @brief Geometry of a page for an intent.
+ *
+ * @param base Unrotated specs of the page at the base zoom.
+ * @return The zoom to render at and the rotated specs scaled by it.
+ */
+[[nodiscard]] std::pair<float, pdf::PageSpecs> resolve_geometry(const pdf::PageSpecs& base,
+                                                                const PageIntent& intent);
+
 struct RenderRequest {
   int page_num;
   float zoom;
   pdf::PageSpecs scaled_page_specs;  ///< Geometry requested by viewer
   size_t req_id;  ///< id tagged to this request. Matching result is tagged to same id.
   std::string transmission;
+  /// When set, zoom and scaled_page_specs are resolved from it on the coordinator thread
+  std::optional<PageIntent> intent = std::nullopt;
 };
 
 struct RenderResult {
   size_t req_id;
   int page_num;
   pdf::PageSpecs rendered_page_specs;
+  float zoom = 0.0F;  ///< Zoom the page was rendered at
   std::string error_message;  // empty if successful
-  int render_time_ms;
+  /// The page's data has not arrived yet; a placeholder to request again as more loads
+  bool pending = false;
+  std::chrono::microseconds render_time{};  ///< Request pickup to completed frame
+
   std::string path_to_data;
   std::string transmission;
 };
 
+/**
+ * @brief Bytes held by the engine, split by owner.
+ *
+ * Transmission buffers live in shared memory or temp file mappings, so they
+ * count towards RSS but are shared with the terminal that reads them. A temp
+ * file can be both the current frame and a page cache entry.
+ */
+struct EngineMemory {
+  std::size_t page_cache = 0;            ///< Rendered frames kept by the page cache
+  std::size_t display_list_cache = 0;    ///< Estimated MuPDF memory of cached display lists
+  std::size_t pending_transmission = 0;  ///< Buffer being rendered for the in-flight request
+  std::size_t current_transmission = 0;  ///< Buffer of the most recently completed frame
+};
+
+/**
+ * @brief How render workers get their MuPDF contexts.
+ */
+enum class WorkerContexts {
+  Cloned,       ///< Clones of one root context: shared store and display lists, shared locks
+  Independent,  ///< Own root context and store per worker: no shared locks, pages parsed per worker
+};
+
+/**
+ * @brief How many strips each page is rendered in.
+ */
+enum class StripPolicy {
+  Auto,   ///< Chosen per request from predicted raster work and free CPUs, up to n_threads
+  Fixed,  ///< Always one strip per worker thread
+};
+
 class RenderEngine {
  public:
-  RenderEngine(const pdf::Parser& prototype_parser, int n_threads, bool use_cache);
+  RenderEngine(const pdf::Parser& prototype_parser, int n_threads, bool use_cache,
+               WorkerContexts worker_contexts = WorkerContexts::Cloned,
+               StripPolicy strip_policy = StripPolicy::Auto);
   ~RenderEngine();
 
   // main thread calls to request a page
   std::size_t request_page(int page_num, float zoom, pdf::PageSpecs,
                            const std::string& transmission);
+
+  /**
+   * @brief Requests a page by intent, resolving its geometry on the coordinator thread.
+   *
+   * Never blocks on MuPDF. The result carries the resolved specs and zoom, or
+   * an error if the page cannot be loaded.
+   */
+  std::size_t request_page(const PageIntent& intent, const std::string& transmission);
+
+  /// Number of worker threads rendering strips.
+  [[nodiscard]] int threads() const { return n_threads_; }
+
+  /// Base specs of page_num if the page index has them already, without blocking.
+  [[nodiscard]] std::optional<pdf::PageSpecs> indexed_page_specs(int page_num) const;
   // main thread calls to check if a result is ready
   std::optional<RenderResult> get_result();
 
+  /// Current memory attribution, safe to call from any thread.
+  EngineMemory memory_breakdown();
+
  private:
   void coordinator_loop();
+  /// Fills in zoom and specs of an intent request. @return false if the page cannot be loaded.
+  bool resolve_intent(RenderRequest& req);
+  /**
+   * @brief Fills in a failed result.
+   * @param loading Whether the document was still arriving when the page was loaded, which
+   * makes the result a pending placeholder instead of an error.
+   */
+  static void mark_failed(RenderResult& result, std::string message, bool loading);
   void dispatch_page_write(const RenderRequest& req);
   void cache_page(const RenderRequest& req, const RenderResult& res,
                   const std::shared_ptr<SharedMemory>& shm,
@@ -73,9 +163,26 @@ class RenderEngine {
 
   std::optional<pdf::DisplayListHandle> fetch_display_list(int page_num);
 
+  /**
+   * @brief Display list of page_num built by worker parser idx, for independent contexts.
+   * @throws std::runtime_error if the display list cannot be built.
+   */
+  pdf::DisplayListHandle worker_display_list(std::size_t idx, int page_num);
+
   // core
+  std::chrono::steady_clock::time_point created_at;          // start of construction
   std::unique_ptr<pdf::Parser> parser;                       // thread local parser
+  std::unique_ptr<pdf::PageIndex> page_index;                // page bounds for intent requests
   std::vector<std::unique_ptr<pdf::Parser>> worker_parsers;  // separate parsers for rendering work
+  // worker_parsers[i] has opened the document; set once by the pool task opening it
+  std::vector<std::atomic<bool>> worker_ready;
+  std::atomic<std::size_t> workers_opened = 0;  // open attempts finished, failed or not
+  std::atomic<std::size_t> workers_failed = 0;
+  std::vector<std::size_t> ready_workers;  // indices of ready workers, coordinator only
+  bool first_frame_done = false;           // coordinator only
+  WorkerContexts worker_contexts;
+  // last display list of each independent worker parser, only touched by the task using it
+  std::vector<std::pair<int, pdf::DisplayListHandle>> worker_dlists;
   std::thread worker;                                        // coordinator thread
   std::atomic<bool> running = true;
   std::atomic<size_t> current_req_id = 0;
@@ -83,6 +190,10 @@ class RenderEngine {
   // threadpool for heavy work
   int n_threads_;
   std::unique_ptr<ThreadPool> thread_pool;
+  // strip count selection, only touched by the coordinator thread
+  StripPolicy strip_policy;
+  parallelism::StripTuner strip_tuner;
+  parallelism::LoadMonitor load_monitor;
 
   // thread safety and synchronisation
   std::mutex state_mutex;  // shared between cv_worker and actual worker
@@ -95,6 +206,8 @@ class RenderEngine {
   std::optional<RenderResult> latest_result;
   std::shared_ptr<SharedMemory> current_shm;
   std::shared_ptr<Tempfile> current_tempfile;
+  std::atomic<std::size_t> pending_bytes = 0;  // transmission buffer being rendered
+  std::atomic<std::size_t> current_bytes = 0;  // transmission buffer of latest frame
 
   bool use_cache = true;
   // lru_cache to cache heavy display lists
@@ -0,0 +1,349 @@
+#include "search_index.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+namespace {
+constexpr std::array<char, 8> MAGIC = {'P', 'D', 'V', 'U', 'I', 'D', 'X', '\0'};
+/// Bumped whenever the layout or the text extraction changes
+constexpr std::uint32_t FORMAT_VERSION = 1;
+constexpr std::size_t SECTION_ALIGNMENT = 8;
+constexpr std::size_t HASH_CHUNK_SIZE = std::size_t{1} << 20;
+
+constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+constexpr std::uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+/// Byte as compared by PageText::find(): ASCII case folded, line breaks as spaces.
+unsigned char fold(char c) {
+  if (c == '\n') {
+    return ' ';
+  }
+  if (c >= 'A' && c <= 'Z') {
+    return static_cast<unsigned char>(c - 'A' + 'a');
+  }
+  return static_cast<unsigned char>(c);
+}
+
+/// Distinct trigrams of text, sorted.
+std::vector<std::uint32_t> trigrams_of(std::string_view text) {
+  std::vector<std::uint32_t> trigrams;
+  if (text.size() < 3) {
+    return trigrams;
+  }
+  trigrams.reserve(text.size() - 2);
+  std::uint32_t window = (std::uint32_t{fold(text[0])} << 8) | fold(text[1]);
+  for (std::size_t i = 2; i < text.size(); i++) {
+    window = ((window << 8) | fold(text[i])) & 0xFFFFFFU;
+    trigrams.push_back(window);
+  }
+  std::ranges::sort(trigrams);
+  const auto [first, last] = std::ranges::unique(trigrams);
+  trigrams.erase(first, last);
+  return trigrams;
+}
+
+std::size_t align_up(std::size_t offset) {
+  return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+/// Appends the bytes of values to out at the next aligned offset, which is returned.
+template <typename T>
+std::uint64_t append_section(std::string& out, std::span<const T> values) {
+  out.resize(align_up(out.size()), '\0');
+  const std::size_t offset = out.size();
+  if (!values.empty()) {
+    out.append(reinterpret_cast<const char*>(values.data()), values.size_bytes());
+  }
+  return offset;
+}
+
+/// Section of count Ts at offset in file, or an empty optional if it does not fit.
+template <typename T>
+std::optional<std::span<const T>> section(const MappedFile& file, std::uint64_t offset,
+                                          std::uint64_t count) {
+  if (offset % alignof(T) != 0 || offset > file.size() ||
+      count > (file.size() - offset) / sizeof(T)) {
+    return std::nullopt;
+  }
+  // the mapping is page aligned and the format only holds trivially copyable types
+  return std::span(reinterpret_cast<const T*>(file.data() + offset),
+                   static_cast<std::size_t>(count));
+}
+
+/// Whether the lines of a page lie within its text and edges, in order.
+bool lines_are_valid(std::span<const pdf::TextLine> lines, std::size_t text_size,
+                     std::size_t n_edges) {
+  std::uint32_t previous_begin = 0;
+  for (std::size_t i = 0; i < lines.size(); i++) {
+    const auto& line = lines[i];
+    if (line.begin >= text_size || line.first_edge > n_edges ||
+        (i > 0 && line.begin <= previous_begin)) {
+      return false;
+    }
+    previous_begin = line.begin;
+  }
+  return true;
+}
+}  // namespace
+
+namespace pdf {
+std::expected<DocumentKey, std::string> DocumentKey::of(const std::filesystem::path& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return std::unexpected(std::format("Cannot open {}: {}", path.string(), strerror(errno)));
+  }
+  // read sequentially rather than through MappedFile, which is advised for random access
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  const auto buffer = std::make_unique_for_overwrite<unsigned char[]>(HASH_CHUNK_SIZE);
+  DocumentKey key{.size = 0, .hash = FNV_OFFSET_BASIS};
+  while (true) {
+    const ssize_t n = read(fd, buffer.get(), HASH_CHUNK_SIZE);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n == -1) {
+      const int error = errno;
+      close(fd);
+      return std::unexpected(std::format("Cannot read {}: {}", path.string(), strerror(error)));
+    }
+    if (n == 0) {
+      break;
+    }
+    for (ssize_t i = 0; i < n; i++) {
+      key.hash = (key.hash ^ buffer[static_cast<std::size_t>(i)]) * FNV_PRIME;
+    }
+    key.size += static_cast<std::uint64_t>(n);
+  }
+  close(fd);
+  return key;
+}
+
+std::string DocumentKey::file_stem() const { return std::format("{:016x}-{}", hash, size); }
+
+SearchIndex::SearchIndex(MappedFile file) : m_file(std::move(file)) {}
+
+std::expected<SearchIndex, std::string> SearchIndex::open(const std::filesystem::path& path,
+                                                          const DocumentKey& key) {
+  auto mapped = MappedFile::open(path);
+  if (!mapped) {
+    return std::unexpected(mapped.error());
+  }
+  SearchIndex index(std::move(*mapped));
+  const auto& file = index.m_file;
+  auto malformed = [&](std::string_view what) {
+    return std::unexpected(std::format("Malformed search index {}: {}", path.string(), what));
+  };
+
+  const auto header = section<Header>(file, 0, 1);
+  if (!header) {
+    return malformed("truncated header");
+  }
+  const Header& h = header->front();
+  if (!std::ranges::equal(h.magic, MAGIC) || h.version != FORMAT_VERSION) {
+    return malformed("unknown format");
+  }
+  if (h.doc_size != key.size || h.doc_hash != key.hash) {
+    return std::unexpected(std::format("Search index {} is for another document", path.string()));
+  }
+  const auto pages = section<PageEntry>(file, h.pages_offset, h.num_pages);
+  const auto trigrams = section<TrigramEntry>(file, h.trigrams_offset, h.n_trigrams);
+  const auto postings = section<std::uint32_t>(file, h.postings_offset, h.n_postings);
+  const auto lines = section<TextLine>(file, h.lines_offset, h.n_lines);
+  const auto edges = section<float>(file, h.edges_offset, h.n_edges);
+  const auto text = section<char>(file, h.text_offset, h.text_size);
+  if (!pages || !trigrams || !postings || !lines || !edges || !text) {
+    return malformed("section out of bounds");
+  }
+  for (const auto& page : *pages) {
+    if (page.text_begin > text->size() || page.text_size > text->size() - page.text_begin ||
+        page.line_begin > lines->size() || page.n_lines > lines->size() - page.line_begin ||
+        page.edge_begin > edges->size() || page.n_edges > edges->size() - page.edge_begin ||
+        !lines_are_valid(lines->subspan(page.line_begin, page.n_lines),
+                         page.text_size,
+                         page.n_edges)) {
+      return malformed("page out of bounds");
+    }
+  }
+  for (const auto& trigram : *trigrams) {
+    if (trigram.postings_begin > postings->size() ||
+        trigram.count > postings->size() - trigram.postings_begin) {
+      return malformed("postings out of bounds");
+    }
+  }
+
+  index.m_header = &h;
+  index.m_pages = *pages;
+  index.m_trigrams = *trigrams;
+  index.m_postings = *postings;
+  index.m_lines = *lines;
+  index.m_edges = *edges;
+  index.m_text = std::string_view(text->data(), text->size());
+  return index;
+}
+
+std::expected<void, std::string> SearchIndex::write(const std::filesystem::path& path,
+                                                    const DocumentKey& key,
+                                                    std::span<const PageText> pages) {
+  std::vector<PageEntry> entries;
+  entries.reserve(pages.size());
+  std::vector<TextLine> lines;
+  std::vector<float> edges;
+  std::string text;
+  // (trigram, page) pairs, sorted below into one posting list per trigram
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> occurrences;
+  for (std::size_t i = 0; i < pages.size(); i++) {
+    const auto view = pages[i].view();
+    entries.push_back({
+        .text_begin = text.size(),
+        .text_size = static_cast<std::uint32_t>(view.text().size()),
+        .line_begin = static_cast<std::uint32_t>(lines.size()),
+        .n_lines = static_cast<std::uint32_t>(view.lines().size()),
+        .edge_begin = static_cast<std::uint32_t>(edges.size()),
+        .n_edges = static_cast<std::uint32_t>(view.edges().size()),
+        .reserved = 0,
+    });
+    text += view.text();
+    lines.insert(lines.end(), view.lines().begin(), view.lines().end());
+    edges.insert(edges.end(), view.edges().begin(), view.edges().end());
+    for (const auto trigram : trigrams_of(view.text())) {
+      occurrences.emplace_back(trigram, static_cast<std::uint32_t>(i));
+    }
+  }
+  std::ranges::sort(occurrences);
+
+  std::vector<TrigramEntry> trigrams;
+  std::vector<std::uint32_t> postings;
+  postings.reserve(occurrences.size());
+  for (const auto& [trigram, page] : occurrences) {
+    if (trigrams.empty() || trigrams.back().trigram != trigram) {
+      trigrams.push_back({
+          .trigram = trigram,
+          .postings_begin = static_cast<std::uint32_t>(postings.size()),
+          .count = 0,
+      });
+    }
+    trigrams.back().count++;
+    postings.push_back(page);
+  }
+
+  Header header{};
+  std::ranges::copy(MAGIC, header.magic);
+  header.version = FORMAT_VERSION;
+  header.num_pages = static_cast<std::uint32_t>(pages.size());
+  header.doc_size = key.size;
+  header.doc_hash = key.hash;
+  std::string out(sizeof(Header), '\0');
+  header.pages_offset = append_section(out, std::span<const PageEntry>(entries));
+  header.trigrams_offset = append_section(out, std::span<const TrigramEntry>(trigrams));
+  header.n_trigrams = trigrams.size();
+  header.postings_offset = append_section(out, std::span<const std::uint32_t>(postings));
+  header.n_postings = postings.size();
+  header.lines_offset = append_section(out, std::span<const TextLine>(lines));
+  header.n_lines = lines.size();
+  header.edges_offset = append_section(out, std::span<const float>(edges));
+  header.n_edges = edges.size();
+  header.text_offset = append_section(out, std::span<const char>(text));
+  header.text_size = text.size();
+  std::memcpy(out.data(), &header, sizeof(Header));
+
+  // a unique name, so processes indexing the same document never write one file
+  std::string partial = path.string() + ".partial.XXXXXX";
+  const int fd = mkstemp(partial.data());
+  if (fd == -1) {
+    return std::unexpected(std::format("Cannot create {}: {}", partial, strerror(errno)));
+  }
+  close(fd);
+  {
+    std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.data(), static_cast<std::streamsize>(out.size())).flush()) {
+      std::error_code error;
+      std::filesystem::remove(partial, error);
+      return std::unexpected(std::format("Cannot write {}", partial));
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(partial, path, error);
+  if (error) {
+    std::filesystem::remove(partial, error);
+    return std::unexpected(std::format("Cannot write {}: {}", path.string(), error.message()));
+  }
+  return {};
+}
+
+std::optional<std::filesystem::path> SearchIndex::default_directory() {
+  const char* cache = std::getenv("XDG_CACHE_HOME");
+  if (cache != nullptr && *cache == '/') {  // relative paths are ignored, as the spec says
+    return std::filesystem::path(cache) / "pdvu" / "index";
+  }
+  const char* home = std::getenv("HOME");
+  if (home != nullptr && *home != '\0') {
+    return std::filesystem::path(home) / ".cache" / "pdvu" / "index";
+  }
+  return std::nullopt;
+}
+
+int SearchIndex::num_pages() const { return static_cast<int>(m_pages.size()); }
+
+PageTextView SearchIndex::page(int page_num) const {
+  const auto& page = m_pages[static_cast<std::size_t>(page_num)];
+  return {m_text.substr(page.text_begin, page.text_size),
+          m_lines.subspan(page.line_begin, page.n_lines),
+          m_edges.subspan(page.edge_begin, page.n_edges)};
+}
+
+std::span<const std::uint32_t> SearchIndex::postings(std::uint32_t trigram) const {
+  const auto it = std::ranges::lower_bound(m_trigrams, trigram, {}, &TrigramEntry::trigram);
+  if (it == m_trigrams.end() || it->trigram != trigram) {
+    return {};
+  }
+  return m_postings.subspan(it->postings_begin, it->count);
+}
+
+std::vector<int> SearchIndex::candidate_pages(std::string_view query) const {
+  const auto trigrams = trigrams_of(query);
+  std::vector<int> pages;
+  if (trigrams.empty()) {
+    pages.resize(m_pages.size());
+    for (std::size_t i = 0; i < pages.size(); i++) {
+      pages[i] = static_cast<int>(i);
+    }
+    return pages;
+  }
+
+  std::vector<std::span<const std::uint32_t>> lists;
+  lists.reserve(trigrams.size());
+  for (const auto trigram : trigrams) {
+    lists.push_back(postings(trigram));
+    if (lists.back().empty()) {
+      return pages;  // some trigram occurs nowhere
+    }
+  }
+  // intersect starting from the rarest trigram, which bounds the result
+  std::ranges::sort(lists, {}, &std::span<const std::uint32_t>::size);
+  std::vector<std::uint32_t> common(lists.front().begin(), lists.front().end());
+  std::vector<std::uint32_t> next;
+  for (std::size_t i = 1; i < lists.size() && !common.empty(); i++) {
+    next.clear();
+    std::ranges::set_intersection(common, lists[i], std::back_inserter(next));
+    std::swap(common, next);
+  }
+  for (const auto page : common) {
+    if (page < m_pages.size()) {
+      pages.push_back(static_cast<int>(page));
+    }
+  }
+  return pages;
+}
+}  // namespace pdf
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "page_text.h"
+#include "utils/mapped_file.h"
+
+namespace pdf {
+/**
+ * @brief Identifies a document by its contents, so renamed or moved copies share an index.
+ */
+struct DocumentKey {
+  std::uint64_t size = 0;
+  std::uint64_t hash = 0;  ///< 64-bit FNV-1a of every byte
+
+  /**
+   * @brief Hashes the file at path.
+   * @return The key, or an error message if the file cannot be mapped.
+   */
+  [[nodiscard]] static std::expected<DocumentKey, std::string> of(
+      const std::filesystem::path& path);
+
+  /// File name stem for the document's index files, from the hash and size.
+  [[nodiscard]] std::string file_stem() const;
+
+  bool operator==(const DocumentKey&) const = default;
+};
+
+/**
+ * @brief Full-text index of one document, memory-mapped from the index cache.
+ *
+ * The file holds the PageText of every page and a trigram table: for every
+ * three-byte sequence in the text, the pages containing it. A query is first
+ * narrowed to the pages containing all of its trigrams, and only those pages
+ * are searched, straight from the mapping. MuPDF is never involved.
+ *
+ * Trigrams fold ASCII case and treat a line break as a space, matching how
+ * PageText::find() compares, so the narrowing never drops a page find()
+ * would match.
+ */
+class SearchIndex {
+ public:
+  /**
+   * @brief Maps an index file and checks it belongs to key.
+   * @return The index, or an error message if the file is missing, was
+   * written for another document or format version, or is malformed.
+   */
+  [[nodiscard]] static std::expected<SearchIndex, std::string> open(
+      const std::filesystem::path& path, const DocumentKey& key);
+
+  /**
+   * @brief Writes the index of pages to path.
+   *
+   * The file is written next to path under a unique name and renamed into
+   * place, so readers never see a partial index and concurrent writers never
+   * share a file.
+   */
+  [[nodiscard]] static std::expected<void, std::string> write(const std::filesystem::path& path,
+                                                              const DocumentKey& key,
+                                                              std::span<const PageText> pages);
+
+  /**
+   * @brief Directory index files are kept in.
+   * @return $XDG_CACHE_HOME/pdvu/index, else ~/.cache/pdvu/index, or
+   * std::nullopt if neither variable is set.
+   */
+  [[nodiscard]] static std::optional<std::filesystem::path> default_directory();
+
+  [[nodiscard]] int num_pages() const;
+
+  /// Text of page_num, pointing into the mapping.
+  [[nodiscard]] PageTextView page(int page_num) const;
+
+  /**
+   * @brief Pages that may contain query, in ascending order.
+   *
+   * Every page for queries shorter than a trigram.
+   *
+   * @param query Normalized query, see PageText::normalize_query().
+   */
+  [[nodiscard]] std::vector<int> candidate_pages(std::string_view query) const;
+
+  /// Size of the mapped file in bytes.
+  [[nodiscard]] std::size_t bytes() const { return m_file.size(); }
+
+ private:
+  // file layout: Header, then the sections it points to, each 8-byte aligned
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t num_pages;
+    std::uint64_t doc_size;
+    std::uint64_t doc_hash;
+    std::uint64_t pages_offset;  ///< PageEntry[num_pages]
+    std::uint64_t trigrams_offset;
+    std::uint64_t n_trigrams;  ///< TrigramEntry[n_trigrams], sorted by trigram
+    std::uint64_t postings_offset;
+    std::uint64_t n_postings;  ///< Page numbers, ascending within each trigram
+    std::uint64_t lines_offset;
+    std::uint64_t n_lines;
+    std::uint64_t edges_offset;
+    std::uint64_t n_edges;
+    std::uint64_t text_offset;
+    std::uint64_t text_size;
+  };
+
+  /// Where a page's slices of the shared text, line and edge sections are
+  struct PageEntry {
+    std::uint64_t text_begin;
+    std::uint32_t text_size;
+    std::uint32_t line_begin;
+    std::uint32_t n_lines;
+    std::uint32_t edge_begin;
+    std::uint32_t n_edges;
+    std::uint32_t reserved;
+  };
+
+  struct TrigramEntry {
+    std::uint32_t trigram;  ///< Three folded bytes, first in the high byte
+    std::uint32_t postings_begin;
+    std::uint32_t count;
+  };
+
+  explicit SearchIndex(MappedFile file);
+
+  [[nodiscard]] std::span<const std::uint32_t> postings(std::uint32_t trigram) const;
+
+  MappedFile m_file;
+  const Header* m_header = nullptr;
+  std::span<const PageEntry> m_pages;
+  std::span<const TrigramEntry> m_trigrams;  ///< Sorted by trigram
+  std::span<const std::uint32_t> m_postings;
+  std::span<const TextLine> m_lines;
+  std::span<const float> m_edges;
+  std::string_view m_text;
+};
+}  // namespace pdf
@@ -0,0 +1,255 @@
+#include "text_search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <utility>
+
+#include "plog/Log.h"
+#include "utils/logging.h"
+#include "utils/metrics.h"
+#include "utils/profiling.h"
+
+namespace {
+/// Pages each worker scans per chunk. Hits are published, and cancellation seen, once per chunk.
+constexpr int PAGES_PER_WORKER = 4;
+
+/**
+ * @brief Text search metrics, looked up once from the process-wide registry.
+ */
+struct SearchMetrics {
+  /// Structured text extraction of one page on a worker parser
+  metrics::LatencyHistogram& extract = metrics::registry().histogram("search.extract");
+  /// Search started to its last page scanned, cancelled searches excluded
+  metrics::LatencyHistogram& total = metrics::registry().histogram("search.total");
+  /// Searches answered from a SearchIndex
+  metrics::Counter& indexed = metrics::registry().counter("search.indexed");
+  metrics::Counter& text_hits = metrics::registry().counter("cache.text.hits");
+  metrics::Counter& text_misses = metrics::registry().counter("cache.text.misses");
+  metrics::Gauge& text_bytes = metrics::registry().gauge("memory.search_text_bytes");
+};
+
+SearchMetrics& search_metrics() {
+  static SearchMetrics instance;
+  return instance;
+}
+}  // namespace
+
+namespace pdf {
+TextSearch::TextSearch(const Parser& prototype, int n_threads)
+    : m_num_pages(prototype.num_pages()), m_workers(prototype, n_threads, "Search") {
+  m_cache.resize(static_cast<std::size_t>(std::max(m_num_pages, 0)));
+  m_thread = std::thread(&TextSearch::search_loop, this);
+}
+
+TextSearch::~TextSearch() {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stop = true;
+    m_latest_id.fetch_add(1, std::memory_order_relaxed);  // stop scanning between pages
+  }
+  m_wake.notify_one();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+std::size_t TextSearch::start(std::string_view query, int first_page) {
+  std::string normalized = PageText::normalize_query(query);
+  std::size_t id = 0;
+  {
+    std::scoped_lock lock(m_mutex);
+    id = m_latest_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    const bool nothing_to_do = normalized.empty() || m_num_pages <= 0;
+    m_hits.clear();
+    m_status = {
+        .search_id = id,
+        .pages_scanned = 0,
+        .total_pages = m_num_pages,
+        .hits = 0,
+        .done = nothing_to_do,
+    };
+    m_pending.reset();
+    if (!nothing_to_do) {
+      m_pending = Query{
+          .id = id,
+          .text = std::move(normalized),
+          .first_page = std::clamp(first_page, 0, m_num_pages - 1),
+      };
+    }
+  }
+  m_wake.notify_one();
+  m_done.notify_all();
+  return id;
+}
+
+void TextSearch::use_index(std::shared_ptr<const SearchIndex> index) {
+  if (index && index->num_pages() != m_num_pages) {
+    PLOG_WARNING << "Search index has " << index->num_pages() << " pages, the document "
+                 << m_num_pages << ", not using it";
+    return;
+  }
+  std::scoped_lock lock(m_mutex);
+  m_index = std::move(index);
+}
+
+void TextSearch::cancel() {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_latest_id.fetch_add(1, std::memory_order_relaxed);
+    m_pending.reset();
+    m_hits.clear();
+    m_status.done = true;
+  }
+  m_done.notify_all();
+}
+
+std::vector<SearchHit> TextSearch::take_hits() {
+  std::scoped_lock lock(m_mutex);
+  return std::exchange(m_hits, {});
+}
+
+SearchStatus TextSearch::status() const {
+  std::scoped_lock lock(m_mutex);
+  return m_status;
+}
+
+void TextSearch::wait() const {
+  std::unique_lock lock(m_mutex);
+  m_done.wait(lock, [&] { return m_status.done; });
+}
+
+void TextSearch::search_loop() {
+  chrome_trace::set_thread_name("text search");
+  while (true) {
+    Query query;
+    std::shared_ptr<const SearchIndex> index;
+    {
+      std::unique_lock lock(m_mutex);
+      m_wake.wait(lock, [&] { return m_stop || m_pending.has_value(); });
+      if (m_stop) {
+        return;
+      }
+      query = std::move(*m_pending);
+      m_pending.reset();
+      index = m_index;
+    }
+    if (index) {
+      run_indexed(query, *index);
+    } else {
+      run(query);
+    }
+  }
+}
+
+void TextSearch::run(const Query& query) {
+  ZoneScopedN("text search");
+  const auto start = std::chrono::steady_clock::now();
+  const auto length = static_cast<std::uint32_t>(query.text.size());
+  const std::size_t n_workers = m_workers.size();
+  const int chunk = static_cast<int>(n_workers) * PAGES_PER_WORKER;
+
+  for (int first = 0; first < m_num_pages && current(query.id); first += chunk) {
+    const int count = std::min(chunk, m_num_pages - first);
+    std::vector<std::vector<SearchHit>> found(static_cast<std::size_t>(count));
+    std::atomic<int> next = 0;
+    // pages are handed out one at a time, so a slow page does not hold up a whole worker's share
+    m_workers.run(n_workers, [&](Parser& parser) {
+      for (int i = next.fetch_add(1); i < count && current(query.id); i = next.fetch_add(1)) {
+        const int page_num = (query.first_page + first + i) % m_num_pages;
+        const auto text = text_of(page_num, parser);
+        if (!text) {
+          continue;
+        }
+        auto& page_hits = found[static_cast<std::size_t>(i)];
+        for (const auto offset : text->find(query.text)) {
+          page_hits.push_back({.page_num = page_num, .rects = text->rects(offset, length)});
+        }
+      }
+    });
+
+    std::scoped_lock lock(m_mutex);
+    if (!current(query.id)) {
+      return;
+    }
+    for (auto& page_hits : found) {
+      m_status.hits += page_hits.size();
+      std::ranges::move(page_hits, std::back_inserter(m_hits));
+    }
+    m_status.pages_scanned += count;
+  }
+
+  {
+    std::scoped_lock lock(m_mutex);
+    if (!current(query.id)) {
+      return;
+    }
+    m_status.done = true;
+  }
+  m_done.notify_all();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  search_metrics().total.record(elapsed);
+  PLOG_INFO << std::format(
+      "Searched {} pages in {}ms",
+      m_num_pages,
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+}
+
+void TextSearch::run_indexed(const Query& query, const SearchIndex& index) {
+  ZoneScopedN("indexed text search");
+  const auto start = std::chrono::steady_clock::now();
+  const auto length = static_cast<std::uint32_t>(query.text.size());
+  auto pages = index.candidate_pages(query.text);
+  // report hits from the first page onward, like a scan would
+  std::ranges::rotate(pages, std::ranges::lower_bound(pages, query.first_page));
+  std::vector<SearchHit> found;
+  for (const int page_num : pages) {
+    const auto text = index.page(page_num);
+    for (const auto offset : text.find(query.text)) {
+      found.push_back({.page_num = page_num, .rects = text.rects(offset, length)});
+    }
+  }
+
+  {
+    std::scoped_lock lock(m_mutex);
+    if (!current(query.id)) {
+      return;
+    }
+    m_status.hits += found.size();
+    std::ranges::move(found, std::back_inserter(m_hits));
+    m_status.pages_scanned = m_num_pages;
+    m_status.done = true;
+  }
+  m_done.notify_all();
+  search_metrics().total.record(std::chrono::steady_clock::now() - start);
+  search_metrics().indexed.add();
+}
+
+std::shared_ptr<const PageText> TextSearch::text_of(int page_num, Parser& parser) {
+  const auto page = static_cast<std::size_t>(page_num);
+  {
+    std::scoped_lock lock(m_cache_mutex);
+    if (m_cache[page]) {
+      search_metrics().text_hits.add();
+      return m_cache[page];
+    }
+  }
+  search_metrics().text_misses.add();
+
+  const auto start = std::chrono::steady_clock::now();
+  auto text = parser.page_text(page_num);
+  search_metrics().extract.record(std::chrono::steady_clock::now() - start);
+  if (!text) {
+    return nullptr;  // not cached, a streamed page may still arrive
+  }
+  auto shared = std::make_shared<const PageText>(std::move(*text));
+  const std::size_t total =
+      m_cached_bytes.fetch_add(shared->bytes(), std::memory_order_relaxed) + shared->bytes();
+  search_metrics().text_bytes.set(static_cast<std::int64_t>(total));
+  std::scoped_lock lock(m_cache_mutex);
+  m_cache[page] = shared;
+  return shared;
+}
+}  // namespace pdf
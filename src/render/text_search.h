@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "page_specs.h"
+#include "page_text.h"
+#include "parser.h"
+#include "search_index.h"
+#include "worker_parsers.h"
+
+namespace pdf {
+/**
+ * @brief One occurrence of the search query.
+ */
+struct SearchHit {
+  int page_num;
+  /// Boxes of the match in unrotated base zoom page coordinates, one per line it spans
+  std::vector<Rect> rects;
+};
+
+/**
+ * @brief Progress of the latest search.
+ */
+struct SearchStatus {
+  std::size_t search_id = 0;  ///< 0 before the first search
+  int pages_scanned = 0;
+  int total_pages = 0;
+  std::size_t hits = 0;  ///< Hits found so far, taken or not
+  bool done = true;      ///< Every page scanned, or the search was cancelled
+};
+
+/**
+ * @brief Full-text search over every page, extracted in parallel on worker parsers.
+ *
+ * A search scans pages from a starting page onward, wrapping around at the
+ * end, in chunks of a few pages per worker. Hits of a chunk are published in
+ * page order as soon as it is done, so the first hits near the reader show
+ * while the rest of the document is still being scanned. Starting a new
+ * search cancels the previous one between pages.
+ *
+ * The text of each page is extracted once and kept as a PageText, so later
+ * searches only scan memory. Once given a SearchIndex of the document,
+ * searches are answered from it instead, without extracting anything.
+ */
+class TextSearch {
+ public:
+  /**
+   * @brief Prepares the parsers pages are extracted with, see WorkerParsers.
+   * @param n_threads Pages extracted in parallel, at least 1.
+   */
+  TextSearch(const Parser& prototype, int n_threads);
+
+  /// Cancels the running search and joins every thread.
+  ~TextSearch();
+
+  TextSearch(const TextSearch&) = delete;
+  TextSearch& operator=(const TextSearch&) = delete;
+  TextSearch(TextSearch&&) = delete;
+  TextSearch& operator=(TextSearch&&) = delete;
+
+  /**
+   * @brief Starts searching for query, cancelling any search in progress.
+   *
+   * @param query Text to find, see PageText::find(). An empty query finds nothing.
+   * @param first_page Page to start from; hits are reported from here onward, wrapping around.
+   * @return Id of the new search, as reported by status().
+   */
+  std::size_t start(std::string_view query, int first_page);
+
+  /**
+   * @brief Answers later searches from index.
+   *
+   * Ignored if the index has a different page count than the document.
+   */
+  void use_index(std::shared_ptr<const SearchIndex> index);
+
+  /// Stops the running search and drops its untaken hits.
+  void cancel();
+
+  /// Hits of the latest search found since the last call, in scan order.
+  [[nodiscard]] std::vector<SearchHit> take_hits();
+
+  [[nodiscard]] SearchStatus status() const;
+
+  /// Blocks until the latest search is done. Used by tests and benchmarks.
+  void wait() const;
+
+  /// Heap bytes of the cached page texts.
+  [[nodiscard]] std::size_t cached_bytes() const {
+    return m_cached_bytes.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Query {
+    std::size_t id;
+    std::string text;  ///< Normalized
+    int first_page;
+  };
+
+  void search_loop();
+  void run(const Query& query);
+  /// Searches only the candidate pages of index, all at once.
+  void run_indexed(const Query& query, const SearchIndex& index);
+  /// Text of page_num from the cache, or extracted with parser.
+  std::shared_ptr<const PageText> text_of(int page_num, Parser& parser);
+  /// Whether id is still the latest search.
+  [[nodiscard]] bool current(std::size_t id) const {
+    return m_latest_id.load(std::memory_order_relaxed) == id;
+  }
+
+  int m_num_pages;
+  WorkerParsers m_workers;
+
+  mutable std::mutex m_cache_mutex;
+  std::vector<std::shared_ptr<const PageText>> m_cache;  ///< Indexed by page, null until extracted
+  std::atomic<std::size_t> m_cached_bytes = 0;
+
+  mutable std::mutex m_mutex;  ///< Guards everything below except the atomics
+  std::condition_variable m_wake;
+  mutable std::condition_variable m_done;
+  std::optional<Query> m_pending;
+  std::vector<SearchHit> m_hits;  ///< Found but not taken yet
+  std::shared_ptr<const SearchIndex> m_index;
+  SearchStatus m_status;
+  std::atomic<std::size_t> m_latest_id = 0;  ///< Bumped by start() and cancel()
+  bool m_stop = false;
+  std::thread m_thread;
+};
+}  // namespace pdf
@@ -43,6 +43,7 @@ void ThreadPool::shutdown_and_join() {
 }
 
 void ThreadPool::worker_loop() {
+  chrome_trace::set_thread_name("render worker");
   while (true) {
     Task task;
     {
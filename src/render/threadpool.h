@@ -1,9 +1,10 @@
 #pragma once
 #include <condition_variable>
 #include <cstddef>
+#include <exception>
 #include <functional>
 #include <future>
-#include <memory>
+#include <latch>
 #include <mutex>
 #include <queue>
 #include <stdexcept>
@@ -12,10 +13,13 @@
 #include <utility>
 #include <vector>
 
+#include "inplace_task.h"
+
 /**
  * @brief Fixed-size pool for asynchronously executing callable tasks.
  *
- * Submitted tasks expose their result or exception through a `std::future`.
+ * Submitted tasks expose their result or exception through a `std::future`,
+ * while parallel_for() runs a batch of indices fork-join style without one.
  * Destruction stops new submissions, drains all accepted tasks, and joins every
  * worker thread.
  */
@@ -48,24 +52,91 @@ class ThreadPool {
   auto submit(F&& callable, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
     using Result = std::invoke_result_t<F, Args...>;
 
-    auto bound_task = std::bind(std::forward<F>(callable), std::forward<Args>(args)...);
-
-    // std::function requires a copyable target, so share ownership of the
-    // move-only packaged task with the queued lambda.
-    auto packaged_task = std::make_shared<std::packaged_task<Result()>>(std::move(bound_task));
+    std::packaged_task<Result()> packaged_task(
+        [callable = std::forward<F>(callable), ... args = std::forward<Args>(args)]() mutable {
+          return std::invoke(std::move(callable), std::move(args)...);
+        });
 
-    std::future<Result> future = packaged_task->get_future();
+    std::future<Result> future = packaged_task.get_future();
     {
       std::scoped_lock lock(m_mutex);
       if (m_shutdown) {
         throw std::runtime_error("submit on stopped ThreadPool");
       }
-      m_tasks.emplace([packaged_task] { (*packaged_task)(); });
+      m_tasks.emplace(std::move(packaged_task));
     }
     m_condition_variable.notify_one();
     return future;
   }
 
+  /**
+   * @brief Runs `body(i)` for every i in [0, n) and returns once all have finished.
+   *
+   * Indices 1 to n - 1 are queued under one lock with a single wake-up, and the
+   * calling thread runs index 0 itself instead of idling. Each queued task only
+   * refers to state on the caller's stack, so it fits inline in an InplaceTask,
+   * and completion is tracked with a latch rather than futures.
+   *
+   * Must not be called from a task running on this pool: if every worker
+   * waited on a batch, the queued indices would never run.
+   *
+   * @param n Number of indices.
+   * @param body Callable taking a `std::size_t` index, invoked concurrently.
+   * @throws The first exception thrown by `body`, once every index has finished.
+   * @throws std::runtime_error If the pool has begun shutting down.
+   */
+  template <typename F>
+  void parallel_for(std::size_t n, F&& body) {
+    if (n == 0) {
+      return;
+    }
+    struct Batch {
+      explicit Batch(std::size_t pending) : done(static_cast<std::ptrdiff_t>(pending)) {}
+      std::latch done;  ///< Counts down as queued indices finish
+      std::mutex error_mutex;
+      std::exception_ptr error;  ///< First exception thrown by body
+    } batch(n - 1);
+
+    auto run = [&body, &batch](std::size_t i) noexcept {
+      try {
+        body(i);
+      } catch (...) {
+        std::scoped_lock lock(batch.error_mutex);
+        if (!batch.error) {
+          batch.error = std::current_exception();
+        }
+      }
+    };
+    std::size_t queued = 1;
+    {
+      std::scoped_lock lock(m_mutex);
+      if (m_shutdown) {
+        throw std::runtime_error("parallel_for on stopped ThreadPool");
+      }
+      try {
+        for (; queued < n; queued++) {
+          m_tasks.emplace([&run, &batch, queued] {
+            run(queued);
+            batch.done.count_down();
+          });
+        }
+      } catch (const std::bad_alloc&) {
+        // the queue could not grow: the calling thread runs what did not fit
+      }
+    }
+    m_condition_variable.notify_all();
+
+    run(0);
+    for (std::size_t i = queued; i < n; i++) {
+      run(i);
+      batch.done.count_down();
+    }
+    batch.done.wait();
+    if (batch.error) {
+      std::rethrow_exception(batch.error);
+    }
+  }
+
   ThreadPool(const ThreadPool&) = delete;
   ThreadPool& operator=(const ThreadPool&) = delete;
   ThreadPool(ThreadPool&&) = delete;
@@ -81,7 +152,7 @@ class ThreadPool {
   /** @brief Waits for and executes tasks until shutdown completes. */
   void worker_loop();
 
-  using Task = std::function<void()>;
+  using Task = InplaceTask;
 
   bool m_shutdown = false;                       ///< Whether new submissions are rejected.
   std::vector<std::thread> m_workers;            ///< Worker threads owned by the pool.
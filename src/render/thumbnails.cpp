@@ -0,0 +1,262 @@
+#include "thumbnails.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <utility>
+
+#include "pdf_constants.h"
+#include "plog/Log.h"
+#include "utils/logging.h"
+#include "utils/metrics.h"
+#include "utils/profiling.h"
+
+namespace {
+/**
+ * @brief Thumbnail metrics, looked up once from the process-wide registry.
+ */
+struct ThumbnailMetrics {
+  /// One thumbnail rendered on a worker parser, display list included
+  metrics::LatencyHistogram& render = metrics::registry().histogram("thumbnail.render");
+  /// All missing thumbnails of one request
+  metrics::LatencyHistogram& batch = metrics::registry().histogram("thumbnail.batch");
+  metrics::Counter& hits = metrics::registry().counter("cache.thumbnail.hits");
+  metrics::Counter& misses = metrics::registry().counter("cache.thumbnail.misses");
+  metrics::Counter& evictions = metrics::registry().counter("cache.thumbnail.evictions");
+  metrics::Gauge& bytes = metrics::registry().gauge("memory.thumbnail_bytes");
+};
+
+ThumbnailMetrics& thumbnail_metrics() {
+  static ThumbnailMetrics instance;
+  return instance;
+}
+}  // namespace
+
+namespace pdf {
+Thumbnail Thumbnail::pack(const unsigned char* rgb, int width, int height, std::size_t stride) {
+  Thumbnail result{.width = width, .height = height, .pixels = {}};
+  result.pixels.reserve(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+  for (int y = 0; y < height; y++) {
+    const unsigned char* row = rgb + (static_cast<std::size_t>(y) * stride);
+    for (int x = 0; x < width; x++) {
+      const unsigned char* px = row + (static_cast<std::size_t>(x) * g_pad);
+      result.pixels.push_back(static_cast<std::uint16_t>(((px[0] >> 3U) << 11U) |
+                                                         ((px[1] >> 2U) << 5U) | (px[2] >> 3U)));
+    }
+  }
+  return result;
+}
+
+void Thumbnail::unpack(unsigned char* rgb, std::size_t stride) const {
+  // widen each channel by repeating its top bits, so white stays 255
+  const auto* src = pixels.data();
+  for (int y = 0; y < height; y++) {
+    unsigned char* row = rgb + (static_cast<std::size_t>(y) * stride);
+    for (int x = 0; x < width; x++, src++) {
+      const unsigned r = (*src >> 11U) & 0x1FU;
+      const unsigned g = (*src >> 5U) & 0x3FU;
+      const unsigned b = *src & 0x1FU;
+      unsigned char* px = row + (static_cast<std::size_t>(x) * g_pad);
+      px[0] = static_cast<unsigned char>((r << 3U) | (r >> 2U));
+      px[1] = static_cast<unsigned char>((g << 2U) | (g >> 4U));
+      px[2] = static_cast<unsigned char>((b << 3U) | (b >> 2U));
+    }
+  }
+}
+
+ThumbnailCache::ThumbnailCache(const Parser& prototype, int n_threads, std::size_t budget_bytes)
+    : m_num_pages(prototype.num_pages()),
+      m_budget_bytes(budget_bytes),
+      m_workers(prototype, n_threads, "Thumbnail") {
+  m_cache.resize(static_cast<std::size_t>(std::max(m_num_pages, 0)));
+  m_thread = std::thread(&ThumbnailCache::render_loop, this);
+}
+
+ThumbnailCache::~ThumbnailCache() {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stop = true;
+    m_latest_id.fetch_add(1, std::memory_order_relaxed);  // stop rendering between pages
+  }
+  m_wake.notify_one();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void ThumbnailCache::request(std::span<const int> pages, geometry::PixelSize box, int rotation) {
+  std::vector<int> in_range;
+  for (const int page_num : pages) {
+    if (page_num >= 0 && page_num < m_num_pages) {
+      in_range.push_back(page_num);
+    }
+  }
+  std::ranges::sort(in_range);
+  {
+    std::scoped_lock lock(m_mutex);
+    if (box != m_box || rotation != m_rotation) {
+      std::ranges::fill(m_cache, nullptr);
+      m_cached_bytes.store(0, std::memory_order_relaxed);
+      m_rendered.clear();
+      m_box = box;
+      m_rotation = rotation;
+    }
+    const auto id = m_latest_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    m_pending = Request{.id = id, .pages = std::move(in_range), .box = box, .rotation = rotation};
+  }
+  m_wake.notify_one();
+}
+
+std::vector<int> ThumbnailCache::take_rendered() {
+  std::scoped_lock lock(m_mutex);
+  return std::exchange(m_rendered, {});
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailCache::get(int page_num) const {
+  if (page_num < 0 || page_num >= m_num_pages) {
+    return nullptr;
+  }
+  std::scoped_lock lock(m_mutex);
+  return m_cache[static_cast<std::size_t>(page_num)];
+}
+
+void ThumbnailCache::wait() const {
+  std::unique_lock lock(m_mutex);
+  m_done.wait(lock, [&] { return !m_pending && !m_running; });
+}
+
+void ThumbnailCache::render_loop() {
+  chrome_trace::set_thread_name("thumbnails");
+  while (true) {
+    Request request;
+    {
+      std::unique_lock lock(m_mutex);
+      m_running = false;
+      m_done.notify_all();
+      m_wake.wait(lock, [&] { return m_stop || m_pending.has_value(); });
+      if (m_stop) {
+        return;
+      }
+      request = std::move(*m_pending);
+      m_pending.reset();
+      m_running = true;
+    }
+    run(request);
+  }
+}
+
+void ThumbnailCache::run(const Request& request) {
+  ZoneScopedN("render thumbnails");
+  std::vector<int> missing;
+  {
+    std::scoped_lock lock(m_mutex);
+    for (const int page_num : request.pages) {
+      if (m_cache[static_cast<std::size_t>(page_num)]) {
+        thumbnail_metrics().hits.add();
+      } else {
+        thumbnail_metrics().misses.add();
+        missing.push_back(page_num);
+      }
+    }
+  }
+  if (!missing.empty() && request.box.width > 0 && request.box.height > 0) {
+    render_missing(request, missing);
+  }
+  // the budget is also enforced when everything was cached, as the requested pages moved
+  if (current(request.id)) {
+    evict(request.pages);
+  }
+  thumbnail_metrics().bytes.set(static_cast<std::int64_t>(cached_bytes()));
+}
+
+void ThumbnailCache::render_missing(const Request& request, std::span<const int> missing) {
+  const auto start = std::chrono::steady_clock::now();
+  std::atomic<std::size_t> next = 0;
+  m_workers.run(missing.size(), [&](Parser& parser) {
+    for (auto i = next.fetch_add(1); i < missing.size() && current(request.id);
+         i = next.fetch_add(1)) {
+      auto thumbnail = render_page(missing[i], parser, request.box, request.rotation);
+      if (!thumbnail) {
+        continue;  // not cached, a streamed page may still arrive
+      }
+      std::scoped_lock lock(m_mutex);
+      if (request.box != m_box || request.rotation != m_rotation) {
+        return;  // a later request changed the box, this one is stale
+      }
+      auto& slot = m_cache[static_cast<std::size_t>(missing[i])];
+      if (!slot) {
+        m_cached_bytes.fetch_add(thumbnail->bytes(), std::memory_order_relaxed);
+        slot = std::move(thumbnail);
+        m_rendered.push_back(missing[i]);
+      }
+    }
+  });
+  thumbnail_metrics().batch.record(std::chrono::steady_clock::now() - start);
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailCache::render_page(int page_num, Parser& parser,
+                                                             geometry::PixelSize box,
+                                                             int rotation) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto base = parser.page_specs(page_num);
+  if (!base) {
+    return nullptr;
+  }
+  const auto rotated = base->rotate_quarter_clockwise(rotation / 90);
+  const float zoom = rotated.fit_zoom(box.width, box.height);
+  const PageSpecs specs = rotated.scale(zoom);
+  if (specs.width <= 0 || specs.height <= 0) {
+    return nullptr;
+  }
+  auto dlist = parser.get_display_list(page_num);
+  if (!dlist) {
+    return nullptr;
+  }
+
+  std::vector<unsigned char> rgb(specs.size);
+  try {
+    parser.write_section(specs.width,
+                         specs.height,
+                         zoom,
+                         specs,
+                         std::move(*dlist),
+                         rgb.data(),
+                         {
+                             .x0 = static_cast<float>(specs.x0),
+                             .y0 = static_cast<float>(specs.y0),
+                             .x1 = static_cast<float>(specs.x1),
+                             .y1 = static_cast<float>(specs.y1),
+                         });
+  } catch (const std::exception& e) {
+    PLOG_ERROR << std::format("Failed to render thumbnail. PageNum: {}, {}", page_num, e.what());
+    return nullptr;
+  }
+  auto thumbnail = std::make_shared<const Thumbnail>(Thumbnail::pack(
+      rgb.data(), specs.width, specs.height, static_cast<std::size_t>(specs.width) * g_pad));
+  thumbnail_metrics().render.record(std::chrono::steady_clock::now() - start);
+  return thumbnail;
+}
+
+void ThumbnailCache::evict(std::span<const int> keep) {
+  if (cached_bytes() <= m_budget_bytes || keep.empty()) {
+    return;
+  }
+  std::scoped_lock lock(m_mutex);
+  // walk in from both ends of the document towards the middle of the kept pages
+  const int around_page = keep[keep.size() / 2];
+  int low = 0;
+  int high = m_num_pages - 1;
+  while (cached_bytes() > m_budget_bytes && low <= high) {
+    const bool take_low = std::abs(around_page - low) >= std::abs(high - around_page);
+    const int page_num = take_low ? low++ : high--;
+    auto& thumbnail = m_cache[static_cast<std::size_t>(page_num)];
+    if (thumbnail && !std::ranges::binary_search(keep, page_num)) {
+      m_cached_bytes.fetch_sub(thumbnail->bytes(), std::memory_order_relaxed);
+      thumbnail.reset();
+      thumbnail_metrics().evictions.add();
+    }
+  }
+}
+}  // namespace pdf
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "parser.h"
+#include "utils/geometry.h"
+#include "worker_parsers.h"
+
+namespace pdf {
+/**
+ * @brief A page rendered small, kept at 16 bits per pixel.
+ *
+ * Pixels are packed RGB565, two thirds the size of the RGB bitmaps sent to
+ * the terminal. Thumbnails are only ever shown at their own size, where the
+ * lost colour depth is hard to see.
+ */
+struct Thumbnail {
+  int width = 0;
+  int height = 0;
+  std::vector<std::uint16_t> pixels;  ///< RGB565, row by row
+
+  /// Packs width x height RGB pixels, g_pad bytes each, rows stride bytes apart.
+  static Thumbnail pack(const unsigned char* rgb, int width, int height, std::size_t stride);
+
+  /// Writes the pixels back as RGB, g_pad bytes each, rows stride bytes apart.
+  void unpack(unsigned char* rgb, std::size_t stride) const;
+
+  [[nodiscard]] std::size_t bytes() const { return pixels.size() * sizeof(std::uint16_t); }
+};
+
+/**
+ * @brief Renders page thumbnails in parallel on worker parsers and caches them.
+ *
+ * Each page is fitted into a box of pixels at the zoom that makes it fit, so
+ * a thumbnail costs a fraction of a full page render. Requests are rendered
+ * on a thread of their own, so the caller never waits on MuPDF; it polls
+ * take_rendered() for what has finished. Thumbnails stay cached until the box
+ * or rotation changes. Past the byte budget, the thumbnails farthest from the
+ * pages last requested are dropped first, never the requested pages
+ * themselves.
+ */
+class ThumbnailCache {
+ public:
+  static constexpr std::size_t DEFAULT_BUDGET_BYTES = 64 * 1024 * 1024;
+
+  /**
+   * @brief Prepares the parsers thumbnails are rendered with, see WorkerParsers.
+   *
+   * @param n_threads Thumbnails rendered in parallel, at least 1.
+   * @param budget_bytes Pixel bytes kept before thumbnails are dropped.
+   */
+  ThumbnailCache(const Parser& prototype, int n_threads,
+                 std::size_t budget_bytes = DEFAULT_BUDGET_BYTES);
+
+  /// Abandons the running request between pages and joins every thread.
+  ~ThumbnailCache();
+
+  ThumbnailCache(const ThumbnailCache&) = delete;
+  ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+  ThumbnailCache(ThumbnailCache&&) = delete;
+  ThumbnailCache& operator=(ThumbnailCache&&) = delete;
+
+  /**
+   * @brief Queues the thumbnails of pages not cached yet, and returns at once.
+   *
+   * Replaces the previous request, which stops between pages. A different box
+   * or rotation than the last request drops every cached thumbnail first.
+   * Pages that fail to render, e.g. ones that have not arrived yet, are tried
+   * again by the next request naming them.
+   *
+   * @param pages Zero-based page numbers. Out of range pages are skipped.
+   * @param box Pixels each page is fitted into, keeping its aspect ratio.
+   * @param rotation Clockwise rotation in degrees, a multiple of 90.
+   */
+  void request(std::span<const int> pages, geometry::PixelSize box, int rotation);
+
+  /// Pages rendered into the cache since the last call.
+  [[nodiscard]] std::vector<int> take_rendered();
+
+  /// Cached thumbnail of page_num, nullptr if it is not rendered.
+  [[nodiscard]] std::shared_ptr<const Thumbnail> get(int page_num) const;
+
+  /// Blocks until the latest request is done. Used by tests.
+  void wait() const;
+
+  /// Heap bytes of the cached pixels.
+  [[nodiscard]] std::size_t cached_bytes() const {
+    return m_cached_bytes.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Request {
+    std::size_t id;
+    std::vector<int> pages;  ///< In range, sorted
+    geometry::PixelSize box;
+    int rotation;
+  };
+
+  void render_loop();
+  void run(const Request& request);
+  /// Renders missing, pages of request not cached, in parallel on the worker parsers.
+  void render_missing(const Request& request, std::span<const int> missing);
+  /// Renders page_num with parser, nullptr on failure.
+  static std::shared_ptr<const Thumbnail> render_page(int page_num, Parser& parser,
+                                                      geometry::PixelSize box, int rotation);
+  /// Drops thumbnails of pages outside keep, farthest from its middle first, to fit the budget.
+  void evict(std::span<const int> keep);
+  /// Whether id is still the latest request.
+  [[nodiscard]] bool current(std::size_t id) const {
+    return m_latest_id.load(std::memory_order_relaxed) == id;
+  }
+
+  int m_num_pages;
+  std::size_t m_budget_bytes;
+  WorkerParsers m_workers;
+
+  mutable std::mutex m_mutex;  ///< Guards everything below except the atomics
+  std::condition_variable m_wake;
+  mutable std::condition_variable m_done;
+  geometry::PixelSize m_box{};  ///< Box of the cached thumbnails
+  int m_rotation = 0;           ///< Rotation of the cached thumbnails
+  std::vector<std::shared_ptr<const Thumbnail>> m_cache;  ///< Indexed by page, null until rendered
+  std::optional<Request> m_pending;
+  bool m_running = false;       ///< A request is being rendered
+  std::vector<int> m_rendered;  ///< Rendered but not taken yet
+  std::atomic<std::size_t> m_latest_id = 0;  ///< Bumped by request()
+  std::atomic<std::size_t> m_cached_bytes = 0;
+  bool m_stop = false;
+  std::thread m_thread;
+};
+}  // namespace pdf
@@ -0,0 +1,31 @@
+#include "worker_parsers.h"
+
+#include <exception>
+#include <utility>
+
+#include "plog/Log.h"
+
+namespace pdf {
+WorkerParsers::WorkerParsers(const Parser& prototype, int n_workers, std::string name)
+    : m_name(std::move(name)) {
+  const auto n = static_cast<std::size_t>(std::max(n_workers, 1));
+  for (std::size_t i = 0; i < n; i++) {
+    m_openers.push_back(prototype.duplicate_deferred(false));
+  }
+  m_parsers.resize(n);
+  // parallel_for runs index 0 on the calling thread, so one pool thread fewer
+  m_pool = std::make_unique<ThreadPool>(std::max<std::size_t>(n - 1, 1));
+}
+
+Parser* WorkerParsers::get(std::size_t idx) {
+  auto& parser = m_parsers[idx];
+  if (!parser && m_openers[idx]) {
+    try {
+      parser = std::exchange(m_openers[idx], nullptr)();
+    } catch (const std::exception& e) {
+      PLOG_ERROR << m_name << " parser " << idx << " failed to open the document: " << e.what();
+    }
+  }
+  return parser.get();
+}
+}  // namespace pdf
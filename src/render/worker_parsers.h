@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+#include "threadpool.h"
+
+namespace pdf {
+/**
+ * @brief A pool of threads, each with its own parser that opens the document on first use.
+ *
+ * Contexts are cloned up front, on the thread owning the prototype. Each
+ * worker reopens the document the first time it is given work, on its own
+ * thread, so background features such as search and thumbnails never make
+ * their caller wait for MuPDF to parse the document again.
+ */
+class WorkerParsers {
+ public:
+  /**
+   * @brief Prepares parsers for the document loaded in prototype.
+   *
+   * Must be called on the thread owning prototype.
+   *
+   * @param n_workers Parsers, and so pages worked on in parallel, at least 1.
+   * @param name What the workers are for, used in log messages.
+   * @throw std::runtime_error If a context cannot be cloned.
+   */
+  WorkerParsers(const Parser& prototype, int n_workers, std::string name);
+
+  [[nodiscard]] std::size_t size() const { return m_parsers.size(); }
+
+  /**
+   * @brief Runs body(parser) on min(n, size()) workers at once and waits for all of them.
+   *
+   * One worker runs on the calling thread. Workers whose document failed to
+   * open are skipped, so body should share out work dynamically, for example
+   * through an atomic counter, for the other workers to take their share.
+   */
+  template <typename F>
+  void run(std::size_t n, F&& body) {
+    m_pool->parallel_for(std::min(n, size()), [&](std::size_t idx) {
+      if (Parser* parser = get(idx)) {
+        body(*parser);
+      }
+    });
+  }
+
+ private:
+  /// Parser idx, opened on first use. Null if the document failed to open.
+  Parser* get(std::size_t idx);
+
+  std::string m_name;
+  // parser i is opened by openers[i] on first use, then only used by parallel_for index i
+  std::vector<Parser::DeferredParser> m_openers;
+  std::vector<std::unique_ptr<Parser>> m_parsers;
+  std::unique_ptr<ThreadPool> m_pool;  ///< Declared last, so it is joined before parsers go
+};
+}  // namespace pdf
@@ -0,0 +1,323 @@
+#include "input_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "viewer/keys.h"
+
+namespace {
+/**
+ * @brief Byte classes used as the columns of the transition table.
+ *
+ * Ranges follow ECMA-48: parameter bytes 0x30-0x3F, intermediate bytes
+ * 0x20-0x2F and final bytes 0x40-0x7E. '[' and 'O' are final bytes but get
+ * their own classes because they introduce CSI and SS3 after ESC.
+ */
+enum class ByteClass : std::uint8_t {
+  Esc,           ///< 0x1B
+  Erase,         ///< 0x08 and 0x7F, sent by the backspace key
+  Control,       ///< Remaining C0 controls
+  Intermediate,  ///< 0x20-0x2F, includes space
+  Param,         ///< 0x30-0x3F, digits and ; : < = > ?
+  CsiIntro,      ///< '['
+  Ss3Intro,      ///< 'O'
+  Final,         ///< Remaining 0x40-0x7E
+  High,          ///< 0x80-0xFF
+  Count,
+};
+
+/// What to do with a byte before moving to the next state.
+enum class Action : std::uint8_t {
+  Ignore,       ///< Drop the byte.
+  Key,          ///< Emit the byte as a plain key.
+  Alt,          ///< Emit the byte as an Alt-modified key.
+  EscapeKey,    ///< Emit key_escape for the previous ESC (ESC ESC).
+  Clear,        ///< Start a new parameter buffer.
+  Collect,      ///< Append the byte to the parameter buffer.
+  CsiDispatch,  ///< Decode a completed CSI sequence.
+  Ss3Dispatch,  ///< Decode a completed SS3 sequence.
+  Abort,        ///< Drop the partial sequence and reprocess the byte from Ground.
+};
+
+struct Transition {
+  Action action;
+  std::uint8_t next;  ///< Next state, as the underlying value of InputDecoder::State.
+};
+
+constexpr std::size_t N_CLASSES = static_cast<std::size_t>(ByteClass::Count);
+constexpr std::uint8_t GROUND = 0;
+constexpr std::uint8_t ESCAPE = 1;
+constexpr std::uint8_t CSI = 2;
+constexpr std::uint8_t SS3 = 3;
+
+constexpr std::array<ByteClass, 256> make_class_table() {
+  std::array<ByteClass, 256> table{};
+  for (std::size_t b = 0; b < table.size(); b++) {
+    if (b == 0x1B) {
+      table[b] = ByteClass::Esc;
+    } else if (b == 0x08 || b == 0x7F) {
+      table[b] = ByteClass::Erase;
+    } else if (b < 0x20) {
+      table[b] = ByteClass::Control;
+    } else if (b < 0x30) {
+      table[b] = ByteClass::Intermediate;
+    } else if (b < 0x40) {
+      table[b] = ByteClass::Param;
+    } else if (b == '[') {
+      table[b] = ByteClass::CsiIntro;
+    } else if (b == 'O') {
+      table[b] = ByteClass::Ss3Intro;
+    } else if (b < 0x7F) {
+      table[b] = ByteClass::Final;
+    } else {
+      table[b] = ByteClass::High;
+    }
+  }
+  return table;
+}
+
+constexpr std::array<ByteClass, 256> g_byte_classes = make_class_table();
+
+// clang-format off
+/// Rows are decoder states, columns are byte classes (same order as ByteClass).
+constexpr std::array<std::array<Transition, N_CLASSES>, 4> g_transitions = {{
+    // Ground
+    {{{Action::Ignore, ESCAPE},     {Action::Key, GROUND},         {Action::Key, GROUND},
+      {Action::Key, GROUND},        {Action::Key, GROUND},         {Action::Key, GROUND},
+      {Action::Key, GROUND},        {Action::Key, GROUND},         {Action::Ignore, GROUND}}},
+    // Escape
+    {{{Action::EscapeKey, ESCAPE},  {Action::Alt, GROUND},         {Action::Alt, GROUND},
+      {Action::Alt, GROUND},        {Action::Alt, GROUND},         {Action::Clear, CSI},
+      {Action::Ignore, SS3},        {Action::Alt, GROUND},         {Action::Ignore, GROUND}}},
+    // CSI
+    {{{Action::Abort, GROUND},      {Action::Abort, GROUND},       {Action::Abort, GROUND},
+      {Action::Collect, CSI},       {Action::Collect, CSI},        {Action::CsiDispatch, GROUND},
+      {Action::CsiDispatch, GROUND},{Action::CsiDispatch, GROUND}, {Action::Abort, GROUND}}},
+    // SS3
+    {{{Action::Abort, GROUND},      {Action::Abort, GROUND},       {Action::Abort, GROUND},
+      {Action::Ss3Dispatch, GROUND},{Action::Ss3Dispatch, GROUND}, {Action::Ss3Dispatch, GROUND},
+      {Action::Ss3Dispatch, GROUND},{Action::Ss3Dispatch, GROUND}, {Action::Abort, GROUND}}},
+}};
+// clang-format on
+
+bool is_erase(char c) { return c == '\x08' || c == '\x7F'; }
+
+InputEvent plain_key(char c) {
+  if (c == '\x0D' || c == '\x0A') {
+    return InputEvent{.key = key_enter};
+  }
+  if (c == '\x09') {
+    return InputEvent{.key = key_tab};
+  }
+  if (is_erase(c)) {
+    return InputEvent{.key = key_backspace};
+  }
+  if (c >= 1 && c <= 31) {
+    return InputEvent{.key = key_ctrl_char, .char_value = c};
+  }
+  if (c >= 32 && c <= 126) {
+    return InputEvent{.key = key_char, .char_value = c};
+  }
+  return InputEvent{.key = key_none};
+}
+
+InputEvent alt_key(char c) {
+  if (is_erase(c)) {
+    return InputEvent{.key = key_alt_backspace};
+  }
+  return InputEvent{.key = key_alt_char, .char_value = c};  // e.g. alt + f
+}
+
+InputEvent arrow_key(char final_byte) {
+  switch (final_byte) {
+    case 'A':
+      return InputEvent{.key = key_up_arrow};
+    case 'B':
+      return InputEvent{.key = key_down_arrow};
+    case 'C':
+      return InputEvent{.key = key_right_arrow};
+    case 'D':
+      return InputEvent{.key = key_left_arrow};
+    default:
+      return InputEvent{.key = key_none};
+  }
+}
+
+/**
+ * @brief Parses up to three ';' separated CSI parameters.
+ *
+ * Only the first ':' separated sub-parameter of each field is kept, which is
+ * the key code or modifier value in the Kitty keyboard protocol.
+ * Missing or malformed fields are left as -1.
+ */
+std::array<int, 3> parse_params(std::string_view params) {
+  std::array<int, 3> values = {-1, -1, -1};
+  std::size_t field = 0;
+  while (field < values.size()) {
+    const std::size_t end = params.find(';');
+    std::string_view token = params.substr(0, end);
+    token = token.substr(0, token.find(':'));
+    int value = 0;
+    const auto [ptr, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (error == std::errc{} && ptr == token.data() + token.size()) {
+      values[field] = value;
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    params.remove_prefix(end + 1);
+    field++;
+  }
+  return values;
+}
+
+/**
+ * @brief Decodes a Kitty keyboard protocol report: <code>CSI code ; modifiers u</code>.
+ *
+ * Modifiers are encoded as 1 + bitmask with shift = 1, alt = 2, ctrl = 4.
+ */
+InputEvent kitty_key(int code, int modifiers) {
+  constexpr int SHIFT = 1;
+  constexpr int ALT = 2;
+  constexpr int CTRL = 4;
+  const int mods = modifiers > 0 ? modifiers - 1 : 0;
+
+  switch (code) {
+    case 27:
+      return InputEvent{.key = key_escape};
+    case 13:
+      return InputEvent{.key = key_enter};
+    case 9:
+      return InputEvent{.key = key_tab};
+    case 8:
+    case 127:
+      return InputEvent{.key = (mods & ALT) != 0 ? key_alt_backspace : key_backspace};
+    default:
+      break;
+  }
+  if (code < 32 || code > 126) {
+    return InputEvent{.key = key_none};  // functional keys outside ASCII are not bound
+  }
+
+  auto c = static_cast<char>(code);
+  if ((mods & SHIFT) != 0) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  if ((mods & CTRL) != 0) {
+    return InputEvent{.key = key_ctrl_char, .char_value = static_cast<char>(c & 0x1F)};
+  }
+  if ((mods & ALT) != 0) {
+    return InputEvent{.key = key_alt_char, .char_value = c};
+  }
+  return InputEvent{.key = key_char, .char_value = c};
+}
+}  // namespace
+
+namespace terminal {
+void InputDecoder::feed(std::string_view bytes, std::vector<InputEvent>& out) {
+  std::size_t i = 0;
+  while (i < bytes.size()) {
+    const char c = bytes[i];
+    const auto byte_class = g_byte_classes[static_cast<unsigned char>(c)];
+    const Transition transition = g_transitions[static_cast<std::size_t>(m_state)]
+                                               [static_cast<std::size_t>(byte_class)];
+
+    switch (transition.action) {
+      case Action::Ignore:
+        break;
+      case Action::Key:
+        if (const InputEvent event = plain_key(c); event.key != key_none) {
+          out.push_back(event);
+        }
+        break;
+      case Action::Alt:
+        out.push_back(alt_key(c));
+        break;
+      case Action::EscapeKey:
+        out.push_back(InputEvent{.key = key_escape});
+        break;
+      case Action::Clear:
+        m_param_len = 0;
+        m_param_overflow = false;
+        break;
+      case Action::Collect:
+        if (m_param_len < m_params.size()) {
+          m_params[m_param_len++] = c;
+        } else {
+          m_param_overflow = true;
+        }
+        break;
+      case Action::CsiDispatch:
+        dispatch_csi(c, out);
+        break;
+      case Action::Ss3Dispatch:
+        if (const InputEvent event = arrow_key(c); event.key != key_none) {
+          out.push_back(event);
+        }
+        break;
+      case Action::Abort:
+        // drop the partial sequence and let Ground handle this byte
+        m_state = State::Ground;
+        continue;
+    }
+    m_state = static_cast<State>(transition.next);
+    i++;
+  }
+}
+
+bool InputDecoder::has_pending() const { return m_state != State::Ground; }
+
+void InputDecoder::flush(std::vector<InputEvent>& out) {
+  switch (m_state) {
+    case State::Ground:
+      break;
+    case State::Escape:
+      out.push_back(InputEvent{.key = key_escape});
+      break;
+    case State::Csi:
+      if (m_param_len == 0 && !m_param_overflow) {
+        out.push_back(alt_key('['));
+      }
+      break;
+    case State::Ss3:
+      out.push_back(alt_key('O'));
+      break;
+  }
+  m_state = State::Ground;
+}
+
+void InputDecoder::dispatch_csi(char final_byte, std::vector<InputEvent>& out) {
+  if (m_param_overflow) {
+    return;
+  }
+  const std::string_view params(m_params.data(), m_param_len);
+  // private markers (e.g. replies to mode queries) and intermediates are not key input
+  const bool has_private_marker = !params.empty() && params.front() >= '<';
+  const bool has_intermediate = std::ranges::any_of(params, [](char c) { return c < 0x30; });
+  if (has_private_marker || has_intermediate) {
+    return;
+  }
+
+  InputEvent event{.key = key_none};
+  if (final_byte >= 'A' && final_byte <= 'D') {  // arrows, optionally with "1;mods"
+    event = arrow_key(final_byte);
+  } else if (final_byte == '~') {
+    if (parse_params(params)[0] == 3) {
+      event = InputEvent{.key = key_delete};
+    }
+  } else if (final_byte == 'u') {  // Kitty keyboard protocol
+    const auto values = parse_params(params);
+    event = kitty_key(values[0], values[1]);
+  }
+
+  if (event.key != key_none) {
+    out.push_back(event);
+  }
+}
+}  // namespace terminal
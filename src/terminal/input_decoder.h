@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "viewer/keys.h"
+
+namespace terminal {
+/**
+ * @brief Incremental decoder turning raw terminal bytes into InputEvents.
+ *
+ * Bytes are classified through a lookup table and driven through a small
+ * transition table with four states: Ground, Escape, CSI and SS3. Recognised
+ * sequences are:
+ * - Plain bytes: printable ASCII, Enter, Tab, Backspace and other C0 controls.
+ * - <code>ESC x</code>: Alt + key (<code>ESC DEL</code> is Alt + Backspace).
+ * - <code>ESC [ ... final</code>: arrows, Delete (<code>3~</code>) and Kitty
+ *   keyboard protocol key reports (<code>code;modifiers u</code>).
+ * - <code>ESC O final</code>: application-mode arrows.
+ *
+ * Sequences may be split across feed() calls; the partial sequence is kept
+ * until more bytes arrive or flush() resolves it. This is what lets a lone
+ * Escape key press be told apart from the start of an escape sequence without
+ * waiting after every byte.
+ *
+ * @note Unrecognised sequences are consumed and dropped. Bytes above 0x7F are
+ * ignored since editing is ASCII only (see TUI::InputBar).
+ */
+class InputDecoder {
+ public:
+  /**
+   * @brief Decodes a chunk of bytes, appending complete events to out.
+   *
+   * @param bytes Raw bytes read from the terminal.
+   * @param out Vector receiving decoded events. Existing contents are kept.
+   */
+  void feed(std::string_view bytes, std::vector<InputEvent>& out);
+
+  /**
+   * @brief Whether a partially received escape sequence is buffered.
+   *
+   * Callers should give the terminal a short grace period to deliver the rest
+   * of the sequence before calling flush().
+   */
+  [[nodiscard]] bool has_pending() const;
+
+  /**
+   * @brief Resolves any buffered partial sequence into events.
+   *
+   * A lone <code>ESC</code> becomes key_escape. <code>ESC [</code> and
+   * <code>ESC O</code> become Alt + '[' and Alt + 'O'. Longer incomplete CSI
+   * sequences are dropped. The decoder returns to its ground state.
+   *
+   * @param out Vector receiving decoded events.
+   */
+  void flush(std::vector<InputEvent>& out);
+
+ private:
+  /// Decoder states. Values index the rows of the transition table.
+  enum class State : std::uint8_t {
+    Ground,  ///< Between sequences.
+    Escape,  ///< Received ESC.
+    Csi,     ///< Received ESC [, collecting parameters.
+    Ss3,     ///< Received ESC O, waiting for the final byte.
+  };
+
+  /// Maximum parameter bytes kept for one CSI sequence. Longer ones are dropped.
+  static constexpr std::size_t MAX_PARAM_BYTES = 16;
+
+  void dispatch_csi(char final_byte, std::vector<InputEvent>& out);
+
+  State m_state = State::Ground;
+  std::array<char, MAX_PARAM_BYTES> m_params{};  ///< Collected CSI parameter bytes.
+  std::size_t m_param_len = 0;                   ///< Number of bytes used in m_params.
+  bool m_param_overflow = false;                 ///< Current CSI sequence exceeded the buffer.
+};
+}  // namespace terminal
@@ -5,8 +5,11 @@
 #include "kitty_internal.h"
 
 namespace kitty {
-static constexpr int32_t IMAGE_Z = INT32_MIN / 2 - 2;
+static constexpr int32_t IMAGE_Z = INT32_MIN / 2 - 3;
+static constexpr int32_t HIGHLIGHT_Z = INT32_MIN / 2 - 2;  // above the page, under the dim layer
 static constexpr int32_t DIM_LAYER_Z = INT32_MIN / 2 - 1;
+static constexpr int HIGHLIGHT_IMAGE_ID = 2;
+static constexpr int CURRENT_HIGHLIGHT_IMAGE_ID = 3;
 
 std::string get_image_sequence(const std::string& filepath, int img_id, int img_width,
                                int img_height, int x_offset_pixels, int y_offset_pixels,
@@ -19,11 +22,8 @@ std::string get_image_sequence(const std::string& filepath, int img_id, int img_
   std::string sequence;
   if (transmit) {
     // save the full image first
-    sequence += std::format(
-        "\x1b_Ga=t,q=2,i={},t={},f=24,s={},v={};{}"
-        "\x1b\\",
-        img_id, transmission_medium == "shm" ? "s" : "f", img_width, img_height,
-        kitty::detail::base64_encode(filepath));
+    sequence +=
+        get_transmit_sequence(filepath, img_id, img_width, img_height, transmission_medium);
   }
   sequence += std::format(  // read and display
       "\x1b_Ga=p,q=2,i={},p={},C=1,z={},x={},y={},w={},h={}{}{}\x1b\\", img_id, img_id, IMAGE_Z,
@@ -40,6 +40,46 @@ std::string delete_image_placement() {
   return "\x1b_Ga=d\x1b\\";  // delete all visible placements
 }
 
+std::string get_transmit_sequence(const std::string& filepath, int img_id, int img_width,
+                                  int img_height, const std::string& transmission_medium) {
+  return std::format("\x1b_Ga=t,q=2,i={},t={},f=24,s={},v={};{}\x1b\\",
+                     img_id,
+                     transmission_medium == "shm" ? "s" : "f",
+                     img_width,
+                     img_height,
+                     kitty::detail::base64_encode(filepath));
+}
+
+std::string get_region_sequence(const std::string& filepath, int img_id, int x_pixels,
+                                int y_pixels, int region_width, int region_height,
+                                const std::string& transmission_medium) {
+  // edit the root frame (r=1) in place rather than adding an animation frame
+  return std::format("\x1b_Ga=f,q=2,i={},r=1,x={},y={},t={},f=24,s={},v={};{}\x1b\\",
+                     img_id,
+                     x_pixels,
+                     y_pixels,
+                     transmission_medium == "shm" ? "s" : "f",
+                     region_width,
+                     region_height,
+                     kitty::detail::base64_encode(filepath));
+}
+
+std::string get_crop_placement(int img_id, int placement_id, geometry::PixelRect crop,
+                               int x_offset_pixels, int y_offset_pixels) {
+  return std::format("\x1b_Ga=p,q=2,i={},p={},C=1,z={},x={},y={},w={},h={},X={},Y={}\x1b\\",
+                     img_id,
+                     placement_id,
+                     IMAGE_Z,
+                     crop.x,
+                     crop.y,
+                     crop.width,
+                     crop.height,
+                     x_offset_pixels,
+                     y_offset_pixels);
+}
+
+std::string delete_image(int img_id) { return std::format("\x1b_Ga=d,q=2,d=I,i={}\x1b\\", img_id); }
+
 std::string get_dim_layer(int term_width, int term_height) {
   const std::string b64_block = detail::b64_black_pixel_3x3(100);
   // create a 3 x 3 block
@@ -55,4 +95,38 @@ std::string get_dim_layer(int term_width, int term_height) {
 }
 
 std::string clear_dim_layer() { return std::format("\x1b_Ga=d,d=Z,z={}\x1b\\", DIM_LAYER_Z); }
+
+std::string get_highlight_images() {
+  // same 3 x 3 block as the dim layer, in yellow
+  std::string result;
+  for (const auto& [img_id, opacity] :
+       {std::pair{HIGHLIGHT_IMAGE_ID, 30}, std::pair{CURRENT_HIGHLIGHT_IMAGE_ID, 55}}) {
+    result += std::format("\x1b_Ga=t,q=2,f=32,i={},s={},v={};{}\x1b\\",
+                          img_id,
+                          3,
+                          3,
+                          detail::b64_pixel_3x3(255, 220, 0, opacity));
+  }
+  return result;
+}
+
+std::string get_highlight_placement(bool current, int placement_id, int x_offset_pixels,
+                                    int y_offset_pixels, int cols, int rows) {
+  // stretch the middle pixel, as the dim layer does
+  return std::format(
+      "\x1b_Ga=p,q=2,i={},p={},C=1,z={},X={},Y={},c={},r={},x=1,y=1,w=1,h=1\x1b\\",
+      current ? CURRENT_HIGHLIGHT_IMAGE_ID : HIGHLIGHT_IMAGE_ID,
+      placement_id,
+      HIGHLIGHT_Z,
+      x_offset_pixels,
+      y_offset_pixels,
+      cols,
+      rows);
+}
+
+std::string clear_highlights() {
+  return std::format("\x1b_Ga=d,q=2,d=i,i={}\x1b\\\x1b_Ga=d,q=2,d=i,i={}\x1b\\",
+                     HIGHLIGHT_IMAGE_ID,
+                     CURRENT_HIGHLIGHT_IMAGE_ID);
+}
 }  // namespace kitty
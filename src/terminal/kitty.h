@@ -1,5 +1,6 @@
 #pragma once
 #include "render/parser.h"
+#include "utils/geometry.h"
 
 namespace kitty {
 std::string get_image_sequence(const std::string& filepath, int img_id, int img_width,
@@ -10,6 +11,56 @@ std::string get_image_sequence(const std::string& filepath, int img_id, int img_
 
 std::string delete_image_placement();
 
+/**
+ * @brief Stores an RGB image without displaying it, for placements to crop from.
+ */
+std::string get_transmit_sequence(const std::string& filepath, int img_id, int img_width,
+                                  int img_height, const std::string& transmission_medium);
+
+/**
+ * @brief Overwrites a rectangle of a stored image with new RGB pixels.
+ *
+ * Placements of the image show the new pixels without being placed again.
+ */
+std::string get_region_sequence(const std::string& filepath, int img_id, int x_pixels,
+                                int y_pixels, int region_width, int region_height,
+                                const std::string& transmission_medium);
+
+/**
+ * @brief Places a crop of a stored image at the cursor's cell, at its native size.
+ *
+ * @param x_offset_pixels Offset right from the cell's left edge, less than a cell width.
+ * @param y_offset_pixels Offset down from the cell's top edge, less than a cell height.
+ */
+std::string get_crop_placement(int img_id, int placement_id, geometry::PixelRect crop,
+                               int x_offset_pixels, int y_offset_pixels);
+
+/// Deletes every placement of img_id and frees its pixels.
+std::string delete_image(int img_id);
+
 std::string get_dim_layer(int term_width, int term_height);
 std::string clear_dim_layer();
+
+/**
+ * @brief Stores the translucent pixels search highlights are stretched from.
+ *
+ * Sent with every frame drawing highlights; each is a few dozen bytes.
+ */
+std::string get_highlight_images();
+
+/**
+ * @brief Places a highlight over the page, starting at the cursor's cell.
+ *
+ * @param current Whether this is the hit being shown, drawn more opaque than the others.
+ * @param placement_id Distinguishes the highlights of one frame; ids start at 1.
+ * @param x_offset_pixels Offset right from the cell's left edge, less than a cell width.
+ * @param y_offset_pixels Offset down from the cell's top edge, less than a cell height.
+ * @param cols Cells the highlight is stretched across.
+ * @param rows Cells the highlight is stretched down.
+ */
+std::string get_highlight_placement(bool current, int placement_id, int x_offset_pixels,
+                                    int y_offset_pixels, int cols, int rows);
+
+/// Deletes every highlight placement, keeping the stored pixels.
+std::string clear_highlights();
 }  // namespace kitty
@@ -25,12 +25,13 @@ constexpr std::string base64_encode(const std::string& input) {
   while (out.size() % 4) out.push_back('=');
   return out;
 }
-inline std::string b64_black_pixel_3x3(int opacity) {
+inline std::string b64_pixel_3x3(unsigned char r, unsigned char g, unsigned char b,
+                                 int opacity) {
   // 3x3 due to interpolation on some terminals
   std::string pixel;
-  pixel.push_back(0);
-  pixel.push_back(0);
-  pixel.push_back(0);
+  pixel.push_back(static_cast<char>(r));
+  pixel.push_back(static_cast<char>(g));
+  pixel.push_back(static_cast<char>(b));
   const int alpha_channel = opacity * 255 / 100;  // map from 0 to 100%
   pixel.push_back(static_cast<char>(alpha_channel));
   std::string image_data;
@@ -39,4 +40,5 @@ inline std::string b64_black_pixel_3x3(int opacity) {
   }
   return base64_encode(image_data);
 }
+inline std::string b64_black_pixel_3x3(int opacity) { return b64_pixel_3x3(0, 0, 0, opacity); }
 }  // namespace kitty::detail
@@ -1,15 +1,17 @@
 #include "terminal.h"
 
+#include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/poll.h>
 #include <unistd.h>
 
-#include <array>
 #include <cerrno>
 #include <csignal>
 #include <cstdio>
 #include <format>
 #include <print>
+#include <span>
+#include <string_view>
 #include <system_error>
 
 #include "plog/Log.h"
@@ -39,6 +41,18 @@ std::string_view reset_screen_and_cursor_string() {
 }
 std::string_view save_cursor_string() { return "\0337"; }
 std::string_view restore_cursor_string() { return "\0338"; }
+bool reattach_stdin() {
+  const int tty = open("/dev/tty", O_RDWR | O_CLOEXEC);
+  if (tty == -1) {
+    return false;
+  }
+  if (tty == STDIN_FILENO) {
+    return true;  // stdin was closed and the terminal took its place
+  }
+  const bool ok = dup2(tty, STDIN_FILENO) != -1;  // the duplicate does not inherit O_CLOEXEC
+  close(tty);
+  return ok;
+}
 }  // namespace terminal
 
 Terminal::Terminal() = default;
@@ -87,9 +101,15 @@ bool Terminal::was_resized() {
   return false;
 }
 
+void Terminal::override_size(const TermSize& size) {
+  m_size_overridden = true;
+  m_term_size = size;
+  window_resized = 1;
+}
+
 TermSize Terminal::get_terminal_size() {
   winsize ws{};
-  if (window_resized == 0) {  // not resized, use cached
+  if (window_resized == 0 || m_size_overridden) {  // not resized, use cached
     return m_term_size;
   }
   if (ioctl(STDIN_FILENO, TIOCGWINSZ, &ws) == 0) {
@@ -159,7 +179,8 @@ void Terminal::exit_raw_mode() noexcept {
   m_raw_mode = false;
 }
 
-InputEvent Terminal::read_input(int timeout_ms) {
+std::span<const InputEvent> Terminal::read_input(int timeout_ms) {
+  m_events.clear();
   pollfd stdin_poll{
       .fd = STDIN_FILENO,
       .events = POLLIN,
@@ -167,66 +188,43 @@ InputEvent Terminal::read_input(int timeout_ms) {
   };
 
   const int input_result = poll(&stdin_poll, 1, timeout_ms);
-  if (input_result <= 0) {
-    return InputEvent{.key = key_none};
+  if (input_result <= 0 || !drain_stdin()) {
+    return m_events;
   }
 
-  char c;
-  ssize_t nread = read(STDIN_FILENO, &c, 1);
-  if (nread == -1) {
-    if (errno == EINTR || errno == EAGAIN) {
-      return InputEvent{.key = key_none};
+  // a buffer ending mid sequence may just be a split write, or a lone ESC key press.
+  // wait briefly for the remainder before deciding.
+  while (m_decoder.has_pending()) {
+    if (poll(&stdin_poll, 1, ESCAPE_GRACE_MS) <= 0 || !drain_stdin()) {
+      m_decoder.flush(m_events);
     }
   }
+  return m_events;
+}
 
-  if (nread != 1) {
-    return InputEvent{.key = key_none};
-  }
-
-  if (c == '\x1b') {                                     // escape key and arrow keys
-    const int escape_result = poll(&stdin_poll, 1, 10);  // wait 10ms for next byte
-    if (escape_result == 0) {
-      return InputEvent{.key = key_escape};
+bool Terminal::drain_stdin() {
+  bool read_any = false;
+  while (true) {
+    const ssize_t nread = read(STDIN_FILENO, m_read_buffer.data(), m_read_buffer.size());
+    if (nread <= 0) {
+      // EINTR/EAGAIN or end of input, keep whatever was decoded so far
+      return read_any;
     }
-    if (escape_result > 0) {
-      std::array<char, 3> seq;
-      if (read(STDIN_FILENO, &seq[0], 1) != 1) return InputEvent{.key = key_escape};
-
-      if (seq[0] == '\x08' || seq[0] == '\x7F') {
-        return InputEvent{.key = key_alt_backspace};
-      }
-      if (seq[0] == '[') {
-        if (read(STDIN_FILENO, &seq[1], 1) != 1) return InputEvent{.key = key_escape};
-        switch (seq[1]) {
-          case 'A':
-            return InputEvent{.key = key_up_arrow};
-          case 'B':
-            return InputEvent{.key = key_down_arrow};
-          case 'C':
-            return InputEvent{.key = key_right_arrow};
-          case 'D':
-            return InputEvent{.key = key_left_arrow};
-        }
-      }
-      return InputEvent{.key = key_alt_char, .char_value = seq[0]};  // e.g. alt + f
+    read_any = true;
+    const auto n_bytes = static_cast<std::size_t>(nread);
+    m_decoder.feed(std::string_view(m_read_buffer.data(), n_bytes), m_events);
+    if (n_bytes < m_read_buffer.size()) {
+      return true;  // short read, kernel buffer is empty
     }
-    return InputEvent{.key = key_escape};
-  }
 
-  if (c == '\x0D' || c == '\x0A') {
-    return InputEvent{.key = key_enter};
-  }
-  if (c == '\x09') {
-    return InputEvent{.key = key_tab};
-  }
-  if (c == '\x08' || c == '\x7F') {
-    return InputEvent{.key = key_backspace};
-  }
-  if (c >= 1 && c <= 31) {
-    return InputEvent{.key = key_ctrl_char, .char_value = c};
-  }
-  if (c >= 32 && c <= 126) {  // printable chars
-    return InputEvent(key_char, c);
+    // buffer was filled completely, only keep reading if more is ready right now
+    pollfd more{
+        .fd = STDIN_FILENO,
+        .events = POLLIN,
+        .revents = 0,
+    };
+    if (poll(&more, 1, 0) <= 0) {
+      return true;
+    }
   }
-  return InputEvent{.key = key_none};  // ignore other keys for now
-}
\ No newline at end of file
+}
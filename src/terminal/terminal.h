@@ -1,10 +1,14 @@
 #pragma once
 #include <sys/termios.h>
 
+#include <array>
 #include <csignal>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include "input_decoder.h"
 #include "viewer/keys.h"
 
 /**
@@ -50,6 +54,16 @@ void exit_alt_screen();
 
 /// Returns an ANSI sequence that restores the saved cursor position.
 [[nodiscard]] std::string_view restore_cursor_string();
+
+/**
+ * @brief Points stdin at the controlling terminal.
+ *
+ * Input and window size are read from STDIN_FILENO, so this is needed once a
+ * document piped through stdin has been handed to its reader.
+ *
+ * @return false if the process has no controlling terminal.
+ */
+bool reattach_stdin();
 }  // namespace terminal
 
 /**
@@ -105,13 +119,27 @@ class Terminal {
   TermSize get_terminal_size();
 
   /**
-   * @brief Waits for and decodes one terminal input event.
+   * @brief Pins the reported dimensions, e.g. to reproduce a recorded session.
+   *
+   * get_terminal_size() returns size from now on, ignoring the real terminal,
+   * and the change is reported once through was_resized().
+   */
+  void override_size(const TermSize& size);
+
+  /**
+   * @brief Waits for input, then drains and decodes every byte already available.
+   *
+   * All pending bytes are consumed before returning so key-repeat and pastes are
+   * handled as one batch instead of one event per poll. A buffer ending in a
+   * partial escape sequence is given ESCAPE_GRACE_MS to complete before it is
+   * resolved (e.g. a lone ESC becomes key_escape).
    *
    * @param timeout_ms Poll timeout in milliseconds. Zero performs a nonblocking
    * check; a negative value waits indefinitely.
-   * @return The decoded event, or key_none on timeout, interruption, or unsupported input.
+   * @return Decoded events in arrival order. Empty on timeout, interruption, or
+   * unsupported input. The view is invalidated by the next call.
    */
-  InputEvent read_input(int timeout_ms);
+  std::span<const InputEvent> read_input(int timeout_ms);
 
   Terminal(const Terminal&) = delete;
   Terminal& operator=(const Terminal&) = delete;
@@ -130,8 +158,21 @@ class Terminal {
    */
   void exit_raw_mode() noexcept;
 
-  termios m_orig_termios;   ///< Stores original terminal attributes to restore later
-  bool m_raw_mode = false;  ///< Tracks if we are in raw mode
+  /**
+   * @brief Reads every byte currently available on stdin into the decoder.
+   * @return false if nothing could be read (end of file or read error).
+   */
+  bool drain_stdin();
+
+  /// Time allowed for the rest of an escape sequence to arrive after a partial read.
+  static constexpr int ESCAPE_GRACE_MS = 10;
+
+  terminal::InputDecoder m_decoder;        ///< Decodes raw bytes into events
+  std::array<char, 4096> m_read_buffer{};  ///< Scratch space for a single read()
+  std::vector<InputEvent> m_events;        ///< Events decoded by the last read_input()
+  termios m_orig_termios;                  ///< Stores original terminal attributes to restore later
+  bool m_raw_mode = false;                 ///< Tracks if we are in raw mode
+  bool m_size_overridden = false;          ///< m_term_size is pinned by override_size()
   TermSize m_term_size{
       .columns = 80,
       .rows = 24,
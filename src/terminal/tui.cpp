@@ -1,8 +1,10 @@
 #include "tui.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <functional>
+#include <span>
 #include <string>
 #include <string_view>
 
@@ -13,14 +15,16 @@
 #include "utils/resize_debouncer.h"
 
 namespace TUI::helplist {
-static constexpr std::array<std::array<std::string_view, 2>, 15> help_text = {
+static constexpr std::array<std::array<std::string_view, 2>, 18> help_text = {
     {
         {"->", "Next Page"},
         {"<-", "Previous Page"},
         {"q", "Quit"},
         {"g", "Go to Page"},
         {"Esc", "Exit input textbox"},
-        {"/ or shift+f", "Find text"},  // TODO
+        {"/ or shift+f", "Find text"},
+        {"n / N", "Next / previous match"},
+        {"o", "Page overview"},
         {"w", "Pan up"},
         {"a", "Pan left"},
         {"s", "Pan down"},
@@ -29,6 +33,7 @@ static constexpr std::array<std::array<std::string_view, 2>, 15> help_text = {
         {"+ or =", "Zoom in"},
         {"- or _", "Zoom out"},
         {"z", "Zoom to fit and reset viewport"},
+        {"m", "Toggle metrics overlay"},
         {"?", "Help page"},
     },
 };
@@ -100,6 +105,28 @@ std::string bottom_status_bar(const TermSize& ts, float current_zoom_level, int
   return result;
 }
 
+std::string loading_placeholder(const TermSize& ts, int page_number,
+                                const pdf::LoadProgress& progress) {
+  constexpr double BYTES_PER_KIB = 1024.0;
+  std::string result;
+  result += TermColor::Reset;
+  result += terminal::reset_screen_and_cursor_string();
+  result += kitty::delete_image_placement();
+  const std::string title = std::format("Loading page {}...", page_number);
+  const double received_kib = static_cast<double>(progress.received) / BYTES_PER_KIB;
+  const std::string received =
+      progress.expected
+          ? std::format("{:.0f} of {:.0f} KiB received",
+                        received_kib,
+                        static_cast<double>(*progress.expected) / BYTES_PER_KIB)
+          : std::format("{:.0f} KiB received", received_kib);
+
+  const int center_row = ts.rows / 2;
+  result += add_centered(center_row - 1, ts.columns, title, helpers::visible_length(title));
+  result += add_centered(center_row + 1, ts.columns, received, helpers::visible_length(received));
+  return result;
+}
+
 std::string guard_message(const TermSize& ts) {
   terminal::hide_cursor();
   std::string result;
@@ -204,6 +231,32 @@ std::string help_overlay(const TermSize& ts) {
   return result;
 };
 
+std::string metrics_hud(const TermSize& ts, std::span<const std::string> lines) {
+  constexpr int box_width = 36;
+  constexpr int box_start_row = 2;  // below the top bar
+  constexpr auto text_width = static_cast<std::size_t>(box_width - 4);
+  const int box_start_col = std::max(1, ts.columns - box_width + 1);
+  std::string result(terminal::save_cursor_string());
+  result += helpers::create_box(
+      {
+          .start_row = box_start_row,
+          .start_col = box_start_col,
+          .width = box_width,
+          .height = static_cast<int>(lines.size()) + 1,
+      },
+      true);
+
+  int row = box_start_row + 1;
+  result += std::format("{}{}", TermColor::BlackBg, TermColor::WhiteFg);
+  for (const auto& line : lines) {
+    result += terminal::move_cursor(row++, box_start_col + 2);
+    result += line.substr(0, text_width);
+  }
+  result += TermColor::Reset;
+  result += terminal::restore_cursor_string();
+  return result;
+}
+
 bool is_window_too_small(const TermSize& ts) { return ts.columns < MIN_COLS || ts.rows < MIN_ROWS; }
 
 float calculate_zoom_factor(const TermSize& ts, const pdf::PageSpecs& ps, const ContentArea& area,
@@ -211,10 +264,7 @@ float calculate_zoom_factor(const TermSize& ts, const pdf::PageSpecs& ps, const
   const int max_w_pixels = area.cols * ts.cell_pixel_width;
   const int max_h_pixels = area.rows * ts.cell_pixel_height;
 
-  const float h_scale = static_cast<float>(max_w_pixels) / ps.acc_width;
-  const float v_scale = static_cast<float>(max_h_pixels) / ps.acc_height;
-
-  return std::min(h_scale, v_scale) * zoom;
+  return ps.fit_zoom(max_w_pixels, max_h_pixels) * zoom;
 }
 
 geometry::CellPosition centered_cursor_position(const TermSize& ts, int w_pixels, int h_pixels,
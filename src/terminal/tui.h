@@ -1,5 +1,6 @@
 #pragma once
 #include <functional>
+#include <span>
 #include <string>
 
 #include "render/parser.h"
@@ -72,10 +73,19 @@ std::string bottom_status_bar(const TermSize& ts, float current_zoom_level, int
 /// whenever the terminal is below MIN_COLS x MIN_ROWS.
 std::string guard_message(const TermSize& ts);
 
+/// Renders the placeholder shown in place of a page whose data has not arrived
+/// yet, with how much of the document has been received so far.
+std::string loading_placeholder(const TermSize& ts, int page_number,
+                                const pdf::LoadProgress& progress);
+
 /// Renders the full-screen help overlay (key-binding reference). Falls back
 /// to guard_message() if the terminal is currently too small to fit it.
 std::string help_overlay(const TermSize& ts);
 
+/// Renders a boxed list of metric lines in the top-right corner, just below the
+/// top status bar. Lines wider than the box are truncated.
+std::string metrics_hud(const TermSize& ts, std::span<const std::string> lines);
+
 /// True if the terminal is smaller than MIN_COLS x MIN_ROWS, i.e. too small
 /// to draw normal UI.
 bool is_window_too_small(const TermSize& ts);
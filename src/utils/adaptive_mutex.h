@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Mutex that spins briefly before sleeping in the kernel.
+ *
+ * MuPDF holds its allocator and glyph cache locks for a few hundred cycles at
+ * a time, so a waiter that spins usually gets the lock without the two context
+ * switches a std::mutex sleep costs. The spin budget adapts to how long recent
+ * acquisitions needed, and a waiter that runs out of budget blocks with
+ * std::atomic::wait, which is a futex on Linux.
+ *
+ * The state follows Drepper's "Futexes Are Tricky": 0 unlocked, 1 locked,
+ * 2 locked with possible sleepers, so an uncontended unlock never enters the
+ * kernel. Satisfies Lockable.
+ */
+class AdaptiveMutex {
+ public:
+  AdaptiveMutex() = default;
+  AdaptiveMutex(const AdaptiveMutex&) = delete;
+  AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+  bool try_lock() {
+    std::uint32_t expected = UNLOCKED;
+    return m_state.compare_exchange_strong(
+        expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  void lock() {
+    if (try_lock()) {
+      return;
+    }
+    const int budget = std::min(MAX_SPINS, 2 * m_spins.load(std::memory_order_relaxed) + 16);
+    int spins = 0;
+    for (; spins < budget; spins++) {
+      cpu_relax();
+      if (m_state.load(std::memory_order_relaxed) == UNLOCKED && try_lock()) {
+        adapt(spins);
+        return;
+      }
+    }
+    adapt(spins);
+    // mark the lock as contended so the holder wakes us, then sleep until it changes
+    while (m_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+      m_state.wait(CONTENDED, std::memory_order_relaxed);
+    }
+  }
+
+  void unlock() {
+    if (m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+      m_state.notify_one();
+    }
+  }
+
+ private:
+  static constexpr std::uint32_t UNLOCKED = 0;
+  static constexpr std::uint32_t LOCKED = 1;
+  static constexpr std::uint32_t CONTENDED = 2;
+  static constexpr int MAX_SPINS = 1000;
+
+  static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  /// Moves the spin estimate an eighth of the way towards the latest wait.
+  void adapt(int spins) {
+    const int estimate = m_spins.load(std::memory_order_relaxed);
+    m_spins.store(estimate + (spins - estimate) / 8, std::memory_order_relaxed);
+  }
+
+  std::atomic<std::uint32_t> m_state = UNLOCKED;
+  std::atomic<int> m_spins = 0;  ///< Running estimate of spins needed, racy by design
+};
@@ -0,0 +1,230 @@
+#include "chrome_trace.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int g_pid = 1;  // one process per trace, named through metadata
+
+struct Event {
+  const char* name = nullptr;
+  std::int64_t start_ns = 0;
+  std::int64_t duration_ns = 0;
+  std::int64_t request = -1;  ///< -1 outside a RequestScope
+  int page = -1;
+  std::uint32_t tid = 0;
+};
+
+/**
+ * @brief Single producer ring of events.
+ *
+ * Only the owning thread writes, publishing each event with a release store of
+ * head. Once the thread exits the buffer is handed to the next new thread, and
+ * events keep the id of the thread that wrote them.
+ */
+struct RingBuffer {
+  explicit RingBuffer(std::size_t capacity) : events(capacity) {}
+  std::vector<Event> events;               ///< Size is a power of two
+  std::atomic<std::uint64_t> head = 0;     ///< Events ever written
+  std::atomic<bool> owned = true;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<RingBuffer>> buffers;
+  std::map<std::uint32_t, std::string> thread_names;
+  std::size_t capacity = std::size_t{1} << 16;
+  std::atomic<std::int64_t> epoch_ns = 0;
+  std::atomic<std::uint32_t> next_tid = 1;
+};
+
+Registry& registry() {
+  static Registry r;
+  return r;
+}
+
+struct ThreadState {
+  RingBuffer* buffer = nullptr;
+  std::uint32_t tid = 0;
+  std::int64_t request = -1;
+  int page = -1;
+
+  ThreadState() = default;
+  ThreadState(const ThreadState&) = delete;
+  ThreadState& operator=(const ThreadState&) = delete;
+  ~ThreadState() {
+    if (buffer != nullptr) {
+      buffer->owned.store(false, std::memory_order_release);
+    }
+  }
+};
+
+thread_local ThreadState t_state;
+
+std::uint32_t thread_id() {
+  if (t_state.tid == 0) {
+    t_state.tid = registry().next_tid.fetch_add(1, std::memory_order_relaxed);
+  }
+  return t_state.tid;
+}
+
+RingBuffer* claim_buffer() {
+  auto& r = registry();
+  std::scoped_lock lock(r.mutex);
+  for (auto& buffer : r.buffers) {
+    if (buffer->events.size() == r.capacity &&
+        !buffer->owned.load(std::memory_order_acquire)) {
+      buffer->owned.store(true, std::memory_order_relaxed);
+      return buffer.get();
+    }
+  }
+  return r.buffers.emplace_back(std::make_unique<RingBuffer>(r.capacity)).get();
+}
+
+std::string escape(std::string_view s) {
+  std::string out;
+  out.reserve(s.size());
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  return out;
+}
+
+double to_us(std::int64_t ns) { return static_cast<double>(ns) / 1000.0; }
+}  // namespace
+
+namespace chrome_trace {
+namespace detail {
+std::int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void record(const char* name, std::int64_t start_ns) {
+  const std::int64_t end_ns = now_ns();
+  if (t_state.buffer == nullptr) {
+    t_state.buffer = claim_buffer();
+  }
+  RingBuffer& buffer = *t_state.buffer;
+  const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  buffer.events[head & (buffer.events.size() - 1)] = {
+      .name = name,
+      .start_ns = start_ns,
+      .duration_ns = end_ns - start_ns,
+      .request = t_state.request,
+      .page = t_state.page,
+      .tid = thread_id(),
+  };
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+}  // namespace detail
+
+void start(std::size_t events_per_thread) {
+  auto& r = registry();
+  {
+    std::scoped_lock lock(r.mutex);
+    r.capacity = std::bit_ceil(std::max<std::size_t>(events_per_thread, 2));
+    for (auto& buffer : r.buffers) {
+      buffer->head.store(0, std::memory_order_relaxed);
+    }
+    r.epoch_ns.store(detail::now_ns(), std::memory_order_relaxed);
+  }
+  detail::g_enabled.store(true, std::memory_order_release);
+}
+
+void stop() { detail::g_enabled.store(false, std::memory_order_release); }
+
+void set_thread_name(std::string name) {
+  const std::uint32_t tid = thread_id();
+  auto& r = registry();
+  std::scoped_lock lock(r.mutex);
+  r.thread_names[tid] = std::move(name);
+}
+
+std::expected<void, std::string> write_json(const std::filesystem::path& path) {
+  auto& r = registry();
+  std::vector<Event> events;
+  std::map<std::uint32_t, std::string> thread_names;
+  std::uint64_t dropped = 0;
+  {
+    std::scoped_lock lock(r.mutex);
+    for (const auto& buffer : r.buffers) {
+      const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+      const std::uint64_t size = buffer->events.size();
+      const std::uint64_t first = head > size ? head - size : 0;
+      dropped += first;
+      for (std::uint64_t i = first; i < head; i++) {
+        events.push_back(buffer->events[i & (size - 1)]);
+      }
+    }
+    thread_names = r.thread_names;
+  }
+  std::ranges::sort(events, {}, &Event::start_ns);
+  const std::int64_t epoch_ns = r.epoch_ns.load(std::memory_order_relaxed);
+
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return std::unexpected(std::format("could not open {} for writing", path.string()));
+  }
+  out << std::format(
+      "{{\"displayTimeUnit\":\"ms\",\"otherData\":{{\"dropped_events\":{}}},\"traceEvents\":[\n"
+      "{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":{},\"args\":{{\"name\":\"pdvu\"}}}}",
+      dropped,
+      g_pid);
+  for (const auto& [tid, name] : thread_names) {
+    out << std::format(
+        ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},\"tid\":{},"
+        "\"args\":{{\"name\":\"{}\"}}}}",
+        g_pid,
+        tid,
+        escape(name));
+  }
+  for (const auto& e : events) {
+    std::string args;
+    if (e.request >= 0) {
+      args += std::format("\"req_id\":{}", e.request);
+    }
+    if (e.page >= 0) {
+      args += std::format("{}\"page\":{}", args.empty() ? "" : ",", e.page);
+    }
+    out << std::format(
+        ",\n{{\"name\":\"{}\",\"cat\":\"pdvu\",\"ph\":\"X\",\"pid\":{},\"tid\":{},\"ts\":{:.3f},"
+        "\"dur\":{:.3f},\"args\":{{{}}}}}",
+        escape(e.name),
+        g_pid,
+        e.tid,
+        to_us(e.start_ns - epoch_ns),
+        to_us(e.duration_ns),
+        args);
+  }
+  out << "\n]}\n";
+  if (!out.flush()) {
+    return std::unexpected(std::format("failed to write {}", path.string()));
+  }
+  return {};
+}
+
+RequestScope::RequestScope(std::uint64_t req_id, int page_num)
+    : m_prev_request(t_state.request), m_prev_page(t_state.page) {
+  t_state.request = static_cast<std::int64_t>(req_id);
+  t_state.page = page_num;
+}
+
+RequestScope::~RequestScope() {
+  t_state.request = m_prev_request;
+  t_state.page = m_prev_page;
+}
+}  // namespace chrome_trace
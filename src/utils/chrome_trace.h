@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+
+/**
+ * @brief Always compiled tracer that writes Chrome Trace Event JSON.
+ *
+ * Unlike Tracy it needs no special build or GUI: start() turns it on at runtime
+ * and write_json() produces a file that chrome://tracing and ui.perfetto.dev
+ * open. Zones are recorded into per-thread ring buffers, so recording never
+ * takes a lock, and only the newest events of each thread are kept. While
+ * disabled a zone costs one relaxed atomic load.
+ */
+namespace chrome_trace {
+namespace detail {
+inline std::atomic<bool> g_enabled = false;
+
+std::int64_t now_ns();
+void record(const char* name, std::int64_t start_ns);
+}  // namespace detail
+
+/**
+ * @brief Enables recording.
+ * @param events_per_thread Ring buffer capacity, rounded up to a power of two.
+ *
+ * Clears previously recorded events, so it must not run while other threads
+ * are recording.
+ */
+void start(std::size_t events_per_thread = std::size_t{1} << 16);
+
+/// Disables recording. Recorded events are kept until the next start().
+void stop();
+
+inline bool enabled() { return detail::g_enabled.load(std::memory_order_relaxed); }
+
+/// Names the calling thread in the exported trace.
+void set_thread_name(std::string name);
+
+/**
+ * @brief Writes all recorded events as Chrome Trace Event JSON.
+ *
+ * Threads may still be recording, but events they write during the export can
+ * be torn, so call this once workers have been joined.
+ */
+[[nodiscard]] std::expected<void, std::string> write_json(const std::filesystem::path& path);
+
+/**
+ * @brief Tags zones that end on this thread with a render request and page.
+ *
+ * Scopes nest: the previous tags are restored on destruction.
+ */
+class RequestScope {
+ public:
+  RequestScope(std::uint64_t req_id, int page_num);
+  ~RequestScope();
+  RequestScope(const RequestScope&) = delete;
+  RequestScope& operator=(const RequestScope&) = delete;
+
+ private:
+  std::int64_t m_prev_request;
+  int m_prev_page;
+};
+
+/// Records the lifetime of a scope as a complete ("X") event. Use via ZoneScoped.
+class Zone {
+ public:
+  explicit Zone(const char* name)
+      : m_name(name), m_start_ns(enabled() ? detail::now_ns() : -1) {}
+  ~Zone() {
+    if (m_start_ns >= 0) {
+      detail::record(m_name, m_start_ns);
+    }
+  }
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+ private:
+  const char* m_name;  ///< Must outlive the tracer, string literals and __func__
+  std::int64_t m_start_ns;
+};
+}  // namespace chrome_trace
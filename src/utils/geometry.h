@@ -6,6 +6,8 @@ namespace geometry {
 struct PixelSize {
   int width;
   int height;
+
+  bool operator==(const PixelSize&) const = default;
 };
 
 /**
@@ -29,5 +31,7 @@ struct PixelRect {
 struct CellPosition {
   int row;
   int col;
+
+  bool operator==(const CellPosition&) const = default;
 };
 }  // namespace geometry
\ No newline at end of file
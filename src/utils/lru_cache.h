@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <iterator>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 #include "utils/profiling.h"
@@ -102,6 +103,22 @@ class LRUCache {
    */
   [[nodiscard]] const auto& get_entries() { return entries; }
 
+  /**
+   * @brief Sums a weight over every cached value, e.g. its size in bytes.
+   *
+   * @param weigh Callable returning the weight of a const Value&. Runs under the cache lock.
+   * @return The total weight.
+   */
+  template <typename Weigh>
+  std::size_t total_weight(Weigh weigh) {
+    std::scoped_lock lock(mut);
+    std::size_t total = 0;
+    for (const auto& entry : entries) {
+      total += weigh(entry.value);
+    }
+    return total;
+  }
+
   /**
    * @brief Removes a key-value pair from the cache if it exists.
    *
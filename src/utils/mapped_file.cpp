@@ -0,0 +1,76 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <utility>
+
+namespace {
+/// Bytes at the end of the file read ahead on open, enough for the trailer and most xrefs.
+constexpr std::size_t TAIL_READAHEAD = std::size_t{1} << 20;
+}  // namespace
+
+std::expected<MappedFile, std::string> MappedFile::open(const std::filesystem::path& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return std::unexpected(std::format("Cannot open {}: {}", path.string(), strerror(errno)));
+  }
+  struct stat info{};
+  if (fstat(fd, &info) == -1) {
+    const int error = errno;
+    close(fd);
+    return std::unexpected(std::format("Cannot stat {}: {}", path.string(), strerror(error)));
+  }
+  if (!S_ISREG(info.st_mode) || info.st_size <= 0) {
+    close(fd);
+    return std::unexpected(std::format("Cannot map {}: not a non-empty file", path.string()));
+  }
+  const auto size = static_cast<std::size_t>(info.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  const int error = errno;
+  close(fd);  // the mapping keeps the file open
+  if (data == MAP_FAILED) {
+    return std::unexpected(std::format("Cannot map {}: {}", path.string(), strerror(error)));
+  }
+
+  // hints only, failures are harmless
+  madvise(data, size, MADV_RANDOM);
+  const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const std::size_t tail = size > TAIL_READAHEAD ? (size - TAIL_READAHEAD) / page_size * page_size
+                                                 : 0;
+  madvise(static_cast<unsigned char*>(data) + tail, size - tail, MADV_WILLNEED);
+
+  return MappedFile(path, data, size);
+}
+
+MappedFile::MappedFile(std::filesystem::path path, void* data, std::size_t size)
+    : m_path(std::move(path)), m_data(data), m_size(size) {}
+
+MappedFile::~MappedFile() {
+  if (m_data != nullptr) {
+    munmap(m_data, m_size);
+  }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_path(std::move(other.m_path)),
+      m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (m_data != nullptr) {
+    munmap(m_data, m_size);
+  }
+  m_path = std::move(other.m_path);
+  m_data = std::exchange(other.m_data, nullptr);
+  m_size = std::exchange(other.m_size, 0);
+  return *this;
+}
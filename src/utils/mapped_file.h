@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <string>
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ *
+ * Lets every parser of a document read the same pages of the page cache
+ * instead of each opening the file with its own descriptor and stdio
+ * buffers. The mapping is advised for random access, as PDF readers jump
+ * between the trailer, the xref and the objects it points to, and the tail
+ * of the file, where the trailer lives, is read ahead straight away.
+ *
+ * The pages are the file's own, not a copy. If the file is truncated or
+ * rewritten in place while mapped, touching the pages past its new end
+ * raises SIGBUS, and other rewritten pages change under the reader. Reading
+ * the file into memory has neither problem, at the cost of a private copy.
+ */
+class MappedFile {
+ public:
+  /**
+   * @brief Maps path read-only.
+   * @return The mapping, or an error message if the file cannot be opened,
+   * is empty, or cannot be mapped.
+   */
+  [[nodiscard]] static std::expected<MappedFile, std::string> open(
+      const std::filesystem::path& path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /// Start of the mapped bytes.
+  [[nodiscard]] const unsigned char* data() const {
+    return static_cast<const unsigned char*>(m_data);
+  }
+
+  /// Size of the file when it was mapped, in bytes.
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+  /// Path the file was mapped from.
+  [[nodiscard]] const std::filesystem::path& path() const { return m_path; }
+
+ private:
+  MappedFile(std::filesystem::path path, void* data, std::size_t size);
+
+  std::filesystem::path m_path;
+  void* m_data = nullptr;  ///< nullptr once moved from
+  std::size_t m_size = 0;
+};
@@ -0,0 +1,96 @@
+#include "memory_accounting.h"
+
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "utils/ram_usage.h"
+
+namespace {
+/// Value of a "Key:   1234 kB" line in bytes.
+std::optional<std::size_t> kb_value(std::string_view line, std::string_view key) {
+  if (!line.starts_with(key) || line.size() <= key.size() || line[key.size()] != ':') {
+    return std::nullopt;
+  }
+  line.remove_prefix(key.size() + 1);
+  const std::size_t digits = line.find_first_not_of(' ');
+  if (digits == std::string_view::npos) {
+    return std::nullopt;
+  }
+  std::size_t kb = 0;
+  const auto [ptr, error] = std::from_chars(line.data() + digits, line.data() + line.size(), kb);
+  if (error != std::errc{}) {
+    return std::nullopt;
+  }
+  return kb * 1024;
+}
+}  // namespace
+
+namespace memory_accounting {
+std::optional<ProcessMemory> parse_smaps_rollup(std::string_view text) {
+  ProcessMemory memory;
+  bool found_pss = false;
+  while (!text.empty()) {
+    const std::size_t newline = text.find('\n');
+    const std::string_view line = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+
+    if (const auto v = kb_value(line, "Rss")) {
+      memory.rss = *v;
+    } else if (const auto v = kb_value(line, "Pss")) {
+      memory.pss = *v;
+      found_pss = true;
+    } else if (const auto v = kb_value(line, "Private_Clean")) {
+      memory.uss += *v;
+    } else if (const auto v = kb_value(line, "Private_Dirty")) {
+      memory.uss += *v;
+    } else if (const auto v = kb_value(line, "Shared_Clean")) {
+      memory.shared += *v;
+    } else if (const auto v = kb_value(line, "Shared_Dirty")) {
+      memory.shared += *v;
+    } else if (const auto v = kb_value(line, "Swap")) {
+      memory.swap = *v;
+    }
+  }
+  if (!found_pss) {
+    return std::nullopt;
+  }
+  return memory;
+}
+
+std::optional<ProcessMemory> read_smaps_rollup(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in) {
+    return std::nullopt;
+  }
+  const std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  return parse_smaps_rollup(text);
+}
+
+ProcessMemory current(std::chrono::milliseconds max_age) {
+  static std::mutex mutex;
+  static ProcessMemory cached;
+  static std::chrono::steady_clock::time_point sampled_at;
+  static bool sampled = false;
+
+  std::scoped_lock lock(mutex);
+  const auto now = std::chrono::steady_clock::now();
+  if (sampled && now - sampled_at < max_age) {
+    return cached;
+  }
+  if (const auto memory = read_smaps_rollup("/proc/self/smaps_rollup")) {
+    cached = *memory;
+  } else {
+    const std::size_t rss = ram_usage::getCurrentRSS();
+    cached = {.rss = rss, .pss = rss, .uss = rss, .shared = 0, .swap = 0};
+  }
+  sampled_at = now;
+  sampled = true;
+  return cached;
+}
+}  // namespace memory_accounting
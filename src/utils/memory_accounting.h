@@ -0,0 +1,45 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace memory_accounting {
+/**
+ * @brief Process memory split by how pages are shared, in bytes.
+ *
+ * RSS counts every resident page, including the shared memory and temp file
+ * mappings the terminal also maps. PSS divides each shared page between the
+ * processes mapping it and USS counts only pages private to this process, so
+ * they show what closing pdvu would actually free.
+ */
+struct ProcessMemory {
+  std::size_t rss = 0;
+  std::size_t pss = 0;
+  std::size_t uss = 0;     ///< Private_Clean + Private_Dirty
+  std::size_t shared = 0;  ///< Shared_Clean + Shared_Dirty
+  std::size_t swap = 0;
+};
+
+/**
+ * @brief Parses the contents of a smaps_rollup file.
+ * @return The totals, or std::nullopt if no Pss line was found.
+ */
+std::optional<ProcessMemory> parse_smaps_rollup(std::string_view text);
+
+/**
+ * @brief Reads and parses a smaps_rollup file, e.g. /proc/<pid>/smaps_rollup.
+ * @return The totals, or std::nullopt if the file is missing or unreadable.
+ */
+std::optional<ProcessMemory> read_smaps_rollup(const std::filesystem::path& path);
+
+/**
+ * @brief Memory of the current process.
+ *
+ * The kernel walks every mapping to produce smaps_rollup, so results are
+ * cached and refreshed at most once per max_age. Where smaps_rollup is not
+ * available (macOS, Windows, old kernels) all fields report the RSS.
+ */
+ProcessMemory current(std::chrono::milliseconds max_age = std::chrono::milliseconds(500));
+}  // namespace memory_accounting
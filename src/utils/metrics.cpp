@@ -0,0 +1,252 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace {
+constexpr double NS_PER_US = 1000.0;
+
+std::string json_string(std::string_view s) {
+  std::string out;
+  out.reserve(s.size() + 2);
+  out.push_back('"');
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  out.push_back('"');
+  return out;
+}
+
+void update_min(std::atomic<std::uint64_t>& target, std::uint64_t value) {
+  std::uint64_t current = target.load(std::memory_order_relaxed);
+  while (value < current &&
+         !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+void update_max(std::atomic<std::uint64_t>& target, std::uint64_t value) {
+  std::uint64_t current = target.load(std::memory_order_relaxed);
+  while (value > current &&
+         !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+}  // namespace
+
+namespace metrics {
+std::size_t LatencyHistogram::bucket_index(std::uint64_t value) {
+  if (value < SUB_BUCKETS) {
+    return static_cast<std::size_t>(value);  // exact buckets for tiny values
+  }
+  const auto exponent = static_cast<std::size_t>(std::bit_width(value) - 1);
+  const std::size_t shift = exponent - SUB_BUCKET_BITS;
+  const auto sub_bucket = static_cast<std::size_t>(value >> shift) - SUB_BUCKETS;
+  return ((shift + 1) * SUB_BUCKETS) + sub_bucket;
+}
+
+std::uint64_t LatencyHistogram::bucket_lower_bound(std::size_t index) {
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+  const std::size_t shift = (index / SUB_BUCKETS) - 1;
+  const std::size_t sub_bucket = index % SUB_BUCKETS;
+  return static_cast<std::uint64_t>(SUB_BUCKETS + sub_bucket) << shift;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+  const auto value = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+  m_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+  update_min(m_min, value);
+  update_max(m_max, value);
+}
+
+std::uint64_t LatencyHistogram::percentile(double q) const {
+  // sum the buckets rather than reading m_count so concurrent records cannot
+  // leave the target rank unreachable
+  std::uint64_t total = 0;
+  for (const auto& bucket : m_buckets) {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  q = std::clamp(q, 0.0, 1.0);
+  const auto rank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total))));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < m_buckets.size(); i++) {
+    seen += m_buckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      const std::uint64_t lower = bucket_lower_bound(i);
+      const std::uint64_t upper =
+          i + 1 < m_buckets.size() ? bucket_lower_bound(i + 1) : UINT64_MAX;
+      const std::uint64_t midpoint = lower + ((upper - lower) / 2);
+      return std::min(midpoint, m_max.load(std::memory_order_relaxed));
+    }
+  }
+  return m_max.load(std::memory_order_relaxed);
+}
+
+HistogramSummary LatencyHistogram::summary() const {
+  const std::uint64_t n = count();
+  if (n == 0) {
+    return HistogramSummary{};
+  }
+  auto us = [](std::uint64_t ns) { return static_cast<double>(ns) / NS_PER_US; };
+  return HistogramSummary{
+      .count = n,
+      .min_us = us(m_min.load(std::memory_order_relaxed)),
+      .mean_us = us(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(n),
+      .p50_us = us(percentile(0.50)),
+      .p90_us = us(percentile(0.90)),
+      .p95_us = us(percentile(0.95)),
+      .p99_us = us(percentile(0.99)),
+      .max_us = us(m_max.load(std::memory_order_relaxed)),
+  };
+}
+
+template <typename Metric>
+Metric& Registry::find_or_create(std::vector<Named<Metric>>& metrics, std::string_view name) {
+  std::scoped_lock lock(m_mutex);
+  const auto it = std::ranges::find(metrics, name, &Named<Metric>::name);
+  if (it != metrics.end()) {
+    return *it->metric;
+  }
+  metrics.push_back({.name = std::string(name), .metric = std::make_unique<Metric>()});
+  return *metrics.back().metric;
+}
+
+Counter& Registry::counter(std::string_view name) { return find_or_create(m_counters, name); }
+
+Gauge& Registry::gauge(std::string_view name) { return find_or_create(m_gauges, name); }
+
+LatencyHistogram& Registry::histogram(std::string_view name) {
+  return find_or_create(m_histograms, name);
+}
+
+double Registry::hit_rate(std::string_view prefix) const {
+  std::scoped_lock lock(m_mutex);
+  auto lookup = [this](const std::string& name) -> std::uint64_t {
+    const auto it = std::ranges::find(m_counters, name, &Named<Counter>::name);
+    return it == m_counters.end() ? 0 : it->metric->value();
+  };
+  const std::uint64_t hits = lookup(std::format("{}.hits", prefix));
+  const std::uint64_t misses = lookup(std::format("{}.misses", prefix));
+  if (hits + misses == 0) {
+    return -1.0;
+  }
+  return static_cast<double>(hits) / static_cast<double>(hits + misses);
+}
+
+std::string Registry::to_json() const {
+  std::vector<std::string> hit_rate_prefixes;
+  std::string per_request;
+  std::string json = "{\n  \"counters\": {";
+  {
+    std::scoped_lock lock(m_mutex);
+    std::string_view separator;
+    for (const auto& [name, counter] : m_counters) {
+      json += std::format("{}\n    {}: {}", separator, json_string(name), counter->value());
+      separator = ",";
+      if (name.ends_with(".hits")) {
+        hit_rate_prefixes.push_back(name.substr(0, name.size() - std::string_view(".hits").size()));
+      }
+    }
+
+    separator = "";
+    for (const auto& [requests_name, requests] : m_counters) {
+      constexpr std::string_view suffix = ".requests";
+      if (!requests_name.ends_with(suffix) || requests->value() == 0) {
+        continue;
+      }
+      const std::string prefix = requests_name.substr(0, requests_name.size() - suffix.size() + 1);
+      for (const auto& [name, counter] : m_counters) {
+        if (name.starts_with(prefix) && name != requests_name) {
+          per_request += std::format("{}\n    {}: {:.1f}",
+                                     separator,
+                                     json_string(name),
+                                     static_cast<double>(counter->value()) /
+                                         static_cast<double>(requests->value()));
+          separator = ",";
+        }
+      }
+    }
+
+    json += "\n  },\n  \"gauges\": {";
+    separator = "";
+    for (const auto& [name, gauge] : m_gauges) {
+      json += std::format("{}\n    {}: {}", separator, json_string(name), gauge->value());
+      separator = ",";
+    }
+
+    json += "\n  },\n  \"histograms\": {";
+    separator = "";
+    for (const auto& [name, histogram] : m_histograms) {
+      const HistogramSummary s = histogram->summary();
+      json += std::format(
+          "{}\n    {}: {{\"count\": {}, \"min_us\": {:.3f}, \"mean_us\": {:.3f}, "
+          "\"p50_us\": {:.3f}, \"p90_us\": {:.3f}, \"p95_us\": {:.3f}, \"p99_us\": {:.3f}, "
+          "\"max_us\": {:.3f}}}",
+          separator,
+          json_string(name),
+          s.count,
+          s.min_us,
+          s.mean_us,
+          s.p50_us,
+          s.p90_us,
+          s.p95_us,
+          s.p99_us,
+          s.max_us);
+      separator = ",";
+    }
+  }
+
+  json += "\n  },\n  \"cache_hit_rates\": {";
+  std::string_view separator;
+  for (const auto& prefix : hit_rate_prefixes) {
+    const double rate = hit_rate(prefix);
+    if (rate < 0) {
+      continue;
+    }
+    json += std::format("{}\n    {}: {:.4f}", separator, json_string(prefix), rate);
+    separator = ",";
+  }
+  json += "\n  },\n  \"per_request\": {";
+  json += per_request;
+  json += "\n  }\n}\n";
+  return json;
+}
+
+Registry& registry() {
+  static Registry instance;
+  return instance;
+}
+
+std::expected<void, std::string> write_json(const Registry& registry,
+                                            const std::filesystem::path& path) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return std::unexpected(std::format("could not open {} for writing", path.string()));
+  }
+  out << registry.to_json();
+  if (!out.flush()) {
+    return std::unexpected(std::format("failed to write {}", path.string()));
+  }
+  return {};
+}
+}  // namespace metrics
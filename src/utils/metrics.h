@@ -0,0 +1,180 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace metrics {
+/**
+ * @brief Monotonically increasing event count.
+ *
+ * Updates are relaxed atomic adds, cheap enough for the render hot path.
+ */
+class Counter {
+ public:
+  void add(std::uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+  [[nodiscard]] std::uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<std::uint64_t> m_value{0};
+};
+
+/**
+ * @brief Point-in-time value, e.g. resident memory. Last write wins.
+ */
+class Gauge {
+ public:
+  void set(std::int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+  [[nodiscard]] std::int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<std::int64_t> m_value{0};
+};
+
+/**
+ * @brief Summary statistics of a LatencyHistogram. All durations in microseconds.
+ */
+struct HistogramSummary {
+  std::uint64_t count;
+  double min_us;
+  double mean_us;
+  double p50_us;
+  double p90_us;
+  double p95_us;
+  double p99_us;
+  double max_us;
+};
+
+/**
+ * @brief Lock-free latency histogram with HDR-style log-linear buckets.
+ *
+ * Values are recorded in nanoseconds. Values below 2^SUB_BUCKET_BITS get one
+ * bucket each; above that, every power of two is split into 2^SUB_BUCKET_BITS
+ * linear sub-buckets. Reported percentiles are therefore within ~3% of the
+ * true value over the whole nanosecond to hours range, with a fixed memory
+ * cost and no allocation when recording.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int SUB_BUCKET_BITS = 5;
+  static constexpr std::size_t SUB_BUCKETS = std::size_t{1} << SUB_BUCKET_BITS;
+  static constexpr std::size_t N_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  /// Records one sample. Negative durations are recorded as zero.
+  void record(std::chrono::nanoseconds duration);
+
+  /// Number of samples recorded so far.
+  [[nodiscard]] std::uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Estimates the value at quantile q.
+   *
+   * @param q Quantile in [0, 1]; values outside are clamped.
+   * @return Midpoint of the bucket holding the quantile, in nanoseconds. Zero
+   * when empty. Never exceeds the largest recorded value.
+   */
+  [[nodiscard]] std::uint64_t percentile(double q) const;
+
+  /// Snapshot of count, mean, extremes and common percentiles.
+  [[nodiscard]] HistogramSummary summary() const;
+
+  /// Maps a value to its bucket index. Exposed for testing.
+  [[nodiscard]] static std::size_t bucket_index(std::uint64_t value);
+
+  /// Smallest value that falls in bucket index. Exposed for testing.
+  [[nodiscard]] static std::uint64_t bucket_lower_bound(std::size_t index);
+
+ private:
+  std::array<std::atomic<std::uint64_t>, N_BUCKETS> m_buckets{};
+  std::atomic<std::uint64_t> m_count{0};
+  std::atomic<std::uint64_t> m_sum{0};
+  std::atomic<std::uint64_t> m_min{UINT64_MAX};
+  std::atomic<std::uint64_t> m_max{0};
+};
+
+/**
+ * @brief Records the lifetime of a scope into a LatencyHistogram.
+ */
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(LatencyHistogram& histogram)
+      : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() { m_histogram.record(std::chrono::steady_clock::now() - m_start); }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+  ScopedTimer(ScopedTimer&&) = delete;
+  ScopedTimer& operator=(ScopedTimer&&) = delete;
+
+ private:
+  LatencyHistogram& m_histogram;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @brief Named collection of counters, gauges and latency histograms.
+ *
+ * Metrics are created on first lookup and live as long as the registry, so
+ * callers on hot paths should look a metric up once and keep the reference.
+ * Lookups take a mutex; updating a metric does not.
+ *
+ * Names use dotted lowercase paths, e.g. "render.raster". A pair of counters
+ * named "<prefix>.hits" and "<prefix>.misses" is reported as a cache hit rate,
+ * and a "<prefix>.requests" counter reports its sibling counters averaged per
+ * request.
+ */
+class Registry {
+ public:
+  Counter& counter(std::string_view name);
+  Gauge& gauge(std::string_view name);
+  LatencyHistogram& histogram(std::string_view name);
+
+  /**
+   * @brief Serialises every metric, in creation order, to a JSON object.
+   *
+   * Layout: <code>{"counters": {...}, "gauges": {...}, "histograms": {name:
+   * HistogramSummary}, "cache_hit_rates": {prefix: ratio}, "per_request": {name:
+   * mean}}</code>.
+   */
+  [[nodiscard]] std::string to_json() const;
+
+  /**
+   * @brief Returns the hit ratio for a "<prefix>.hits"/"<prefix>.misses" counter pair.
+   * @return Ratio in [0, 1], or a negative value when there were no lookups.
+   */
+  [[nodiscard]] double hit_rate(std::string_view prefix) const;
+
+ private:
+  template <typename Metric>
+  struct Named {
+    std::string name;
+    std::unique_ptr<Metric> metric;  ///< Heap allocated so references survive growth.
+  };
+
+  template <typename Metric>
+  Metric& find_or_create(std::vector<Named<Metric>>& metrics, std::string_view name);
+
+  mutable std::mutex m_mutex;  ///< Protects the metric lists, not the metric values.
+  std::vector<Named<Counter>> m_counters;
+  std::vector<Named<Gauge>> m_gauges;
+  std::vector<Named<LatencyHistogram>> m_histograms;
+};
+
+/// Process-wide registry used by the viewer and render engine.
+Registry& registry();
+
+/**
+ * @brief Writes Registry::to_json() to path, replacing any existing file.
+ * @return An error message on failure.
+ */
+[[nodiscard]] std::expected<void, std::string> write_json(const Registry& registry,
+                                                          const std::filesystem::path& path);
+}  // namespace metrics
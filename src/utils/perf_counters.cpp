@@ -0,0 +1,202 @@
+#include "perf_counters.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <format>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+std::atomic<bool> g_enabled = false;
+
+#ifdef __linux__
+constexpr std::size_t N_EVENTS = 4;
+constexpr std::array<std::uint64_t, N_EVENTS> g_events = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int perf_event_open(perf_event_attr& attr, int group_fd) {
+  // pid 0 and cpu -1: the calling thread on any CPU
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+/**
+ * @brief One counter group per thread, read in a single syscall.
+ *
+ * Cycles lead the group. Events that fail to open are left out, so a CPU
+ * without, say, a cache miss event still reports the rest.
+ */
+class ThreadCounters {
+ public:
+  ThreadCounters() {
+    for (std::size_t i = 0; i < N_EVENTS; i++) {
+      perf_event_attr attr{};
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = g_events[i];
+      attr.disabled = m_leader == -1 ? 1 : 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format =
+          PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      const int fd = perf_event_open(attr, m_leader);
+      if (fd == -1) {
+        if (m_leader == -1) {
+          m_error = std::strerror(errno);
+          return;  // without cycles as the leader there is no group
+        }
+        continue;
+      }
+      if (m_leader == -1) {
+        m_leader = fd;
+      }
+      m_fds[m_n_open] = fd;
+      m_slots[m_n_open] = i;
+      m_n_open++;
+    }
+    ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+  ~ThreadCounters() {
+    for (std::size_t i = 0; i < m_n_open; i++) {
+      close(m_fds[i]);
+    }
+  }
+  ThreadCounters(const ThreadCounters&) = delete;
+  ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+  [[nodiscard]] bool ok() const { return m_leader != -1; }
+  [[nodiscard]] const std::string& error() const { return m_error; }
+
+  std::optional<perf_counters::Counts> read() const {
+    if (!ok()) {
+      return std::nullopt;
+    }
+    struct {
+      std::uint64_t nr;
+      std::uint64_t time_enabled;
+      std::uint64_t time_running;
+      std::array<std::uint64_t, N_EVENTS> values;
+    } data{};
+    if (::read(m_leader, &data, sizeof(data)) == -1 || data.nr != m_n_open) {
+      return std::nullopt;
+    }
+    // scale up if the kernel had to multiplex the group with other users of the PMU
+    const double scale = data.time_running == 0 ? 0.0
+                                                : static_cast<double>(data.time_enabled) /
+                                                      static_cast<double>(data.time_running);
+    std::array<std::uint64_t, N_EVENTS> values{};
+    for (std::size_t i = 0; i < m_n_open; i++) {
+      values[m_slots[i]] = static_cast<std::uint64_t>(static_cast<double>(data.values[i]) * scale);
+    }
+    return perf_counters::Counts{
+        .cycles = values[0],
+        .instructions = values[1],
+        .cache_misses = values[2],
+        .branch_misses = values[3],
+    };
+  }
+
+ private:
+  int m_leader = -1;
+  std::array<int, N_EVENTS> m_fds{};
+  std::array<std::size_t, N_EVENTS> m_slots{};  ///< Index into g_events of each open fd
+  std::size_t m_n_open = 0;
+  std::string m_error;
+};
+
+ThreadCounters& thread_counters() {
+  thread_local ThreadCounters counters;
+  return counters;
+}
+#endif
+}  // namespace
+
+namespace perf_counters {
+Counts& Counts::operator+=(const Counts& other) {
+  cycles += other.cycles;
+  instructions += other.instructions;
+  cache_misses += other.cache_misses;
+  branch_misses += other.branch_misses;
+  return *this;
+}
+
+Counts Counts::operator-(const Counts& other) const {
+  auto sub = [](std::uint64_t a, std::uint64_t b) { return a > b ? a - b : 0; };
+  return {
+      .cycles = sub(cycles, other.cycles),
+      .instructions = sub(instructions, other.instructions),
+      .cache_misses = sub(cache_misses, other.cache_misses),
+      .branch_misses = sub(branch_misses, other.branch_misses),
+  };
+}
+
+std::expected<void, std::string> enable() {
+#ifdef __linux__
+  const auto& counters = thread_counters();
+  if (!counters.ok()) {
+    return std::unexpected(std::format(
+        "perf_event_open failed ({}), check /proc/sys/kernel/perf_event_paranoid",
+        counters.error()));
+  }
+  g_enabled.store(true, std::memory_order_relaxed);
+  return {};
+#else
+  return std::unexpected("hardware counters need Linux perf_event_open");
+#endif
+}
+
+bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+std::optional<Counts> read_thread() {
+#ifdef __linux__
+  if (!enabled()) {
+    return std::nullopt;
+  }
+  return thread_counters().read();
+#else
+  return std::nullopt;
+#endif
+}
+
+StageCounters::StageCounters(std::string_view stage)
+    : m_cycles(metrics::registry().counter(std::format("perf.{}.cycles", stage))),
+      m_instructions(metrics::registry().counter(std::format("perf.{}.instructions", stage))),
+      m_cache_misses(metrics::registry().counter(std::format("perf.{}.cache_misses", stage))),
+      m_branch_misses(metrics::registry().counter(std::format("perf.{}.branch_misses", stage))),
+      m_requests(metrics::registry().counter(std::format("perf.{}.requests", stage))) {}
+
+void StageCounters::record(const Counts& counts) {
+  m_cycles.add(counts.cycles);
+  m_instructions.add(counts.instructions);
+  m_cache_misses.add(counts.cache_misses);
+  m_branch_misses.add(counts.branch_misses);
+}
+
+Scope::Scope(StageCounters& stage, bool count_request)
+    : m_stage(stage), m_start(read_thread()), m_count_request(count_request) {}
+
+Scope::~Scope() {
+  if (!m_start) {
+    return;
+  }
+  if (const auto end = read_thread()) {
+    m_stage.record(*end - *m_start);
+    if (m_count_request) {
+      m_stage.add_request();
+    }
+  }
+}
+}  // namespace perf_counters
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "utils/metrics.h"
+
+/**
+ * @brief Optional hardware performance counters for the render stages.
+ *
+ * Counters are opened with perf_event_open for each thread on first use and
+ * count user space only. They are off unless enable() succeeds, and every
+ * entry point turns into a no-op when they are unavailable: non-Linux builds,
+ * kernels with perf_event_paranoid too strict, or virtual machines without a
+ * PMU. Events the CPU does not support read as zero.
+ */
+namespace perf_counters {
+struct Counts {
+  std::uint64_t cycles = 0;
+  std::uint64_t instructions = 0;
+  std::uint64_t cache_misses = 0;   ///< Last level cache misses
+  std::uint64_t branch_misses = 0;
+
+  Counts& operator+=(const Counts& other);
+  /// Per event difference, clamped at zero.
+  [[nodiscard]] Counts operator-(const Counts& other) const;
+};
+
+/**
+ * @brief Turns collection on after checking counters open on the calling thread.
+ * @return The reason counters are unavailable, in which case collection stays off.
+ */
+[[nodiscard]] std::expected<void, std::string> enable();
+
+[[nodiscard]] bool enabled();
+
+/**
+ * @brief Running totals of the calling thread's counters.
+ * @return std::nullopt when collection is off or counters failed to open on this thread.
+ */
+[[nodiscard]] std::optional<Counts> read_thread();
+
+/**
+ * @brief Metrics counters for one stage, named "perf.<stage>.<event>".
+ *
+ * The "perf.<stage>.requests" counter makes the registry report every event
+ * of the stage per request as well as in total.
+ */
+class StageCounters {
+ public:
+  explicit StageCounters(std::string_view stage);
+
+  void record(const Counts& counts);
+
+  /// Counts one request for the per request averages.
+  void add_request() { m_requests.add(); }
+
+ private:
+  metrics::Counter& m_cycles;
+  metrics::Counter& m_instructions;
+  metrics::Counter& m_cache_misses;
+  metrics::Counter& m_branch_misses;
+  metrics::Counter& m_requests;
+};
+
+/**
+ * @brief Adds the counts of the calling thread during a scope to a stage.
+ *
+ * A stage that runs on several threads for one request, like raster strips,
+ * uses one Scope per thread and calls StageCounters::add_request() once.
+ */
+class Scope {
+ public:
+  explicit Scope(StageCounters& stage, bool count_request = true);
+  ~Scope();
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+ private:
+  StageCounters& m_stage;
+  std::optional<Counts> m_start;
+  bool m_count_request;
+};
+}  // namespace perf_counters
@@ -1,8 +1,24 @@
 #pragma once
 
+#include "utils/chrome_trace.h"
+
+// Zones go to Tracy when it is compiled in and to the chrome_trace exporter
+// when that is enabled at runtime. Tracy's own ZoneScoped macros are replaced
+// by ones that feed both.
 #ifdef TRACY_ENABLE
 #include <tracy/Tracy.hpp>
+#undef ZoneScoped
+#undef ZoneScopedN
+#define PDVU_TRACY_ZONE ZoneNamed(___tracy_scoped_zone, true)
+#define PDVU_TRACY_ZONE_N(name) ZoneNamedN(___tracy_scoped_zone, name, true)
 #else
-#define ZoneScoped
-#define ZoneScopedN(name)
-#endif
\ No newline at end of file
+#define PDVU_TRACY_ZONE
+#define PDVU_TRACY_ZONE_N(name)
+#endif
+
+#define ZoneScoped \
+  PDVU_TRACY_ZONE; \
+  const chrome_trace::Zone pdvu_chrome_trace_zone_(static_cast<const char*>(__func__))
+#define ZoneScopedN(name) \
+  PDVU_TRACY_ZONE_N(name); \
+  const chrome_trace::Zone pdvu_chrome_trace_zone_(name)
@@ -5,9 +5,12 @@
 #include <mach/mach.h>
 
 #elif defined(__linux__)
+#include <fcntl.h>
 #include <unistd.h>
 
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <charconv>
 
 #elif defined(_WIN32)
 #include <psapi.h>
@@ -34,10 +37,25 @@ inline std::size_t getCurrentRSS() {
 /* only tested on mac so far */
 #elif defined(__linux__)
 inline std::size_t getCurrentRSS() {
-  std::ifstream statm("/proc/self/statm");
-  long pages = 0, rss = 0;
-  statm >> pages >> rss;
-  return (std::size_t)rss * (std::size_t)sysconf(_SC_PAGESIZE);
+  // keep statm open and pread from the start, this is called on every redraw
+  static const int statm_fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+  if (statm_fd == -1) {
+    return 0;
+  }
+  std::array<char, 128> buffer{};
+  const ssize_t n = pread(statm_fd, buffer.data(), buffer.size() - 1, 0);
+  if (n <= 0) {
+    return 0;
+  }
+  // format: "size resident shared ..." in pages
+  const char* begin = buffer.data();
+  const char* end = begin + n;
+  const char* resident = std::find(begin, end, ' ');
+  std::size_t rss_pages = 0;
+  if (resident == end || std::from_chars(resident + 1, end, rss_pages).ec != std::errc{}) {
+    return 0;
+  }
+  return rss_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
 }
 
 #elif defined(_WIN32)
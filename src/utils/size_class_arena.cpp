@@ -0,0 +1,235 @@
+#include "size_class_arena.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+using size_class_arena::GRANULE;
+using size_class_arena::MAX_SMALL;
+
+constexpr std::size_t HEADER = 16;
+constexpr std::size_t N_CLASSES = MAX_SMALL / GRANULE;
+constexpr std::uint32_t LARGE = UINT32_MAX;  ///< size_class of blocks from malloc
+constexpr std::size_t SLAB_BYTES = std::size_t{64} * 1024;
+constexpr std::uint32_t BATCH = 32;  ///< Blocks moved per depot visit
+constexpr std::size_t CACHE_BYTES_PER_CLASS = std::size_t{64} * 1024;
+
+struct alignas(16) Header {
+  std::size_t size;          ///< Usable bytes
+  std::uint32_t size_class;  ///< Index into the free lists, or LARGE
+  std::uint32_t unused;
+};
+static_assert(sizeof(Header) == HEADER);
+
+/// A free block; the link overlays the header.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct FreeList {
+  FreeBlock* head = nullptr;
+  std::uint32_t count = 0;
+
+  void push(FreeBlock* block) {
+    block->next = head;
+    head = block;
+    count++;
+  }
+  FreeBlock* pop() {
+    FreeBlock* block = head;
+    head = block->next;
+    count--;
+    return block;
+  }
+  /// Moves up to n blocks onto other.
+  void move_to(FreeList& other, std::uint32_t n) {
+    for (; n > 0 && head != nullptr; n--) {
+      other.push(pop());
+    }
+  }
+};
+
+constexpr std::size_t class_of(std::size_t size) { return size == 0 ? 0 : (size - 1) / GRANULE; }
+constexpr std::size_t class_bytes(std::size_t size_class) { return (size_class + 1) * GRANULE; }
+constexpr std::size_t block_bytes(std::size_t size_class) {
+  return HEADER + class_bytes(size_class);
+}
+/// Free blocks a thread keeps per class before returning a batch to the depot.
+constexpr std::uint32_t cache_cap(std::size_t size_class) {
+  return static_cast<std::uint32_t>(
+      std::max<std::size_t>(2 * BATCH, CACHE_BYTES_PER_CLASS / block_bytes(size_class)));
+}
+
+struct Depot {
+  std::mutex mutex;
+  std::array<FreeList, N_CLASSES> lists;
+  std::vector<void*> slabs;  ///< Kept reachable, never freed
+  std::atomic<std::size_t> reserved_bytes = 0;
+};
+
+/// Intentionally never destroyed: blocks may still be freed during static destruction.
+Depot& depot() {
+  static auto* instance = new Depot;
+  return *instance;
+}
+
+/**
+ * @brief Moves a batch from the depot into list, carving a new slab if the depot is empty.
+ *
+ * Leaves list empty only when the system is out of memory.
+ */
+void refill(FreeList& list, std::size_t size_class) {
+  auto& d = depot();
+  {
+    std::scoped_lock lock(d.mutex);
+    d.lists[size_class].move_to(list, BATCH);
+    if (list.head != nullptr) {
+      return;
+    }
+  }
+  auto* slab = static_cast<std::byte*>(std::malloc(SLAB_BYTES));
+  if (slab == nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock lock(d.mutex);
+    d.slabs.push_back(slab);
+  }
+  d.reserved_bytes.fetch_add(SLAB_BYTES, std::memory_order_relaxed);
+  const std::size_t block = block_bytes(size_class);
+  for (std::size_t offset = 0; offset + block <= SLAB_BYTES; offset += block) {
+    list.push(reinterpret_cast<FreeBlock*>(slab + offset));
+  }
+}
+
+void return_to_depot(FreeList& list, std::size_t size_class, std::uint32_t n) {
+  auto& d = depot();
+  std::scoped_lock lock(d.mutex);
+  list.move_to(d.lists[size_class], n);
+}
+
+thread_local bool t_cache_destroyed = false;
+
+struct ThreadCache {
+  std::array<FreeList, N_CLASSES> lists;
+
+  ThreadCache() = default;
+  ThreadCache(const ThreadCache&) = delete;
+  ThreadCache& operator=(const ThreadCache&) = delete;
+  ~ThreadCache() {
+    for (std::size_t i = 0; i < N_CLASSES; i++) {
+      return_to_depot(lists[i], i, UINT32_MAX);
+    }
+    t_cache_destroyed = true;
+  }
+};
+
+thread_local ThreadCache t_cache;
+
+FreeBlock* pop_block(std::size_t size_class) {
+  if (!t_cache_destroyed) {
+    FreeList& list = t_cache.lists[size_class];
+    if (list.head == nullptr) {
+      refill(list, size_class);
+    }
+    return list.head != nullptr ? list.pop() : nullptr;
+  }
+  // thread is exiting: go through the depot
+  FreeList local;
+  refill(local, size_class);
+  if (local.head == nullptr) {
+    return nullptr;
+  }
+  FreeBlock* block = local.pop();
+  return_to_depot(local, size_class, UINT32_MAX);
+  return block;
+}
+
+void push_block(FreeBlock* block, std::size_t size_class) {
+  if (t_cache_destroyed) {
+    FreeList local;
+    local.push(block);
+    return_to_depot(local, size_class, 1);
+    return;
+  }
+  FreeList& list = t_cache.lists[size_class];
+  list.push(block);
+  if (list.count > cache_cap(size_class)) {
+    return_to_depot(list, size_class, list.count - cache_cap(size_class) / 2);
+  }
+}
+
+Header* header_of(const void* ptr) {
+  return static_cast<Header*>(const_cast<void*>(ptr)) - 1;
+}
+}  // namespace
+
+namespace size_class_arena {
+void* allocate(std::size_t size) {
+  Header* header = nullptr;
+  if (size > MAX_SMALL) {
+    header = static_cast<Header*>(std::malloc(HEADER + size));
+    if (header == nullptr) {
+      return nullptr;
+    }
+    header->size = size;
+    header->size_class = LARGE;
+    return header + 1;
+  }
+  const std::size_t size_class = class_of(size);
+  header = reinterpret_cast<Header*>(pop_block(size_class));
+  if (header == nullptr) {
+    return nullptr;
+  }
+  header->size = class_bytes(size_class);
+  header->size_class = static_cast<std::uint32_t>(size_class);
+  return header + 1;
+}
+
+void deallocate(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  Header* header = header_of(ptr);
+  if (header->size_class == LARGE) {
+    std::free(header);
+    return;
+  }
+  push_block(reinterpret_cast<FreeBlock*>(header), header->size_class);
+}
+
+void* reallocate(void* ptr, std::size_t size) {
+  if (ptr == nullptr) {
+    return allocate(size);
+  }
+  Header* header = header_of(ptr);
+  if (header->size_class == LARGE && size > MAX_SMALL) {
+    auto* resized = static_cast<Header*>(std::realloc(header, HEADER + size));
+    if (resized == nullptr) {
+      return nullptr;
+    }
+    resized->size = size;
+    return resized + 1;
+  }
+  if (header->size_class != LARGE && class_of(size) == header->size_class) {
+    return ptr;
+  }
+  void* resized = allocate(size);
+  if (resized == nullptr) {
+    return nullptr;
+  }
+  std::memcpy(resized, ptr, std::min(size, header->size));
+  deallocate(ptr);
+  return resized;
+}
+
+std::size_t usable_size(const void* ptr) { return header_of(ptr)->size; }
+
+std::size_t reserved_bytes() { return depot().reserved_bytes.load(std::memory_order_relaxed); }
+}  // namespace size_class_arena
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @brief Size-class allocator with per-thread caches, for MuPDF's many small blocks.
+ *
+ * Requests up to MAX_SMALL bytes are rounded up to a multiple of GRANULE and
+ * served from per-thread free lists, refilled from 64 KiB slabs. A thread
+ * never takes a lock unless its list for a class runs empty or grows past
+ * its cap, when a batch moves to or from a shared depot. Blocks freed on
+ * another thread join that thread's cache, and caches of exiting threads are
+ * returned to the depot. Slabs are kept for reuse and never returned to the
+ * system. Larger requests go straight to malloc.
+ *
+ * Every block carries a 16 byte header with its size, so deallocate() and
+ * usable_size() need only the pointer. Returned blocks are 16 byte aligned.
+ */
+namespace size_class_arena {
+constexpr std::size_t GRANULE = 16;
+constexpr std::size_t MAX_SMALL = 1024;
+
+/// @return A block of at least size bytes, or nullptr if the system is out of memory.
+[[nodiscard]] void* allocate(std::size_t size);
+
+/// Releases a block from allocate() or reallocate(). nullptr is ignored.
+void deallocate(void* ptr);
+
+/**
+ * @brief Resizes a block, keeping its contents up to the smaller size.
+ * @return The new block, or nullptr on failure with ptr left untouched.
+ */
+[[nodiscard]] void* reallocate(void* ptr, std::size_t size);
+
+/// Bytes usable in a block, at least the size it was requested with.
+[[nodiscard]] std::size_t usable_size(const void* ptr);
+
+/// Bytes held in slabs, whether handed out or cached for reuse.
+[[nodiscard]] std::size_t reserved_bytes();
+}  // namespace size_class_arena
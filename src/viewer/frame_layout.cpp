@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace viewer {
 FrameLayout calculate_frame_layout(geometry::PixelSize source, geometry::PixelSize target,
@@ -57,4 +58,70 @@ FrameLayout calculate_frame_layout(geometry::PixelSize source, geometry::PixelSi
 
   return result;
 }
-}  // namespace viewer
\ No newline at end of file
+
+geometry::PixelRect map_page_rect(const pdf::Rect& rect, const pdf::PageSpecs& target) {
+  // rotate_quarter_clockwise swaps the base bounds, so swap them back for the unrotated page
+  const bool flipped = target.rotation % 180 != 0;
+  const float page_x0 = flipped ? target.base_y0 : target.base_x0;
+  const float page_y0 = flipped ? target.base_x0 : target.base_y0;
+  const float page_width = flipped ? target.base_y1 - target.base_y0
+                                   : target.base_x1 - target.base_x0;
+  const float page_height = flipped ? target.base_x1 - target.base_x0
+                                    : target.base_y1 - target.base_y0;
+  if (page_width <= 0.0F || page_height <= 0.0F) {
+    return {};
+  }
+
+  // corners turned clockwise on the page, then zoomed to the bitmap
+  auto rotate = [&](float x, float y) -> std::pair<float, float> {
+    const float dx = x - page_x0;
+    const float dy = y - page_y0;
+    switch (target.rotation) {
+      case 90:
+        return {page_height - dy, dx};
+      case 180:
+        return {page_width - dx, page_height - dy};
+      case 270:
+        return {dy, page_width - dx};
+      default:
+        return {dx, dy};
+    }
+  };
+  const auto [u0, v0] = rotate(rect.x0, rect.y0);
+  const auto [u1, v1] = rotate(rect.x1, rect.y1);
+  const float x_scale = static_cast<float>(target.width) / (flipped ? page_height : page_width);
+  const float y_scale = static_cast<float>(target.height) / (flipped ? page_width : page_height);
+  const int x0 = static_cast<int>(std::floor(std::min(u0, u1) * x_scale));
+  const int y0 = static_cast<int>(std::floor(std::min(v0, v1) * y_scale));
+  const int x1 = static_cast<int>(std::ceil(std::max(u0, u1) * x_scale));
+  const int y1 = static_cast<int>(std::ceil(std::max(v0, v1) * y_scale));
+  return {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+}
+
+std::optional<OverlayPlacement> calculate_overlay_placement(geometry::PixelRect rect,
+                                                            const FrameLayout& layout,
+                                                            const TermSize& ts) {
+  const auto& crop = layout.target_crop_rect;
+  const int x0 = std::max(rect.x, crop.x) - crop.x;
+  const int y0 = std::max(rect.y, crop.y) - crop.y;
+  const int x1 = std::min(rect.x + rect.width, crop.x + crop.width) - crop.x;
+  const int y1 = std::min(rect.y + rect.height, crop.y + crop.height) - crop.y;
+  if (x1 <= x0 || y1 <= y0 || ts.cell_pixel_width <= 0 || ts.cell_pixel_height <= 0) {
+    return std::nullopt;
+  }
+
+  const int x_offset = x0 % ts.cell_pixel_width;
+  const int y_offset = y0 % ts.cell_pixel_height;
+  return OverlayPlacement{
+      .origin =
+          {
+              .row = layout.placement_origin.row + (y0 / ts.cell_pixel_height),
+              .col = layout.placement_origin.col + (x0 / ts.cell_pixel_width),
+          },
+      .x_offset_pixels = x_offset,
+      .y_offset_pixels = y_offset,
+      .cols = (x_offset + x1 - x0 + ts.cell_pixel_width - 1) / ts.cell_pixel_width,
+      .rows = (y_offset + y1 - y0 + ts.cell_pixel_height - 1) / ts.cell_pixel_height,
+  };
+}
+}  // namespace viewer
@@ -1,4 +1,7 @@
 #pragma once
+#include <optional>
+
+#include "render/page_specs.h"
 #include "terminal/terminal.h"
 #include "terminal/tui.h"
 #include "utils/geometry.h"
@@ -45,4 +48,40 @@ struct FrameLayout {
                                                  geometry::PixelRect target_crop,
                                                  const TermSize& ts,
                                                  const TUI::ContentArea& content_area);
+
+/**
+ * @brief defines where kitty should stretch an overlay drawn over part of a frame
+ */
+struct OverlayPlacement {
+  geometry::CellPosition origin;  ///< terminal cell holding the overlay's top left corner
+  int x_offset_pixels;            ///< offset right from origin's left edge
+  int y_offset_pixels;            ///< offset down from origin's top edge
+  int cols;                       ///< number of terminal cell cols the overlay covers
+  int rows;                       ///< number of terminal cell rows the overlay covers
+};
+
+/**
+ * @brief maps a rectangle on the page to the pixels it covers in the target bitmap.
+ *
+ * Applies the transforms the bitmap is rendered with: the zoom from the base page bounds to
+ * the bitmap size, then the clockwise rotation.
+ * @param rect rectangle in unrotated page coordinates at the base zoom, as search hits give them
+ * @param target specs of the target bitmap, zoomed and rotated
+ * @return rectangle in target bitmap pixels, rounded outwards
+ */
+[[nodiscard]] geometry::PixelRect map_page_rect(const pdf::Rect& rect,
+                                                const pdf::PageSpecs& target);
+
+/**
+ * @brief calculates where an overlay over part of the target bitmap lands on screen.
+ *
+ * Kitty can only stretch an overlay over whole cells, so the overlay starts at the exact pixel
+ * but its size is rounded up to cells.
+ * @param rect rectangle in target bitmap pixels, as from map_page_rect
+ * @param layout layout the frame is drawn with
+ * @param ts current terminal size
+ * @return placement of the part of rect inside the crop window, std::nullopt if none of it is
+ */
+[[nodiscard]] std::optional<OverlayPlacement> calculate_overlay_placement(
+    geometry::PixelRect rect, const FrameLayout& layout, const TermSize& ts);
 }  // namespace viewer
\ No newline at end of file
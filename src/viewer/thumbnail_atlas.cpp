@@ -0,0 +1,162 @@
+#include "thumbnail_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "render/pdf_constants.h"
+#include "terminal/kitty.h"
+
+namespace viewer {
+ThumbnailAtlas::ThumbnailAtlas(const ThumbnailGrid& grid)
+    : m_grid(grid),
+      m_width(grid.cols * grid.box.width),
+      m_height(grid.visible_rows * grid.box.height),
+      m_pixels(static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_height) * pdf::g_pad,
+               0xFF),
+      m_held(static_cast<std::size_t>(grid.visible_rows), -1),
+      m_dirty(static_cast<std::size_t>(grid.visible_rows), false),
+      m_slots(static_cast<std::size_t>(grid.visible_rows) * static_cast<std::size_t>(grid.cols)) {
+}
+
+std::vector<int> ThumbnailAtlas::missing_rows(int top_row) const {
+  std::vector<int> rows;
+  const int end = std::min(top_row + m_grid.visible_rows, m_grid.total_rows);
+  for (int row = std::max(top_row, 0); row < end; row++) {
+    if (m_held[static_cast<std::size_t>(row % m_grid.visible_rows)] != row) {
+      rows.push_back(row);
+    }
+  }
+  return rows;
+}
+
+bool ThumbnailAtlas::fill_row(int row, const pdf::ThumbnailCache& cache, int num_pages) {
+  const int atlas_row = row % m_grid.visible_rows;
+  const auto stride = static_cast<std::size_t>(m_width) * pdf::g_pad;
+  bool complete = true;
+  bool changed = false;
+  for (int col = 0; col < m_grid.cols; col++) {
+    auto& slot = m_slots[static_cast<std::size_t>((atlas_row * m_grid.cols) + col)];
+    const int index = (row * m_grid.cols) + col;
+    const int page_num = index < num_pages ? index : -1;
+    const auto thumbnail = page_num < 0 ? nullptr : cache.get(page_num);
+    if (slot.page_num == page_num && (slot.content || !thumbnail)) {
+      complete = complete && (slot.content || page_num < 0);
+      continue;  // copied already, or still rendering
+    }
+    changed = true;
+    slot = {.page_num = page_num, .content = std::nullopt};
+    if (page_num < 0) {
+      continue;
+    }
+    if (!thumbnail) {
+      complete = false;
+      continue;
+    }
+    // centre in the box; rounding may make a thumbnail a pixel larger than it
+    const int width = std::min(thumbnail->width, m_grid.box.width);
+    const int height = std::min(thumbnail->height, m_grid.box.height);
+    const geometry::PixelRect content{
+        .x = (col * m_grid.box.width) + ((m_grid.box.width - width) / 2),
+        .y = (atlas_row * m_grid.box.height) + ((m_grid.box.height - height) / 2),
+        .width = width,
+        .height = height,
+    };
+    if (width == thumbnail->width && height == thumbnail->height) {
+      thumbnail->unpack(m_pixels.data() + (static_cast<std::size_t>(content.y) * stride) +
+                            (static_cast<std::size_t>(content.x) * pdf::g_pad),
+                        stride);
+    } else {
+      // unpack the oversized thumbnail alone, then copy the part that fits
+      std::vector<unsigned char> rgb(static_cast<std::size_t>(thumbnail->width) *
+                                     static_cast<std::size_t>(thumbnail->height) * pdf::g_pad);
+      const auto source_stride = static_cast<std::size_t>(thumbnail->width) * pdf::g_pad;
+      thumbnail->unpack(rgb.data(), source_stride);
+      for (int y = 0; y < height; y++) {
+        std::memcpy(m_pixels.data() + (static_cast<std::size_t>(content.y + y) * stride) +
+                        (static_cast<std::size_t>(content.x) * pdf::g_pad),
+                    rgb.data() + (static_cast<std::size_t>(y) * source_stride),
+                    static_cast<std::size_t>(width) * pdf::g_pad);
+      }
+    }
+    slot.content = content;
+  }
+  m_held[static_cast<std::size_t>(atlas_row)] = complete ? row : -1;
+  if (changed) {
+    m_dirty[static_cast<std::size_t>(atlas_row)] = true;
+  }
+  return changed;
+}
+
+std::string ThumbnailAtlas::transmission_sequence(const std::string& transmission_medium) {
+  m_shm.clear();
+  m_tempfiles.clear();
+  std::string sequence;
+  if (!m_transmitted) {
+    const auto path = stage(0, m_pixels.size(), transmission_medium);
+    sequence += kitty::get_transmit_sequence(path, IMAGE_ID, m_width, m_height,
+                                             transmission_medium);
+    m_transmitted = true;
+    std::fill(m_dirty.begin(), m_dirty.end(), false);
+    return sequence;
+  }
+
+  // full width rows of the atlas are contiguous, so each atlas row is one edit
+  const auto row_bytes =
+      static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_grid.box.height) * pdf::g_pad;
+  for (std::size_t atlas_row = 0; atlas_row < m_dirty.size(); atlas_row++) {
+    if (!m_dirty[atlas_row]) {
+      continue;
+    }
+    const auto path = stage(atlas_row * row_bytes, row_bytes, transmission_medium);
+    sequence += kitty::get_region_sequence(path,
+                                           IMAGE_ID,
+                                           0,
+                                           static_cast<int>(atlas_row) * m_grid.box.height,
+                                           m_width,
+                                           m_grid.box.height,
+                                           transmission_medium);
+    m_dirty[atlas_row] = false;
+  }
+  return sequence;
+}
+
+std::string ThumbnailAtlas::placement_sequence(int top_row, const TermSize& ts) const {
+  const int cell_width = std::max(ts.cell_pixel_width, 1);
+  const int cell_height = std::max(ts.cell_pixel_height, 1);
+  std::string sequence;
+  const int end = std::min(top_row + m_grid.visible_rows, m_grid.total_rows);
+  for (int row = std::max(top_row, 0); row < end; row++) {
+    const int atlas_row = row % m_grid.visible_rows;
+    for (int col = 0; col < m_grid.cols; col++) {
+      const auto& slot = m_slots[static_cast<std::size_t>((atlas_row * m_grid.cols) + col)];
+      if (!slot.content || slot.page_num != (row * m_grid.cols) + col) {
+        continue;
+      }
+      // the thumbnail's offset within its box, as whole cells and the pixels left over
+      const int dx = slot.content->x - (col * m_grid.box.width);
+      const int dy = slot.content->y - (atlas_row * m_grid.box.height);
+      const auto cell = m_grid.slot_position(top_row, row, col);
+      sequence +=
+          terminal::move_cursor(cell.row + (dy / cell_height), cell.col + (dx / cell_width));
+      sequence += kitty::get_crop_placement(IMAGE_ID,
+                                            ((row - top_row) * m_grid.cols) + col + 1,
+                                            *slot.content,
+                                            dx % cell_width,
+                                            dy % cell_height);
+    }
+  }
+  return sequence;
+}
+
+std::string ThumbnailAtlas::stage(std::size_t offset, std::size_t bytes,
+                                  const std::string& transmission_medium) {
+  if (transmission_medium == "shm") {
+    auto& shm = m_shm.emplace_back(std::make_unique<SharedMemory>(bytes));
+    shm->write_data(m_pixels.data() + offset, bytes);
+    return shm->name();
+  }
+  auto& tempfile = m_tempfiles.emplace_back(std::make_unique<Tempfile>(bytes));
+  tempfile->write_data(m_pixels.data() + offset, bytes);
+  return tempfile->path();
+}
+}  // namespace viewer
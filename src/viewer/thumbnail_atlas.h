@@ -0,0 +1,86 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "render/thumbnails.h"
+#include "terminal/terminal.h"
+#include "thumbnail_grid.h"
+#include "utils/geometry.h"
+#include "utils/shm.h"
+#include "utils/tempfile.h"
+
+namespace viewer {
+/**
+ * @brief One image holding the thumbnails of every visible grid row, sent to the terminal once.
+ *
+ * The atlas has a row of box sized slots for each visible grid row, and every
+ * thumbnail on screen is a crop placement of it. Grid rows are kept in atlas
+ * rows round robin, grid row r in atlas row r % visible_rows, so rows still
+ * visible after scrolling keep their place. Only the rows scrolled into view
+ * are filled and sent again, each as an edit of the stored image.
+ */
+class ThumbnailAtlas {
+ public:
+  static constexpr int IMAGE_ID = 4;
+
+  explicit ThumbnailAtlas(const ThumbnailGrid& grid);
+
+  [[nodiscard]] const ThumbnailGrid& grid() const { return m_grid; }
+
+  /**
+   * @brief Grid rows visible from top_row that the atlas does not hold yet.
+   */
+  [[nodiscard]] std::vector<int> missing_rows(int top_row) const;
+
+  /**
+   * @brief Copies the thumbnails of grid row from cache into its atlas row.
+   *
+   * Thumbnails already in place are not copied again. The row is only taken
+   * as held if every thumbnail in it is cached, so rows with pages still to
+   * arrive are filled again once they have rendered.
+   *
+   * @return Whether any thumbnail was copied, leaving the row to be sent.
+   */
+  bool fill_row(int row, const pdf::ThumbnailCache& cache, int num_pages);
+
+  /**
+   * @brief Sends the atlas if it has never been sent, or else only the rows filled since.
+   *
+   * @param transmission_medium "shm" or "tempfile".
+   * @return Kitty sequence, empty if nothing changed.
+   * @throw std::runtime_error If the transfer buffer cannot be created.
+   */
+  std::string transmission_sequence(const std::string& transmission_medium);
+
+  /**
+   * @brief Places the thumbnail of every visible page, each a crop of the atlas.
+   *
+   * @param top_row First visible grid row.
+   * @param ts Current terminal size.
+   */
+  [[nodiscard]] std::string placement_sequence(int top_row, const TermSize& ts) const;
+
+ private:
+  struct Slot {
+    int page_num = -1;                           ///< Page shown, -1 if none
+    std::optional<geometry::PixelRect> content;  ///< Pixels of the thumbnail in the atlas
+  };
+
+  /// Writes bytes at offset in m_pixels to a new transfer buffer, returning its path.
+  std::string stage(std::size_t offset, std::size_t bytes, const std::string& transmission_medium);
+
+  ThumbnailGrid m_grid;
+  int m_width;                          ///< Atlas width in pixels
+  int m_height;                         ///< Atlas height in pixels
+  std::vector<unsigned char> m_pixels;  ///< RGB, row by row
+  std::vector<int> m_held;              ///< Grid row in each atlas row, -1 if none
+  std::vector<bool> m_dirty;            ///< Atlas rows filled but not sent
+  std::vector<Slot> m_slots;            ///< Indexed by atlas row * cols + col
+  bool m_transmitted = false;
+  // transfer buffers of the last transmission, kept until the terminal has read them
+  std::vector<std::unique_ptr<SharedMemory>> m_shm;
+  std::vector<std::unique_ptr<Tempfile>> m_tempfiles;
+};
+}  // namespace viewer
@@ -0,0 +1,53 @@
+#include "thumbnail_grid.h"
+
+#include <algorithm>
+
+namespace viewer {
+namespace {
+constexpr int ROWS_PER_SCREEN = 3;
+constexpr int MIN_SLOT_ROWS = 4;
+constexpr int LABEL_ROWS = 1;
+constexpr int GAP_COLS = 1;
+// box width over height, close to both A4 and letter pages
+constexpr int BOX_ASPECT_NUM = 3;
+constexpr int BOX_ASPECT_DEN = 4;
+}  // namespace
+
+int ThumbnailGrid::scroll_to(int top_row, int page_num) const {
+  const int row = page_num / cols;
+  if (row < top_row) {
+    return row;
+  }
+  if (row >= top_row + visible_rows) {
+    return row - visible_rows + 1;
+  }
+  return top_row;
+}
+
+ThumbnailGrid calculate_thumbnail_grid(const TermSize& ts, const TUI::ContentArea& content_area,
+                                       int num_pages) {
+  const int cell_width = std::max(ts.cell_pixel_width, 1);
+  const int cell_height = std::max(ts.cell_pixel_height, 1);
+  const int slot_rows = std::max(content_area.rows / ROWS_PER_SCREEN, MIN_SLOT_ROWS);
+  const int box_height = (slot_rows - LABEL_ROWS) * cell_height;
+  const int box_width = box_height * BOX_ASPECT_NUM / BOX_ASPECT_DEN;
+  const int slot_cols = ((box_width + cell_width - 1) / cell_width) + GAP_COLS;
+
+  const int cols = std::max(content_area.cols / slot_cols, 1);
+  const int visible_rows = std::max(content_area.rows / slot_rows, 1);
+  return {
+      .cols = cols,
+      .visible_rows = visible_rows,
+      .total_rows = std::max((num_pages + cols - 1) / cols, 1),
+      .slot_cols = slot_cols,
+      .slot_rows = slot_rows,
+      .box = {.width = box_width, .height = box_height},
+      .origin =
+          {
+              .row = content_area.start_row,
+              .col = content_area.start_col +
+                     (std::max(content_area.cols - (cols * slot_cols), 0) / 2),
+          },
+  };
+}
+}  // namespace viewer
@@ -0,0 +1,52 @@
+#pragma once
+#include "terminal/terminal.h"
+#include "terminal/tui.h"
+#include "utils/geometry.h"
+
+namespace viewer {
+/**
+ * @brief defines how page thumbnails are laid out in the overview grid
+ *
+ * Each slot holds one thumbnail with its page number on the row below it and
+ * a gap of one cell to its right. Grid rows are numbered from the first page,
+ * and the grid scrolls a whole row at a time.
+ */
+struct ThumbnailGrid {
+  int cols;                       ///< thumbnails per grid row
+  int visible_rows;               ///< grid rows that fit on screen at once
+  int total_rows;                 ///< grid rows needed for every page
+  int slot_cols;                  ///< terminal cell cols one slot takes
+  int slot_rows;                  ///< terminal cell rows one slot takes, label included
+  geometry::PixelSize box;        ///< pixels each thumbnail is fitted in
+  geometry::CellPosition origin;  ///< top left terminal cell of the first visible slot
+
+  bool operator==(const ThumbnailGrid&) const = default;
+
+  /// top left terminal cell of the slot at grid row, col while top_row is the first visible row
+  [[nodiscard]] geometry::CellPosition slot_position(int top_row, int row, int col) const {
+    return {
+        .row = origin.row + ((row - top_row) * slot_rows),
+        .col = origin.col + (col * slot_cols),
+    };
+  }
+
+  /**
+   * @brief first visible row that shows page_num, scrolling as little as possible from top_row
+   */
+  [[nodiscard]] int scroll_to(int top_row, int page_num) const;
+};
+
+/**
+ * @brief calculates the overview grid for the content area.
+ *
+ * Slots are sized so about three rows fit on screen, with boxes in the
+ * proportions of a portrait page. The grid is centred horizontally.
+ * @param ts current terminal size
+ * @param content_area drawable content area
+ * @param num_pages pages in the document
+ * @return ThumbnailGrid with at least one row and column
+ */
+[[nodiscard]] ThumbnailGrid calculate_thumbnail_grid(const TermSize& ts,
+                                                     const TUI::ContentArea& content_area,
+                                                     int num_pages);
+}  // namespace viewer
@@ -0,0 +1,422 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr std::string_view event_type_name(trace::EventType type) {
+  switch (type) {
+    case trace::EventType::Input:
+      return "input";
+    case trace::EventType::Resize:
+      return "resize";
+    case trace::EventType::RenderRequest:
+      return "render_request";
+    case trace::EventType::RenderResult:
+      return "render_result";
+    case trace::EventType::FrameDrawn:
+      return "frame_drawn";
+  }
+  return "unknown";
+}
+
+std::optional<trace::EventType> event_type_from_name(std::string_view name) {
+  constexpr trace::EventType types[] = {
+      trace::EventType::Input,
+      trace::EventType::Resize,
+      trace::EventType::RenderRequest,
+      trace::EventType::RenderResult,
+      trace::EventType::FrameDrawn,
+  };
+  const auto* it = std::ranges::find(types, name, event_type_name);
+  if (it == std::end(types)) {
+    return std::nullopt;
+  }
+  return *it;
+}
+
+std::string escape(std::string_view s) {
+  std::string out;
+  out.reserve(s.size());
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  return out;
+}
+
+/**
+ * @brief Finds the raw value of "key" in a flat JSON object written by this file.
+ *
+ * Strings are returned without quotes and with escapes left in place. Nested
+ * objects and arrays are not supported since traces never contain them.
+ */
+std::optional<std::string_view> raw_field(std::string_view line, std::string_view key) {
+  const std::string needle = std::format("\"{}\":", key);
+  const std::size_t pos = line.find(needle);
+  if (pos == std::string_view::npos) {
+    return std::nullopt;
+  }
+  std::string_view rest = line.substr(pos + needle.size());
+  rest.remove_prefix(std::min(rest.find_first_not_of(' '), rest.size()));
+  if (rest.starts_with('"')) {
+    for (std::size_t i = 1; i < rest.size(); i++) {
+      if (rest[i] == '\\') {
+        i++;
+      } else if (rest[i] == '"') {
+        return rest.substr(1, i - 1);
+      }
+    }
+    return std::nullopt;  // unterminated string
+  }
+  return rest.substr(0, rest.find_first_of(",}"));
+}
+
+template <typename T>
+bool read_field(std::string_view line, std::string_view key, T& out) {
+  const auto raw = raw_field(line, key);
+  if (!raw) {
+    return false;
+  }
+  if constexpr (std::is_same_v<T, bool>) {
+    out = *raw == "true";
+    return *raw == "true" || *raw == "false";
+  } else {
+    const auto [ptr, error] = std::from_chars(raw->data(), raw->data() + raw->size(), out);
+    return error == std::errc{} && ptr == raw->data() + raw->size();
+  }
+}
+
+std::string unescape(std::string_view s) {
+  std::string out;
+  out.reserve(s.size());
+  for (std::size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '\\' && i + 1 < s.size()) {
+      i++;
+    }
+    out.push_back(s[i]);
+  }
+  return out;
+}
+
+std::string size_fields(const TermSize& size) {
+  return std::format(
+      R"("columns":{},"rows":{},"pixel_width":{},"pixel_height":{},"cell_width":{},)"
+      R"("cell_height":{})",
+      size.columns,
+      size.rows,
+      size.pixel_width,
+      size.pixel_height,
+      size.cell_pixel_width,
+      size.cell_pixel_height);
+}
+
+bool read_size(std::string_view line, TermSize& size) {
+  return read_field(line, "columns", size.columns) && read_field(line, "rows", size.rows) &&
+         read_field(line, "pixel_width", size.pixel_width) &&
+         read_field(line, "pixel_height", size.pixel_height) &&
+         read_field(line, "cell_width", size.cell_pixel_width) &&
+         read_field(line, "cell_height", size.cell_pixel_height);
+}
+}  // namespace
+
+namespace trace {
+std::string to_json(const TraceHeader& header) {
+  return std::format(R"({{"type":"header","version":{},"document":"{}"}})",
+                     header.version,
+                     escape(header.document));
+}
+
+std::string to_json(const TraceEvent& event) {
+  std::string json =
+      std::format(R"({{"t_us":{},"type":"{}",)", event.t_us, event_type_name(event.type));
+  switch (event.type) {
+    case EventType::Input:
+      json += std::format(R"("batch":{},"key":{},"char":{})",
+                          event.batch,
+                          static_cast<int>(event.input.key),
+                          static_cast<int>(static_cast<unsigned char>(event.input.char_value)));
+      break;
+    case EventType::Resize:
+      json += size_fields(event.size);
+      break;
+    case EventType::RenderRequest:
+      json += std::format(
+          R"("req_id":{},"page":{},"zoom":{})", event.req_id, event.page_num, event.zoom);
+      break;
+    case EventType::RenderResult:
+      json += std::format(R"("req_id":{},"page":{},"render_us":{},"ok":{})",
+                          event.req_id,
+                          event.page_num,
+                          event.render_us,
+                          event.ok);
+      break;
+    case EventType::FrameDrawn:
+      json += std::format(R"("req_id":{},"page":{})", event.req_id, event.page_num);
+      break;
+  }
+  json += '}';
+  return json;
+}
+
+std::optional<TraceEvent> parse_event(std::string_view line) {
+  TraceEvent event;
+  const auto type_name = raw_field(line, "type");
+  const auto type = type_name ? event_type_from_name(*type_name) : std::nullopt;
+  if (!type || !read_field(line, "t_us", event.t_us)) {
+    return std::nullopt;
+  }
+  event.type = *type;
+
+  bool ok = true;
+  switch (event.type) {
+    case EventType::Input: {
+      int key = 0;
+      int char_value = 0;
+      ok = read_field(line, "batch", event.batch) && read_field(line, "key", key) &&
+           read_field(line, "char", char_value) && key >= key_none && key <= key_ctrl_char &&
+           char_value >= 0 && char_value <= 255;
+      event.input = InputEvent{
+          .key = static_cast<Key>(key),
+          .char_value = static_cast<char>(char_value),
+      };
+      break;
+    }
+    case EventType::Resize:
+      ok = read_size(line, event.size);
+      break;
+    case EventType::RenderRequest:
+      ok = read_field(line, "req_id", event.req_id) && read_field(line, "page", event.page_num) &&
+           read_field(line, "zoom", event.zoom);
+      break;
+    case EventType::RenderResult:
+      ok = read_field(line, "req_id", event.req_id) && read_field(line, "page", event.page_num) &&
+           read_field(line, "render_us", event.render_us) && read_field(line, "ok", event.ok);
+      break;
+    case EventType::FrameDrawn:
+      ok = read_field(line, "req_id", event.req_id) && read_field(line, "page", event.page_num);
+      break;
+  }
+  if (!ok) {
+    return std::nullopt;
+  }
+  return event;
+}
+
+std::optional<TraceHeader> parse_header(std::string_view line) {
+  TraceHeader header;
+  const auto document = raw_field(line, "document");
+  if (raw_field(line, "type") != "header" || !read_field(line, "version", header.version) ||
+      !document) {
+    return std::nullopt;
+  }
+  header.document = unescape(*document);
+  return header;
+}
+
+std::expected<Trace, std::string> load(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in) {
+    return std::unexpected(std::format("could not open {}", path.string()));
+  }
+  std::string line;
+  if (!std::getline(in, line)) {
+    return std::unexpected(std::format("{} is empty", path.string()));
+  }
+  auto header = parse_header(line);
+  if (!header) {
+    return std::unexpected(std::format("{}:1: missing trace header", path.string()));
+  }
+  if (header->version != TraceHeader{}.version) {
+    return std::unexpected(std::format("unsupported trace version {}", header->version));
+  }
+
+  Trace trace{.header = std::move(*header), .events = {}};
+  for (std::size_t line_number = 2; std::getline(in, line); line_number++) {
+    if (line.empty()) {
+      continue;
+    }
+    auto event = parse_event(line);
+    if (!event) {
+      return std::unexpected(
+          std::format("{}:{}: malformed trace event", path.string(), line_number));
+    }
+    trace.events.push_back(*event);
+  }
+  return trace;
+}
+
+std::expected<Recorder, std::string> Recorder::create(const std::filesystem::path& path,
+                                                      const TraceHeader& header) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return std::unexpected(std::format("could not open {} for writing", path.string()));
+  }
+  out << to_json(header) << '\n';
+  return Recorder(std::move(out), Clock::now());
+}
+
+Recorder::Recorder(std::ofstream out, Clock::time_point start)
+    : m_out(std::move(out)), m_start(start) {}
+
+void Recorder::write(TraceEvent event) {
+  using namespace std::chrono;
+  event.t_us = duration_cast<microseconds>(Clock::now() - m_start).count();
+  m_out << to_json(event) << '\n';
+}
+
+void Recorder::input(const InputEvent& event) {
+  write({.type = EventType::Input, .batch = m_batch, .input = event});
+}
+
+void Recorder::resize(const TermSize& size) { write({.type = EventType::Resize, .size = size}); }
+
+void Recorder::render_request(std::size_t req_id, int page_num, float zoom) {
+  write({.type = EventType::RenderRequest, .req_id = req_id, .page_num = page_num, .zoom = zoom});
+}
+
+void Recorder::render_result(std::size_t req_id, int page_num,
+                             std::chrono::microseconds render_time, bool ok) {
+  write({
+      .type = EventType::RenderResult,
+      .req_id = req_id,
+      .page_num = page_num,
+      .render_us = render_time.count(),
+      .ok = ok,
+  });
+}
+
+void Recorder::frame_drawn(std::size_t req_id, int page_num) {
+  write({.type = EventType::FrameDrawn, .req_id = req_id, .page_num = page_num});
+}
+
+Replayer::Replayer(Trace trace, Pacing pacing, std::chrono::milliseconds settle_timeout)
+    : m_pacing(pacing), m_settle_timeout(settle_timeout) {
+  bool seen_input = false;
+  for (const auto& event : trace.events) {
+    if (event.type == EventType::Resize) {
+      if (!seen_input && m_steps.empty()) {
+        m_initial_size = event.size;  // dimensions at start up, not a user action
+        continue;
+      }
+      m_steps.push_back(
+          {.first = m_resizes.size(), .count = 0, .batch = 0, .t_us = event.t_us});
+      m_resizes.push_back(event.size);
+    } else if (event.type == EventType::Input) {
+      seen_input = true;
+      const bool same_batch = !m_steps.empty() && m_steps.back().count > 0 &&
+                              m_steps.back().batch == event.batch;
+      if (!same_batch) {
+        m_steps.push_back(
+            {.first = m_inputs.size(), .count = 0, .batch = event.batch, .t_us = event.t_us});
+      }
+      m_steps.back().count++;
+      m_inputs.push_back(event.input);
+    }
+  }
+}
+
+std::optional<Replayer::Step> Replayer::poll(Clock::time_point now) {
+  const auto wait = time_until_next(now);
+  if (!wait || *wait > std::chrono::milliseconds::zero()) {
+    return std::nullopt;
+  }
+
+  const StepRange& range = m_steps[m_next_step++];
+  m_latencies.push_back({
+      .batch = range.batch,
+      .recorded_t_us = range.t_us,
+      .first_input = range.count > 0 ? m_inputs[range.first] : InputEvent{.key = key_none},
+      .latency = std::chrono::microseconds::zero(),
+      .timed_out = false,
+  });
+  m_delivered_at.push_back(now);
+
+  if (range.count == 0) {
+    return Step{.inputs = {}, .resize = m_resizes[range.first]};
+  }
+  return Step{
+      .inputs = std::span<const InputEvent>(m_inputs).subspan(range.first, range.count),
+      .resize = std::nullopt,
+  };
+}
+
+std::optional<std::chrono::milliseconds> Replayer::time_until_next(Clock::time_point now) const {
+  using namespace std::chrono;
+  if (!m_started || m_next_step >= m_steps.size()) {
+    return std::nullopt;
+  }
+  if (m_pacing == Pacing::AsFastAsPossible) {
+    if (m_first_unsettled < m_latencies.size()) {
+      return std::nullopt;
+    }
+    return milliseconds::zero();
+  }
+  const auto offset = microseconds(m_steps[m_next_step].t_us - m_steps.front().t_us);
+  const auto remaining = duration_cast<milliseconds>(m_replay_start + offset - now);
+  return std::max(remaining, milliseconds::zero());
+}
+
+void Replayer::update(bool busy, Clock::time_point now) {
+  if (!m_started) {
+    if (!busy) {  // start once the initial frame is on screen
+      m_started = true;
+      m_replay_start = now;
+    }
+    return;
+  }
+  for (; m_first_unsettled < m_latencies.size(); m_first_unsettled++) {
+    const auto elapsed = now - m_delivered_at[m_first_unsettled];
+    const bool timed_out = elapsed >= m_settle_timeout;
+    if (busy && !timed_out) {
+      break;
+    }
+    auto& latency = m_latencies[m_first_unsettled];
+    latency.latency = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+    latency.timed_out = busy;
+  }
+}
+
+bool Replayer::finished() const {
+  return m_started && m_next_step >= m_steps.size() && m_first_unsettled >= m_latencies.size();
+}
+
+std::expected<void, std::string> write_report(const std::vector<ReplayLatency>& latencies,
+                                              const std::filesystem::path& path) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return std::unexpected(std::format("could not open {} for writing", path.string()));
+  }
+  for (const auto& entry : latencies) {
+    out << std::format(
+        R"({{"batch":{},"recorded_t_us":{},"key":{},"char":{},"latency_us":{},"timed_out":{}}})",
+        entry.batch,
+        entry.recorded_t_us,
+        static_cast<int>(entry.first_input.key),
+        static_cast<int>(static_cast<unsigned char>(entry.first_input.char_value)),
+        entry.latency.count(),
+        entry.timed_out)
+        << '\n';
+  }
+  if (!out.flush()) {
+    return std::unexpected(std::format("failed to write {}", path.string()));
+  }
+  return {};
+}
+}  // namespace trace
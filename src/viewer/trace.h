@@ -0,0 +1,218 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "keys.h"
+#include "terminal/terminal.h"
+
+namespace trace {
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Kind of a recorded viewer event.
+ */
+enum class EventType {
+  Input,          ///< Decoded key press, see TraceEvent::input and TraceEvent::batch
+  Resize,         ///< Terminal dimensions changed, see TraceEvent::size
+  RenderRequest,  ///< Page render dispatched to the engine
+  RenderResult,   ///< Engine result accepted or rejected by the viewer
+  FrameDrawn,     ///< Frame for TraceEvent::req_id written to the terminal
+};
+
+/**
+ * @brief One line of a trace file.
+ *
+ * Only the fields relevant to the event type are meaningful. Timestamps are
+ * microseconds on the monotonic clock since recording started.
+ */
+struct TraceEvent {
+  EventType type = EventType::Input;
+  std::int64_t t_us = 0;
+  std::uint64_t batch = 0;  ///< Input: index of the read that produced the event
+  InputEvent input{.key = key_none};
+  TermSize size{};
+  std::size_t req_id = 0;  ///< Render request, result and drawn frame
+  int page_num = 0;
+  float zoom = 0.0F;           ///< RenderRequest: user zoom on top of fit to window
+  std::int64_t render_us = 0;  ///< RenderResult: engine render time
+  bool ok = true;              ///< RenderResult: false for render errors
+};
+
+/**
+ * @brief First line of a trace file. The initial terminal size is recorded as a
+ * Resize event at the start of the trace.
+ */
+struct TraceHeader {
+  int version = 1;
+  std::string document;  ///< Name of the document that was open while recording
+};
+
+/// Serialises the header as the first line of a trace file, without the newline.
+std::string to_json(const TraceHeader& header);
+
+/// Serialises one event as a single JSON object, without the newline.
+std::string to_json(const TraceEvent& event);
+
+/// Parses a line written by to_json(const TraceEvent&).
+std::optional<TraceEvent> parse_event(std::string_view line);
+
+/// Parses a line written by to_json(const TraceHeader&).
+std::optional<TraceHeader> parse_header(std::string_view line);
+
+/**
+ * @brief A loaded trace: header and events in recorded order.
+ */
+struct Trace {
+  TraceHeader header;
+  std::vector<TraceEvent> events;
+};
+
+/**
+ * @brief Reads a trace file written by Recorder.
+ * @return The trace, or an error naming the first malformed line.
+ */
+std::expected<Trace, std::string> load(const std::filesystem::path& path);
+
+/**
+ * @brief Appends viewer events to a JSON Lines trace file.
+ *
+ * Lines are buffered by the stream and flushed on destruction, so recording
+ * adds no syscall per event on the input path.
+ */
+class Recorder {
+ public:
+  /**
+   * @brief Creates the trace file and writes its header.
+   * @return An error message if the file cannot be opened.
+   */
+  static std::expected<Recorder, std::string> create(const std::filesystem::path& path,
+                                                     const TraceHeader& header);
+
+  void input(const InputEvent& event);
+  void resize(const TermSize& size);
+  void render_request(std::size_t req_id, int page_num, float zoom);
+  void render_result(std::size_t req_id, int page_num, std::chrono::microseconds render_time,
+                     bool ok);
+  void frame_drawn(std::size_t req_id, int page_num);
+
+  /// Marks the start of a new read_input() batch for subsequent input events.
+  void next_batch() { m_batch++; }
+
+ private:
+  Recorder(std::ofstream out, Clock::time_point start);
+  void write(TraceEvent event);
+
+  std::ofstream m_out;
+  Clock::time_point m_start;
+  std::uint64_t m_batch = 0;
+};
+
+/**
+ * @brief Latency of one replayed input batch or resize.
+ */
+struct ReplayLatency {
+  std::uint64_t batch;                ///< Recorded batch index, 0 for resizes
+  std::int64_t recorded_t_us;         ///< When the step happened in the recording
+  InputEvent first_input;             ///< key_none for resizes
+  std::chrono::microseconds latency;  ///< Delivery until the viewer was idle again
+  bool timed_out;                     ///< The viewer did not become idle within the timeout
+};
+
+/**
+ * @brief Feeds a recorded trace back into the viewer.
+ *
+ * Input and resize events are grouped into the steps they were recorded in:
+ * every input event of one read_input() batch, or a single resize. A step is
+ * delivered either at its recorded offset from the first step (OriginalTiming),
+ * even if the viewer is still busy, or as soon as the previous step has settled
+ * (AsFastAsPossible). A step has settled once the viewer reports it is idle,
+ * i.e. the frame for the resulting render request has been presented and no
+ * resize is being debounced; the time from delivery to that point is the
+ * step's latency.
+ *
+ * Render requests, results and drawn frames in the trace are not replayed, they
+ * are produced again by the viewer.
+ */
+class Replayer {
+ public:
+  enum class Pacing {
+    OriginalTiming,
+    AsFastAsPossible,
+  };
+
+  /// A step handed to the viewer.
+  struct Step {
+    std::span<const InputEvent> inputs;  ///< Empty for a resize
+    std::optional<TermSize> resize;
+  };
+
+  Replayer(Trace trace, Pacing pacing,
+           std::chrono::milliseconds settle_timeout = std::chrono::seconds(10));
+
+  /// Terminal dimensions at the start of the recording, if they were recorded.
+  [[nodiscard]] const std::optional<TermSize>& initial_size() const { return m_initial_size; }
+
+  /**
+   * @brief Returns the next step if it is due.
+   *
+   * The first step waits until the viewer has been idle once. With
+   * AsFastAsPossible nothing is delivered while an earlier step is unsettled.
+   */
+  std::optional<Step> poll(Clock::time_point now);
+
+  /**
+   * @brief How long the caller may wait for input before the next step is due.
+   * @return Milliseconds to wait, or std::nullopt if no step is due on time alone.
+   */
+  [[nodiscard]] std::optional<std::chrono::milliseconds> time_until_next(
+      Clock::time_point now) const;
+
+  /**
+   * @brief Reports whether the viewer has pending work, once per main loop iteration.
+   * @param busy true while a render is pending or a resize is being debounced.
+   */
+  void update(bool busy, Clock::time_point now);
+
+  /// True once every step has been delivered and settled.
+  [[nodiscard]] bool finished() const;
+
+  [[nodiscard]] const std::vector<ReplayLatency>& latencies() const { return m_latencies; }
+
+ private:
+  struct StepRange {
+    std::size_t first;  ///< Index into m_inputs, or of the resize in m_resizes
+    std::size_t count;  ///< Input events in the step, 0 for a resize
+    std::uint64_t batch;
+    std::int64_t t_us;
+  };
+
+  std::optional<TermSize> m_initial_size;
+  Pacing m_pacing;
+  std::chrono::milliseconds m_settle_timeout;
+  std::vector<InputEvent> m_inputs;
+  std::vector<TermSize> m_resizes;
+  std::vector<StepRange> m_steps;
+  std::size_t m_next_step = 0;
+  bool m_started = false;  ///< Viewer was idle once, replay clock is running
+  Clock::time_point m_replay_start{};
+  std::vector<ReplayLatency> m_latencies;         ///< One entry per delivered step
+  std::vector<Clock::time_point> m_delivered_at;  ///< Parallel to m_latencies
+  std::size_t m_first_unsettled = 0;  ///< Delivered steps from here on await an idle viewer
+};
+
+/**
+ * @brief Writes per-step replay latencies as JSON Lines.
+ * @return An error message on failure.
+ */
+std::expected<void, std::string> write_report(const std::vector<ReplayLatency>& latencies,
+                                              const std::filesystem::path& path);
+}  // namespace trace
@@ -5,40 +5,203 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdio>
+#include <iterator>
 #include <optional>
 #include <print>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "frame_layout.h"
 #include "keys.h"
 #include "plog/Log.h"
 #include "render/parser.h"
+#include "terminal/ansi.h"
 #include "terminal/kitty.h"
 #include "terminal/terminal.h"
 #include "terminal/tui.h"
 #include "utils/logging.h"
+#include "utils/memory_accounting.h"
+#include "utils/metrics.h"
+#include "utils/perf_counters.h"
 #include "utils/profiling.h"
-#include "utils/ram_usage.h"
 #include "utils/resize_debouncer.h"
+#include "utils/size_class_arena.h"
 namespace {  // utility functions and constants
 // UI and timing constants
 constexpr int RESIZE_DEBOUNCE_MS = 75;  // Milliseconds to wait after terminal resize
 constexpr int INPUT_POLL_RATE_MS = 16;  // ~60 FPS for responsive main loop input
 constexpr float PAN_STEP_RATIO = 0.1F;  // 10% of viewport shifted per pan keypress
+constexpr auto HUD_REFRESH_INTERVAL = std::chrono::milliseconds(500);
+// how often a page still loading from a stream is requested again while bytes arrive
+constexpr auto PLACEHOLDER_RETRY_INTERVAL = std::chrono::milliseconds(100);
+// how often search progress alone repaints the status bar
+constexpr auto SEARCH_PROGRESS_INTERVAL = std::chrono::milliseconds(250);
+
+/**
+ * @brief Viewer metrics, looked up once from the process-wide registry.
+ */
+struct ViewerMetrics {
+  metrics::LatencyHistogram& input_to_frame =
+      metrics::registry().histogram("viewer.input_to_frame");
+  metrics::LatencyHistogram& transmission = metrics::registry().histogram("viewer.transmission");
+  metrics::Counter& input_events = metrics::registry().counter("input.events");
+  metrics::Counter& frames_drawn = metrics::registry().counter("viewer.frames_drawn");
+  metrics::Counter& bytes_written = metrics::registry().counter("viewer.bytes_written");
+  perf_counters::StageCounters perf_transmission{"transmission"};
+  metrics::Gauge& rss_bytes = metrics::registry().gauge("memory.rss_bytes");
+  metrics::Gauge& pss_bytes = metrics::registry().gauge("memory.pss_bytes");
+  metrics::Gauge& uss_bytes = metrics::registry().gauge("memory.uss_bytes");
+  metrics::Gauge& mupdf_heap_bytes = metrics::registry().gauge("memory.mupdf_heap_bytes");
+  metrics::Gauge& mupdf_other_bytes = metrics::registry().gauge("memory.mupdf_other_bytes");
+  metrics::Gauge& mupdf_arena_reserved_bytes =
+      metrics::registry().gauge("memory.mupdf_arena_reserved_bytes");
+  metrics::Gauge& page_cache_bytes = metrics::registry().gauge("memory.page_cache_bytes");
+  metrics::Gauge& dlist_cache_bytes = metrics::registry().gauge("memory.display_list_cache_bytes");
+  metrics::Gauge& pending_transmission_bytes =
+      metrics::registry().gauge("memory.transmission_pending_bytes");
+  metrics::Gauge& current_transmission_bytes =
+      metrics::registry().gauge("memory.transmission_current_bytes");
+  // published by pdf::TextSearch as it extracts pages
+  metrics::Gauge& search_text_bytes = metrics::registry().gauge("memory.search_text_bytes");
+  // published by pdf::ThumbnailCache as it renders thumbnails
+  metrics::Gauge& thumbnail_bytes = metrics::registry().gauge("memory.thumbnail_bytes");
+};
+
+ViewerMetrics& viewer_metrics() {
+  static ViewerMetrics instance;
+  return instance;
+}
+
+/**
+ * @brief Samples process and engine memory into the memory.* gauges.
+ * @return The proportional set size in bytes.
+ */
+std::size_t publish_memory(RenderEngine& engine) {
+  auto gauge_bytes = [](metrics::Gauge& gauge, std::size_t bytes) {
+    gauge.set(static_cast<std::int64_t>(bytes));
+  };
+  auto& m = viewer_metrics();
+  const auto process = memory_accounting::current();
+  const auto attributed = engine.memory_breakdown();
+  const std::size_t mupdf_heap = pdf::mupdf_allocated_bytes();
+  gauge_bytes(m.rss_bytes, process.rss);
+  gauge_bytes(m.pss_bytes, process.pss);
+  gauge_bytes(m.uss_bytes, process.uss);
+  gauge_bytes(m.mupdf_heap_bytes, mupdf_heap);
+  // everything else every context holds: the resource store, open documents and their xrefs,
+  // fonts and text being extracted; not broken down further
+  gauge_bytes(m.mupdf_other_bytes,
+              mupdf_heap - std::min(mupdf_heap, attributed.display_list_cache));
+  gauge_bytes(m.mupdf_arena_reserved_bytes, size_class_arena::reserved_bytes());
+  gauge_bytes(m.page_cache_bytes, attributed.page_cache);
+  gauge_bytes(m.dlist_cache_bytes, attributed.display_list_cache);
+  gauge_bytes(m.pending_transmission_bytes, attributed.pending_transmission);
+  gauge_bytes(m.current_transmission_bytes, attributed.current_transmission);
+  return process.pss;
+}
+
+/**
+ * @brief Publishes live and peak MuPDF bytes of every context family.
+ *
+ * Gauges are named "memory.mupdf_context.<name>.{bytes,peak_bytes}". Gauges of
+ * contexts that have since been dropped keep their last values.
+ */
+void publish_context_memory() {
+  auto& registry = metrics::registry();
+  for (const auto& context : pdf::mupdf_context_memory()) {
+    registry.gauge(std::format("memory.mupdf_context.{}.bytes", context.name))
+        .set(static_cast<std::int64_t>(context.live_bytes));
+    registry.gauge(std::format("memory.mupdf_context.{}.peak_bytes", context.name))
+        .set(static_cast<std::int64_t>(context.peak_bytes));
+  }
+}
+
+std::vector<std::string> metrics_hud_lines() {
+  auto& registry = metrics::registry();
+  auto latency = [&](std::string_view label, std::string_view name) {
+    const auto s = registry.histogram(name).summary();
+    return std::format(
+        "{:<9}p50 {:5.1f} p95 {:5.1f}ms", label, s.p50_us / 1000.0, s.p95_us / 1000.0);
+  };
+  auto rate = [&](std::string_view label, std::string_view prefix) {
+    const double r = registry.hit_rate(prefix);
+    if (r < 0) {
+      return std::format("{:<14}-", label);
+    }
+    return std::format("{:<14}{:.1f}%", label, r * 100.0);
+  };
+  auto megabytes = [](std::string_view label, std::int64_t bytes) {
+    return std::format("{:<14}{:.1f}MB", label, static_cast<double>(bytes) / (1024.0 * 1024.0));
+  };
+  const auto& m = viewer_metrics();
+  return {
+      latency("render", "render.total"),
+      latency("raster", "render.raster"),
+      latency("dlist", "render.display_list_build"),
+      latency("transmit", "viewer.transmission"),
+      latency("input", "viewer.input_to_frame"),
+      rate("page cache", "cache.page"),
+      rate("dlist cache", "cache.display_list"),
+      megabytes("pss", m.pss_bytes.value()),
+      megabytes("uss", m.uss_bytes.value()),
+      megabytes("mupdf other", m.mupdf_other_bytes.value()),
+      megabytes("dlist cache", m.dlist_cache_bytes.value()),
+      megabytes("page cache", m.page_cache_bytes.value()),
+      megabytes("search text", m.search_text_bytes.value()),
+      megabytes("thumbnails", m.thumbnail_bytes.value()),
+      megabytes("frame buffers",
+                m.pending_transmission_bytes.value() + m.current_transmission_bytes.value()),
+  };
+}
 
 std::string top_status_bar_with_stats(const TermSize& ts, const RenderResult& latest_frame,
-                                      const std::string& doc_name, int page, int total_pages) {
-  std::size_t mem_bytes = ram_usage::getCurrentRSS();
+                                      const std::string& doc_name, int page, int total_pages,
+                                      const std::string& search, std::size_t mem_bytes) {
   double mem_usage_mb = static_cast<double>(mem_bytes) / (1024.0 * 1024.0);
-  std::string stats = std::to_string(latest_frame.render_time_ms) +
-                      std::format("ms {} ", TUI::symbols::box_single_line.at(179)) +
-                      std::format("{:.1f}MB", mem_usage_mb);
-  return TUI::top_status_bar(ts, doc_name, std::format("{}/{}", page + 1, total_pages), stats);
+  const double render_ms = static_cast<double>(latest_frame.render_time.count()) / 1000.0;
+  std::string stats =
+      std::format("{:.1f}ms {} ", render_ms, TUI::symbols::box_single_line.at(179)) +
+      std::format("{:.1f}MB", mem_usage_mb);
+  std::string position = std::format("{}/{}", page + 1, total_pages);
+  if (!search.empty()) {
+    position += std::format(" {} {}", TUI::symbols::box_single_line.at(179), search);
+  }
+  return TUI::top_status_bar(ts, doc_name, position, stats);
 }
+
 std::string bottom_bar(const TermSize& ts, float current_zoom_level, int rotation) {
   return TUI::bottom_status_bar(ts, current_zoom_level, rotation);
 }
 
+/// Page numbers below the visible thumbnails, the selected one highlighted.
+std::string overview_labels(const viewer::ThumbnailGrid& grid, int top_row, int selected,
+                            int total_pages) {
+  std::string result;
+  const int end = std::min(top_row + grid.visible_rows, grid.total_rows);
+  for (int row = top_row; row < end; row++) {
+    for (int col = 0; col < grid.cols; col++) {
+      const int page = (row * grid.cols) + col;
+      if (page >= total_pages) {
+        break;
+      }
+      const auto slot = grid.slot_position(top_row, row, col);
+      const std::string label = std::format("{}", page + 1);
+      const int width = grid.slot_cols - 1;  // the last col is the gap
+      result += terminal::move_cursor(
+          slot.row + grid.slot_rows - 1,
+          slot.col + std::max((width - static_cast<int>(label.size())) / 2, 0));
+      if (page == selected) {
+        result += std::format("{}{}{}{}", TermText::BoldText, TermColor::OrangeFg, label,
+                              TermColor::Reset);
+      } else {
+        result += label;
+      }
+    }
+  }
+  return result;
+}
+
 std::optional<int> parse_page_index(std::string_view input, int total_pages) {
   if (input.empty() || total_pages <= 0) {
     return std::nullopt;
@@ -73,6 +236,19 @@ Viewer::Viewer(std::unique_ptr<pdf::Parser> main_parser,
   m_shm_supported = use_shm && Shm::is_shm_supported();
 }
 
+void Viewer::record_trace(std::unique_ptr<trace::Recorder> recorder) {
+  m_recorder = std::move(recorder);
+}
+
+void Viewer::replay_trace(std::unique_ptr<trace::Replayer> replayer) {
+  m_replayer = std::move(replayer);
+}
+
+void Viewer::build_search_index(const std::filesystem::path& document,
+                                const std::filesystem::path& directory) {
+  m_index_builder = std::make_unique<pdf::IndexBuilder>(*m_parser, document, directory);
+}
+
 void Viewer::run() {
   m_running = true;
   {
@@ -83,6 +259,13 @@ void Viewer::run() {
     m_term.setup_signal_handlers();
   }
   m_term.was_resized();  // force fetch initial sizes and set flag to 0
+  if (m_replayer && m_replayer->initial_size()) {
+    m_term.override_size(*m_replayer->initial_size());
+    m_term.was_resized();
+  }
+  if (m_recorder) {
+    m_recorder->resize(m_term.get_terminal_size());
+  }
   request_page_render(m_current_page);
   draw_for_current_mode();  // force draw guard message if start dimensions too small
 
@@ -97,19 +280,59 @@ void Viewer::run() {
       break;
     }
 
+    // a batch of input may move several pages at once, only the final state is rendered
+    if (m_render_requested) {
+      m_render_requested = false;
+      request_page_render(m_current_page);
+    }
+    m_last_input_time.reset();
+
     if (fetch_latest_frame()) {
-      // store completed frames during Help, but don't redraw
-      need_redraw |= m_ui_mode == UiMode::Browse || m_ui_mode == UiMode::GoToPage;
+      // store completed frames during Help and Overview, but don't redraw
+      need_redraw |= m_ui_mode != UiMode::Help && m_ui_mode != UiMode::Overview;
     }
+    retry_placeholder();
+    need_redraw |= poll_search();
+    need_redraw |= poll_thumbnails();
 
     if (need_redraw) {
       draw_for_current_mode();
+    } else if (m_show_metrics && m_ui_mode == UiMode::Browse &&
+               std::chrono::steady_clock::now() - m_last_hud_draw >= HUD_REFRESH_INTERVAL) {
+      std::print("{}", metrics_hud_sequence());
+      std::fflush(stdout);
+    }
+
+    if (m_replayer) {
+      m_replayer->update(is_busy(), std::chrono::steady_clock::now());
+      if (m_replayer->finished()) {
+        m_running = false;
+      }
     }
   }
+  publish_memory(*m_renderer);  // final values for --metrics-out
+  publish_context_memory();
+}
+
+bool Viewer::is_busy() const {
+  const bool render_pending = m_render.latest_frame.req_id != m_render.target_state.req_id;
+  return m_render_requested || render_pending || m_resize_in_progress;
+}
+
+std::string Viewer::metrics_hud_sequence() {
+  m_last_hud_draw = std::chrono::steady_clock::now();
+  publish_memory(*m_renderer);
+  publish_context_memory();
+  return TUI::metrics_hud(m_term.get_terminal_size(), metrics_hud_lines());
 }
 
 bool Viewer::handle_resize(ResizeDebouncer& debouncer) {
-  const ResizeState state = debouncer.poll(m_term.was_resized(), std::chrono::steady_clock::now());
+  const bool resized = m_term.was_resized();
+  if (resized && m_recorder) {
+    m_recorder->resize(m_term.get_terminal_size());
+  }
+  const ResizeState state = debouncer.poll(resized, std::chrono::steady_clock::now());
+  m_resize_in_progress = state == ResizeState::Resizing;
   switch (state) {
     case ResizeState::Idle:
       return false;
@@ -118,7 +341,7 @@ bool Viewer::handle_resize(ResizeDebouncer& debouncer) {
     case ResizeState::Settled:
       // keep mode independent. If help is open, render the resized page in the background
       // so it is ready when the help page closes.
-      request_page_render(m_current_page);
+      m_render_requested = true;
       return true;
   }
 
@@ -140,8 +363,8 @@ bool Viewer::is_preview_compatible() const {
   const auto& displayed = m_render.latest_frame;
   const auto& target = m_render.target_state;
 
-  return displayed.page_num == target.page_num &&
-         displayed.rendered_page_specs.rotation == target.page_specs.rotation;
+  return target.page_specs.has_value() && displayed.page_num == target.page_num &&
+         displayed.rendered_page_specs.rotation == target.page_specs->rotation;
 }
 
 bool Viewer::fetch_latest_frame() {
@@ -150,10 +373,18 @@ bool Viewer::fetch_latest_frame() {
     return false;
   }
   auto& result = result_opt.value();
+  if (m_recorder) {
+    m_recorder->render_result(
+        result.req_id, result.page_num, result.render_time, result.error_message.empty());
+  }
   // ignore results superseded by a newer render request
   if (result.req_id != m_render.target_state.req_id) {
     return false;
   }
+  if (result.pending) {
+    draw_placeholder(result);
+    return false;
+  }
   if (!result.error_message.empty()) {  // check if there was a render error
     const TermSize ts = m_term.get_terminal_size();
     const int error_message_length = static_cast<int>(std::ssize(result.error_message));
@@ -164,9 +395,45 @@ bool Viewer::fetch_latest_frame() {
     return false;
   }
   m_render.latest_frame = std::move(result_opt.value());  // store latest frame
+  m_render.target_state.page_specs = m_render.latest_frame.rendered_page_specs;
   return true;
 }
 
+void Viewer::draw_placeholder(const RenderResult& result) {
+  const auto progress = m_parser->load_progress();
+  m_placeholder_received = progress.received;
+  m_placeholder_time = std::chrono::steady_clock::now();
+  const TermSize ts = m_term.get_terminal_size();
+  if (m_ui_mode == UiMode::Help || TUI::is_window_too_small(ts)) {
+    return;
+  }
+  // the previous frame belongs to another page, so it is cleared rather than kept
+  std::string sequence = TUI::loading_placeholder(ts, result.page_num + 1, progress);
+  sequence += TUI::top_status_bar(ts,
+                                  m_parser->get_document_name(),
+                                  std::format("{}/{}", result.page_num + 1, m_total_pages),
+                                  "loading");
+  if (m_ui_mode == UiMode::Browse) {
+    sequence += bottom_bar(ts, m_page_view.current_zoom(), m_rotation_degrees);
+  }
+  std::print("{}", sequence);
+  std::fflush(stdout);
+}
+
+void Viewer::retry_placeholder() {
+  if (!m_placeholder_received) {
+    return;
+  }
+  const auto progress = m_parser->load_progress();
+  const bool arrived = progress.received != *m_placeholder_received;
+  const bool due =
+      std::chrono::steady_clock::now() - m_placeholder_time >= PLACEHOLDER_RETRY_INTERVAL;
+  // once complete the page either renders or fails for good, so it is retried only once
+  if (progress.complete || (arrived && due)) {
+    request_page_render(m_current_page);
+  }
+}
+
 std::string Viewer::latest_frame_sequence(const FrameDisplayParams& params) {
   constexpr int KITTY_SLOT_ID = 1;
   const auto [existing_width, existing_height] = params.existing;
@@ -205,7 +472,7 @@ std::string Viewer::latest_frame_sequence(const FrameDisplayParams& params) {
       ts,
       area);
 
-  const bool need_transmit = m_render.last_transmitted_req_id != m_render.latest_frame.req_id;
+  const bool need_transmit = params.transmit;
   if (need_transmit) {
     m_render.last_transmitted_req_id = m_render.latest_frame.req_id;
   }
@@ -232,6 +499,15 @@ std::string Viewer::latest_frame_sequence(const FrameDisplayParams& params) {
                                         need_transmit,
                                         pin_cols,
                                         pin_rows);
+  // hits and geometry both come from the page of the displayed frame, never a pending one
+  const auto& displayed = m_render.latest_frame;
+  const auto& target = m_render.target_state;
+  const bool target_is_displayed = target.page_num == displayed.page_num && target.page_specs;
+  sequence += search_highlight_sequence(
+      frame_layout,
+      displayed.page_num,
+      target_is_displayed ? *target.page_specs : displayed.rendered_page_specs,
+      ts);
 
   return sequence;
 }
@@ -251,7 +527,8 @@ void Viewer::draw_latest_frame(bool with_top_bar, bool with_bottom_bar) {
   }
 
   const auto& source_specs = m_render.latest_frame.rendered_page_specs;
-  const auto& target_specs = m_render.target_state.page_specs;
+  const auto target_specs = m_render.target_state.page_specs.value_or(source_specs);
+  const bool transmit = m_render.last_transmitted_req_id != m_render.latest_frame.req_id;
   std::string sequence = latest_frame_sequence({
       .existing =
           {
@@ -263,20 +540,54 @@ void Viewer::draw_latest_frame(bool with_top_bar, bool with_bottom_bar) {
               .width = target_specs.width,
               .height = target_specs.height,
           },
+      .transmit = transmit,
   });
 
   if (with_top_bar) {
-    sequence += top_status_bar_with_stats(
-        ts, m_render.latest_frame, m_parser->get_document_name(), m_current_page, m_total_pages);
+    sequence += top_status_bar_with_stats(ts,
+                                          m_render.latest_frame,
+                                          m_parser->get_document_name(),
+                                          m_current_page,
+                                          m_total_pages,
+                                          search_summary(),
+                                          publish_memory(*m_renderer));
   }
 
   if (with_bottom_bar) {
     sequence += bottom_bar(ts, m_page_view.current_zoom(), m_rotation_degrees);
   }
 
+  if (m_show_metrics) {
+    sequence += metrics_hud_sequence();
+  }
+
   // flush and display
-  std::print("{}", sequence);
-  std::fflush(stdout);
+  auto& stats = viewer_metrics();
+  const auto write_start = std::chrono::steady_clock::now();
+  {
+    std::optional<perf_counters::Scope> perf;
+    if (transmit) {
+      perf.emplace(stats.perf_transmission);
+    }
+    std::print("{}", sequence);
+    std::fflush(stdout);
+  }
+  const auto write_end = std::chrono::steady_clock::now();
+
+  stats.frames_drawn.add();
+  stats.bytes_written.add(sequence.size());
+  if (transmit) {
+    stats.transmission.record(write_end - write_start);
+  }
+  // input latency ends when the frame rendered for that input reaches the terminal
+  auto& input_time = m_render.target_state.input_time;
+  if (input_time && m_render.latest_frame.req_id == m_render.target_state.req_id) {
+    stats.input_to_frame.record(write_end - *input_time);
+    input_time.reset();
+  }
+  if (m_recorder) {
+    m_recorder->frame_drawn(m_render.latest_frame.req_id, m_render.latest_frame.page_num);
+  }
 }
 
 void Viewer::request_page_render(int page_num) {
@@ -284,24 +595,29 @@ void Viewer::request_page_render(int page_num) {
   if (TUI::is_window_too_small(ts)) {
     return;  // draw_latest_frame handles showing of the guard message
   }
-  if (const auto specs = m_parser->page_specs(page_num)) {
-    auto target_specs = specs->rotate_quarter_clockwise(m_rotation_degrees / 90);
-    // ts.height - 2 due to rows taken by top and bottom bar
-    const float zoom_factor = TUI::calculate_zoom_factor(ts,
-                                                         target_specs,
-                                                         {
-                                                             .cols = ts.columns,
-                                                             .rows = ts.rows - 2,
-                                                         },
-                                                         m_page_view.current_zoom());
-    target_specs = target_specs.scale(zoom_factor);
-    const std::size_t req_id = m_renderer->request_page(
-        page_num, zoom_factor, target_specs, m_shm_supported ? "shm" : "tempfile");
-    m_render.target_state = {
-        .req_id = req_id,
-        .page_num = page_num,
-        .page_specs = target_specs,
-    };
+  const auto [width, height] = available_window();
+  const PageIntent intent{
+      .page_num = page_num,
+      .zoom = m_page_view.current_zoom(),
+      .rotation_degrees = m_rotation_degrees,
+      .viewport_width = width,
+      .viewport_height = height,
+  };
+  const std::size_t req_id =
+      m_renderer->request_page(intent, m_shm_supported ? "shm" : "tempfile");
+  m_placeholder_received.reset();
+  std::optional<pdf::PageSpecs> predicted;
+  if (const auto base = m_renderer->indexed_page_specs(page_num)) {
+    predicted = resolve_geometry(*base, intent).second;
+  }
+  m_render.target_state = {
+      .req_id = req_id,
+      .page_num = page_num,
+      .page_specs = predicted,
+      .input_time = m_last_input_time,
+  };
+  if (m_recorder) {
+    m_recorder->render_request(req_id, page_num, intent.zoom);
   }
 }
 
@@ -370,7 +686,7 @@ bool Viewer::handle_go_to_page_input(const InputEvent& event) {
       m_ui_mode = UiMode::Browse;
 
       if (page_changed) {
-        request_page_render(m_current_page);
+        m_render_requested = true;
       }
 
       m_go_to_page.reset();
@@ -381,6 +697,297 @@ bool Viewer::handle_go_to_page_input(const InputEvent& event) {
   return false;
 }
 
+bool Viewer::handle_find_input(const InputEvent& event) {
+  if (TUI::is_window_too_small(m_term.get_terminal_size())) {
+    if (event.key == key_char && event.char_value == 'q') {
+      m_running = false;
+    }
+    return false;
+  }
+
+  switch (m_find.input.handle(event)) {
+    case TUI::InputBar::Action::None:
+      return false;
+    case TUI::InputBar::Action::Changed:
+      return true;
+    case TUI::InputBar::Action::Cancelled:
+      break;
+    case TUI::InputBar::Action::Submitted:
+      if (!pdf::PageText::normalize_query(m_find.input.value()).empty()) {
+        m_find.query = m_find.input.value();
+        m_find.hits.clear();
+        m_find.current.reset();
+        m_find.status = {};
+        auto& search = text_search();
+        if (m_index_builder) {
+          if (auto index = m_index_builder->index()) {
+            search.use_index(std::move(index));
+          }
+        }
+        search.start(m_find.query, m_current_page);
+      }
+      break;
+  }
+  m_ui_mode = UiMode::Browse;
+  m_find.input.reset();
+  terminal::hide_cursor();
+  return true;
+}
+
+pdf::TextSearch& Viewer::text_search() {
+  if (!m_search) {
+    m_search = std::make_unique<pdf::TextSearch>(*m_parser, m_renderer->threads());
+  }
+  return *m_search;
+}
+
+bool Viewer::poll_search() {
+  if (!m_search) {
+    return false;
+  }
+  auto hits = m_search->take_hits();
+  const auto status = m_search->status();
+  const auto now = std::chrono::steady_clock::now();
+  const bool progressed = status.pages_scanned != m_find.status.pages_scanned &&
+                          now - m_find.drawn >= SEARCH_PROGRESS_INTERVAL;
+  const bool finished = status.done != m_find.status.done;
+  if (hits.empty() && !progressed && !finished) {
+    return false;
+  }
+  std::ranges::move(hits, std::back_inserter(m_find.hits));
+  m_find.status = status;
+  m_find.drawn = now;
+  if (!m_find.current && !m_find.hits.empty()) {
+    // the scan starts at the current page, so the first hit is the nearest one
+    m_find.current = 0;
+    if (m_find.hits.front().page_num != m_current_page) {
+      m_current_page = m_find.hits.front().page_num;
+      m_render_requested = true;
+    }
+  }
+  return m_ui_mode != UiMode::Help && m_ui_mode != UiMode::Overview;
+}
+
+bool Viewer::step_search_hit(int step) {
+  if (m_find.hits.empty()) {
+    return false;
+  }
+  const auto count = static_cast<std::ptrdiff_t>(m_find.hits.size());
+  const auto from = static_cast<std::ptrdiff_t>(m_find.current.value_or(0));
+  const auto next = static_cast<std::size_t>((from + step + count) % count);
+  m_find.current = next;
+  if (m_find.hits[next].page_num != m_current_page) {
+    m_current_page = m_find.hits[next].page_num;
+    m_render_requested = true;
+  }
+  return true;
+}
+
+bool Viewer::handle_overview_input(const InputEvent& event) {
+  const auto [key, char_value] = event;
+  if (key == key_char && char_value == 'q') {
+    m_running = false;
+    return false;
+  }
+  if (TUI::is_window_too_small(m_term.get_terminal_size())) {
+    return false;
+  }
+
+  const int cols = m_overview.atlas ? m_overview.atlas->grid().cols : 1;
+  int step = 0;
+  switch (key) {
+    case key_enter:
+      leave_overview(true);
+      return true;
+    case key_escape:
+      leave_overview(false);
+      return true;
+    case key_left_arrow:
+      step = -1;
+      break;
+    case key_right_arrow:
+      step = 1;
+      break;
+    case key_up_arrow:
+      step = -cols;
+      break;
+    case key_down_arrow:
+      step = cols;
+      break;
+    case key_char:
+      switch (char_value) {
+        case 'o':
+          leave_overview(false);
+          return true;
+        case 'a':
+          step = -1;
+          break;
+        case 'd':
+          step = 1;
+          break;
+        case 'w':
+          step = -cols;
+          break;
+        case 's':
+          step = cols;
+          break;
+        default:
+          break;
+      }
+      break;
+    default:
+      break;
+  }
+  const int selected = std::clamp(m_overview.selected + step, 0, m_total_pages - 1);
+  if (selected == m_overview.selected) {
+    return false;
+  }
+  m_overview.selected = selected;
+  return true;
+}
+
+void Viewer::leave_overview(bool open_selected) {
+  std::print("{}", kitty::delete_image(viewer::ThumbnailAtlas::IMAGE_ID));
+  m_overview.atlas.reset();
+  m_ui_mode = UiMode::Browse;
+  if (open_selected && m_overview.selected != m_current_page) {
+    m_current_page = m_overview.selected;
+    m_render_requested = true;
+  }
+}
+
+pdf::ThumbnailCache& Viewer::thumbnails() {
+  if (!m_thumbnails) {
+    m_thumbnails = std::make_unique<pdf::ThumbnailCache>(*m_parser, m_renderer->threads());
+  }
+  return *m_thumbnails;
+}
+
+bool Viewer::poll_thumbnails() {
+  if (!m_thumbnails) {
+    return false;
+  }
+  const auto rendered = m_thumbnails->take_rendered();
+  if (rendered.empty() || m_ui_mode != UiMode::Overview || !m_overview.atlas) {
+    return false;
+  }
+  bool changed = false;
+  for (const int row : m_overview.atlas->missing_rows(m_overview.top_row)) {
+    changed |= m_overview.atlas->fill_row(row, *m_thumbnails, m_total_pages);
+  }
+  return changed;
+}
+
+void Viewer::draw_overview() {
+  const TermSize ts = m_term.get_terminal_size();
+  if (TUI::is_window_too_small(ts)) {
+    std::print("{}", TUI::guard_message(ts));
+    std::fflush(stdout);
+    return;
+  }
+  const TUI::ContentArea area = {
+      .cols = ts.columns,
+      .rows = ts.rows - 2,
+      .start_row = 2,
+      .start_col = 1,
+  };
+  const auto grid = viewer::calculate_thumbnail_grid(ts, area, m_total_pages);
+  std::string sequence;
+  sequence += terminal::reset_screen_and_cursor_string();
+  sequence += kitty::delete_image_placement();  // the page, its highlights and the last grid
+  auto& overview = m_overview;
+  if (!overview.atlas || overview.atlas->grid() != grid ||
+      overview.rotation != m_rotation_degrees) {
+    sequence += kitty::delete_image(viewer::ThumbnailAtlas::IMAGE_ID);
+    overview.atlas = std::make_unique<viewer::ThumbnailAtlas>(grid);
+    overview.rotation = m_rotation_degrees;
+  }
+  auto& atlas = *overview.atlas;
+  const int last_top_row = std::max(grid.total_rows - grid.visible_rows, 0);
+  overview.top_row =
+      grid.scroll_to(std::clamp(overview.top_row, 0, last_top_row), overview.selected);
+
+  // only rows scrolled into view are rendered and sent; poll_thumbnails() fills in the rest
+  const auto rows = atlas.missing_rows(overview.top_row);
+  if (!rows.empty()) {
+    std::vector<int> pages;
+    for (const int row : rows) {
+      for (int page = row * grid.cols; page < std::min((row + 1) * grid.cols, m_total_pages);
+           page++) {
+        pages.push_back(page);
+      }
+    }
+    auto& cache = thumbnails();
+    cache.request(pages, grid.box, m_rotation_degrees);
+    for (const int row : rows) {
+      atlas.fill_row(row, cache, m_total_pages);
+    }
+  }
+  try {
+    sequence += atlas.transmission_sequence(m_shm_supported ? "shm" : "tempfile");
+  } catch (const std::exception& e) {
+    PLOG_ERROR << "Failed to transmit thumbnails: " << e.what();
+  }
+  sequence += atlas.placement_sequence(overview.top_row, ts);
+  sequence += overview_labels(grid, overview.top_row, overview.selected, m_total_pages);
+  sequence += TUI::top_status_bar(ts,
+                                  m_parser->get_document_name(),
+                                  std::format("{}/{}", overview.selected + 1, m_total_pages),
+                                  "overview");
+
+  std::print("{}", sequence);
+  std::fflush(stdout);
+  viewer_metrics().bytes_written.add(sequence.size());
+}
+
+std::string Viewer::search_highlight_sequence(const viewer::FrameLayout& layout,
+                                              int page_num,
+                                              const pdf::PageSpecs& target,
+                                              const TermSize& ts) const {
+  std::string sequence = kitty::clear_highlights();
+  int placement_id = 0;
+  for (std::size_t i = 0; i < m_find.hits.size(); i++) {
+    const auto& hit = m_find.hits[i];
+    if (hit.page_num != page_num) {
+      continue;
+    }
+    for (const auto& rect : hit.rects) {
+      const auto placement =
+          viewer::calculate_overlay_placement(viewer::map_page_rect(rect, target), layout, ts);
+      if (!placement) {
+        continue;  // panned out of view
+      }
+      if (placement_id == 0) {
+        sequence += kitty::get_highlight_images();
+      }
+      sequence += terminal::move_cursor(placement->origin.row, placement->origin.col);
+      sequence += kitty::get_highlight_placement(m_find.current == i,
+                                                 ++placement_id,
+                                                 placement->x_offset_pixels,
+                                                 placement->y_offset_pixels,
+                                                 placement->cols,
+                                                 placement->rows);
+    }
+  }
+  return sequence;
+}
+
+std::string Viewer::search_summary() const {
+  if (m_find.status.search_id == 0) {
+    return "";
+  }
+  std::string summary = m_find.hits.empty()
+                            ? std::string(m_find.status.done ? "no matches" : "searching")
+                            : std::format("match {}/{}",
+                                          m_find.current.value_or(0) + 1,
+                                          m_find.hits.size());
+  if (!m_find.status.done && m_find.status.total_pages > 0) {
+    summary += std::format(
+        " {}%", m_find.status.pages_scanned * 100 / m_find.status.total_pages);
+  }
+  return summary;
+}
+
 bool Viewer::handle_help_input(const InputEvent& event) {
   if (m_ui_mode != UiMode::Help) {
     PLOG_ERROR << "handle_help_input called when ui_mode is not Help";
@@ -427,7 +1034,7 @@ bool Viewer::handle_browse_input(const InputEvent& event) {
         m_current_page = m_total_pages - 1;
       } else {
         m_current_page++;
-        request_page_render(m_current_page);
+        m_render_requested = true;
         return true;
       }
       return false;
@@ -436,7 +1043,7 @@ bool Viewer::handle_browse_input(const InputEvent& event) {
         m_current_page = 0;
       } else {
         m_current_page--;
-        request_page_render(m_current_page);
+        m_render_requested = true;
         return true;
       }
       return false;
@@ -449,6 +1056,19 @@ bool Viewer::handle_browse_input(const InputEvent& event) {
         m_ui_mode = UiMode::Help;
         return true;
       }
+      if (char_value == '/' || char_value == 'F') {
+        m_find.input.reset();
+        m_ui_mode = UiMode::Find;
+        return m_running;
+      }
+      if (char_value == 'n' || char_value == 'N') {  // next or previous search hit
+        return step_search_hit(char_value == 'n' ? 1 : -1);
+      }
+      if (char_value == 'o' && m_total_pages > 0) {
+        m_overview.selected = m_current_page;
+        m_ui_mode = UiMode::Overview;
+        return m_running;
+      }
       if (char_value == 'g') {
         // go to page
         m_go_to_page.reset();
@@ -460,28 +1080,32 @@ bool Viewer::handle_browse_input(const InputEvent& event) {
         if (m_page_view.current_zoom() != 1.0) {
           m_page_view.reset_offsets_to_default();
           m_page_view.reset_zoom_to_default();
-          request_page_render(m_current_page);
+          m_render_requested = true;
           return true;
         }
         return false;
       }
       if (char_value == '=' || char_value == '+') {  // zoom in
         if (m_page_view.change_zoom_index(1)) {
-          request_page_render(m_current_page);
+          m_render_requested = true;
           return true;
         }
         return false;
       }
       if (char_value == '-' || char_value == '_') {  // zoom out
         if (m_page_view.change_zoom_index(-1)) {
-          request_page_render(m_current_page);
+          m_render_requested = true;
           return true;
         }
         return false;
       }
+      if (char_value == 'm') {
+        m_show_metrics = !m_show_metrics;
+        return true;
+      }
       if (char_value == 'r') {
         m_rotation_degrees = (m_rotation_degrees + 90) % 360;
-        request_page_render(m_current_page);
+        m_render_requested = true;
         return false;
       }
       if (pan_keys.contains(char_value)) {  // handle panning
@@ -506,6 +1130,17 @@ void Viewer::draw_for_current_mode() {
         std::fflush(stdout);
       }
       break;
+    case UiMode::Find:
+      draw_latest_frame(true, false);
+      if (!TUI::is_window_too_small(m_term.get_terminal_size())) {
+        terminal::show_cursor();
+        std::print("{}", m_find.input.render_sequence(m_term.get_terminal_size()));
+        std::fflush(stdout);
+      }
+      break;
+    case UiMode::Overview:
+      draw_overview();
+      break;
     case UiMode::Help:
       std::string sequence;
       sequence += terminal::reset_screen_and_cursor_string();
@@ -519,14 +1154,65 @@ void Viewer::draw_for_current_mode() {
 }
 
 bool Viewer::process_keypress() {
-  const auto event = m_term.read_input(INPUT_POLL_RATE_MS);  // 60fps
-  switch (m_ui_mode) {
-    case UiMode::Browse:
-      return handle_browse_input(event);
-    case UiMode::Help:
-      return handle_help_input(event);
-    case UiMode::GoToPage:
-      return handle_go_to_page_input(event);
+  bool need_redraw = false;
+  const auto events = next_input_batch();
+  if (!events.empty()) {
+    m_last_input_time = std::chrono::steady_clock::now();
+    viewer_metrics().input_events.add(events.size());
   }
-  return false;
+  for (const auto& event : events) {
+    if (!m_running) {
+      break;  // drop anything typed after quit
+    }
+    switch (m_ui_mode) {
+      case UiMode::Browse:
+        need_redraw |= handle_browse_input(event);
+        break;
+      case UiMode::Help:
+        need_redraw |= handle_help_input(event);
+        break;
+      case UiMode::GoToPage:
+        need_redraw |= handle_go_to_page_input(event);
+        break;
+      case UiMode::Find:
+        need_redraw |= handle_find_input(event);
+        break;
+      case UiMode::Overview:
+        need_redraw |= handle_overview_input(event);
+        break;
+    }
+  }
+  return need_redraw;
+}
+
+std::span<const InputEvent> Viewer::next_input_batch() {
+  if (!m_replayer) {
+    const auto events = m_term.read_input(INPUT_POLL_RATE_MS);  // 60fps
+    if (m_recorder && !events.empty()) {
+      m_recorder->next_batch();
+      for (const auto& event : events) {
+        m_recorder->input(event);
+      }
+    }
+    return events;
+  }
+
+  // wait no longer than the next due step, a real key press aborts the replay
+  const auto now = std::chrono::steady_clock::now();
+  const auto wait = m_replayer->time_until_next(now).value_or(
+      std::chrono::milliseconds(INPUT_POLL_RATE_MS));
+  const auto timeout = std::min<std::chrono::milliseconds::rep>(wait.count(), INPUT_POLL_RATE_MS);
+  if (!m_term.read_input(static_cast<int>(timeout)).empty()) {
+    PLOG_INFO << "Replay interrupted by key press";
+    m_running = false;
+    return {};
+  }
+  const auto step = m_replayer->poll(std::chrono::steady_clock::now());
+  if (!step) {
+    return {};
+  }
+  if (step->resize) {
+    m_term.override_size(*step->resize);
+  }
+  return step->inputs;
 }
\ No newline at end of file
@@ -1,11 +1,22 @@
 #pragma once
+#include <chrono>
 #include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
 
+#include "frame_layout.h"
 #include "pageview.h"
+#include "render/index_builder.h"
 #include "render/parser.h"
 #include "render/render_engine.h"
+#include "render/text_search.h"
+#include "render/thumbnails.h"
 #include "terminal/inputbar.h"
 #include "terminal/terminal.h"
+#include "thumbnail_atlas.h"
+#include "trace.h"
 #include "utils/resize_debouncer.h"
 
 class Viewer {
@@ -26,6 +37,28 @@ class Viewer {
    */
   void run();  // main loop
 
+  /// Records input, resizes, render requests, results and drawn frames to recorder.
+  void record_trace(std::unique_ptr<trace::Recorder> recorder);
+
+  /**
+   * @brief Feeds a recorded trace instead of terminal input.
+   *
+   * The terminal is pinned to the recorded dimensions. Any real key press ends
+   * the replay, which otherwise stops once every step has settled.
+   */
+  void replay_trace(std::unique_ptr<trace::Replayer> replayer);
+
+  /**
+   * @brief Builds, or loads, a persistent search index of document in directory.
+   *
+   * Searches use the index once it is ready. Call before run().
+   */
+  void build_search_index(const std::filesystem::path& document,
+                          const std::filesystem::path& directory);
+
+  /// The attached replayer, or nullptr. Holds per-step latencies after run() returns.
+  [[nodiscard]] const trace::Replayer* replayer() const { return m_replayer.get(); }
+
  private:
   /**
    * @brief Wraps standard two-dimensional pixel or grid dimensions.
@@ -46,6 +79,7 @@ class Viewer {
   struct FrameDisplayParams {
     Dimensions existing;
     Dimensions target;
+    bool transmit;  ///< Whether the bitmap has not yet been sent to the terminal
   };
 
   /**
@@ -72,6 +106,23 @@ class Viewer {
    */
   bool fetch_latest_frame();
 
+  /**
+   * @brief Draws the placeholder of a page whose data has not arrived yet.
+   *
+   * Remembers how much of the document had arrived, so the page is requested
+   * again once more does.
+   */
+  void draw_placeholder(const RenderResult& result);
+
+  /**
+   * @brief Requests the placeholder page again if more of the document arrived.
+   *
+   * Retries at most every PLACEHOLDER_RETRY_INTERVAL while bytes trickle in,
+   * and once more as soon as the document is complete. Only reads the load
+   * counters, never MuPDF.
+   */
+  void retry_placeholder();
+
   /**
    * @brief Builds the terminal sequence that places the latest page image.
    *
@@ -106,11 +157,12 @@ class Viewer {
   /**
    * @brief Requests an asynchronous render for the desired page state.
    *
-   * Reads the current terminal dimensions, page rotation, and zoom state;
-   * calculates the scaled target PageSpecs; dispatches a non-blocking request to
-   * the render engine; and stores the returned generation ID, page number, and
-   * specs together in RenderState::target_state. Does nothing if the terminal is
-   * too small or the page number is invalid.
+   * Sends the page, zoom, rotation and available window to the render engine,
+   * which resolves the page geometry on its own thread, and stores the returned
+   * generation ID and page number in RenderState::target_state. The target specs
+   * are predicted from the engine's page index when the page is indexed already,
+   * so previews can be scaled; MuPDF is never called. Does nothing if the
+   * terminal is too small.
    *
    * @param page_num Zero-based page number to render.
    */
@@ -137,6 +189,97 @@ class Viewer {
    */
   bool handle_go_to_page_input(const InputEvent& event);
 
+  /**
+   * @brief Handles one input event while Find is active.
+   *
+   * Submitting a non-empty query starts a search from the current page and
+   * returns to Browse, where hits arrive through poll_search(). Escape or an
+   * empty query returns to Browse and keeps the previous hits.
+   *
+   * @param event Decoded terminal input event.
+   * @return true when the current mode should be redrawn immediately.
+   */
+  bool handle_find_input(const InputEvent& event);
+
+  /**
+   * @brief Collects hits found since the last loop.
+   *
+   * Jumps to the first hit of a new search. Progress alone redraws at most
+   * every SEARCH_PROGRESS_INTERVAL, so the status bar follows a long scan
+   * without repainting on every chunk.
+   *
+   * @return true when the status bar should be redrawn.
+   */
+  bool poll_search();
+
+  /**
+   * @brief Moves to the next or previous hit, wrapping around.
+   * @param step 1 for the next hit, -1 for the previous one.
+   * @return true when there was a hit to move to.
+   */
+  bool step_search_hit(int step);
+
+  /// The text search, created with worker parsers on first use.
+  pdf::TextSearch& text_search();
+
+  /**
+   * @brief Builds the Kitty placements highlighting the search hits on the drawn page.
+   *
+   * Hit rectangles go through the zoom, rotation and crop the frame is drawn
+   * with and become translucent overlays above the page, so moving between
+   * hits on one page replaces placements without rendering it again.
+   *
+   * @param layout Layout the page frame is drawn with.
+   * @param page_num Page of the drawn frame; only its hits are placed.
+   * @param target Specs of page_num's target bitmap the layout was calculated for.
+   * @param ts Current terminal size.
+   * @return Sequence clearing the previous highlights and placing the current ones.
+   */
+  [[nodiscard]] std::string search_highlight_sequence(const viewer::FrameLayout& layout,
+                                                      int page_num,
+                                                      const pdf::PageSpecs& target,
+                                                      const TermSize& ts) const;
+
+  /**
+   * @brief Handles one input event while Overview is active.
+   *
+   * Arrow keys and wasd move the selection, scrolling the grid to keep it in
+   * view. Enter opens the selected page, Escape or o returns to the current
+   * one, and q quits.
+   *
+   * @param event Decoded terminal input event.
+   * @return true when the current mode should be redrawn immediately.
+   */
+  bool handle_overview_input(const InputEvent& event);
+
+  /**
+   * @brief Leaves Overview for Browse and frees the atlas in the terminal.
+   * @param open_selected Whether to go to the selected page.
+   */
+  void leave_overview(bool open_selected);
+
+  /**
+   * @brief Draws the thumbnail grid around the selected page.
+   *
+   * Thumbnails of rows scrolled into view are requested from the cache
+   * without waiting, and slots still rendering are left empty. Whatever is
+   * cached is copied into the atlas and sent as edits of it. Every thumbnail
+   * on screen is then placed again, which costs a few bytes each.
+   */
+  void draw_overview();
+
+  /**
+   * @brief Copies thumbnails rendered since the last loop into the visible atlas rows.
+   * @return true when Overview should be redrawn to send and place them.
+   */
+  bool poll_thumbnails();
+
+  /// The thumbnail cache, created with worker parsers on first use.
+  pdf::ThumbnailCache& thumbnails();
+
+  /// Match count and scan progress for the top bar, empty without a search.
+  [[nodiscard]] std::string search_summary() const;
+
   /**
    * @brief Handles one input event while Help is active.
    *
@@ -152,8 +295,8 @@ class Viewer {
   /**
    * @brief Handles one input event while Browse is active.
    *
-   * Applies document navigation, zoom, rotation, and pan commands, or transitions
-   * to Help and GoToPage. While the minimum-size guard is visible, only q is
+   * Applies document navigation, zoom, rotation, pan and search hit commands, or
+   * transitions to Help, GoToPage and Find. While the minimum-size guard is visible, only q is
    * accepted and requests application shutdown.
    *
    * @param event Decoded terminal input event.
@@ -170,22 +313,46 @@ class Viewer {
    * @brief Draws the complete presentation for the active UI mode.
    *
    * - Browse draws the page and both status bars.
-   * - GoToPage draws the page and top bar while reserving the bottom row for its
-   * input component.
+   * - GoToPage and Find draw the page and top bar while reserving the bottom row
+   * for their input component.
    * - Help clears and redraws its overlay using the current terminal dimensions.
    */
   void draw_for_current_mode();
 
   /**
-   * @brief Reads and routes one terminal input event.
+   * @brief Reads and routes a batch of terminal input events.
    *
-   * Waits up to INPUT_POLL_RATE_MS for an event, then forwards it to the input handler
-   * for the active mode.
+   * Waits up to INPUT_POLL_RATE_MS for input, then forwards every decoded event to
+   * the input handler for the active mode, in order. Handlers only mark that a page
+   * render is needed; the main loop dispatches one request per batch so a burst of
+   * key-repeat events renders the final page only.
    *
    * @return true when the active mode should be redrawn immediately.
    */
   bool process_keypress();
 
+  /**
+   * @brief Returns the next batch of input events.
+   *
+   * Reads the terminal, or during a replay the next due trace step, applying
+   * recorded resizes. Recorded when a recorder is attached.
+   */
+  std::span<const InputEvent> next_input_batch();
+
+  /**
+   * @brief True while the viewer still has work for the latest input: a render
+   * is requested or pending, or a resize is being debounced.
+   */
+  [[nodiscard]] bool is_busy() const;
+
+  /**
+   * @brief Builds the metrics overlay from the process-wide registry.
+   *
+   * Refreshes the resident memory gauge and records the draw time so the main
+   * loop can repaint the overlay on its own every HUD_REFRESH_INTERVAL.
+   */
+  std::string metrics_hud_sequence();
+
   /**
    * @brief Calculates the usable pixel dimensions of the terminal window, reserving two rows for
    * the top and bottom status bars.
@@ -205,10 +372,13 @@ class Viewer {
   [[nodiscard]] bool is_preview_compatible() const;
 
   // subsystems
-  Terminal m_term;                           // terminal data and raw mode
-  std::unique_ptr<pdf::Parser> m_parser;     // parsing pdfs
-  std::unique_ptr<RenderEngine> m_renderer;  // loading page frames
-  PageView m_page_view;                      // zoom and panning handling
+  Terminal m_term;                               // terminal data and raw mode
+  std::unique_ptr<pdf::Parser> m_parser;         // parsing pdfs
+  std::unique_ptr<RenderEngine> m_renderer;      // loading page frames
+  PageView m_page_view;                          // zoom and panning handling
+  std::unique_ptr<pdf::TextSearch> m_search;     // full-text search, created on first use
+  std::unique_ptr<pdf::IndexBuilder> m_index_builder;  // persistent search index, if enabled
+  std::unique_ptr<pdf::ThumbnailCache> m_thumbnails;  // overview thumbnails, created on first use
 
   /**
    * @brief Identifies the active UI mode and determines input routing and drawing.
@@ -217,6 +387,8 @@ class Viewer {
     Browse,    ///< Normal document controls
     GoToPage,  ///< Page-number entry through TUI::InputBar
     Help,      ///< Viewing help ui page
+    Find,      ///< Search query entry through TUI::InputBar
+    Overview,  ///< Grid of page thumbnails
   };
 
   /**
@@ -229,7 +401,11 @@ class Viewer {
   struct RenderTarget {
     std::size_t req_id = 0;       ///< Generation ID returned for the request
     int page_num = 0;             ///< Zero-based page requested
-    pdf::PageSpecs page_specs{};  ///< Scaled and rotated geometry requested
+    /// Scaled and rotated geometry: predicted from the page index until the frame arrives,
+    /// std::nullopt if the page was not indexed yet
+    std::optional<pdf::PageSpecs> page_specs;
+    /// Time of the input batch that triggered the request, cleared once its frame is drawn
+    std::optional<std::chrono::steady_clock::time_point> input_time;
   };
 
   /**
@@ -253,17 +429,50 @@ class Viewer {
     void reset() { input.reset(); }
   };
 
+  struct FindState {
+    TUI::InputBar input{"FIND: "};
+    std::string query;                   ///< Query of the latest search, as typed
+    std::vector<pdf::SearchHit> hits;    ///< Hits taken so far, in scan order
+    std::optional<std::size_t> current;  ///< Index of the hit shown, none before the first
+    pdf::SearchStatus status;            ///< Status at the last redraw
+    std::chrono::steady_clock::time_point drawn{};  ///< When progress was last redrawn
+  };
+
+  struct OverviewState {
+    int selected = 0;  ///< Zero-based page under the cursor
+    int top_row = 0;   ///< First visible grid row
+    int rotation = 0;  ///< Rotation the atlas thumbnails were rendered at
+    std::unique_ptr<viewer::ThumbnailAtlas> atlas;  ///< Null until first drawn
+  };
+
   // current state
   UiMode m_ui_mode = UiMode::Browse;
   int m_current_page = 0;           ///< Desired zero-based page number
   int m_total_pages = 0;            ///< Number of pages in loaded document
   int m_rotation_degrees = 0;       ///< Desired clockwise rotation
   bool m_running = false;           ///< Controls main application loop
+  bool m_render_requested = false;  ///< Input changed the desired page state this loop
+  bool m_resize_in_progress = false;  ///< Resize signalled but not yet settled
   GoToPageState m_go_to_page = {};  ///< Track Go To Page Ui state
+  FindState m_find = {};            ///< Search query and hits
+  OverviewState m_overview = {};    ///< Thumbnail grid position and atlas
+  bool m_show_metrics = false;      ///< Draw the metrics overlay over the page
+  /// Bytes of the document received when the target page was drawn as a placeholder,
+  /// std::nullopt unless it is one
+  std::optional<std::size_t> m_placeholder_received;
+  std::chrono::steady_clock::time_point m_placeholder_time{};  ///< When it was drawn
+
+  /// Arrival time of the input batch read this loop, if any
+  std::optional<std::chrono::steady_clock::time_point> m_last_input_time;
+  std::chrono::steady_clock::time_point m_last_hud_draw{};  ///< Last metrics overlay repaint
 
   // configuration
   bool m_shm_supported = false;  ///< Whether shared-memory transmission is enabled
 
   // Rendering state
   RenderState m_render;
+
+  // session tracing
+  std::unique_ptr<trace::Recorder> m_recorder;  ///< Set when recording a trace
+  std::unique_ptr<trace::Replayer> m_replayer;  ///< Set when replaying a trace
 };
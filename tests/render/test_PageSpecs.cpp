@@ -130,3 +130,12 @@ TEST(PageSpecsMethod, rotate_quarter_clockwise) {
     EXPECT_EQ(rotated.rotation, expected_rotation[i]);
   }
 }
+
+TEST(PageSpecsMethod, fit_zoom) {
+  const auto ps = pdf::PageSpecs::from_base_bounds({.x0 = 0, .y0 = 0, .x1 = 100, .y1 = 200});
+  EXPECT_FLOAT_EQ(ps.fit_zoom(400, 400), 2.0F);  // limited by height
+  EXPECT_FLOAT_EQ(ps.fit_zoom(50, 400), 0.5F);   // limited by width
+  // a quarter turn swaps which side limits the fit
+  EXPECT_FLOAT_EQ(ps.rotate_quarter_clockwise(1).fit_zoom(400, 400), 2.0F);
+  EXPECT_FLOAT_EQ(ps.rotate_quarter_clockwise(1).fit_zoom(400, 100), 1.0F);
+}
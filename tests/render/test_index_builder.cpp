@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "render/index_builder.h"
+#include "render/parser.h"
+#include "render/text_search.h"
+#include "utils/metrics.h"
+
+namespace {
+constexpr std::string_view g_fixtures_dir = PDVU_TEST_FIXTURES_DIR;
+
+auto pdf_file_path(std::string_view filename) {
+  return std::filesystem::path{g_fixtures_dir} / "pdf" / filename;
+}
+
+std::filesystem::path index_directory(std::string_view name) {
+  return std::filesystem::temp_directory_path() / std::format("pdvu_{}_{}", name, getpid());
+}
+}  // namespace
+
+TEST(IndexBuilderTest, BuildsOnceAndLoadsAfterwards) {
+  const auto directory = index_directory("index_builds_once");
+  const auto document = pdf_file_path("multi_page.pdf");
+  auto& extracted = metrics::registry().counter("search.index.pages");
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(document));
+
+  const auto before = extracted.value();
+  {
+    pdf::IndexBuilder builder(parser, document, directory);
+    builder.wait();
+    const auto index = builder.index();
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->num_pages(), 3);
+    EXPECT_EQ(builder.pages_indexed(), 3);
+    EXPECT_EQ(index->candidate_pages("400 x 100"), (std::vector<int>{1}));
+  }
+  EXPECT_EQ(extracted.value(), before + 3);
+  const auto key = pdf::DocumentKey::of(document);
+  ASSERT_TRUE(key.has_value());
+  EXPECT_TRUE(std::filesystem::exists(directory / (key->file_stem() + ".idx")));
+  EXPECT_FALSE(std::filesystem::exists(directory / (key->file_stem() + ".log")));
+
+  {
+    pdf::IndexBuilder builder(parser, document, directory);
+    builder.wait();
+    ASSERT_NE(builder.index(), nullptr);
+  }
+  EXPECT_EQ(extracted.value(), before + 3);  // mapped, not extracted again
+  std::filesystem::remove_all(directory);
+}
+
+TEST(IndexBuilderTest, SearchUsesIndex) {
+  const auto directory = index_directory("index_search");
+  const auto document = pdf_file_path("multi_page.pdf");
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(document));
+  pdf::IndexBuilder builder(parser, document, directory);
+  builder.wait();
+  ASSERT_NE(builder.index(), nullptr);
+
+  auto& indexed = metrics::registry().counter("search.indexed");
+  const auto before = indexed.value();
+  pdf::TextSearch search(parser, 2);
+  search.use_index(builder.index());
+  search.start("page", 2);
+  search.wait();
+  std::vector<int> pages;
+  for (const auto& hit : search.take_hits()) {
+    pages.push_back(hit.page_num);
+    EXPECT_EQ(hit.rects.size(), 1U);
+  }
+  EXPECT_EQ(pages, (std::vector<int>{2, 0, 1}));
+  EXPECT_EQ(search.cached_bytes(), 0U);  // nothing extracted
+  EXPECT_EQ(indexed.value(), before + 1);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(IndexBuilderTest, RebuildsDamagedIndex) {
+  const auto directory = index_directory("index_damaged");
+  const auto document = pdf_file_path("single_page.pdf");
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(document));
+  const auto key = pdf::DocumentKey::of(document);
+  ASSERT_TRUE(key.has_value());
+  std::filesystem::create_directories(directory);
+  std::ofstream(directory / (key->file_stem() + ".idx"), std::ios::binary) << "garbage";
+
+  pdf::IndexBuilder builder(parser, document, directory);
+  builder.wait();
+  const auto index = builder.index();
+  ASSERT_NE(index, nullptr);
+  EXPECT_EQ(index->candidate_pages("single_page"), (std::vector<int>{0}));
+  std::filesystem::remove_all(directory);
+}
+
+TEST(IndexBuilderTest, SkipsDocumentLockedByAnotherProcess) {
+  const auto directory = index_directory("index_locked");
+  const auto document = pdf_file_path("single_page.pdf");
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(document));
+  const auto key = pdf::DocumentKey::of(document);
+  ASSERT_TRUE(key.has_value());
+  std::filesystem::create_directories(directory);
+  const auto log_path = directory / (key->file_stem() + ".log");
+  // a separate open file description conflicts like another process would
+  const int fd = open(log_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  ASSERT_NE(fd, -1);
+  ASSERT_EQ(flock(fd, LOCK_EX | LOCK_NB), 0);
+
+  {
+    pdf::IndexBuilder builder(parser, document, directory);
+    builder.wait();
+    EXPECT_EQ(builder.index(), nullptr);
+    EXPECT_EQ(builder.pages_indexed(), 0);
+  }
+  EXPECT_EQ(std::filesystem::file_size(log_path), 0U);  // nothing appended
+
+  close(fd);
+  pdf::IndexBuilder builder(parser, document, directory);
+  builder.wait();
+  EXPECT_NE(builder.index(), nullptr);
+  std::filesystem::remove_all(directory);
+}
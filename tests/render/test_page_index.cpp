@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string_view>
+
+#include "render/page_index.h"
+#include "render/parser.h"
+
+namespace {
+constexpr std::string_view g_fixtures_dir = PDVU_TEST_FIXTURES_DIR;
+
+auto pdf_file_path(std::string_view filename) {
+  return std::filesystem::path(g_fixtures_dir) / "pdf" / filename;
+}
+}  // namespace
+
+TEST(PageIndex, MatchesParserForEveryPage) {
+  for (const auto* fixture : {"multi_page.pdf", "rotated_page.pdf"}) {
+    pdf::MuPDFParser parser(false);
+    ASSERT_TRUE(parser.load_document(pdf_file_path(fixture)));
+    const pdf::PageIndex index(parser);
+    index.wait();
+    ASSERT_TRUE(index.complete());
+    ASSERT_EQ(index.num_pages(), parser.num_pages());
+    for (int page = 0; page < parser.num_pages(); page++) {
+      const auto indexed = index.get(page);
+      ASSERT_TRUE(indexed.has_value()) << fixture << " page " << page;
+      EXPECT_EQ(*indexed, *parser.page_specs(page)) << fixture << " page " << page;
+    }
+  }
+}
+
+TEST(PageIndex, OutOfRangePagesAreNotIndexed) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("single_page.pdf")));
+  const pdf::PageIndex index(parser);
+  index.wait();
+  EXPECT_FALSE(index.get(-1).has_value());
+  EXPECT_FALSE(index.get(index.num_pages()).has_value());
+  EXPECT_FALSE(index.get_or_load(index.num_pages(), parser).has_value());
+}
+
+TEST(PageIndex, LookupsBeforeCompletionFallBackToParser) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("multi_page.pdf")));
+  const pdf::PageIndex index(parser);
+  // whether or not page 1 is indexed yet, the answer is the same
+  EXPECT_EQ(index.get_or_load(1, parser), parser.page_specs(1));
+}
+
+TEST(PageIndex, EmptyParserGivesEmptyIndex) {
+  const pdf::MuPDFParser parser(false);
+  const pdf::PageIndex index(parser);
+  index.wait();
+  EXPECT_EQ(index.num_pages(), 0);
+  EXPECT_FALSE(index.get(0).has_value());
+}
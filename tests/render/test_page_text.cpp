@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "render/page_text.h"
+
+namespace {
+/// Adds text as one line of 10 unit wide characters starting at x.
+void add_line(pdf::PageText& page, std::u32string_view text, float y0, float x = 0.0F) {
+  page.begin_line(y0, y0 + 12.0F);
+  for (const char32_t c : text) {
+    page.add_char(c, x, x + 10.0F);
+    x += 10.0F;
+  }
+}
+
+pdf::PageText two_lines() {
+  pdf::PageText page;
+  add_line(page, U"Hello World", 0.0F);
+  add_line(page, U"second line", 20.0F, 5.0F);
+  page.shrink_to_fit();
+  return page;
+}
+}  // namespace
+
+TEST(PageTextTest, LinesEndWithNewline) {
+  const auto page = two_lines();
+  EXPECT_EQ(page.text(), "Hello World\nsecond line\n");
+  EXPECT_GT(page.bytes(), page.text().size());
+}
+
+TEST(PageTextTest, EmptyLinesAreDropped) {
+  pdf::PageText page;
+  page.begin_line(0.0F, 10.0F);
+  add_line(page, U"text", 20.0F);
+  page.begin_line(40.0F, 50.0F);
+  page.end_line();
+  EXPECT_EQ(page.text(), "text\n");
+}
+
+TEST(PageTextTest, FindIgnoresAsciiCase) {
+  const auto page = two_lines();
+  EXPECT_EQ(page.find("world"), (std::vector<std::uint32_t>{6}));
+  EXPECT_EQ(page.find("LINE"), (std::vector<std::uint32_t>{19}));
+  EXPECT_TRUE(page.find("absent").empty());
+  EXPECT_TRUE(page.find("").empty());
+}
+
+TEST(PageTextTest, FindMatchesDoNotOverlap) {
+  pdf::PageText page;
+  add_line(page, U"aaaa", 0.0F);
+  page.end_line();
+  EXPECT_EQ(page.find("aa"), (std::vector<std::uint32_t>{0, 2}));
+}
+
+TEST(PageTextTest, SpaceMatchesLineBreak) {
+  const auto page = two_lines();
+  EXPECT_EQ(page.find("world second"), (std::vector<std::uint32_t>{6}));
+}
+
+TEST(PageTextTest, RectsCoverMatchOnOneLine) {
+  const auto page = two_lines();
+  const auto rects = page.rects(6, 5);  // "World"
+  ASSERT_EQ(rects.size(), 1U);
+  EXPECT_FLOAT_EQ(rects[0].x0, 60.0F);
+  EXPECT_FLOAT_EQ(rects[0].x1, 110.0F);
+  EXPECT_FLOAT_EQ(rects[0].y0, 0.0F);
+  EXPECT_FLOAT_EQ(rects[0].y1, 12.0F);
+}
+
+TEST(PageTextTest, RectsSplitAcrossLines) {
+  const auto page = two_lines();
+  const auto rects = page.rects(6, 12);  // "World\nsecond"
+  ASSERT_EQ(rects.size(), 2U);
+  EXPECT_FLOAT_EQ(rects[0].x0, 60.0F);
+  EXPECT_FLOAT_EQ(rects[0].x1, 110.0F);
+  EXPECT_FLOAT_EQ(rects[1].x0, 5.0F);
+  EXPECT_FLOAT_EQ(rects[1].x1, 65.0F);
+  EXPECT_FLOAT_EQ(rects[1].y0, 20.0F);
+}
+
+TEST(PageTextTest, RectsCountCodePointsNotBytes) {
+  pdf::PageText page;
+  add_line(page, U"été ete", 0.0F);  // two 2-byte characters before the space
+  page.end_line();
+  const auto offsets = page.find("ete");
+  ASSERT_EQ(offsets.size(), 1U);
+  const auto rects = page.rects(offsets[0], 3);
+  ASSERT_EQ(rects.size(), 1U);
+  EXPECT_FLOAT_EQ(rects[0].x0, 40.0F);
+  EXPECT_FLOAT_EQ(rects[0].x1, 70.0F);
+}
+
+TEST(PageTextTest, NormalizeQueryCollapsesWhitespace) {
+  EXPECT_EQ(pdf::PageText::normalize_query("  hello \t  world \n"), "hello world");
+  EXPECT_EQ(pdf::PageText::normalize_query(" \t "), "");
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+#include "render/parallelism.h"
+
+using namespace std::chrono_literals;
+
+TEST(Parallelism, ParsesCpuMax) {
+  EXPECT_DOUBLE_EQ(parallelism::parse_cpu_max("200000 100000\n").value(), 2.0);
+  EXPECT_DOUBLE_EQ(parallelism::parse_cpu_max("50000 100000").value(), 0.5);
+  EXPECT_FALSE(parallelism::parse_cpu_max("max 100000\n").has_value());
+  EXPECT_FALSE(parallelism::parse_cpu_max("").has_value());
+  EXPECT_FALSE(parallelism::parse_cpu_max("100000").has_value());
+}
+
+TEST(Parallelism, ReadsQuotaFromCgroupRoot) {
+  const auto root = std::filesystem::temp_directory_path() /
+                    std::format("pdvu_cgroup_test_{}", getpid());
+  std::filesystem::create_directories(root);
+  EXPECT_FALSE(parallelism::cpu_quota(root).has_value());
+  std::ofstream(root / "cpu.max") << "150000 100000\n";
+  EXPECT_DOUBLE_EQ(parallelism::cpu_quota(root).value(), 1.5);
+  std::filesystem::remove_all(root);
+}
+
+TEST(Parallelism, AvailableCpusIsPositive) { EXPECT_GE(parallelism::available_cpus(), 1); }
+
+TEST(Parallelism, ParsesProcStat) {
+  const auto times =
+      parallelism::parse_proc_stat("cpu  10 1 5 100 4 2 3 0 7 0\ncpu0 1 2 3 4 5 6 7 8 9 10\n");
+  ASSERT_TRUE(times.has_value());
+  EXPECT_EQ(times->busy, 10U + 1 + 5 + 2 + 3);
+  EXPECT_EQ(times->total, times->busy + 100 + 4);
+  EXPECT_FALSE(parallelism::parse_proc_stat("intr 1 2 3").has_value());
+  EXPECT_FALSE(parallelism::parse_proc_stat("cpu 1 2").has_value());
+}
+
+TEST(Parallelism, HeadroomStaysWithinAvailableCpus) {
+  parallelism::LoadMonitor monitor(0ms);
+  for (int i = 0; i < 3; i++) {
+    const int headroom = monitor.headroom();
+    EXPECT_GE(headroom, 1);
+    EXPECT_LE(headroom, parallelism::available_cpus());
+  }
+}
+
+TEST(StripTuner, UnmeasuredPagesUseEveryStrip) {
+  const parallelism::StripTuner tuner(8, 1000us);
+  EXPECT_EQ(tuner.choose(0, 1'000'000, 8), 8);
+  EXPECT_EQ(tuner.choose(0, 1'000'000, 3), 3);  // limited by free CPUs
+  EXPECT_EQ(tuner.choose(0, 1'000'000, 0), 1);
+}
+
+TEST(StripTuner, StripsFollowPredictedWork) {
+  parallelism::StripTuner tuner(8, 1000us);
+  tuner.record(0, 1'000'000, 500us);  // cheap text page
+  tuner.record(1, 1'000'000, 20ms);   // heavy image page
+  EXPECT_EQ(tuner.choose(0, 1'000'000, 8), 1);
+  EXPECT_EQ(tuner.choose(1, 1'000'000, 8), 8);
+  EXPECT_EQ(tuner.choose(1, 1'000'000, 4), 4);
+  // a quarter of the pixels, e.g. zoomed out, needs 5ms: five strips
+  EXPECT_EQ(tuner.choose(1, 250'000, 8), 5);
+}
+
+TEST(StripTuner, UnseenPagesUseAverageCost) {
+  parallelism::StripTuner tuner(8, 1000us);
+  tuner.record(0, 1'000'000, 4ms);
+  EXPECT_EQ(tuner.predict(7, 1'000'000), std::chrono::nanoseconds(4ms));
+  EXPECT_EQ(tuner.choose(7, 1'000'000, 8), 4);
+}
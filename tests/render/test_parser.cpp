@@ -1,15 +1,24 @@
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include "gmock/gmock-matchers.h"
 #include "render/parser.h"
 #include "render/pdf_constants.h"
+#include "render/progressive_source.h"
+#include "utils/metrics.h"
 
 namespace {
 constexpr std::string_view g_fixtures_dir = PDVU_TEST_FIXTURES_DIR;
@@ -180,6 +189,200 @@ TEST(MuPDFIntegration, MovedParserCanBeDuplicated) {
   }
 }
 
+TEST(MuPDFIntegration, IndependentDuplicateRendersLikeClone) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("single_page.pdf")));
+  const auto ps = parser.page_specs(0);
+  ASSERT_TRUE(ps.has_value());
+  const pdf::Rect clip{
+      .x0 = static_cast<float>(ps->x0),
+      .y0 = static_cast<float>(ps->y0),
+      .x1 = static_cast<float>(ps->x1),
+      .y1 = static_cast<float>(ps->y1),
+  };
+
+  auto render = [&](pdf::Parser& p) {
+    std::vector<unsigned char> buffer(ps->size, 0xCD);
+    const auto dlist = p.get_display_list(0);
+    EXPECT_TRUE(dlist.has_value());
+    if (dlist.has_value()) {
+      p.write_section(ps->width, ps->height, 1.0F, *ps, *dlist, buffer.data(), clip);
+    }
+    return buffer;
+  };
+  const auto cloned = parser.duplicate();
+  const auto independent = parser.duplicate_independent();
+  EXPECT_EQ(independent->num_pages(), cloned->num_pages());
+  EXPECT_EQ(render(*independent), render(*cloned));
+}
+
+TEST(MuPDFIntegration, DeferredDuplicatesOpenOnOtherThreads) {
+  auto loaded = std::make_unique<pdf::MuPDFParser>(false);
+  ASSERT_TRUE(loaded->load_document(pdf_file_path("multi_page.pdf")));
+  const auto expected = loaded->page_specs(1);
+  auto cloned = loaded->duplicate_deferred(false);
+  auto independent = loaded->duplicate_deferred(true);
+  loaded.reset();  // the deferred halves must not need the source parser
+
+  std::unique_ptr<pdf::Parser> from_clone;
+  std::unique_ptr<pdf::Parser> from_independent;
+  std::thread first([&] { from_clone = cloned(); });
+  std::thread second([&] { from_independent = independent(); });
+  first.join();
+  second.join();
+  ASSERT_NE(from_clone, nullptr);
+  ASSERT_NE(from_independent, nullptr);
+  EXPECT_EQ(from_clone->page_specs(1), expected);
+  EXPECT_EQ(from_independent->page_specs(1), expected);
+}
+
+TEST(MuPDFIntegration, RepairedDocumentIsRepairedOnceForDuplicates) {
+  auto& saves = metrics::registry().histogram("mupdf.repaired_copy_save");
+  const auto saves_before = saves.count();
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("damaged_xref.pdf")));
+  const auto first = parser.duplicate();
+  const auto second = parser.duplicate_independent();
+  const auto nested = first->duplicate();
+  EXPECT_EQ(saves.count(), saves_before + 1);
+
+  for (const auto* duplicate : {first.get(), second.get(), nested.get()}) {
+    EXPECT_EQ(duplicate->get_document_name(), "damaged_xref.pdf");
+    ASSERT_EQ(duplicate->num_pages(), parser.num_pages());
+    for (int page = 0; page < parser.num_pages(); page++) {
+      EXPECT_EQ(duplicate->page_specs(page), parser.page_specs(page));
+    }
+  }
+}
+
+TEST(MuPDFIntegration, IntactDocumentIsNotCopied) {
+  auto& saves = metrics::registry().histogram("mupdf.repaired_copy_save");
+  const auto saves_before = saves.count();
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("multi_page.pdf")));
+  const auto duplicate = parser.duplicate();
+  EXPECT_EQ(saves.count(), saves_before);
+}
+
+TEST(MuPDFIntegration, MemoryMappedInputMatchesFileInput) {
+  for (const auto* fixture : {"multi_page.pdf", "damaged_xref.pdf"}) {
+    pdf::MuPDFParser from_file(false);
+    pdf::MuPDFParser mapped(false, pdf::DocumentInput::MemoryMap);
+    ASSERT_TRUE(from_file.load_document(pdf_file_path(fixture)));
+    ASSERT_TRUE(mapped.load_document(pdf_file_path(fixture)));
+    const auto cloned = mapped.duplicate();
+    const auto independent = mapped.duplicate_independent();
+    for (const pdf::Parser* parser : {static_cast<const pdf::Parser*>(&mapped),
+                                      static_cast<const pdf::Parser*>(cloned.get()),
+                                      static_cast<const pdf::Parser*>(independent.get())}) {
+      EXPECT_EQ(parser->get_document_name(), fixture);
+      ASSERT_EQ(parser->num_pages(), from_file.num_pages()) << fixture;
+      for (int page = 0; page < from_file.num_pages(); page++) {
+        EXPECT_EQ(parser->page_specs(page), from_file.page_specs(page)) << fixture;
+      }
+    }
+  }
+}
+
+TEST(MuPDFIntegration, MemoryMappedInputRejectsInvalidFile) {
+  pdf::MuPDFParser parser(false, pdf::DocumentInput::MemoryMap);
+  EXPECT_FALSE(parser.load_document(pdf_file_path("not_a_pdf.pdf")));
+  EXPECT_EQ(parser.num_pages(), 0);
+}
+
+TEST(MuPDFIntegration, StreamedDocumentMatchesFile) {
+  std::ifstream file(pdf_file_path("multi_page.pdf"), std::ios::binary);
+  const std::string contents{std::istreambuf_iterator<char>(file), {}};
+  ASSERT_FALSE(contents.empty());
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  // a slow writer: the document is not linearized, so it opens once the last piece lands
+  std::thread writer([fd = fds[1], &contents] {
+    for (std::size_t offset = 0; offset < contents.size(); offset += 512) {
+      const std::string_view piece = std::string_view(contents).substr(offset, 512);
+      if (write(fd, piece.data(), piece.size()) != static_cast<ssize_t>(piece.size())) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    close(fd);
+  });
+  auto source = std::make_shared<pdf::ProgressiveSource>(fds[0], "multi_page.pdf");
+
+  pdf::MuPDFParser from_file(false);
+  pdf::MuPDFParser streamed(false);
+  ASSERT_TRUE(from_file.load_document(pdf_file_path("multi_page.pdf")));
+  const bool loaded = streamed.load_progressive(source);
+  writer.join();
+  ASSERT_TRUE(loaded);
+  EXPECT_TRUE(from_file.load_progress().complete);
+
+  const auto progress = streamed.load_progress();
+  EXPECT_TRUE(progress.complete);
+  EXPECT_EQ(progress.received, contents.size());
+  EXPECT_EQ(progress.expected, contents.size());
+  const auto cloned = streamed.duplicate();
+  const auto independent = streamed.duplicate_independent();
+  for (const pdf::Parser* parser : {static_cast<const pdf::Parser*>(&streamed),
+                                    static_cast<const pdf::Parser*>(cloned.get()),
+                                    static_cast<const pdf::Parser*>(independent.get())}) {
+    EXPECT_EQ(parser->get_document_name(), "multi_page.pdf");
+    ASSERT_EQ(parser->num_pages(), from_file.num_pages());
+    for (int page = 0; page < from_file.num_pages(); page++) {
+      EXPECT_EQ(parser->page_specs(page), from_file.page_specs(page));
+    }
+  }
+}
+
+TEST(MuPDFIntegration, StreamedInvalidDocumentFailsOnceComplete) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  constexpr std::string_view garbage = "this is not a pdf";
+  ASSERT_EQ(write(fds[1], garbage.data(), garbage.size()), static_cast<ssize_t>(garbage.size()));
+  close(fds[1]);
+  pdf::MuPDFParser parser(false);
+  EXPECT_FALSE(parser.load_progressive(std::make_shared<pdf::ProgressiveSource>(fds[0], "bad")));
+  EXPECT_EQ(parser.num_pages(), 0);
+}
+
+TEST(MuPDFIntegration, SharedLocksAreCounted) {
+  const auto before = pdf::mupdf_lock_stats();
+  ASSERT_FALSE(before.empty());
+  EXPECT_EQ(before[0].name, "alloc");
+
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("single_page.pdf")));
+  ASSERT_TRUE(parser.get_display_list(0).has_value());
+
+  const auto after = pdf::mupdf_lock_stats();
+  ASSERT_EQ(after.size(), before.size());
+  EXPECT_GT(after[0].acquisitions, before[0].acquisitions);
+  for (const auto& lock : after) {
+    EXPECT_LE(lock.contended, lock.acquisitions) << lock.name;
+  }
+}
+
+TEST(MuPDFIntegration, ContextMemoryIsAttributedPerFamily) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("single_page.pdf")));
+  const auto clone = parser.duplicate();
+  const auto independent = parser.duplicate_independent();
+  ASSERT_TRUE(clone->get_display_list(0).has_value());
+  ASSERT_TRUE(independent->get_display_list(0).has_value());
+
+  // the newest two families are the parser with its clone, then the independent context
+  const auto contexts = pdf::mupdf_context_memory();
+  ASSERT_GE(contexts.size(), 2U);
+  const auto& shared = contexts[contexts.size() - 2];
+  const auto& own = contexts.back();
+  EXPECT_FALSE(shared.independent);
+  EXPECT_TRUE(own.independent);
+  for (const auto& context : {shared, own}) {
+    EXPECT_GT(context.live_bytes, 0U) << context.name;
+    EXPECT_GE(context.peak_bytes, context.live_bytes) << context.name;
+  }
+}
+
 TEST(MuPDFIntegration, DisplayListCanOutliveParser) {
   // It should not be the case where a display list outlives a parser
   // but since it is exposed to the client side, we want to make sure
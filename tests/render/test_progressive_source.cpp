@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "render/progressive_source.h"
+
+namespace {
+/**
+ * @brief Writes contents into a pipe in pieces, sleeping between them, then closes it.
+ * @return The read end, for a ProgressiveSource to own.
+ */
+int throttled_pipe(std::string contents, std::size_t piece, std::chrono::milliseconds delay,
+                   std::thread& writer) {
+  int fds[2];
+  if (pipe(fds) == -1) {
+    return -1;
+  }
+  writer = std::thread([fd = fds[1], contents = std::move(contents), piece, delay] {
+    for (std::size_t offset = 0; offset < contents.size(); offset += piece) {
+      const std::string_view rest = std::string_view(contents).substr(offset, piece);
+      if (write(fd, rest.data(), rest.size()) != static_cast<ssize_t>(rest.size())) {
+        break;
+      }
+      std::this_thread::sleep_for(delay);
+    }
+    close(fd);
+  });
+  return fds[0];
+}
+
+std::string read_all(const pdf::ProgressiveSource& source) {
+  std::string bytes;
+  while (bytes.size() < source.received()) {
+    const auto view = source.view(bytes.size());
+    bytes.append(reinterpret_cast<const char*>(view.data()), view.size());
+  }
+  return bytes;
+}
+}  // namespace
+
+TEST(ProgressiveSourceTest, ReceivesThrottledPipeUntilEof) {
+  std::string contents(std::size_t{3} << 19, '\0');  // spans two buffer chunks
+  for (std::size_t i = 0; i < contents.size(); i++) {
+    contents[i] = static_cast<char>('a' + i % 26);
+  }
+  std::thread writer;
+  const int fd = throttled_pipe(contents, 64 * 1024, std::chrono::milliseconds(2), writer);
+  ASSERT_NE(fd, -1);
+  pdf::ProgressiveSource source(fd, "pipe");
+  EXPECT_EQ(source.name(), "pipe");
+
+  std::size_t seen = 0;
+  int increments = 0;
+  while (!source.complete()) {
+    source.wait_for_more(seen, std::chrono::milliseconds(100));
+    const std::size_t received = source.received();
+    EXPECT_GE(received, seen);
+    increments += received > seen ? 1 : 0;
+    seen = received;
+    if (!source.complete()) {
+      EXPECT_FALSE(source.expected_size().has_value());  // not a linearized PDF
+    }
+  }
+  writer.join();
+
+  EXPECT_GT(increments, 1);  // observed while arriving, not all at once
+  EXPECT_EQ(source.received(), contents.size());
+  EXPECT_EQ(source.expected_size(), contents.size());
+  EXPECT_TRUE(source.view(contents.size()).empty());
+  EXPECT_EQ(read_all(source), contents);
+}
+
+TEST(ProgressiveSourceTest, EmptyPipeCompletesWithNothing) {
+  std::thread writer;
+  const int fd = throttled_pipe("", 1, std::chrono::milliseconds(0), writer);
+  ASSERT_NE(fd, -1);
+  pdf::ProgressiveSource source(fd, "empty");
+  EXPECT_TRUE(source.wait_for_more(0, std::chrono::seconds(5)));
+  writer.join();
+  EXPECT_TRUE(source.complete());
+  EXPECT_EQ(source.received(), 0U);
+  EXPECT_TRUE(source.view(0).empty());
+}
+
+TEST(ProgressiveSourceTest, DeclaredLengthIsKnownBeforeEof) {
+  const std::string head =
+      "%PDF-1.7\n%\xe2\xe3\xcf\xd3\n"
+      "1 0 obj\n<< /Linearized 1 /L 4096 /H [ 600 150 ] /O 3 /E 2000 /N 2 /T 3900 >>\nendobj\n";
+  std::thread writer;
+  // the writer keeps the pipe open long enough to look before the end
+  const int fd = throttled_pipe(head + std::string(100, ' '), head.size(),
+                                std::chrono::milliseconds(300), writer);
+  ASSERT_NE(fd, -1);
+  pdf::ProgressiveSource source(fd, "linearized");
+  ASSERT_TRUE(source.wait_for_more(0, std::chrono::seconds(5)));
+  if (!source.complete()) {
+    EXPECT_EQ(source.expected_size(), 4096U);
+  }
+  writer.join();
+  while (!source.complete()) {
+    source.wait_for_more(source.received(), std::chrono::milliseconds(100));
+  }
+  EXPECT_EQ(source.expected_size(), head.size() + 100);  // what actually arrived wins
+}
+
+TEST(ProgressiveSourceTest, ParsesLinearizedLength) {
+  using pdf::ProgressiveSource;
+  EXPECT_EQ(ProgressiveSource::parse_linearized_length(
+                "%PDF-1.5\n4 0 obj\n<</Linearized 1/L 71436/O 6/E 67132/N 1/H [ 456 140]>>"),
+            71436U);
+  EXPECT_EQ(ProgressiveSource::parse_linearized_length(
+                "%PDF-1.4\n1 0 obj\n<< /Linearized 1.0\n/L\n 12345 /N 3 >>\nendobj"),
+            12345U);
+  // no dictionary, unterminated dictionary, missing or malformed /L
+  EXPECT_FALSE(ProgressiveSource::parse_linearized_length("%PDF-1.7\n1 0 obj\n<< /Type /Catalog >>")
+                   .has_value());
+  EXPECT_FALSE(
+      ProgressiveSource::parse_linearized_length("%PDF-1.7\n1 0 obj\n<< /Linearized 1 /L 40")
+          .has_value());
+  EXPECT_FALSE(ProgressiveSource::parse_linearized_length("<< /Linearized 1 /N 2 >>").has_value());
+  EXPECT_FALSE(ProgressiveSource::parse_linearized_length("<< /Linearized 1 /L x >>").has_value());
+}
+
+TEST(ProgressiveSourceTest, OpenReportsMissingPath) {
+  const auto source = pdf::ProgressiveSource::open("/nonexistent/pdvu.fifo");
+  ASSERT_FALSE(source.has_value());
+  EXPECT_NE(source.error().find("/nonexistent/pdvu.fifo"), std::string::npos);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+#include "render/parser.h"
+#include "render/render_engine.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr std::string_view g_fixtures_dir = PDVU_TEST_FIXTURES_DIR;
+
+auto pdf_file_path(std::string_view filename) {
+  return std::filesystem::path(g_fixtures_dir) / "pdf" / filename;
+}
+
+std::optional<RenderResult> wait_for_result(RenderEngine& engine, std::size_t req_id) {
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (auto result = engine.get_result(); result && result->req_id == req_id) {
+      return result;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return std::nullopt;
+}
+}  // namespace
+
+TEST(RenderEngine, ResolvesIntentGeometryOnItsOwnThread) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("rotated_page.pdf")));
+  RenderEngine engine(parser, 2, false);
+  const PageIntent intent{
+      .page_num = 0,
+      .zoom = 1.5F,
+      .rotation_degrees = 90,
+      .viewport_width = 300,
+      .viewport_height = 200,
+  };
+  const auto result = wait_for_result(engine, engine.request_page(intent, "tempfile"));
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result->error_message.empty()) << result->error_message;
+
+  const auto [zoom, specs] = resolve_geometry(*parser.page_specs(0), intent);
+  EXPECT_FLOAT_EQ(result->zoom, zoom);
+  EXPECT_EQ(result->rendered_page_specs, specs);
+  EXPECT_FALSE(result->path_to_data.empty());
+}
+
+TEST(RenderEngine, IntentForMissingPageReportsError) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("single_page.pdf")));
+  RenderEngine engine(parser, 1, false);
+  const PageIntent intent{
+      .page_num = parser.num_pages(),
+      .zoom = 1.0F,
+      .rotation_degrees = 0,
+      .viewport_width = 100,
+      .viewport_height = 100,
+  };
+  const auto result = wait_for_result(engine, engine.request_page(intent, "tempfile"));
+  ASSERT_TRUE(result.has_value());
+  EXPECT_FALSE(result->error_message.empty());
+}
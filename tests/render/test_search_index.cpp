@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "render/page_text.h"
+#include "render/search_index.h"
+
+namespace {
+std::filesystem::path temp_path(std::string_view name) {
+  return std::filesystem::temp_directory_path() / std::format("pdvu_{}_{}", name, getpid());
+}
+
+/// A page of one line per string, 10 units per character.
+pdf::PageText page_of(const std::vector<std::string_view>& lines) {
+  pdf::PageText page;
+  float y = 0.0F;
+  for (const auto line : lines) {
+    page.begin_line(y, y + 12.0F);
+    float x = 0.0F;
+    for (const char c : line) {
+      page.add_char(static_cast<char32_t>(c), x, x + 10.0F);
+      x += 10.0F;
+    }
+    y += 20.0F;
+  }
+  page.shrink_to_fit();
+  return page;
+}
+
+std::vector<pdf::PageText> sample_pages() {
+  std::vector<pdf::PageText> pages;
+  pages.push_back(page_of({"Introduction to algorithms", "sorting in linear time"}));
+  pages.push_back(page_of({}));  // no text at all
+  pages.push_back(page_of({"Linear programming", "and the simplex"}));
+  pages.push_back(page_of({"Graph algorithms"}));
+  return pages;
+}
+
+constexpr pdf::DocumentKey SAMPLE_KEY{.size = 1234, .hash = 0x5eed};
+}  // namespace
+
+TEST(SearchIndexTest, RoundTripsPages) {
+  const auto path = temp_path("index_round_trip.idx");
+  const auto pages = sample_pages();
+  ASSERT_TRUE(pdf::SearchIndex::write(path, SAMPLE_KEY, pages).has_value());
+  {
+    const auto index = pdf::SearchIndex::open(path, SAMPLE_KEY);
+    ASSERT_TRUE(index.has_value()) << index.error();
+    ASSERT_EQ(index->num_pages(), 4);
+    for (int i = 0; i < 4; i++) {
+      const auto stored = index->page(i);
+      const auto original = pages[static_cast<std::size_t>(i)].view();
+      EXPECT_EQ(stored.text(), original.text());
+      EXPECT_EQ(stored.lines().size(), original.lines().size());
+      EXPECT_EQ(stored.edges().size(), original.edges().size());
+    }
+    const auto rects = index->page(2).rects(index->page(2).find("simplex").front(), 7);
+    ASSERT_EQ(rects.size(), 1U);
+    EXPECT_FLOAT_EQ(rects[0].x0, 80.0F);
+    EXPECT_FLOAT_EQ(rects[0].y0, 20.0F);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(SearchIndexTest, CandidatePagesContainEveryTrigram) {
+  const auto path = temp_path("index_candidates.idx");
+  ASSERT_TRUE(pdf::SearchIndex::write(path, SAMPLE_KEY, sample_pages()).has_value());
+  {
+    const auto index = pdf::SearchIndex::open(path, SAMPLE_KEY);
+    ASSERT_TRUE(index.has_value()) << index.error();
+    EXPECT_EQ(index->candidate_pages("algorithms"), (std::vector<int>{0, 3}));
+    EXPECT_EQ(index->candidate_pages("LINEAR"), (std::vector<int>{0, 2}));  // case folded
+    // a space also stands for the line break between "programming" and "and"
+    EXPECT_EQ(index->candidate_pages("programming and"), (std::vector<int>{2}));
+    EXPECT_TRUE(index->candidate_pages("quicksort").empty());
+    EXPECT_EQ(index->candidate_pages("in"), (std::vector<int>{0, 1, 2, 3}));  // too short
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(SearchIndexTest, RejectsOtherDocumentsAndDamagedFiles) {
+  const auto path = temp_path("index_damaged.idx");
+  ASSERT_TRUE(pdf::SearchIndex::write(path, SAMPLE_KEY, sample_pages()).has_value());
+  EXPECT_FALSE(pdf::SearchIndex::open(path, {.size = 1234, .hash = 0xbad}).has_value());
+
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+  EXPECT_FALSE(pdf::SearchIndex::open(path, SAMPLE_KEY).has_value());
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "not an index";
+  EXPECT_FALSE(pdf::SearchIndex::open(path, SAMPLE_KEY).has_value());
+  std::filesystem::remove(path);
+  EXPECT_FALSE(pdf::SearchIndex::open(path, SAMPLE_KEY).has_value());
+}
+
+TEST(SearchIndexTest, DocumentKeyFollowsContents) {
+  const auto first = temp_path("key_first.pdf");
+  const auto second = temp_path("key_second.pdf");
+  std::ofstream(first, std::ios::binary) << "%PDF-1.7 same bytes";
+  std::ofstream(second, std::ios::binary) << "%PDF-1.7 same bytes";
+  const auto a = pdf::DocumentKey::of(first);
+  const auto b = pdf::DocumentKey::of(second);
+  ASSERT_TRUE(a.has_value() && b.has_value());
+  EXPECT_EQ(*a, *b);  // renamed copies share an index
+  EXPECT_EQ(a->size, 19U);
+  EXPECT_EQ(a->file_stem(), b->file_stem());
+
+  std::ofstream(second, std::ios::binary | std::ios::trunc) << "%PDF-1.7 new bytes!";
+  const auto changed = pdf::DocumentKey::of(second);
+  ASSERT_TRUE(changed.has_value());
+  EXPECT_NE(*changed, *a);
+  EXPECT_FALSE(pdf::DocumentKey::of("/nonexistent/pdvu.pdf").has_value());
+  std::filesystem::remove(first);
+  std::filesystem::remove(second);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "render/parser.h"
+#include "render/text_search.h"
+
+namespace {
+constexpr std::string_view g_fixtures_dir = PDVU_TEST_FIXTURES_DIR;
+
+auto pdf_file_path(std::string_view filename) {
+  return std::filesystem::path{g_fixtures_dir} / "pdf" / filename;
+}
+
+std::vector<int> hit_pages(const std::vector<pdf::SearchHit>& hits) {
+  std::vector<int> pages;
+  for (const auto& hit : hits) {
+    pages.push_back(hit.page_num);
+  }
+  return pages;
+}
+}  // namespace
+
+TEST(TextSearchTest, FindsEveryPageFromStartPageOnward) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("multi_page.pdf")));
+  pdf::TextSearch search(parser, 2);
+
+  const auto id = search.start("PAGE", 1);
+  search.wait();
+  const auto hits = search.take_hits();
+  EXPECT_EQ(hit_pages(hits), (std::vector<int>{1, 2, 0}));  // wraps around the end
+  for (const auto& hit : hits) {
+    ASSERT_EQ(hit.rects.size(), 1U);
+    EXPECT_LT(hit.rects[0].x0, hit.rects[0].x1);
+    EXPECT_LT(hit.rects[0].y0, hit.rects[0].y1);
+  }
+  const auto status = search.status();
+  EXPECT_EQ(status.search_id, id);
+  EXPECT_TRUE(status.done);
+  EXPECT_EQ(status.pages_scanned, 3);
+  EXPECT_EQ(status.total_pages, 3);
+  EXPECT_EQ(status.hits, 3U);
+  EXPECT_TRUE(search.take_hits().empty());  // taken already
+  EXPECT_GT(search.cached_bytes(), 0U);
+}
+
+TEST(TextSearchTest, LaterSearchesReuseExtractedText) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("multi_page.pdf")));
+  pdf::TextSearch search(parser, 1);
+
+  search.start("page", 0);
+  search.wait();
+  const auto cached = search.cached_bytes();
+  search.start("400  x 100", 0);  // whitespace is normalized
+  search.wait();
+  EXPECT_EQ(hit_pages(search.take_hits()), (std::vector<int>{1}));
+  EXPECT_EQ(search.cached_bytes(), cached);
+}
+
+TEST(TextSearchTest, EmptyQueryIsDoneAtOnce) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("single_page.pdf")));
+  pdf::TextSearch search(parser, 2);
+
+  search.start("  ", 0);
+  search.wait();
+  EXPECT_TRUE(search.status().done);
+  EXPECT_TRUE(search.take_hits().empty());
+}
+
+TEST(TextSearchTest, CancelDropsHits) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("multi_page.pdf")));
+  pdf::TextSearch search(parser, 2);
+
+  search.start("page", 0);
+  search.cancel();
+  search.wait();
+  EXPECT_TRUE(search.status().done);
+  EXPECT_TRUE(search.take_hits().empty());
+}
@@ -1,8 +1,13 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <future>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "render/threadpool.h"
 
@@ -96,4 +101,66 @@ TEST(ThreadPoolTest, MultipleWorkersExecuteConcurrently) {
   EXPECT_TRUE(both_started);
   EXPECT_NO_THROW(first.get());
   EXPECT_NO_THROW(second.get());
-}
\ No newline at end of file
+}
+
+TEST(ThreadPoolTest, ParallelForRunsEveryIndexOnce) {
+  constexpr std::size_t n = 64;
+  ThreadPool pool{3};
+  std::vector<std::atomic<int>> runs(n);
+  pool.parallel_for(n, [&](std::size_t i) { runs[i].fetch_add(1); });
+  for (std::size_t i = 0; i < n; i++) {
+    EXPECT_EQ(runs[i].load(), 1) << i;
+  }
+  pool.parallel_for(0, [](std::size_t) { FAIL(); });
+}
+
+TEST(ThreadPoolTest, ParallelForRunsFirstIndexOnCaller) {
+  ThreadPool pool{2};
+  std::thread::id first_index_thread;
+  pool.parallel_for(3, [&](std::size_t i) {
+    if (i == 0) {
+      first_index_thread = std::this_thread::get_id();
+    }
+  });
+  EXPECT_EQ(first_index_thread, std::this_thread::get_id());
+}
+
+TEST(ThreadPoolTest, ParallelForRethrowsAfterAllIndicesFinish) {
+  using namespace std::chrono_literals;
+  ThreadPool pool{2};
+  std::atomic<int> finished = 0;
+  EXPECT_THROW(pool.parallel_for(4,
+                                 [&](std::size_t i) {
+                                   if (i == 1) {
+                                     throw std::runtime_error("error in strip");
+                                   }
+                                   std::this_thread::sleep_for(5ms);
+                                   finished.fetch_add(1);
+                                 }),
+               std::runtime_error);
+  EXPECT_EQ(finished.load(), 3);
+}
+
+TEST(InplaceTaskTest, StoresMoveOnlyCallables) {
+  auto value = std::make_unique<int>(7);
+  int seen = 0;
+  InplaceTask task([&seen, value = std::move(value)] { seen = *value; });
+  InplaceTask moved = std::move(task);
+  EXPECT_FALSE(static_cast<bool>(task));  // NOLINT(bugprone-use-after-move)
+  ASSERT_TRUE(static_cast<bool>(moved));
+  moved();
+  EXPECT_EQ(seen, 7);
+}
+
+TEST(InplaceTaskTest, LargeCallablesAreDestroyedOnce) {
+  auto alive = std::make_shared<int>(0);
+  std::array<char, 2 * InplaceTask::INLINE_SIZE> padding{};
+  {
+    InplaceTask task([alive, padding] { (void)padding; });
+    InplaceTask other;
+    other = std::move(task);
+    EXPECT_EQ(alive.use_count(), 2);
+    other();
+  }
+  EXPECT_EQ(alive.use_count(), 1);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "render/parser.h"
+#include "render/thumbnails.h"
+
+namespace {
+constexpr std::string_view g_fixtures_dir = PDVU_TEST_FIXTURES_DIR;
+
+auto pdf_file_path(std::string_view filename) {
+  return std::filesystem::path{g_fixtures_dir} / "pdf" / filename;
+}
+
+constexpr geometry::PixelSize BOX{.width = 100, .height = 100};
+}  // namespace
+
+TEST(ThumbnailTest, PacksToTwoBytesPerPixel) {
+  // white, black, red and blue, with two padding bytes after each row
+  const std::array<unsigned char, 16> rgb = {
+      255, 255, 255, 0, 0, 0, 9, 9, 255, 0, 0, 0, 0, 255, 9, 9,
+  };
+  const auto thumbnail = pdf::Thumbnail::pack(rgb.data(), 2, 2, 8);
+  EXPECT_EQ(thumbnail.bytes(), 8U);
+
+  std::array<unsigned char, 12> unpacked{};
+  thumbnail.unpack(unpacked.data(), 6);
+  EXPECT_EQ(unpacked, (std::array<unsigned char, 12>{255, 255, 255, 0, 0, 0,  //
+                                                     255, 0, 0, 0, 0, 255}));
+}
+
+TEST(ThumbnailCacheTest, FitsPagesInBox) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("multi_page.pdf")));
+  pdf::ThumbnailCache cache(parser, 2);
+
+  const std::vector<int> pages = {0, 1, 2, 7};  // 7 is out of range
+  cache.request(pages, BOX, 0);
+  cache.wait();
+  auto rendered = cache.take_rendered();
+  std::ranges::sort(rendered);
+  EXPECT_EQ(rendered, (std::vector<int>{0, 1, 2}));
+  EXPECT_TRUE(cache.take_rendered().empty());
+  const auto tall = cache.get(0);  // 200 x 300
+  const auto wide = cache.get(1);  // 400 x 100
+  ASSERT_NE(tall, nullptr);
+  ASSERT_NE(wide, nullptr);
+  EXPECT_EQ(tall->height, 100);
+  EXPECT_LE(tall->width, 67);
+  EXPECT_EQ(wide->width, 100);
+  EXPECT_EQ(wide->height, 25);
+  EXPECT_EQ(cache.get(7), nullptr);
+  EXPECT_EQ(cache.cached_bytes(), tall->bytes() + wide->bytes() + cache.get(2)->bytes());
+
+  cache.request(pages, BOX, 90);  // rotating renders everything again
+  cache.wait();
+  const auto turned = cache.get(0);
+  ASSERT_NE(turned, nullptr);
+  EXPECT_EQ(turned->width, 100);
+  EXPECT_LE(turned->height, 67);
+}
+
+TEST(ThumbnailCacheTest, EvictsFarthestUnrequestedPagesPastBudget) {
+  pdf::MuPDFParser parser(false);
+  ASSERT_TRUE(parser.load_document(pdf_file_path("multi_page.pdf")));
+  // pages 1 and 2 take 5000 and 20000 bytes, page 0 about 13400
+  pdf::ThumbnailCache cache(parser, 2, 25000);
+
+  cache.request(std::vector<int>{0, 1, 2}, BOX, 0);
+  cache.wait();
+  // requested pages are kept even past the budget, so the grid showing them can fill
+  EXPECT_NE(cache.get(0), nullptr);
+  EXPECT_NE(cache.get(1), nullptr);
+  EXPECT_NE(cache.get(2), nullptr);
+
+  cache.request(std::vector<int>{2}, BOX, 0);
+  cache.wait();
+  EXPECT_EQ(cache.get(0), nullptr);  // farthest from page 2, dropped first
+  EXPECT_NE(cache.get(1), nullptr);
+  EXPECT_NE(cache.get(2), nullptr);
+  EXPECT_LE(cache.cached_bytes(), 25000U);
+}
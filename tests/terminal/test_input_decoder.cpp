@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <string_view>
+#include <vector>
+
+#include "terminal/input_decoder.h"
+
+namespace {
+std::vector<InputEvent> decode(std::string_view bytes) {
+  terminal::InputDecoder decoder;
+  std::vector<InputEvent> events;
+  decoder.feed(bytes, events);
+  return events;
+}
+
+void expect_keys(const std::vector<InputEvent>& events, const std::vector<InputEvent>& expected) {
+  ASSERT_EQ(events.size(), expected.size());
+  for (std::size_t i = 0; i < events.size(); i++) {
+    EXPECT_EQ(events[i].key, expected[i].key) << "event " << i;
+    EXPECT_EQ(events[i].char_value, expected[i].char_value) << "event " << i;
+  }
+}
+}  // namespace
+
+TEST(InputDecoder, PlainBytesDecodeToKeys) {
+  expect_keys(decode("ab\r\t\x7f\x01"),
+              {
+                  {.key = key_char, .char_value = 'a'},
+                  {.key = key_char, .char_value = 'b'},
+                  {.key = key_enter},
+                  {.key = key_tab},
+                  {.key = key_backspace},
+                  {.key = key_ctrl_char, .char_value = '\x01'},
+              });
+}
+
+TEST(InputDecoder, BatchOfArrowsDecodesEveryEvent) {
+  // key-repeat delivers many sequences in a single read
+  expect_keys(decode("\x1b[C\x1b[C\x1b[D\x1bOA\x1b[B"),
+              {
+                  {.key = key_right_arrow},
+                  {.key = key_right_arrow},
+                  {.key = key_left_arrow},
+                  {.key = key_up_arrow},
+                  {.key = key_down_arrow},
+              });
+}
+
+TEST(InputDecoder, ModifiedArrowsAndDelete) {
+  expect_keys(decode("\x1b[1;3C\x1b[3~\x1b[5~"),
+              {
+                  {.key = key_right_arrow},
+                  {.key = key_delete},
+              });
+}
+
+TEST(InputDecoder, AltSequences) {
+  expect_keys(decode("\x1b"
+                     "f\x1b\x7f"),
+              {
+                  {.key = key_alt_char, .char_value = 'f'},
+                  {.key = key_alt_backspace},
+              });
+}
+
+TEST(InputDecoder, KittyKeyboardProtocol) {
+  expect_keys(decode("\x1b[27u\x1b[97u\x1b[97;2u\x1b[99;5u\x1b[102;3u\x1b[127;3u\x1b[13u"),
+              {
+                  {.key = key_escape},
+                  {.key = key_char, .char_value = 'a'},
+                  {.key = key_char, .char_value = 'A'},
+                  {.key = key_ctrl_char, .char_value = '\x03'},
+                  {.key = key_alt_char, .char_value = 'f'},
+                  {.key = key_alt_backspace},
+                  {.key = key_enter},
+              });
+}
+
+TEST(InputDecoder, KittySubParametersAreIgnored) {
+  // shifted key and event type reported through ':' sub-parameters
+  expect_keys(decode("\x1b[97:65;2:1u"), {{.key = key_char, .char_value = 'A'}});
+}
+
+TEST(InputDecoder, PrivateRepliesAreDropped) {
+  // e.g. reply to a keyboard protocol query, must not turn into key presses
+  expect_keys(decode("\x1b[?1u"
+                     "q"),
+              {{.key = key_char, .char_value = 'q'}});
+}
+
+TEST(InputDecoder, SplitSequenceCompletesAcrossFeeds) {
+  terminal::InputDecoder decoder;
+  std::vector<InputEvent> events;
+  decoder.feed("\x1b", events);
+  EXPECT_TRUE(events.empty());
+  EXPECT_TRUE(decoder.has_pending());
+
+  decoder.feed("[", events);
+  EXPECT_TRUE(decoder.has_pending());
+
+  decoder.feed("C", events);
+  EXPECT_FALSE(decoder.has_pending());
+  expect_keys(events, {{.key = key_right_arrow}});
+}
+
+TEST(InputDecoder, FlushResolvesLoneEscape) {
+  terminal::InputDecoder decoder;
+  std::vector<InputEvent> events;
+  decoder.feed("q\x1b", events);
+  ASSERT_TRUE(decoder.has_pending());
+
+  decoder.flush(events);
+  EXPECT_FALSE(decoder.has_pending());
+  expect_keys(events,
+              {
+                  {.key = key_char, .char_value = 'q'},
+                  {.key = key_escape},
+              });
+}
+
+TEST(InputDecoder, DoubleEscapeEmitsEscapeAndKeepsPending) {
+  terminal::InputDecoder decoder;
+  std::vector<InputEvent> events;
+  decoder.feed("\x1b\x1b", events);
+  expect_keys(events, {{.key = key_escape}});
+  EXPECT_TRUE(decoder.has_pending());
+}
+
+TEST(InputDecoder, ControlByteAbortsSequence) {
+  // an interrupted sequence is dropped and the control byte is still decoded
+  expect_keys(decode("\x1b[12\r"), {{.key = key_enter}});
+}
+
+TEST(InputDecoder, OverlongSequenceIsDropped) {
+  expect_keys(decode("\x1b[11111111111111111111111111111111C"
+                     "a"),
+              {{.key = key_char, .char_value = 'a'}});
+}
+
+TEST(InputDecoder, NonAsciiBytesAreIgnored) {
+  expect_keys(decode("\xc3\xa9z"), {{.key = key_char, .char_value = 'z'}});
+}
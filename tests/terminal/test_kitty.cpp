@@ -122,3 +122,41 @@ TEST(KittyProtocol, PathEncoding) {
     EXPECT_TRUE(result.contains(expected));
   }
 }
+
+TEST(KittyProtocol, HighlightPlacementStretchesStoredPixel) {
+  const auto images = get_highlight_images();
+  EXPECT_EQ(count_substr(images, "a=t"), 2U);  // other hits and the current one
+  EXPECT_FALSE(images.contains("a=T"));        // stored, not displayed
+
+  const auto other = get_highlight_placement(false, 3, 4, 7, 5, 1);
+  const auto current = get_highlight_placement(true, 3, 4, 7, 5, 1);
+  EXPECT_TRUE(other.starts_with("\x1b_Ga=p"));
+  EXPECT_TRUE(other.contains("p=3"));
+  EXPECT_TRUE(other.contains("X=4"));
+  EXPECT_TRUE(other.contains("Y=7"));
+  EXPECT_TRUE(other.contains("c=5"));
+  EXPECT_TRUE(other.contains("r=1"));
+  EXPECT_TRUE(other.contains("C=1"));
+  EXPECT_NE(other, current);  // distinct image ids
+  EXPECT_EQ(count_substr(clear_highlights(), "a=d"), 2U);
+}
+
+TEST(KittyProtocol, RegionUpdateEditsRootFrame) {
+  const auto result = get_region_sequence("atlas", 4, 0, 240, 900, 120, "shm");
+  EXPECT_TRUE(result.starts_with("\x1b_Ga=f"));
+  EXPECT_TRUE(result.contains("i=4"));
+  EXPECT_TRUE(result.contains("r=1"));  // edit in place, no new animation frame
+  EXPECT_TRUE(result.contains("y=240"));
+  EXPECT_TRUE(result.contains("s=900"));
+  EXPECT_TRUE(result.contains("v=120"));
+  EXPECT_TRUE(result.contains("t=s"));
+  EXPECT_TRUE(result.ends_with(detail::base64_encode("atlas") + "\x1b\\"));
+
+  const auto crop = get_crop_placement(4, 7, {.x = 180, .y = 0, .width = 90, .height = 120}, 3, 0);
+  EXPECT_TRUE(crop.contains("a=p"));
+  EXPECT_TRUE(crop.contains("p=7"));
+  EXPECT_TRUE(crop.contains("x=180"));
+  EXPECT_TRUE(crop.contains("w=90"));
+  EXPECT_TRUE(crop.contains("X=3"));
+  EXPECT_FALSE(crop.contains("c="));  // native size
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <utils/adaptive_mutex.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+TEST(AdaptiveMutex, TryLockFailsWhileHeld) {
+  AdaptiveMutex mutex;
+  ASSERT_TRUE(mutex.try_lock());
+  EXPECT_FALSE(mutex.try_lock());
+  mutex.unlock();
+  EXPECT_TRUE(mutex.try_lock());
+  mutex.unlock();
+}
+
+TEST(AdaptiveMutex, SerializesContendedIncrements) {
+  constexpr int n_threads = 8;
+  constexpr int n_increments = 20'000;
+  AdaptiveMutex mutex;
+  long counter = 0;  // deliberately non-atomic
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; t++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < n_increments; i++) {
+        std::scoped_lock lock(mutex);
+        counter++;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter, static_cast<long>(n_threads) * n_increments);
+}
+
+TEST(AdaptiveMutex, WakesSleepingWaiter) {
+  AdaptiveMutex mutex;
+  mutex.lock();
+  bool acquired = false;
+  std::thread waiter([&] {
+    std::scoped_lock lock(mutex);
+    acquired = true;
+  });
+  // long enough for the waiter to exhaust its spin budget and sleep
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  mutex.unlock();
+  waiter.join();
+  EXPECT_TRUE(acquired);
+}
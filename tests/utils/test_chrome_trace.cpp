@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "utils/chrome_trace.h"
+#include "utils/profiling.h"
+
+namespace {
+std::string export_trace() {
+  const auto path = std::filesystem::temp_directory_path() /
+                    std::format("pdvu_chrome_trace_test_{}.json", getpid());
+  const auto result = chrome_trace::write_json(path);
+  EXPECT_TRUE(result.has_value()) << result.error();
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  std::filesystem::remove(path);
+  return text.str();
+}
+
+std::size_t count(const std::string& text, const std::string& needle) {
+  std::size_t n = 0;
+  for (auto pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+    n++;
+  }
+  return n;
+}
+
+void traced_work() { ZoneScoped; }
+}  // namespace
+
+TEST(ChromeTrace, DisabledRecordsNothing) {
+  chrome_trace::start();
+  chrome_trace::stop();
+  { ZoneScopedN("while disabled"); }
+  EXPECT_EQ(count(export_trace(), "while disabled"), 0U);
+}
+
+TEST(ChromeTrace, RecordsZonesWithThreadsAndRequests) {
+  chrome_trace::start();
+  {
+    const chrome_trace::RequestScope scope(7, 3);
+    traced_work();
+  }
+  std::thread([] {
+    chrome_trace::set_thread_name("test worker");
+    ZoneScopedN("worker zone");
+  }).join();
+  chrome_trace::stop();
+
+  const std::string json = export_trace();
+  EXPECT_TRUE(json.starts_with("{\"displayTimeUnit\""));
+  EXPECT_EQ(count(json, R"("name":"traced_work","cat":"pdvu","ph":"X")"), 1U) << json;
+  EXPECT_EQ(count(json, R"("args":{"req_id":7,"page":3})"), 1U) << json;
+  EXPECT_EQ(count(json, R"("name":"worker zone")"), 1U) << json;
+  EXPECT_EQ(count(json, R"("args":{"name":"test worker"})"), 1U) << json;
+  EXPECT_EQ(count(json, R"("args":{}})"), 1U) << "worker zone is outside any request";
+}
+
+TEST(ChromeTrace, RingKeepsNewestEvents) {
+  chrome_trace::start(4);
+  std::thread([] {
+    for (int i = 0; i < 10; i++) {
+      const chrome_trace::RequestScope scope(static_cast<std::uint64_t>(i), i);
+      ZoneScopedN("ring zone");
+    }
+  }).join();
+  chrome_trace::stop();
+
+  const std::string json = export_trace();
+  EXPECT_EQ(count(json, R"("name":"ring zone")"), 4U);
+  EXPECT_EQ(count(json, R"("req_id":5,)"), 0U);
+  EXPECT_EQ(count(json, R"("req_id":9,)"), 1U);
+  EXPECT_EQ(count(json, R"("dropped_events":6)"), 1U) << json;
+}
@@ -200,4 +200,13 @@ INSTANTIATE_TEST_SUITE_P(
         }),
     [](const ::testing::TestParamInfo<EraseParameterizedTest::ParamType>& info) {
       return info.param.name;
-    });
\ No newline at end of file
+    });
+
+TEST(LRUCache, TotalWeightSumsEntries) {
+  auto cache = LRUCache<int, std::vector<char>>(3);
+  cache.put(1, std::vector<char>(10));
+  cache.put(2, std::vector<char>(20));
+  cache.put(3, std::vector<char>(30));
+  cache.put(4, std::vector<char>(40));  // evicts 1
+  EXPECT_EQ(cache.total_weight([](const std::vector<char>& v) { return v.size(); }), 90U);
+}
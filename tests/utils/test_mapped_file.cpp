@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "utils/mapped_file.h"
+
+namespace {
+std::filesystem::path write_file(std::string_view name, std::string_view contents) {
+  const auto path =
+      std::filesystem::temp_directory_path() / std::format("pdvu_{}_{}", name, getpid());
+  std::ofstream(path, std::ios::binary) << contents;
+  return path;
+}
+}  // namespace
+
+TEST(MappedFileTest, MapsWholeFile) {
+  const auto path = write_file("mapped", "%PDF-1.7 mapped bytes");
+  {
+    const auto mapped = MappedFile::open(path);
+    ASSERT_TRUE(mapped.has_value()) << mapped.error();
+    EXPECT_EQ(mapped->path(), path);
+    ASSERT_EQ(mapped->size(), 21U);
+    EXPECT_EQ(std::string_view(reinterpret_cast<const char*>(mapped->data()), mapped->size()),
+              "%PDF-1.7 mapped bytes");
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, MissingAndEmptyFilesAreErrors) {
+  EXPECT_FALSE(MappedFile::open("/nonexistent/pdvu.pdf").has_value());
+  EXPECT_FALSE(MappedFile::open(std::filesystem::temp_directory_path()).has_value());
+  const auto path = write_file("empty", "");
+  EXPECT_FALSE(MappedFile::open(path).has_value());
+  std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, MoveTransfersMapping) {
+  const auto path = write_file("moved", "abc");
+  auto source = MappedFile::open(path);
+  ASSERT_TRUE(source.has_value());
+  const unsigned char* data = source->data();
+  MappedFile target = std::move(*source);
+  EXPECT_EQ(target.data(), data);
+  EXPECT_EQ(target.size(), 3U);
+  EXPECT_EQ(source->data(), nullptr);
+  EXPECT_EQ(source->size(), 0U);
+
+  auto other = MappedFile::open(path);
+  ASSERT_TRUE(other.has_value());
+  *other = std::move(target);
+  EXPECT_EQ(other->data(), data);
+  EXPECT_EQ(target.data(), nullptr);
+  std::filesystem::remove(path);
+}
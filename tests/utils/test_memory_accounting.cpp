@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <utils/memory_accounting.h>
+
+#include <chrono>
+
+namespace {
+constexpr std::size_t KiB = 1024;
+
+constexpr auto g_rollup = R"(55d0c3a4e000-7ffd4b1f2000 ---p 00000000 00:00 0                  [rollup]
+Rss:               12000 kB
+Pss:                9000 kB
+Pss_Anon:           7000 kB
+Pss_File:           1500 kB
+Pss_Shmem:           500 kB
+Shared_Clean:       2000 kB
+Shared_Dirty:       1000 kB
+Private_Clean:       500 kB
+Private_Dirty:      8500 kB
+Referenced:        12000 kB
+Anonymous:          8000 kB
+Swap:                 64 kB
+SwapPss:              64 kB
+)";
+}  // namespace
+
+TEST(MemoryAccounting, ParsesSmapsRollup) {
+  const auto memory = memory_accounting::parse_smaps_rollup(g_rollup);
+  ASSERT_TRUE(memory.has_value());
+  EXPECT_EQ(memory->rss, 12000 * KiB);
+  EXPECT_EQ(memory->pss, 9000 * KiB) << "Pss_* breakdown lines must not override Pss";
+  EXPECT_EQ(memory->uss, 9000 * KiB);
+  EXPECT_EQ(memory->shared, 3000 * KiB);
+  EXPECT_EQ(memory->swap, 64 * KiB) << "SwapPss must not override Swap";
+}
+
+TEST(MemoryAccounting, RejectsTextWithoutPss) {
+  EXPECT_FALSE(memory_accounting::parse_smaps_rollup("").has_value());
+  EXPECT_FALSE(memory_accounting::parse_smaps_rollup("Rss: 100 kB\n").has_value());
+  EXPECT_FALSE(memory_accounting::parse_smaps_rollup("Pss: lots\n").has_value());
+}
+
+TEST(MemoryAccounting, MissingFileIsEmpty) {
+  EXPECT_FALSE(memory_accounting::read_smaps_rollup("/nonexistent/smaps_rollup").has_value());
+}
+
+TEST(MemoryAccounting, CurrentProcessIsNonZero) {
+  const auto memory = memory_accounting::current(std::chrono::milliseconds(0));
+  EXPECT_GT(memory.rss, 0U);
+  EXPECT_GT(memory.pss, 0U);
+  EXPECT_LE(memory.uss, memory.rss);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "utils/metrics.h"
+
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogram, SmallValuesHaveExactBuckets) {
+  for (std::uint64_t v = 0; v < metrics::LatencyHistogram::SUB_BUCKETS; v++) {
+    EXPECT_EQ(metrics::LatencyHistogram::bucket_index(v), v);
+    EXPECT_EQ(metrics::LatencyHistogram::bucket_lower_bound(v), v);
+  }
+}
+
+TEST(LatencyHistogram, BucketBoundsRoundTrip) {
+  // every value must fall in a bucket whose lower bound does not exceed it
+  constexpr std::uint64_t values[] = {32, 33, 63, 64, 1'000, 123'456'789, UINT64_MAX};
+  for (const std::uint64_t v : values) {
+    const auto index = metrics::LatencyHistogram::bucket_index(v);
+    ASSERT_LT(index, metrics::LatencyHistogram::N_BUCKETS);
+    EXPECT_LE(metrics::LatencyHistogram::bucket_lower_bound(index), v);
+    if (index + 1 < metrics::LatencyHistogram::N_BUCKETS) {
+      EXPECT_GT(metrics::LatencyHistogram::bucket_lower_bound(index + 1), v);
+    }
+  }
+}
+
+TEST(LatencyHistogram, EmptyHistogramReportsZero) {
+  metrics::LatencyHistogram h;
+  EXPECT_EQ(h.count(), 0U);
+  EXPECT_EQ(h.percentile(0.5), 0U);
+  EXPECT_EQ(h.summary().count, 0U);
+}
+
+TEST(LatencyHistogram, PercentilesWithinRelativeError) {
+  metrics::LatencyHistogram h;
+  for (int ms = 1; ms <= 100; ms++) {
+    h.record(std::chrono::milliseconds(ms));
+  }
+  EXPECT_EQ(h.count(), 100U);
+
+  auto near = [](std::uint64_t actual_ns, double expected_ms) {
+    const double actual_ms = static_cast<double>(actual_ns) / 1e6;
+    EXPECT_NEAR(actual_ms, expected_ms, expected_ms * 0.04);
+  };
+  near(h.percentile(0.50), 50);
+  near(h.percentile(0.95), 95);
+  near(h.percentile(0.99), 99);
+  EXPECT_LE(h.percentile(1.0), 100'000'000U);  // never above the recorded maximum
+
+  const auto s = h.summary();
+  EXPECT_DOUBLE_EQ(s.min_us, 1'000.0);
+  EXPECT_DOUBLE_EQ(s.max_us, 100'000.0);
+  EXPECT_DOUBLE_EQ(s.mean_us, 50'500.0);
+}
+
+TEST(LatencyHistogram, ConcurrentRecordsAreAllCounted) {
+  metrics::LatencyHistogram h;
+  constexpr int n_threads = 4;
+  constexpr int per_thread = 10'000;
+  std::vector<std::thread> threads;
+  threads.reserve(n_threads);
+  for (int t = 0; t < n_threads; t++) {
+    threads.emplace_back([&h] {
+      for (int i = 0; i < per_thread; i++) {
+        h.record(std::chrono::microseconds(i));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(h.count(), static_cast<std::uint64_t>(n_threads * per_thread));
+}
+
+TEST(MetricsRegistry, LookupReturnsSameMetric) {
+  metrics::Registry registry;
+  auto& a = registry.counter("render.frames");
+  auto& b = registry.counter("render.frames");
+  EXPECT_EQ(&a, &b);
+
+  a.add();
+  b.add(2);
+  EXPECT_EQ(registry.counter("render.frames").value(), 3U);
+}
+
+TEST(MetricsRegistry, HitRateFromCounterPair) {
+  metrics::Registry registry;
+  EXPECT_LT(registry.hit_rate("cache.page"), 0.0);
+
+  registry.counter("cache.page.hits").add(3);
+  registry.counter("cache.page.misses").add(1);
+  EXPECT_DOUBLE_EQ(registry.hit_rate("cache.page"), 0.75);
+}
+
+TEST(MetricsRegistry, JsonContainsEveryMetric) {
+  metrics::Registry registry;
+  registry.counter("cache.page.hits").add(1);
+  registry.counter("cache.page.misses").add(1);
+  registry.gauge("memory.rss_bytes").set(4096);
+  registry.histogram("render.raster").record(2ms);
+
+  const std::string json = registry.to_json();
+  EXPECT_TRUE(json.contains(R"("cache.page.hits": 1)"));
+  EXPECT_TRUE(json.contains(R"("memory.rss_bytes": 4096)"));
+  EXPECT_TRUE(json.contains(R"("render.raster": {"count": 1)"));
+  EXPECT_TRUE(json.contains(R"("cache.page": 0.5000)"));
+}
+
+TEST(MetricsRegistry, RequestsCounterReportsPerRequestMeans) {
+  metrics::Registry registry;
+  registry.counter("perf.raster.cycles").add(3000);
+  registry.counter("perf.raster.requests").add(2);
+  registry.counter("perf.rasterize.cycles").add(1);
+
+  const std::string json = registry.to_json();
+  EXPECT_TRUE(json.contains(R"("perf.raster.cycles": 1500.0)")) << json;
+  EXPECT_FALSE(json.contains(R"("perf.rasterize.cycles": 0.5)")) << json;
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "utils/metrics.h"
+#include "utils/perf_counters.h"
+
+namespace {
+std::uint64_t counter(std::string_view name) { return metrics::registry().counter(name).value(); }
+
+std::uint64_t spin(std::uint64_t n) {
+  volatile std::uint64_t sum = 0;
+  for (std::uint64_t i = 0; i < n; i++) {
+    sum = sum + i;
+  }
+  return sum;
+}
+}  // namespace
+
+TEST(PerfCounters, CountsSubtractWithoutWrapping) {
+  const perf_counters::Counts a{
+      .cycles = 10, .instructions = 20, .cache_misses = 1, .branch_misses = 5};
+  const perf_counters::Counts b{
+      .cycles = 4, .instructions = 25, .cache_misses = 1, .branch_misses = 2};
+  const auto d = a - b;
+  EXPECT_EQ(d.cycles, 6U);
+  EXPECT_EQ(d.instructions, 0U);
+  EXPECT_EQ(d.cache_misses, 0U);
+  EXPECT_EQ(d.branch_misses, 3U);
+}
+
+TEST(PerfCounters, ScopeRecordsIntoStageWhenAvailable) {
+  perf_counters::StageCounters stage("test_stage");
+  const std::uint64_t requests_before = counter("perf.test_stage.requests");
+  const std::uint64_t instructions_before = counter("perf.test_stage.instructions");
+  if (const auto enabled = perf_counters::enable(); !enabled) {
+    // unavailable counters must leave the stage untouched
+    { const perf_counters::Scope scope(stage); }
+    EXPECT_EQ(counter("perf.test_stage.requests"), requests_before);
+    GTEST_SKIP() << enabled.error();
+  }
+  {
+    const perf_counters::Scope scope(stage);
+    spin(100'000);
+  }
+  EXPECT_EQ(counter("perf.test_stage.requests"), requests_before + 1);
+  EXPECT_GT(counter("perf.test_stage.instructions"), instructions_before + 100'000);
+}
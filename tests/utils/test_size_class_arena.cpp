@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <utils/size_class_arena.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+bool aligned16(const void* ptr) { return reinterpret_cast<std::uintptr_t>(ptr) % 16 == 0; }
+}  // namespace
+
+TEST(SizeClassArena, BlocksAreAlignedAndLargeEnough) {
+  for (const std::size_t size : {0UL, 1UL, 15UL, 16UL, 17UL, 1000UL, 1024UL, 1025UL, 70'000UL}) {
+    void* ptr = size_class_arena::allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(aligned16(ptr)) << size;
+    EXPECT_GE(size_class_arena::usable_size(ptr), size);
+    std::memset(ptr, 0xab, size);
+    size_class_arena::deallocate(ptr);
+  }
+  size_class_arena::deallocate(nullptr);
+}
+
+TEST(SizeClassArena, SmallSizesRoundToGranule) {
+  void* ptr = size_class_arena::allocate(17);
+  EXPECT_EQ(size_class_arena::usable_size(ptr), 2 * size_class_arena::GRANULE);
+  size_class_arena::deallocate(ptr);
+}
+
+TEST(SizeClassArena, FreedBlocksAreReused) {
+  void* first = size_class_arena::allocate(48);
+  size_class_arena::deallocate(first);
+  void* second = size_class_arena::allocate(40);
+  EXPECT_EQ(first, second);  // same class, top of the thread's free list
+  size_class_arena::deallocate(second);
+}
+
+TEST(SizeClassArena, ReallocatePreservesContents) {
+  auto* bytes = static_cast<unsigned char*>(size_class_arena::allocate(10));
+  for (int i = 0; i < 10; i++) {
+    bytes[i] = static_cast<unsigned char>(i);
+  }
+  // grow within small classes, into a malloc block, then within malloc blocks
+  for (const std::size_t size : {100UL, 2000UL, 100'000UL}) {
+    bytes = static_cast<unsigned char*>(size_class_arena::reallocate(bytes, size));
+    ASSERT_NE(bytes, nullptr);
+    EXPECT_GE(size_class_arena::usable_size(bytes), size);
+    for (int i = 0; i < 10; i++) {
+      ASSERT_EQ(bytes[i], i) << size;
+    }
+  }
+  bytes = static_cast<unsigned char*>(size_class_arena::reallocate(bytes, 5));
+  ASSERT_NE(bytes, nullptr);
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(bytes[i], i);
+  }
+  size_class_arena::deallocate(bytes);
+}
+
+TEST(SizeClassArena, BlocksCanBeFreedOnAnotherThread) {
+  constexpr int n_threads = 4;
+  constexpr int n_blocks = 5'000;
+  std::vector<std::vector<void*>> blocks(n_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < n_blocks; i++) {
+        void* ptr = size_class_arena::allocate(static_cast<std::size_t>(16 + (i % 64) * 16));
+        std::memset(ptr, t, 16);
+        blocks[static_cast<std::size_t>(t)].push_back(ptr);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  // each thread frees the blocks another one allocated, after that thread has exited
+  for (int t = 0; t < n_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (void* ptr : blocks[static_cast<std::size_t>((t + 1) % n_threads)]) {
+        size_class_arena::deallocate(ptr);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_GT(size_class_arena::reserved_bytes(), 0U);
+}
@@ -155,4 +155,57 @@ TEST(FrameLayout, RoundsPlacementDimensionsToNearestCell) {
   EXPECT_TRUE(layout.source_matches_target);
   EXPECT_EQ(layout.placement_cols, 10);
   EXPECT_EQ(layout.placement_rows, 11);
-}
\ No newline at end of file
+}
+
+TEST(FrameLayout, MapsPageRectThroughZoomAndRotation) {
+  // 100 x 200 page at base zoom, rendered at twice the size
+  const auto page = pdf::PageSpecs::from_base_bounds({.x0 = 0, .y0 = 0, .x1 = 100, .y1 = 200});
+  const pdf::Rect word{.x0 = 10, .y0 = 20, .x1 = 30, .y1 = 30};
+
+  expect_rect_eq(viewer::map_page_rect(word, page.scale(2.0F)),
+                 {.x = 20, .y = 40, .width = 40, .height = 20});
+  // clockwise: the top left corner moves to the top right
+  expect_rect_eq(viewer::map_page_rect(word, page.rotate_quarter_clockwise(1).scale(2.0F)),
+                 {.x = 340, .y = 20, .width = 20, .height = 40});
+  expect_rect_eq(viewer::map_page_rect(word, page.rotate_quarter_clockwise(2).scale(2.0F)),
+                 {.x = 140, .y = 340, .width = 40, .height = 20});
+  expect_rect_eq(viewer::map_page_rect(word, page.rotate_quarter_clockwise(3).scale(2.0F)),
+                 {.x = 40, .y = 140, .width = 20, .height = 40});
+}
+
+TEST(FrameLayout, PlacesOverlayRelativeToCrop) {
+  const geometry::PixelSize size{
+      .width = 2000,
+      .height = 3000,
+  };
+  const geometry::PixelRect crop{
+      .x = 500,
+      .y = 1000,
+      .width = 1000,
+      .height = 800,
+  };
+  const auto layout = viewer::calculate_frame_layout(size, size, crop, term_size, content_area);
+
+  // 25 pixels right and 45 down of the crop: 2 cells and 5 pixels, 2 cells and 5 pixels
+  const auto placement = viewer::calculate_overlay_placement(
+      {.x = 525, .y = 1045, .width = 30, .height = 10}, layout, term_size);
+  ASSERT_TRUE(placement.has_value());
+  EXPECT_EQ(placement->origin.row, layout.placement_origin.row + 2);
+  EXPECT_EQ(placement->origin.col, layout.placement_origin.col + 2);
+  EXPECT_EQ(placement->x_offset_pixels, 5);
+  EXPECT_EQ(placement->y_offset_pixels, 5);
+  EXPECT_EQ(placement->cols, 4);  // 5 + 30 pixels spill into a fourth cell
+  EXPECT_EQ(placement->rows, 1);
+
+  // clipped at the crop's left edge
+  const auto clipped = viewer::calculate_overlay_placement(
+      {.x = 490, .y = 1000, .width = 30, .height = 20}, layout, term_size);
+  ASSERT_TRUE(clipped.has_value());
+  EXPECT_EQ(clipped->origin.col, layout.placement_origin.col);
+  EXPECT_EQ(clipped->x_offset_pixels, 0);
+  EXPECT_EQ(clipped->cols, 2);
+
+  EXPECT_FALSE(viewer::calculate_overlay_placement(
+                   {.x = 0, .y = 0, .width = 100, .height = 100}, layout, term_size)
+                   .has_value());
+}
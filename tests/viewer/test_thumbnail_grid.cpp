@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "viewer/thumbnail_grid.h"
+
+namespace {
+
+constexpr TermSize term_size{
+    .columns = 100,
+    .rows = 42,
+    .pixel_width = 1000,
+    .pixel_height = 840,
+    .cell_pixel_width = 10,
+    .cell_pixel_height = 20,
+};
+
+constexpr TUI::ContentArea content_area{
+    .cols = 100,
+    .rows = 40,
+    .start_row = 2,
+    .start_col = 1,
+};
+
+}  // namespace
+
+TEST(ThumbnailGrid, FitsThreeRowsOfPortraitSlots) {
+  // 40 rows / 3 = 13 rows per slot, 12 of them thumbnail: 240 x 180 pixel boxes
+  // 180 pixels take 18 cols, plus the gap
+  const auto grid = viewer::calculate_thumbnail_grid(term_size, content_area, 50);
+
+  EXPECT_EQ(grid.slot_rows, 13);
+  EXPECT_EQ(grid.box.height, 240);
+  EXPECT_EQ(grid.box.width, 180);
+  EXPECT_EQ(grid.slot_cols, 19);
+  EXPECT_EQ(grid.cols, 5);
+  EXPECT_EQ(grid.visible_rows, 3);
+  EXPECT_EQ(grid.total_rows, 10);
+  // 5 slots take 95 of 100 cols, centred
+  EXPECT_EQ(grid.origin.row, 2);
+  EXPECT_EQ(grid.origin.col, 3);
+}
+
+TEST(ThumbnailGrid, KeepsOneRowForShortDocuments) {
+  const auto grid = viewer::calculate_thumbnail_grid(term_size, content_area, 2);
+
+  EXPECT_EQ(grid.total_rows, 1);
+  EXPECT_EQ(grid.slot_position(0, 0, 1).col, grid.origin.col + grid.slot_cols);
+}
+
+TEST(ThumbnailGrid, ScrollsAsLittleAsPossible) {
+  const auto grid = viewer::calculate_thumbnail_grid(term_size, content_area, 50);
+
+  EXPECT_EQ(grid.scroll_to(0, 14), 0);   // row 2 already visible
+  EXPECT_EQ(grid.scroll_to(0, 15), 1);   // row 3 becomes the last visible row
+  EXPECT_EQ(grid.scroll_to(4, 12), 2);   // row 2 becomes the first visible row
+  EXPECT_EQ(grid.scroll_to(4, 49), 7);
+  EXPECT_EQ(grid.slot_position(1, 2, 0).row, grid.origin.row + grid.slot_rows);
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "viewer/trace.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr TermSize g_size = {
+    .columns = 120,
+    .rows = 40,
+    .pixel_width = 1200,
+    .pixel_height = 800,
+    .cell_pixel_width = 10,
+    .cell_pixel_height = 20,
+};
+
+trace::TraceEvent input(std::int64_t t_us, std::uint64_t batch, InputEvent event) {
+  return {.type = trace::EventType::Input, .t_us = t_us, .batch = batch, .input = event};
+}
+
+trace::TraceEvent resize(std::int64_t t_us, const TermSize& size) {
+  return {.type = trace::EventType::Resize, .t_us = t_us, .size = size};
+}
+
+trace::Trace make_trace(std::vector<trace::TraceEvent> events) {
+  return {.header = {.version = 1, .document = "doc.pdf"}, .events = std::move(events)};
+}
+}  // namespace
+
+TEST(Trace, EventsRoundTrip) {
+  const trace::TraceEvent events[] = {
+      input(10, 3, {.key = key_char, .char_value = 'q'}),
+      input(11, 3, {.key = key_right_arrow}),
+      resize(12, g_size),
+      {.type = trace::EventType::RenderRequest,
+       .t_us = 13,
+       .req_id = 7,
+       .page_num = 2,
+       .zoom = 1.5F},
+      {.type = trace::EventType::RenderResult,
+       .t_us = 14,
+       .req_id = 7,
+       .page_num = 2,
+       .render_us = 4321,
+       .ok = false},
+      {.type = trace::EventType::FrameDrawn, .t_us = 15, .req_id = 7, .page_num = 2},
+  };
+  for (const auto& event : events) {
+    const auto parsed = trace::parse_event(trace::to_json(event));
+    ASSERT_TRUE(parsed.has_value()) << trace::to_json(event);
+    EXPECT_EQ(parsed->type, event.type);
+    EXPECT_EQ(parsed->t_us, event.t_us);
+    EXPECT_EQ(parsed->batch, event.batch);
+    EXPECT_EQ(parsed->input.key, event.input.key);
+    EXPECT_EQ(parsed->input.char_value, event.input.char_value);
+    EXPECT_EQ(parsed->size.columns, event.size.columns);
+    EXPECT_EQ(parsed->size.cell_pixel_height, event.size.cell_pixel_height);
+    EXPECT_EQ(parsed->req_id, event.req_id);
+    EXPECT_EQ(parsed->page_num, event.page_num);
+    EXPECT_FLOAT_EQ(parsed->zoom, event.zoom);
+    EXPECT_EQ(parsed->render_us, event.render_us);
+    EXPECT_EQ(parsed->ok, event.ok);
+  }
+}
+
+TEST(Trace, HeaderRoundTripsEscapedNames) {
+  const trace::TraceHeader header{.version = 1, .document = R"(my "notes"\v2.pdf)"};
+  const auto parsed = trace::parse_header(trace::to_json(header));
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->document, header.document);
+}
+
+TEST(Trace, MalformedEventsAreRejected) {
+  EXPECT_FALSE(trace::parse_event("").has_value());
+  EXPECT_FALSE(trace::parse_event(R"({"t_us":1,"type":"teleport"})").has_value());
+  EXPECT_FALSE(trace::parse_event(R"({"t_us":1,"type":"input","batch":0,"key":99,"char":0})")
+                   .has_value());
+  EXPECT_FALSE(trace::parse_event(R"({"t_us":1,"type":"frame_drawn","req_id":"x","page":0})")
+                   .has_value());
+}
+
+TEST(Trace, RecorderOutputLoads) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    std::format("pdvu_trace_test_{}.jsonl", getpid());
+  {
+    auto recorder = trace::Recorder::create(path, {.version = 1, .document = "doc.pdf"});
+    ASSERT_TRUE(recorder.has_value());
+    recorder->resize(g_size);
+    recorder->next_batch();
+    recorder->input({.key = key_right_arrow});
+    recorder->render_request(1, 1, 2.0F);
+    recorder->render_result(1, 1, 1500us, true);
+    recorder->frame_drawn(1, 1);
+  }
+  const auto loaded = trace::load(path);
+  std::filesystem::remove(path);
+  ASSERT_TRUE(loaded.has_value()) << loaded.error();
+  EXPECT_EQ(loaded->header.document, "doc.pdf");
+  ASSERT_EQ(loaded->events.size(), 5U);
+  EXPECT_EQ(loaded->events[1].batch, 1U);
+  EXPECT_EQ(loaded->events[3].render_us, 1500);
+  for (std::size_t i = 1; i < loaded->events.size(); i++) {
+    EXPECT_GE(loaded->events[i].t_us, loaded->events[i - 1].t_us);
+  }
+}
+
+TEST(TraceReplayer, GroupsStepsAndExtractsInitialSize) {
+  trace::Replayer replayer(make_trace({
+                               resize(0, g_size),
+                               input(100, 1, {.key = key_right_arrow}),
+                               input(100, 1, {.key = key_right_arrow}),
+                               resize(200, g_size),
+                               input(300, 2, {.key = key_char, .char_value = 'q'}),
+                           }),
+                           trace::Replayer::Pacing::AsFastAsPossible);
+  ASSERT_TRUE(replayer.initial_size().has_value());
+  EXPECT_EQ(replayer.initial_size()->columns, g_size.columns);
+
+  const auto t0 = trace::Clock::now();
+  EXPECT_FALSE(replayer.poll(t0).has_value()) << "must wait for the viewer to be idle once";
+  replayer.update(false, t0);
+
+  const auto first = replayer.poll(t0);
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(first->inputs.size(), 2U);
+  EXPECT_FALSE(first->resize.has_value());
+  EXPECT_FALSE(replayer.poll(t0).has_value()) << "previous step has not settled";
+
+  replayer.update(true, t0 + 5ms);
+  replayer.update(false, t0 + 20ms);
+  const auto second = replayer.poll(t0 + 20ms);
+  ASSERT_TRUE(second.has_value());
+  EXPECT_TRUE(second->inputs.empty());
+  ASSERT_TRUE(second->resize.has_value());
+
+  replayer.update(false, t0 + 21ms);
+  const auto third = replayer.poll(t0 + 21ms);
+  ASSERT_TRUE(third.has_value());
+  EXPECT_EQ(third->inputs[0].char_value, 'q');
+  replayer.update(false, t0 + 22ms);
+  EXPECT_TRUE(replayer.finished());
+
+  const auto& latencies = replayer.latencies();
+  ASSERT_EQ(latencies.size(), 3U);
+  EXPECT_EQ(latencies[0].latency, 20ms);
+  EXPECT_EQ(latencies[0].first_input.key, key_right_arrow);
+  EXPECT_EQ(latencies[1].first_input.key, key_none);
+  EXPECT_FALSE(latencies[2].timed_out);
+}
+
+TEST(TraceReplayer, OriginalTimingDeliversAtRecordedOffsets) {
+  trace::Replayer replayer(make_trace({
+                               input(1'000, 1, {.key = key_right_arrow}),
+                               input(51'000, 2, {.key = key_right_arrow}),
+                           }),
+                           trace::Replayer::Pacing::OriginalTiming);
+  const auto t0 = trace::Clock::now();
+  replayer.update(false, t0);
+  ASSERT_TRUE(replayer.poll(t0).has_value());
+
+  // the second step is due 50ms later even though the first is still busy
+  replayer.update(true, t0 + 10ms);
+  EXPECT_EQ(replayer.time_until_next(t0 + 10ms), 40ms);
+  EXPECT_FALSE(replayer.poll(t0 + 49ms).has_value());
+  ASSERT_TRUE(replayer.poll(t0 + 50ms).has_value());
+
+  replayer.update(false, t0 + 60ms);
+  ASSERT_EQ(replayer.latencies().size(), 2U);
+  EXPECT_EQ(replayer.latencies()[0].latency, 60ms);
+  EXPECT_EQ(replayer.latencies()[1].latency, 10ms);
+  EXPECT_TRUE(replayer.finished());
+}
+
+TEST(TraceReplayer, StuckStepTimesOut) {
+  trace::Replayer replayer(make_trace({input(0, 1, {.key = key_right_arrow})}),
+                           trace::Replayer::Pacing::AsFastAsPossible,
+                           100ms);
+  const auto t0 = trace::Clock::now();
+  replayer.update(false, t0);
+  ASSERT_TRUE(replayer.poll(t0).has_value());
+  replayer.update(true, t0 + 50ms);
+  EXPECT_FALSE(replayer.finished());
+  replayer.update(true, t0 + 100ms);
+  EXPECT_TRUE(replayer.finished());
+  EXPECT_TRUE(replayer.latencies()[0].timed_out);
+}